@@ -6,6 +6,7 @@
 #include <irq_func.h>
 #include <asm/cache.h>
 #include <common.h>
+#include <serial.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -85,6 +86,7 @@ static void boot_jump_linux(bootm_headers_t *images, int flag)
 
 	printf("\nStarting kernel ...%s\n\n", fake ?
 	       "(fake run for tracing)" : "");
+	serial_flush();
 	bootstage_mark_name(BOOTSTAGE_ID_BOOTM_HANDOFF, "start_kernel");
 
 	if (IMAGE_ENABLE_OF_LIBFDT && images->ft_len) {
@@ -83,3 +83,21 @@ int cleanup_before_linux(void)
 {
 	return cleanup_before_linux_select(CBL_ALL);
 }
+
+unsigned long get_cpu_cycles(void)
+{
+	u32 val;
+
+	/* Start the PMU cycle counter, counting every cycle, on first use */
+	asm volatile("mrc p15, 0, %0, c9, c12, 1" : "=r" (val));
+	if (!(val & BIT(31))) {
+		asm volatile("mrc p15, 0, %0, c9, c12, 0" : "=r" (val));
+		val &= ~BIT(3);			/* PMCR.D: no divider */
+		val |= BIT(2) | BIT(0);		/* PMCR.C, PMCR.E */
+		asm volatile("mcr p15, 0, %0, c9, c12, 0" : : "r" (val));
+		asm volatile("mcr p15, 0, %0, c9, c12, 1" : : "r" (BIT(31)));
+	}
+	asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r" (val));
+
+	return val;
+}
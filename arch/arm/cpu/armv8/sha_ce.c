@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Runtime detection of the ARMv8 Crypto Extensions SHA instructions
+ *
+ * The instructions are optional, so an image built with them must
+ * still run on cores that lack them; lib/sha1.c and lib/sha256.c fall back
+ * to the generic block functions when these return zero.
+ */
+
+#include <common.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+
+static u64 read_id_aa64isar0(void)
+{
+	u64 isar0;
+
+	asm("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+
+	return isar0;
+}
+
+int sha1_ce_available(void)
+{
+	return ((read_id_aa64isar0() >> 8) & 0xf) != 0;
+}
+
+int sha256_ce_available(void)
+{
+	return ((read_id_aa64isar0() >> 12) & 0xf) != 0;
+}
@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Work queue CPUs for ARMv8, started and stopped through PSCI
+ *
+ * The secondary CPUs listed in /cpus with enable-method "psci" are switched
+ * on with CPU_ON the first time work is queued. Each one enters
+ * work_cpu_entry() at the boot CPU's exception level, takes over its page
+ * tables and then polls a one-item mailbox. arch_work_stop() turns them off
+ * again with CPU_OFF before the OS boots, so the OS finds them powered down
+ * as the firmware left them.
+ */
+
+#include <common.h>
+#include <cpu_func.h>
+#include <dm.h>
+#include <malloc.h>
+#include <workqueue.h>
+#include <asm/system.h>
+#include <linux/psci.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define WORK_CPU_STACK_SIZE	SZ_16K
+#define WORK_CPU_TIMEOUT_MS	100
+
+/* Affinity fields of MPIDR_EL1, as used in the device tree and by PSCI */
+#define MPIDR_HWID_MASK		0xff00ffffffUL
+
+/**
+ * struct work_cpu - A secondary CPU which runs work
+ *
+ * The fields up to @sctlr are read by work_cpu_entry() with the MMU and
+ * caches off, at the offsets given there.
+ *
+ * @sp:		Top of the CPU's stack
+ * @gd:		Global data pointer
+ * @ttbr:	TTBR0 of the boot CPU's exception level
+ * @tcr:	TCR of the boot CPU's exception level
+ * @mair:	MAIR of the boot CPU's exception level
+ * @vbar:	VBAR of the boot CPU's exception level
+ * @sctlr:	SCTLR of the boot CPU's exception level
+ * @mpidr:	Affinity of the CPU, for PSCI
+ * @work:	Work item to run next, cleared by the CPU when done
+ * @running:	Set by the CPU once it polls @work
+ * @stop:	Set by the boot CPU to have the CPU turn itself off
+ */
+struct work_cpu {
+	ulong sp;
+	ulong gd;
+	ulong ttbr;
+	ulong tcr;
+	ulong mair;
+	ulong vbar;
+	ulong sctlr;
+	ulong mpidr;
+	struct work *volatile work;
+	volatile int running;
+	volatile int stop;
+};
+
+void work_cpu_save(struct work_cpu *cpu);
+void work_cpu_entry(struct work_cpu *cpu);
+
+static struct work_cpu work_cpu[CONFIG_ARMV8_WORK_CPUS]
+	__aligned(ARCH_DMA_MINALIGN);
+/* Number of CPUs switched on, including any which never reached the loop */
+static int work_cpu_num;
+static int work_cpu_running;
+static bool work_cpu_started;
+
+static inline void work_cpu_wfe(void)
+{
+	asm volatile("wfe" : : : "memory");
+}
+
+static inline void work_cpu_sev(void)
+{
+	dsb();
+	asm volatile("sev" : : : "memory");
+}
+
+/* Called by work_cpu_entry() once the MMU and caches are on */
+void __noreturn work_cpu_loop(struct work_cpu *cpu)
+{
+	struct work *work;
+
+	cpu->running = 1;
+	work_cpu_sev();
+
+	for (;;) {
+		work = cpu->work;
+		if (work) {
+			work_run(work);
+			cpu->work = NULL;
+			work_cpu_sev();
+		} else if (cpu->stop) {
+			break;
+		} else {
+			work_cpu_wfe();
+		}
+	}
+
+	invoke_psci_fn(PSCI_0_2_FN_CPU_OFF, 0, 0, 0);
+
+	/* CPU_OFF only returns if it failed */
+	for (;;)
+		work_cpu_wfe();
+}
+
+static int work_cpu_start(struct work_cpu *cpu, ulong mpidr)
+{
+	void *stack;
+	ulong start;
+	int ret;
+
+	stack = memalign(16, WORK_CPU_STACK_SIZE);
+	if (!stack)
+		return -ENOMEM;
+
+	cpu->sp = (ulong)stack + WORK_CPU_STACK_SIZE;
+	cpu->gd = (ulong)gd;
+	cpu->mpidr = mpidr;
+	work_cpu_save(cpu);
+	flush_dcache_range((ulong)cpu,
+			   ALIGN((ulong)(cpu + 1), ARCH_DMA_MINALIGN));
+
+	ret = invoke_psci_fn(PSCI_0_2_FN64_CPU_ON, mpidr,
+			     (ulong)work_cpu_entry, (ulong)cpu);
+	if (ret != PSCI_RET_SUCCESS) {
+		debug("%s: CPU %lx: CPU_ON failed (%d)\n", __func__, mpidr,
+		      ret);
+		free(stack);
+		return -EIO;
+	}
+
+	start = get_timer(0);
+	while (!cpu->running) {
+		if (get_timer(start) > WORK_CPU_TIMEOUT_MS) {
+			/* It turns itself off again if it ever gets going */
+			cpu->stop = 1;
+			debug("%s: CPU %lx: timed out\n", __func__, mpidr);
+			return -ETIMEDOUT;
+		}
+	}
+
+	return 0;
+}
+
+static void work_cpus_start(void)
+{
+	struct udevice *dev;
+	const char *prop;
+	const fdt32_t *reg;
+	ofnode node;
+	ulong self, mpidr;
+	int len, ret;
+
+	/* Probing the PSCI device selects the SMC or HVC conduit */
+	if (uclass_get_device_by_name(UCLASS_FIRMWARE, "psci", &dev))
+		return;
+
+	self = read_mpidr() & MPIDR_HWID_MASK;
+	ofnode_for_each_subnode(node, ofnode_path("/cpus")) {
+		if (work_cpu_num == CONFIG_ARMV8_WORK_CPUS)
+			break;
+
+		prop = ofnode_read_string(node, "device_type");
+		if (!prop || strcmp(prop, "cpu"))
+			continue;
+		prop = ofnode_read_string(node, "enable-method");
+		if (!prop || strcmp(prop, "psci"))
+			continue;
+
+		reg = ofnode_get_property(node, "reg", &len);
+		if (reg && len == sizeof(fdt64_t))
+			mpidr = fdt64_to_cpu(*(const fdt64_t *)reg);
+		else if (reg && len == sizeof(fdt32_t))
+			mpidr = fdt32_to_cpu(*reg);
+		else
+			continue;
+		if (mpidr == self)
+			continue;
+
+		ret = work_cpu_start(&work_cpu[work_cpu_num], mpidr);
+		if (ret == -ETIMEDOUT)
+			work_cpu_num++;
+		if (!ret) {
+			work_cpu_num++;
+			work_cpu_running++;
+		}
+	}
+}
+
+int arch_work_cpus(void)
+{
+	/* The mailboxes and stacks must survive relocation */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+
+	if (!work_cpu_started) {
+		work_cpu_started = true;
+		work_cpus_start();
+	}
+
+	return work_cpu_running;
+}
+
+int arch_work_submit(struct work *work)
+{
+	struct work_cpu *cpu;
+	int i;
+
+	if (!arch_work_cpus())
+		return -ENODEV;
+
+	for (i = 0; i < work_cpu_num; i++) {
+		cpu = &work_cpu[i];
+		if (!cpu->running || cpu->stop || cpu->work)
+			continue;
+		cpu->work = work;
+		work_cpu_sev();
+
+		return 0;
+	}
+
+	return -EBUSY;
+}
+
+void arch_work_wait(struct work *work)
+{
+	while (!work->done)
+		work_cpu_wfe();
+}
+
+void arch_work_stop(void)
+{
+	struct work_cpu *cpu;
+	ulong start;
+	int i;
+
+	if (!work_cpu_num)
+		return;
+
+	for (i = 0; i < work_cpu_num; i++)
+		work_cpu[i].stop = 1;
+	work_cpu_sev();
+
+	for (i = 0; i < work_cpu_num; i++) {
+		cpu = &work_cpu[i];
+		start = get_timer(0);
+		while (invoke_psci_fn(PSCI_0_2_FN64_AFFINITY_INFO, cpu->mpidr,
+				      0, 0) != PSCI_0_2_AFFINITY_LEVEL_OFF) {
+			if (get_timer(start) > WORK_CPU_TIMEOUT_MS) {
+				printf("workqueue: CPU %lx did not turn off\n",
+				       cpu->mpidr);
+				break;
+			}
+		}
+	}
+
+	/* Work queued from now on runs on the boot CPU */
+	work_cpu_num = 0;
+	work_cpu_running = 0;
+}
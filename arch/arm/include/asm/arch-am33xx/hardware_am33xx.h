@@ -68,6 +68,9 @@
 /* LCD Controller */
 #define LCD_CNTL_BASE			0x4830E000
 
+/* EDMA3 channel controller */
+#define EDMA3_BASE			0x49000000
+
 /* PWMSS */
 #define PWMSS0_BASE			0x48300000
 #define AM33XX_ECAP0_BASE		0x48300100
@@ -98,6 +98,8 @@ struct edma3_channel_config {
 
 void qedma3_start(u32 base, struct edma3_channel_config *cfg);
 void qedma3_stop(u32 base, struct edma3_channel_config *cfg);
+void edma3_start(u32 base, struct edma3_channel_config *cfg);
+void edma3_stop(u32 base, struct edma3_channel_config *cfg);
 void edma3_slot_configure(u32 base, int slot, struct edma3_slot_config *cfg);
 int edma3_check_for_transfer(u32 base, struct edma3_channel_config *cfg);
 void edma3_write_slot(u32 base, int slot, struct edma3_slot_layout *param);
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * CRC32 and CRC32C using the optional ARMv8 CRC32 instructions
+ *
+ * The instructions exist in both AArch64 and AArch32 state, so a 32-bit
+ * build running on an ARMv8 core can use them too. They work on the
+ * bit-reflected form of the CRC, like the table-based code in lib/.
+ */
+
+#include <common.h>
+#include <u-boot/crc.h>
+
+#ifdef CONFIG_ARM64
+#define CRC_ARCH	".arch_extension crc\n\t"
+#define CRC32_BYTE(crc, v)	asm(CRC_ARCH "crc32b %w0, %w0, %w1" \
+			    : "+r" (crc) : "r" (v))
+#define CRC32C_BYTE(crc, v)	asm(CRC_ARCH "crc32cb %w0, %w0, %w1" \
+			    : "+r" (crc) : "r" (v))
+#define CRC32_WORD(crc, v)	asm(CRC_ARCH "crc32x %w0, %w0, %x1" \
+			    : "+r" (crc) : "r" (v))
+#define CRC32C_WORD(crc, v)	asm(CRC_ARCH "crc32cx %w0, %w0, %x1" \
+			    : "+r" (crc) : "r" (v))
+#define CRC_WORD	u64
+#define crc_word_le(p)	le64_to_cpu(*(const u64 *)(p))
+#else
+#define CRC_ARCH	".arch armv8-a\n\t.arch_extension crc\n\t"
+#define CRC32_BYTE(crc, v)	asm(CRC_ARCH "crc32b %0, %0, %1" \
+			    : "+r" (crc) : "r" (v))
+#define CRC32C_BYTE(crc, v)	asm(CRC_ARCH "crc32cb %0, %0, %1" \
+			    : "+r" (crc) : "r" (v))
+#define CRC32_WORD(crc, v)	asm(CRC_ARCH "crc32w %0, %0, %1" \
+			    : "+r" (crc) : "r" (v))
+#define CRC32C_WORD(crc, v)	asm(CRC_ARCH "crc32cw %0, %0, %1" \
+			    : "+r" (crc) : "r" (v))
+#define CRC_WORD	u32
+#define crc_word_le(p)	le32_to_cpu(*(const u32 *)(p))
+#endif
+
+int crc32_arm_available(void)
+{
+#ifdef CONFIG_ARM64
+	u64 isar0;
+
+	asm("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+
+	return ((isar0 >> 16) & 0xf) != 0;
+#else
+	u32 isar5;
+
+	/* ID_ISAR5 reads as zero before ARMv8 */
+	asm("mrc p15, 0, %0, c0, c2, 5" : "=r" (isar5));
+
+	return ((isar5 >> 16) & 0xf) != 0;
+#endif
+}
+
+uint32_t crc32_arm(uint32_t crc, const uint8_t *buf, uint len)
+{
+	CRC_WORD word;
+	u32 byte;
+
+	for (; len && ((ulong)buf & (sizeof(word) - 1)); len--) {
+		byte = *buf++;
+		CRC32_BYTE(crc, byte);
+	}
+	for (; len >= sizeof(word); len -= sizeof(word)) {
+		word = crc_word_le(buf);
+		CRC32_WORD(crc, word);
+		buf += sizeof(word);
+	}
+	for (; len; len--) {
+		byte = *buf++;
+		CRC32_BYTE(crc, byte);
+	}
+
+	return crc;
+}
+
+uint32_t crc32c_arm(uint32_t crc, const uint8_t *buf, uint len)
+{
+	CRC_WORD word;
+	u32 byte;
+
+	for (; len && ((ulong)buf & (sizeof(word) - 1)); len--) {
+		byte = *buf++;
+		CRC32C_BYTE(crc, byte);
+	}
+	for (; len >= sizeof(word); len -= sizeof(word)) {
+		word = crc_word_le(buf);
+		CRC32C_WORD(crc, word);
+		buf += sizeof(word);
+	}
+	for (; len; len--) {
+		byte = *buf++;
+		CRC32C_BYTE(crc, byte);
+	}
+
+	return crc;
+}
@@ -21,7 +21,9 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <irq_func.h>
+#include <serial.h>
 
 __weak void reset_misc(void)
 {
@@ -30,6 +32,8 @@ __weak void reset_misc(void)
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	puts ("resetting ...\n");
+	blkcache_flush_all();
+	serial_flush();
 
 	udelay (50000);				/* wait 50 ms */
 
@@ -11,6 +11,7 @@
 #include <dm.h>
 #include <dm/root.h>
 #include <image.h>
+#include <serial.h>
 #include <asm/byteorder.h>
 #include <asm/csr.h>
 #include <asm/smp.h>
@@ -38,6 +39,7 @@ static void announce_and_cleanup(int fake)
 {
 	printf("\nStarting kernel ...%s\n\n", fake ?
 		"(fake run for tracing)" : "");
+	serial_flush();
 	bootstage_mark_name(BOOTSTAGE_ID_BOOTM_HANDOFF, "start_kernel");
 #ifdef CONFIG_BOOTSTAGE_FDT
 	bootstage_fdt_add_report();
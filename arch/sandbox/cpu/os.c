@@ -7,6 +7,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <signal.h>
 #include <setjmp.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -827,3 +829,93 @@ void *os_find_text_base(void)
 
 	return base;
 }
+
+/*
+ * A small pool of host threads used in place of secondary CPUs. The queue is
+ * a ring protected by os_work_lock; os_work_done is broadcast each time a
+ * function returns, so waiters can check their own flag.
+ */
+#define OS_WORK_QUEUE_LEN	64
+
+struct os_work {
+	void (*func)(void *arg);
+	void *arg;
+};
+
+static pthread_mutex_t os_work_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t os_work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t os_work_done = PTHREAD_COND_INITIALIZER;
+static struct os_work os_work_queue[OS_WORK_QUEUE_LEN];
+static unsigned int os_work_head, os_work_tail;
+static int os_work_threads;
+
+static void *os_work_thread(void *unused)
+{
+	struct os_work work;
+	sigset_t set;
+
+	/* Leave signal handling (e.g. Ctrl-C, SIGSEGV reporting) to main */
+	sigfillset(&set);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	pthread_mutex_lock(&os_work_lock);
+	for (;;) {
+		while (os_work_head == os_work_tail)
+			pthread_cond_wait(&os_work_ready, &os_work_lock);
+		work = os_work_queue[os_work_tail++ % OS_WORK_QUEUE_LEN];
+		pthread_mutex_unlock(&os_work_lock);
+
+		work.func(work.arg);
+
+		pthread_mutex_lock(&os_work_lock);
+		pthread_cond_broadcast(&os_work_done);
+	}
+
+	return NULL;
+}
+
+int os_work_start(int count)
+{
+	pthread_t thread;
+
+	pthread_mutex_lock(&os_work_lock);
+	while (os_work_threads < count) {
+		if (pthread_create(&thread, NULL, os_work_thread, NULL))
+			break;
+		pthread_detach(thread);
+		os_work_threads++;
+	}
+	count = os_work_threads;
+	pthread_mutex_unlock(&os_work_lock);
+
+	return count;
+}
+
+int os_work_submit(void (*func)(void *arg), void *arg)
+{
+	struct os_work *work;
+	int ret = 0;
+
+	pthread_mutex_lock(&os_work_lock);
+	if (!os_work_threads) {
+		ret = -ENODEV;
+	} else if (os_work_head - os_work_tail == OS_WORK_QUEUE_LEN) {
+		ret = -ENOSPC;
+	} else {
+		work = &os_work_queue[os_work_head++ % OS_WORK_QUEUE_LEN];
+		work->func = func;
+		work->arg = arg;
+		pthread_cond_signal(&os_work_ready);
+	}
+	pthread_mutex_unlock(&os_work_lock);
+
+	return ret;
+}
+
+void os_work_wait(volatile int *flag)
+{
+	pthread_mutex_lock(&os_work_lock);
+	while (!*flag)
+		pthread_cond_wait(&os_work_done, &os_work_lock);
+	pthread_mutex_unlock(&os_work_lock);
+}
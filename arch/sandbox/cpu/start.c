@@ -13,6 +13,7 @@
 #include <asm/io.h>
 #include <asm/sections.h>
 #include <asm/state.h>
+#include <dm/lists.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -319,6 +320,15 @@ static int sandbox_cmdline_cb_show_of_platdata(struct sandbox_state *state,
 }
 SANDBOX_CMDLINE_OPT(show_of_platdata, 0, "Show of-platdata in SPL");
 
+static int sandbox_cmdline_cb_load_fit(struct sandbox_state *state,
+				       const char *arg)
+{
+	state->load_fit_fname = arg;
+
+	return 0;
+}
+SANDBOX_CMDLINE_OPT(load_fit, 1, "Load a FIT in SPL, as a test");
+
 int board_run_command(const char *cmdline)
 {
 	printf("## Commands are disabled. Please enable CONFIG_CMDLINE.\n");
@@ -349,6 +359,9 @@ void state_show(struct sandbox_state *state)
 int main(int argc, char *argv[])
 {
 	struct sandbox_state *state;
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	void *compat;
+#endif
 	gd_t data;
 	int ret;
 
@@ -371,6 +384,12 @@ int main(int argc, char *argv[])
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
 	gd->malloc_base = CONFIG_MALLOC_F_ADDR;
 #endif
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	/* There is no reserved area before relocation, so use the host's */
+	compat = os_malloc(lists_compat_size());
+	if (compat && !lists_compat_build(compat, lists_compat_size()))
+		gd->dm_compat = compat;
+#endif
 #if CONFIG_IS_ENABLED(LOG)
 	gd->default_log_level = state->default_log_level;
 #endif
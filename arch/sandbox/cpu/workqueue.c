@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Work queue CPUs for sandbox, provided by host threads
+ */
+
+#include <common.h>
+#include <os.h>
+#include <workqueue.h>
+
+static void sandbox_work_run(void *arg)
+{
+	work_run(arg);
+}
+
+int arch_work_cpus(void)
+{
+	return os_work_start(CONFIG_SANDBOX_WORK_CPUS);
+}
+
+int arch_work_submit(struct work *work)
+{
+	if (!arch_work_cpus())
+		return -ENODEV;
+
+	return os_work_submit(sandbox_work_run, work);
+}
+
+void arch_work_wait(struct work *work)
+{
+	os_work_wait(&work->done);
+}
+
+void arch_work_stop(void)
+{
+	/* Host threads are not needed by anything else, so keep them */
+}
@@ -198,6 +198,24 @@ int sandbox_get_pch_spi_protect(struct udevice *dev);
  */
 int sandbox_get_pci_ep_irq_count(struct udevice *dev);
 
+/**
+ * sandbox_serial_set_busy() - Make the sandbox uart report that it is busy
+ *
+ * @dev: Serial device
+ * @count: Number of following putc() calls which return -EAGAIN
+ */
+void sandbox_serial_set_busy(struct udevice *dev, int count);
+
+/**
+ * sandbox_serial_get_written() - Get the number of characters written
+ *
+ * @dev: Serial device
+ * @at_changep: Returns the number of characters written when the baud rate
+ *	or line settings were last changed
+ * @return number of characters written so far
+ */
+int sandbox_serial_get_written(struct udevice *dev, int *at_changep);
+
 /**
  * sandbox_pci_read_bar() - Read the BAR value for a read_config operation
  *
@@ -13,21 +13,40 @@ static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 		     int argc, char * const argv[])
 {
 	struct block_cache_stats stats;
+	struct block_cache_dev_stats dev;
+	int i;
+
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "evictions: %u\n"
 	       "entries: %u\n"
 	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "max cache entries: %u\n"
+	       "entries/set: %u\n"
+	       "mode: %s\n",
+	       stats.hits, stats.misses, stats.evictions, stats.entries,
+	       stats.max_blocks_per_entry, stats.max_entries, stats.ways,
+	       stats.writeback ? "write-back" : "write-through");
+
+	for (i = 0; !blkcache_dev_stats(i, &dev); i++) {
+		if (!i)
+			printf("\n%-10s %8s %8s %8s %10s %10s\n", "device",
+			       "hits", "misses", "evicted", "read-ahead",
+			       "written");
+		printf("%-6s %3d %8u %8u %8u %10u %10u\n",
+		       blk_get_if_type_name(dev.iftype), dev.devnum,
+		       dev.hits, dev.misses, dev.evictions, dev.readahead,
+		       dev.writebacks);
+	}
 	return 0;
 }
 
 static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 			  int argc, char * const argv[])
 {
+	struct block_cache_stats stats;
 	unsigned blocks_per_entry, max_entries;
 	if (argc != 3)
 		return CMD_RET_USAGE;
@@ -35,14 +54,42 @@ static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
 	max_entries = simple_strtoul(argv[2], 0, 0);
 	blkcache_configure(blocks_per_entry, max_entries);
+	blkcache_stats(&stats);
 	printf("changed to max of %u entries of %u blocks each\n",
-	       max_entries, blocks_per_entry);
+	       stats.max_entries, stats.max_blocks_per_entry);
+	return 0;
+}
+
+static int blkc_flush(cmd_tbl_t *cmdtp, int flag,
+		      int argc, char * const argv[])
+{
+	if (blkcache_flush(-1, 0)) {
+		printf("failed to write back the block cache\n");
+		return CMD_RET_FAILURE;
+	}
+	return 0;
+}
+
+static int blkc_mode(cmd_tbl_t *cmdtp, int flag,
+		     int argc, char * const argv[])
+{
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	if (!strcmp(argv[1], "writeback"))
+		blkcache_set_writeback(true);
+	else if (!strcmp(argv[1], "writethrough"))
+		blkcache_set_writeback(false);
+	else
+		return CMD_RET_USAGE;
 	return 0;
 }
 
 static cmd_tbl_t cmd_blkc_sub[] = {
 	U_BOOT_CMD_MKENT(show, 0, 0, blkc_show, "", ""),
 	U_BOOT_CMD_MKENT(configure, 3, 0, blkc_configure, "", ""),
+	U_BOOT_CMD_MKENT(flush, 1, 0, blkc_flush, "", ""),
+	U_BOOT_CMD_MKENT(mode, 2, 0, blkc_mode, "", ""),
 };
 
 static __maybe_unused void blkc_reloc(void)
@@ -83,4 +130,6 @@ U_BOOT_CMD(
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
 	"blkcache configure blocks entries\n"
+	"blkcache flush - write back dirty blocks\n"
+	"blkcache mode writeback|writethrough\n"
 );
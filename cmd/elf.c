@@ -19,6 +19,7 @@
 #include <elf.h>
 #include <env.h>
 #include <net.h>
+#include <serial.h>
 #include <vxworks.h>
 #ifdef CONFIG_X86
 #include <vbe.h>
@@ -79,6 +80,7 @@ int do_bootelf(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return rcode;
 
 	printf("## Starting application at 0x%08lx ...\n", addr);
+	serial_flush();
 
 	/*
 	 * pass address parameter as argv[0] (aka command name),
@@ -282,6 +284,7 @@ int do_bootvx(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		puts("## Not an ELF image, assuming binary\n");
 
 	printf("## Starting vxWorks at 0x%08lx ...\n", addr);
+	serial_flush();
 
 	dcache_disable();
 #if defined(CONFIG_ARM64) && defined(CONFIG_ARMV8_PSCI)
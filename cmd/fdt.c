@@ -10,6 +10,7 @@
 #include <common.h>
 #include <command.h>
 #include <env.h>
+#include <fdtdec.h>
 #include <linux/ctype.h>
 #include <linux/types.h>
 #include <asm/global_data.h>
@@ -116,6 +117,9 @@ static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	if (argc < 2)
 		return CMD_RET_USAGE;
 
+	/* This may change the control FDT, so stop using its index */
+	fdtdec_index_invalidate(working_fdt);
+
 	/*
 	 * Set the address of the fdt
 	 */
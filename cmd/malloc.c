@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Show information about the malloc() pool
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <malloc_slab.h>
+
+static int do_malloc_info(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	printf("Pool: %08lx-%08lx, %lx bytes, %lx reached by sbrk\n",
+	       mem_malloc_start, mem_malloc_end,
+	       mem_malloc_end - mem_malloc_start,
+	       mem_malloc_brk - mem_malloc_start);
+	malloc_slab_info();
+
+	return 0;
+}
+
+static char malloc_help_text[] =
+	"info - show the malloc() pool and slab statistics";
+
+U_BOOT_CMD_WITH_SUBCMDS(malloc, "malloc information", malloc_help_text,
+			U_BOOT_SUBCMD_MKENT(info, 1, 1, do_malloc_info));
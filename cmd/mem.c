@@ -21,6 +21,7 @@
 #include <watchdog.h>
 #include <asm/io.h>
 #include <linux/compiler.h>
+#include <u-boot/crc.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -1068,6 +1069,53 @@ mod_mem(cmd_tbl_t *cmdtp, int incrflag, int flag, int argc, char * const argv[])
 
 #ifdef CONFIG_CMD_CRC32
 
+static void crc_bench_one(const char *what, enum crc32_backend backend,
+			  u32 crc, ulong us, ulong len)
+{
+	printf("%-7s %-12s %08x %10lu us", what, crc32_backend_name(backend),
+	       crc, us);
+	/* bytes per microsecond is MB/s */
+	if (us)
+		printf(" %6lu MB/s", len / us);
+	printf("\n");
+}
+
+static int crc_bench(ulong addr, ulong len)
+{
+	enum crc32_backend old = crc32_get_backend();
+	enum crc32_backend backend;
+	u32 crc, ref = 0;
+	const u8 *buf;
+	ulong start;
+	int ret = 0;
+
+	buf = map_sysmem(addr, len);
+	for (backend = 0; backend < CRC32_BACKEND_COUNT; backend++) {
+		if (crc32_set_backend(backend))
+			continue;
+		start = timer_get_us();
+		crc = crc32(0, buf, len);
+		crc_bench_one("crc32", backend, crc, timer_get_us() - start,
+			      len);
+		if (backend == CRC32_BACKEND_BYTE)
+			ref = crc;
+		else if (crc != ref)
+			ret = CMD_RET_FAILURE;
+#ifdef CONFIG_CRC32C
+		start = timer_get_us();
+		crc = crc32c_no_comp(~0U, buf, len) ^ ~0U;
+		crc_bench_one("crc32c", backend, crc, timer_get_us() - start,
+			      len);
+#endif
+	}
+	crc32_set_backend(old);
+	unmap_sysmem(buf);
+	if (ret)
+		printf("CRC32 backends disagree\n");
+
+	return ret;
+}
+
 static int do_mem_crc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	int flags = 0;
@@ -1079,6 +1127,12 @@ static int do_mem_crc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	av = argv + 1;
 	ac = argc - 1;
+	if (strcmp(*av, "-b") == 0) {
+		if (ac != 3)
+			return CMD_RET_USAGE;
+		return crc_bench(simple_strtoul(av[1], NULL, 16),
+				 simple_strtoul(av[2], NULL, 16));
+	}
 #ifdef CONFIG_CRC32_VERIFY
 	if (strcmp(*av, "-v") == 0) {
 		flags |= HASH_FLAG_VERIFY | HASH_FLAG_ENV;
@@ -1205,7 +1259,8 @@ U_BOOT_CMD(
 U_BOOT_CMD(
 	crc32,	4,	1,	do_mem_crc,
 	"checksum calculation",
-	"address count [addr]\n    - compute CRC32 checksum [save at addr]"
+	"address count [addr]\n    - compute CRC32 checksum [save at addr]\n"
+	"-b address count\n    - benchmark the CRC32 backends"
 );
 
 #else	/* CONFIG_CRC32_VERIFY */
@@ -1214,7 +1269,8 @@ U_BOOT_CMD(
 	crc32,	5,	1,	do_mem_crc,
 	"checksum calculation",
 	"address count [addr]\n    - compute CRC32 checksum [save at addr]\n"
-	"-v address count crc\n    - verify crc of memory area"
+	"-v address count crc\n    - verify crc of memory area\n"
+	"-b address count\n    - benchmark the CRC32 backends"
 );
 
 #endif	/* CONFIG_CRC32_VERIFY */
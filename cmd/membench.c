@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Benchmark memcpy, memmove and memset over a range of sizes
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <mapmem.h>
+#include <watchdog.h>
+#include <div64.h>
+
+/* Bytes moved per size and operation unless a count is given */
+#define MEMBENCH_TOTAL	(16 << 20)
+
+enum membench_op {
+	MEMBENCH_MEMCPY,
+	MEMBENCH_MEMMOVE,
+	MEMBENCH_MEMSET,
+
+	MEMBENCH_OP_COUNT,
+};
+
+static const char *const membench_op_name[MEMBENCH_OP_COUNT] = {
+	"memcpy", "memmove", "memset",
+};
+
+static void membench_run(enum membench_op op, char *buf, ulong len,
+			 ulong count)
+{
+	ulong i;
+
+	switch (op) {
+	case MEMBENCH_MEMCPY:
+		for (i = 0; i < count; i++)
+			memcpy(buf + len, buf, len);
+		break;
+	case MEMBENCH_MEMMOVE:
+		/* Overlapping move towards higher addresses */
+		for (i = 0; i < count; i++)
+			memmove(buf + 8, buf, len);
+		break;
+	case MEMBENCH_MEMSET:
+		for (i = 0; i < count; i++)
+			memset(buf, i, len);
+		break;
+	default:
+		break;
+	}
+}
+
+static void membench_print(ulong len, enum membench_op op, u64 bytes,
+			   ulong us, ulong cycles)
+{
+	u64 rate;
+
+	printf("%8lu  %-8s", len, membench_op_name[op]);
+	rate = bytes;
+	do_div(rate, us ? us : 1);
+	printf("  %8llu MB/s", rate);
+	if (cycles) {
+		rate = bytes * 100;
+		do_div(rate, cycles);
+		printf("  %4llu.%02llu bytes/cycle", rate / 100, rate % 100);
+	}
+	printf("\n");
+}
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	ulong addr, size, len, count = 0;
+	enum membench_op op;
+	char *buf;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+
+	addr = simple_strtoul(argv[1], NULL, 16);
+	size = simple_strtoul(argv[2], NULL, 16);
+	if (argc > 3)
+		count = simple_strtoul(argv[3], NULL, 10);
+	if (size < 16)
+		return CMD_RET_USAGE;
+
+	/* memcpy uses a destination right after the source */
+	buf = map_sysmem(addr, 2 * size);
+	memset(buf, 0xa5, 2 * size);
+
+	printf("    size  op             rate\n");
+	for (len = 16; len <= size; len *= 4) {
+		ulong n = count ? count : max(MEMBENCH_TOTAL / len, 1UL);
+
+		for (op = 0; op < MEMBENCH_OP_COUNT; op++) {
+			ulong start_us, start_cycles, us, cycles;
+
+			start_us = timer_get_us();
+			start_cycles = get_cpu_cycles();
+			membench_run(op, buf, len, n);
+			cycles = get_cpu_cycles() - start_cycles;
+			us = timer_get_us() - start_us;
+			membench_print(len, op, (u64)len * n, us, cycles);
+
+			WATCHDOG_RESET();
+			if (ctrlc()) {
+				unmap_sysmem(buf);
+				return CMD_RET_FAILURE;
+			}
+		}
+	}
+	unmap_sysmem(buf);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	membench,	4,	0,	do_membench,
+	"benchmark memcpy, memmove and memset",
+	"addr size [count]\n"
+	"    - run each operation on sizes from 16 bytes up to 'size' (hex),\n"
+	"      using 2 * 'size' bytes of scratch memory at 'addr'. Each size\n"
+	"      is repeated 'count' times, by default enough to move 16MiB"
+);
@@ -7,8 +7,11 @@
 #include <common.h>
 #include <command.h>
 #include <console.h>
+#include <div64.h>
+#include <memalign.h>
 #include <mmc.h>
 #include <sparse_format.h>
+#include <u-boot/crc.h>
 #include <image-sparse.h>
 
 static int curr_device = -1;
@@ -104,13 +107,19 @@ static struct mmc *init_mmc_device(int dev, bool force_init)
 	if (!mmc_getcd(mmc))
 		force_init = true;
 
+#ifdef CONFIG_BLOCK_CACHE
+	struct blk_desc *bd = mmc_get_blk_desc(mmc);
+
+	/* Write back before the card goes back to its user partition */
+	if (force_init && mmc->has_init)
+		blkcache_flush(bd->if_type, bd->devnum);
+#endif
 	if (force_init)
 		mmc->has_init = 0;
 	if (mmc_init(mmc))
 		return NULL;
 
 #ifdef CONFIG_BLOCK_CACHE
-	struct blk_desc *bd = mmc_get_blk_desc(mmc);
 	blkcache_invalidate(bd->if_type, bd->devnum);
 #endif
 
@@ -317,6 +326,92 @@ static int do_mmc_read(cmd_tbl_t *cmdtp, int flag,
 	return (n == cnt) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
 }
 
+#if CONFIG_IS_ENABLED(MMC_QUEUE)
+static void mmc_bench_print(const char *name, lbaint_t cnt, ulong us, u32 crc)
+{
+	u64 kib_s = (u64)cnt * 512 * 1000000 / 1024;
+
+	do_div(kib_s, us ? us : 1);
+	printf("%-10s %8lu us %8llu KiB/s  crc32 %08x\n", name, us, kib_s,
+	       crc);
+}
+
+static int do_mmc_bench(cmd_tbl_t *cmdtp, int flag,
+			int argc, char * const argv[])
+{
+	struct blk_desc *desc;
+	struct mmc_queue q;
+	lbaint_t blk, cnt, chunk, left, n;
+	ulong start;
+	void *buf[2], *data;
+	u32 crc;
+	int ret = CMD_RET_FAILURE;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+
+	blk = simple_strtoul(argv[1], NULL, 16);
+	cnt = simple_strtoul(argv[2], NULL, 16);
+	chunk = argc > 3 ? simple_strtoul(argv[3], NULL, 16) : 0x800;
+	if (!cnt || !chunk)
+		return CMD_RET_USAGE;
+
+	if (!init_mmc_device(curr_device, false))
+		return CMD_RET_FAILURE;
+	desc = blk_get_devnum_by_type(IF_TYPE_MMC, curr_device);
+	if (!desc || desc->blksz != 512)
+		return CMD_RET_FAILURE;
+
+	buf[0] = malloc_cache_aligned(chunk * 512);
+	buf[1] = malloc_cache_aligned(chunk * 512);
+	if (!buf[0] || !buf[1]) {
+		puts("Out of memory\n");
+		goto out;
+	}
+
+	printf("MMC bench: dev # %d, block # " LBAF ", count " LBAF
+	       ", chunk " LBAF "\n", curr_device, blk, cnt, chunk);
+
+	/* One buffer: each chunk is read, then consumed */
+	crc = 0;
+	start = timer_get_us();
+	for (left = cnt; left; left -= n) {
+		n = min(left, chunk);
+		if (blk_dread(desc, blk + cnt - left, n, buf[0]) != n) {
+			puts("Read error\n");
+			goto out;
+		}
+		crc = crc32(crc, buf[0], n * 512);
+	}
+	mmc_bench_print("read", cnt, timer_get_us() - start, crc);
+
+	/* Two buffers: the next chunk is read while this one is consumed */
+	crc = 0;
+	start = timer_get_us();
+	if (mmc_queue_start(&q, desc, blk, cnt, buf[0], buf[1], chunk)) {
+		puts("Read error\n");
+		goto out;
+	}
+	do {
+		if (mmc_queue_next(&q, &data, &n)) {
+			puts("Read error\n");
+			mmc_queue_stop(&q);
+			goto out;
+		}
+		crc = crc32(crc, data, n * 512);
+	} while (n);
+	mmc_queue_stop(&q);
+	mmc_bench_print("queued", cnt, timer_get_us() - start, crc);
+	ret = CMD_RET_SUCCESS;
+
+out:
+	free(buf[0]);
+	free(buf[1]);
+
+	return ret;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(CMD_MMC_SWRITE)
 static lbaint_t mmc_sparse_write(struct sparse_storage *info, lbaint_t blk,
 				 lbaint_t blkcnt, const void *buffer)
@@ -875,6 +970,9 @@ static int do_mmc_bkops_enable(cmd_tbl_t *cmdtp, int flag,
 static cmd_tbl_t cmd_mmc[] = {
 	U_BOOT_CMD_MKENT(info, 1, 0, do_mmcinfo, "", ""),
 	U_BOOT_CMD_MKENT(read, 4, 1, do_mmc_read, "", ""),
+#if CONFIG_IS_ENABLED(MMC_QUEUE)
+	U_BOOT_CMD_MKENT(bench, 4, 0, do_mmc_bench, "", ""),
+#endif
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	U_BOOT_CMD_MKENT(write, 4, 0, do_mmc_write, "", ""),
 	U_BOOT_CMD_MKENT(erase, 3, 0, do_mmc_erase, "", ""),
@@ -935,6 +1033,9 @@ U_BOOT_CMD(
 	"MMC sub system",
 	"info - display info of the current MMC device\n"
 	"mmc read addr blk# cnt\n"
+#if CONFIG_IS_ENABLED(MMC_QUEUE)
+	"mmc bench blk# cnt [chunk] - time plain and queued reads\n"
+#endif
 	"mmc write addr blk# cnt\n"
 #if CONFIG_IS_ENABLED(CMD_MMC_SWRITE)
 	"mmc swrite addr blk#\n"
@@ -26,6 +26,7 @@
 #include <env.h>
 #include <watchdog.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <asm/byteorder.h>
 #include <jffs2/jffs2.h>
 #include <nand.h>
@@ -555,7 +556,7 @@ static int do_nand(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		if (argc < 4)
 			goto usage;
 
-		addr = (ulong)simple_strtoul(argv[2], NULL, 16);
+		addr = (ulong)map_sysmem(simple_strtoul(argv[2], NULL, 16), 0);
 
 		read = strncmp(cmd, "read", 4) == 0; /* 1 = read, 0 = write */
 		printf("\nNAND %s: ", read ? "read" : "write");
@@ -727,6 +728,35 @@ static int do_nand(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return ret;
 	}
 
+#ifdef CONFIG_NAND_BBT_CACHE
+	if (strcmp(cmd, "bbtcache") == 0) {
+		if (argc < 3)
+			goto usage;
+		if (!strcmp(argv[2], "info")) {
+			ret = nand_bbt_cache_unchecked(mtd);
+			if (ret < 0)
+				puts("Bad block table built by scanning the device\n");
+			else
+				printf("Bad block table restored from the cache, %d blocks not checked yet\n",
+				       ret);
+			return 0;
+		} else if (!strcmp(argv[2], "drop")) {
+			ret = nand_bbt_cache_drop(mtd);
+		} else if (!strcmp(argv[2], "rebuild")) {
+			ret = nand_bbt_cache_rebuild(mtd);
+		} else if (!strcmp(argv[2], "reload")) {
+			ret = nand_bbt_cache_reload(mtd);
+		} else {
+			goto usage;
+		}
+		if (ret) {
+			printf("Bad block cache %s failed: %d\n", argv[2], ret);
+			return 1;
+		}
+		return 0;
+	}
+#endif
+
 	if (strcmp(cmd, "biterr") == 0) {
 		/* todo */
 		return 1;
@@ -812,6 +842,12 @@ static char nand_help_text[] =
 	"nand erase.part [clean] partition - erase entire mtd partition'\n"
 	"nand erase.chip [clean] - erase entire chip'\n"
 	"nand bad - show bad blocks\n"
+#ifdef CONFIG_NAND_BBT_CACHE
+	"nand bbtcache drop|rebuild - forget the stored bad block cache,\n"
+	"    or scan the device and store a new one\n"
+	"nand bbtcache reload - build the bad block table from the stored cache\n"
+	"nand bbtcache info - show whether the bad block cache was used\n"
+#endif
 	"nand dump[.oob] off - dump page\n"
 #ifdef CONFIG_CMD_NAND_TORTURE
 	"nand torture off - torture one block at offset\n"
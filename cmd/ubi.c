@@ -47,6 +47,18 @@ static void display_volume_info(struct ubi_device *ubi)
 	}
 }
 
+static int count_eba_tables(struct ubi_device *ubi)
+{
+	int i, count = 0;
+
+	for (i = 0; i < ubi->vtbl_slots + UBI_INT_VOL_COUNT; i++) {
+		if (ubi->volumes[i] && ubi->volumes[i]->eba_tbl)
+			count++;
+	}
+
+	return count;
+}
+
 static void display_ubi_info(struct ubi_device *ubi)
 {
 	ubi_msg("MTD device name:            \"%s\"", ubi->mtd->name);
@@ -70,6 +82,16 @@ static void display_ubi_info(struct ubi_device *ubi)
 	ubi_msg("number of PEBs reserved for bad PEB handling: %d",
 			ubi->beb_rsvd_pebs);
 	ubi_msg("max/mean erase counter: %d/%d", ubi->max_ec, ubi->mean_ec);
+	ubi_msg("attach time:                %lu us",
+		ubi->attach_us.scan + ubi->attach_us.vtbl + ubi->attach_us.wl +
+		ubi->attach_us.eba + ubi->attach_us.works);
+	ubi_msg("  scan/fastmap: %lu us, volume table: %lu us",
+		ubi->attach_us.scan, ubi->attach_us.vtbl);
+	ubi_msg("  WL: %lu us, EBA: %lu us, works: %lu us",
+		ubi->attach_us.wl, ubi->attach_us.eba, ubi->attach_us.works);
+	ubi_msg("EBA tables built:           %d of %d%s, %lu us after attach",
+		count_eba_tables(ubi), ubi->vol_count,
+		ubi->lazy_ai ? " (lazy)" : "", ubi->lazy_eba_us);
 }
 
 static int ubi_info(int layout)
@@ -447,6 +447,24 @@ static int reserve_trace(void)
 	return 0;
 }
 
+#ifdef CONFIG_LOG_BINARY
+/*
+ * Nothing above reserves the binary log, which is at a fixed address, so
+ * warn if it ended up in what was reserved
+ */
+static int check_log_binary(void)
+{
+	ulong start = CONFIG_LOG_BINARY_ADDR;
+	ulong end = start + CONFIG_LOG_BINARY_SIZE;
+
+	if (end > gd->start_addr_sp && start < gd->ram_top)
+		printf("Warning: binary log at %08lx overlaps memory reserved above %08lx\n",
+		       start, gd->start_addr_sp);
+
+	return 0;
+}
+#endif
+
 static int reserve_uboot(void)
 {
 	if (!(gd->flags & GD_FLG_SKIP_RELOC)) {
@@ -556,6 +574,22 @@ static int reserve_fdt(void)
 	return 0;
 }
 
+static int reserve_fdt_index(void)
+{
+#if CONFIG_IS_ENABLED(OF_INDEX)
+	int size = fdtdec_index_size();
+
+	if (size) {
+		gd->start_addr_sp -= ALIGN(size, 16);
+		gd->new_fdt_index = map_sysmem(gd->start_addr_sp, size);
+		debug("Reserving %#x Bytes for FDT index at: %08lx\n", size,
+		      gd->start_addr_sp);
+	}
+#endif
+
+	return 0;
+}
+
 static int reserve_bootstage(void)
 {
 #ifdef CONFIG_BOOTSTAGE
@@ -687,6 +721,18 @@ static int reloc_fdt(void)
 	return 0;
 }
 
+static int reloc_fdt_index(void)
+{
+#if CONFIG_IS_ENABLED(OF_INDEX)
+	if (gd->flags & GD_FLG_SKIP_RELOC)
+		return 0;
+	if (gd->new_fdt_index)
+		fdtdec_index_relocate(gd->new_fdt_index);
+#endif
+
+	return 0;
+}
+
 static int reloc_bootstage(void)
 {
 #ifdef CONFIG_BOOTSTAGE
@@ -745,6 +791,10 @@ static int setup_reloc(void)
 #endif
 #endif
 	memcpy(gd->new_gd, (char *)gd, sizeof(gd_t));
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	/* The slab area may not survive relocation; mem_malloc_init() sets it */
+	gd->new_gd->malloc_slab = NULL;
+#endif
 
 	debug("Relocation Offset is: %08lx\n", gd->reloc_off);
 	debug("Relocating to %08lx, new gd at %08lx, sp at %08lx\n",
@@ -757,6 +807,8 @@ static int setup_reloc(void)
 #ifdef CONFIG_OF_BOARD_FIXUP
 static int fix_fdt(void)
 {
+	fdtdec_index_invalidate(gd->fdt_blob);
+
 	return board_fix_fdt((void *)gd->fdt_blob);
 }
 #endif
@@ -971,10 +1023,14 @@ static const init_fnc_t init_sequence_f[] = {
 	setup_machine,
 	reserve_global_data,
 	reserve_fdt,
+	reserve_fdt_index,
 	reserve_bootstage,
 	reserve_bloblist,
 	reserve_arch,
 	reserve_stacks,
+#ifdef CONFIG_LOG_BINARY
+	check_log_binary,
+#endif
 	dram_init_banksize,
 	show_dram_config,
 #if defined(CONFIG_M68K) || defined(CONFIG_MIPS) || defined(CONFIG_PPC) || \
@@ -991,6 +1047,7 @@ static const init_fnc_t init_sequence_f[] = {
 #endif
 	INIT_FUNC_WATCHDOG_RESET
 	reloc_fdt,
+	reloc_fdt_index,
 	reloc_bootstage,
 	reloc_bloblist,
 	setup_reloc,
@@ -303,6 +303,10 @@ static int initr_dm(void)
 	/* Save the pre-reloc driver model and start a new one */
 	gd->dm_root_f = gd->dm_root;
 	gd->dm_root = NULL;
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	/* The pre-relocation table may be overwritten, so build a new one */
+	gd->dm_compat = NULL;
+#endif
 #ifdef CONFIG_TIMER
 	gd->timer = NULL;
 #endif
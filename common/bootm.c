@@ -6,6 +6,7 @@
 
 #ifndef USE_HOSTCC
 #include <common.h>
+#include <blk.h>
 #include <bootstage.h>
 #include <cpu_func.h>
 #include <env.h>
@@ -15,6 +16,7 @@
 #include <lmb.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <serial.h>
 #include <asm/io.h>
 #if defined(CONFIG_CMD_USB)
 #include <usb.h>
@@ -59,6 +61,11 @@ static void boot_start_lmb(bootm_headers_t *images)
 
 	lmb_init_and_reserve_range(&images->lmb, (phys_addr_t)mem_start,
 				   mem_size, NULL);
+#ifdef CONFIG_LOG_BINARY
+	/* Do not load anything over the log, which the OS may want to read */
+	lmb_reserve(&images->lmb, CONFIG_LOG_BINARY_ADDR,
+		    CONFIG_LOG_BINARY_SIZE);
+#endif
 }
 #else
 #define lmb_reserve(lmb, base, size)
@@ -354,9 +361,18 @@ static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
-	err = image_decomp(os.comp, load, os.image_start, os.type,
-			   load_buf, image_buf, image_len,
-			   CONFIG_SYS_BOOTM_LEN, &load_end);
+#if IMAGE_ENABLE_FIT
+	if (images->fit_hdr_os)
+		err = fit_image_decomp(images->fit_hdr_os,
+				       images->fit_noffset_os, os.comp, load,
+				       os.image_start, os.type, load_buf,
+				       image_buf, image_len,
+				       CONFIG_SYS_BOOTM_LEN, &load_end);
+	else
+#endif
+		err = image_decomp(os.comp, load, os.image_start, os.type,
+				   load_buf, image_buf, image_len,
+				   CONFIG_SYS_BOOTM_LEN, &load_end);
 	if (err) {
 		err = handle_decomp_error(os.comp, load_end - load, err);
 		bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
@@ -407,6 +423,10 @@ ulong bootm_disable_interrupts(void)
 {
 	ulong iflag;
 
+	/* Nothing writes the block cache or the serial buffer after this */
+	blkcache_flush_all();
+	serial_flush();
+
 	/*
 	 * We have reached the point of no return: we are going to
 	 * overwrite all exception vector code, so we cannot easily
@@ -136,6 +136,7 @@ int do_run(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			return 1;
 		}
 
+		hush_cache_watch(argv[i]);
 		if (run_command(arg, flag | CMD_FLAG_ENV) != 0)
 			return 1;
 	}
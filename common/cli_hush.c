@@ -479,7 +479,9 @@ static int parse_string(o_string *dest, struct p_context *ctx, const char *src);
 #endif
 static int parse_stream(o_string *dest, struct p_context *ctx, struct in_str *input0, int end_trigger);
 /*   setup: */
-static int parse_stream_outer(struct in_str *inp, int flag);
+struct hush_script;
+static int parse_stream_outer(struct in_str *inp, int flag,
+			      struct hush_script *sc);
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag);
 static int parse_file_outer(FILE *f);
@@ -1541,6 +1543,7 @@ static int run_pipe_real(struct pipe *pi)
 	struct child_prog *child;
 	struct built_in_command *x;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1553,6 +1556,7 @@ static int run_pipe_real(struct pipe *pi)
 	int flag = do_repeat ? CMD_FLAG_REPEAT : 0;
 	struct child_prog *child;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1619,6 +1623,8 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/* Count substitutions left without changing the parsed pipe */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1627,11 +1633,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1761,7 +1767,6 @@ static int run_pipe_real(struct pipe *pi)
 
 static int run_list_real(struct pipe *pi)
 {
-	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
 	struct pipe *rpipe;
@@ -1832,31 +1837,23 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
-				save_name = pi->progs->argv[0];
-				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
 			}
 			if (!(*list)) {
-				free(pi->progs->argv[0]);
 				free(save_list);
 				list = NULL;
 				flag_rep = 0;
-				pi->progs->argv[0] = save_name;
-#ifndef __U_BOOT__
-				pi->progs->glob_result.gl_pathv[0] =
-					pi->progs->argv[0];
-#endif
 				continue;
-			} else {
-				/* insert new value from list for variable */
-				if (pi->progs->argv[0])
-					free(pi->progs->argv[0]);
-				pi->progs->argv[0] = *list++;
-#ifndef __U_BOOT__
-				pi->progs->glob_result.gl_pathv[0] =
-					pi->progs->argv[0];
-#endif
 			}
+			/*
+			 * Assign the next value here rather than by running
+			 * the pipe, which must stay as parsed since it may be
+			 * run again
+			 */
+			set_local_var(*list, 0);
+			free(*list++);
+			rcode = last_return_code = 0;
+			continue;
 		}
 		if (rmode == RES_IN) continue;
 		if (rmode == RES_DO) {
@@ -3180,9 +3177,197 @@ static void update_ifs_map(void)
 	mapset(ifs, 2);            /* also flow through if quoted */
 }
 
+#ifdef CONFIG_HUSH_CACHE
+/*
+ * Scripts which run again and again, such as the targets of 'run' in a loop,
+ * are only parsed once. Like parse_stream_outer(), a script is parsed one
+ * statement at a time, just before the statement runs, and the pipe list of
+ * each statement is kept so that the next run of the same text goes straight
+ * to run_list_real(). Parsing does not depend on the values of variables,
+ * which are substituted when a statement runs, so the text is the only key.
+ */
+struct hush_stmt {
+	struct pipe *list;	/* parsed statement */
+	int end;		/* offset of the text following it */
+	int rcode;		/* return value of parse_stream() */
+};
+
+struct hush_script {
+	struct hush_script *next;	/* most recently used first */
+	char *text;		/* as parsed, see parse_string_outer() */
+	int len;		/* length of the text it was run from */
+	uint hash;
+	int flag;
+	int users;		/* number of times it is running */
+	int count;		/* statements parsed so far */
+	int alloc;
+	struct hush_stmt *stmt;
+};
+
+static struct hush_script *hush_cache;
+
+static uint hush_cache_hash(const char *s, int *lenp)
+{
+	const char *p;
+	uint hash = 2166136261U;
+
+	for (p = s; *p; p++)
+		hash = (hash ^ (uchar)*p) * 16777619U;
+	*lenp = p - s;
+
+	return hash;
+}
+
+static bool hush_cache_match(struct hush_script *sc, const char *s, int len,
+			     uint hash)
+{
+	return sc->hash == hash && sc->len == len &&
+		!memcmp(sc->text, s, len);
+}
+
+static void hush_cache_free(struct hush_script *sc)
+{
+	int i;
+
+	for (i = 0; i < sc->count; i++)
+		free_pipe_list(sc->stmt[i].list, 0);
+	free(sc->stmt);
+	free(sc->text);
+	free(sc);
+}
+
+/* Find or add the script for @s, which is then in use until hush_cache_put() */
+static struct hush_script *hush_cache_get(const char *s, int flag)
+{
+	struct hush_script *sc, **scp;
+	const char *p;
+	uint hash;
+	int len, n;
+
+	/* The parser follows $IFS, which is very rarely set */
+	if (env_get("IFS"))
+		return NULL;
+
+	hash = hush_cache_hash(s, &len);
+	for (scp = &hush_cache; (sc = *scp); scp = &sc->next) {
+		if (sc->flag == flag && hush_cache_match(sc, s, len, hash)) {
+			*scp = sc->next;
+			goto found;
+		}
+	}
+
+	sc = calloc(1, sizeof(*sc));
+	if (!sc)
+		return NULL;
+	/* Add a newline as parse_string_outer() does */
+	sc->text = malloc(len + 2);
+	if (!sc->text) {
+		free(sc);
+		return NULL;
+	}
+	strcpy(sc->text, s);
+	p = strchr(s, '\n');
+	if (!p || p[1])
+		strcat(sc->text, "\n");
+	sc->len = len;
+	sc->hash = hash;
+	sc->flag = flag;
+
+	/* Drop the least recently used scripts which are not running */
+	for (n = 1, scp = &hush_cache; (sc->next = *scp);) {
+		if (n < CONFIG_HUSH_CACHE_ENTRIES || sc->next->users) {
+			n++;
+			scp = &sc->next->next;
+		} else {
+			*scp = sc->next->next;
+			hush_cache_free(sc->next);
+		}
+	}
+found:
+	sc->next = hush_cache;
+	hush_cache = sc;
+	sc->users++;
+
+	return sc;
+}
+
+static void hush_cache_put(struct hush_script *sc)
+{
+	struct hush_script **scp;
+
+	if (--sc->users)
+		return;
+
+	/* A script which was dropped while running is no longer in the list */
+	for (scp = &hush_cache; *scp; scp = &(*scp)->next) {
+		if (*scp == sc)
+			return;
+	}
+	hush_cache_free(sc);
+}
+
+/*
+ * Keep the pipe list of the next statement of @sc. Returns false if there is
+ * no memory, in which case the caller still owns the list.
+ */
+static bool hush_cache_add(struct hush_script *sc, struct p_context *ctx,
+			   struct in_str *inp, int rcode)
+{
+	struct hush_stmt *stmt;
+
+	if (sc->count == sc->alloc) {
+		stmt = realloc(sc->stmt, (sc->alloc + 4) * sizeof(*stmt));
+		if (!stmt)
+			return false;
+		sc->stmt = stmt;
+		sc->alloc += 4;
+	}
+	stmt = &sc->stmt[sc->count++];
+	stmt->list = ctx->list_head;
+	stmt->end = inp->p - sc->text;
+	stmt->rcode = rcode;
+
+	return true;
+}
+
+/* Drop the scripts run from the old value of a variable about to change */
+static int on_hushcache(const char *name, const char *value, enum env_op op,
+			int flags)
+{
+	struct hush_script *sc, **scp;
+	const char *old;
+	uint hash;
+	int len;
+
+	old = env_get(name);
+	if (!old)
+		return 0;
+
+	hash = hush_cache_hash(old, &len);
+	for (scp = &hush_cache; (sc = *scp);) {
+		if (hush_cache_match(sc, old, len, hash)) {
+			*scp = sc->next;
+			if (!sc->users)
+				hush_cache_free(sc);
+		} else {
+			scp = &sc->next;
+		}
+	}
+
+	return 0;
+}
+U_BOOT_ENV_CALLBACK(hushcache, on_hushcache);
+
+void hush_cache_watch(const char *name)
+{
+	env_callback_bind(name, "hushcache");
+}
+#endif /* CONFIG_HUSH_CACHE */
+
 /* most recursion does not come through here, the exeception is
  * from builtin_source() */
-static int parse_stream_outer(struct in_str *inp, int flag)
+static int parse_stream_outer(struct in_str *inp, int flag,
+			      struct hush_script *sc)
 {
 
 	struct p_context ctx;
@@ -3190,8 +3375,21 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 	int rcode;
 #ifdef __U_BOOT__
 	int code = 1;
+#endif
+#ifdef CONFIG_HUSH_CACHE
+	int next = 0;
 #endif
 	do {
+#ifdef CONFIG_HUSH_CACHE
+		if (sc && next < sc->count) {
+			struct hush_stmt *stmt = &sc->stmt[next++];
+
+			ctx.list_head = stmt->list;
+			inp->p = sc->text + stmt->end;
+			rcode = stmt->rcode;
+			goto run;
+		}
+#endif
 		ctx.type = flag;
 		initialize_context(&ctx);
 		update_ifs_map();
@@ -3211,6 +3409,19 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 		if (rcode != 1 && ctx.old_flag == 0) {
 			done_word(&temp, &ctx);
 			done_pipe(&ctx,PIPE_SEQ);
+#ifdef CONFIG_HUSH_CACHE
+			if (sc && next == sc->count) {
+				/* Otherwise run_list() frees the statement */
+				if (hush_cache_add(sc, &ctx, inp, rcode))
+					next++;
+				else
+					sc = NULL;
+			}
+run:
+			if (sc && next <= sc->count)
+				code = run_list_real(ctx.list_head);
+			else
+#endif
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
@@ -3229,6 +3440,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 			    flag_repeat = 0;
 #endif
 		} else {
+#ifdef CONFIG_HUSH_CACHE
+			/* Statements after a syntax error are not kept */
+			sc = NULL;
+#endif
 			if (ctx.old_flag != 0) {
 				free(ctx.stack);
 				b_reset(&temp);
@@ -3263,22 +3478,34 @@ int parse_string_outer(const char *s, int flag)
 #ifdef __U_BOOT__
 	char *p = NULL;
 	int rcode;
+#ifdef CONFIG_HUSH_CACHE
+	struct hush_script *sc;
+#endif
 	if (!s)
 		return 1;
 	if (!*s)
 		return 0;
+#ifdef CONFIG_HUSH_CACHE
+	sc = hush_cache_get(s, flag);
+	if (sc) {
+		setup_string_in_str(&input, sc->text);
+		rcode = parse_stream_outer(&input, flag, sc);
+		hush_cache_put(sc);
+		return rcode;
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
 		strcat(p, "\n");
 		setup_string_in_str(&input, p);
-		rcode = parse_stream_outer(&input, flag);
+		rcode = parse_stream_outer(&input, flag, NULL);
 		free(p);
 		return rcode;
 	} else {
 #endif
 	setup_string_in_str(&input, s);
-	return parse_stream_outer(&input, flag);
+	return parse_stream_outer(&input, flag, NULL);
 #ifdef __U_BOOT__
 	}
 #endif
@@ -3297,7 +3524,7 @@ int parse_file_outer(void)
 #else
 	setup_file_in_str(&input);
 #endif
-	rcode = parse_stream_outer(&input, FLAG_PARSE_SEMICOLON);
+	rcode = parse_stream_outer(&input, FLAG_PARSE_SEMICOLON, NULL);
 	return rcode;
 }
 
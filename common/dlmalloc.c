@@ -5,6 +5,7 @@
 #endif
 
 #include <malloc.h>
+#include <malloc_slab.h>
 #include <asm/io.h>
 
 #ifdef DEBUG
@@ -610,6 +611,9 @@ void mem_malloc_init(ulong start, ulong size)
 	memset((void *)mem_malloc_start, 0x0, size);
 #endif
 	malloc_bin_reloc();
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	malloc_slab_init(CONFIG_SYS_MALLOC_SLAB_LEN);
+#endif
 }
 
 /* field-extraction macros */
@@ -1254,6 +1258,12 @@ Void_t* mALLOc(bytes) size_t bytes;
 
   INTERNAL_SIZE_T nb;
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	Void_t *mem = malloc_slab_alloc(bytes);
+
+	if (mem)
+		return mem;
+#endif
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
 	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
 		return malloc_simple(bytes);
@@ -1522,6 +1532,10 @@ void fREe(mem) Void_t* mem;
   mchunkptr fwd;       /* misc temp for linking */
   int       islr;      /* track whether merging with last_remainder */
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	if (malloc_slab_free(mem))
+		return;
+#endif
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
 	/* free() is a no-op - all the memory will be freed on relocation */
 	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
@@ -1682,6 +1696,10 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
   /* realloc of null is supposed to be same as malloc */
   if (oldmem == NULL) return mALLOc(bytes);
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	if (malloc_slab_usable_size(oldmem))
+		return malloc_slab_realloc(oldmem, bytes);
+#endif
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
 	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
 		/* This is harder to support and should not be needed */
@@ -1901,6 +1919,15 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
 
   if (alignment <= MALLOC_ALIGNMENT) return mALLOc(bytes);
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	/* The chunk is split below, so it must not come from the slab area */
+	if (malloc_slab_set_enabled(false)) {
+		m = mEMALIGn(alignment, bytes);
+		malloc_slab_set_enabled(true);
+		return m;
+	}
+#endif
+
   /* Otherwise, ensure that it is at least a minimum chunk size */
 
   if (alignment <  MINSIZE) alignment = MINSIZE;
@@ -2084,6 +2111,12 @@ Void_t* cALLOc(n, elem_size) size_t n; size_t elem_size;
     return NULL;
   else
   {
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	if (malloc_slab_usable_size(mem)) {
+		memset(mem, 0, sz);
+		return mem;
+	}
+#endif
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
 	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
 		memset(mem, 0, sz);
@@ -2237,6 +2270,10 @@ size_t malloc_usable_size(mem) Void_t* mem;
   mchunkptr p;
   if (mem == NULL)
     return 0;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  else if (malloc_slab_usable_size(mem))
+    return malloc_slab_usable_size(mem);
+#endif
   else
   {
     p = mem2chunk(mem);
@@ -2336,8 +2373,16 @@ void malloc_stats()
 #ifdef DEBUG
 struct mallinfo mALLINFo()
 {
+  struct mallinfo info;
+
   malloc_update_mallinfo();
-  return current_mallinfo;
+  info = current_mallinfo;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  /* Count the objects in the slab area rather than the area itself */
+  info.uordblks -= malloc_slab_unused();
+  info.fordblks += malloc_slab_unused();
+#endif
+  return info;
 }
 #endif	/* DEBUG */
 
@@ -2389,6 +2434,9 @@ int initf_malloc(void)
 	assert(gd->malloc_base);	/* Set up by crt0.S */
 	gd->malloc_limit = CONFIG_VAL(SYS_MALLOC_F_LEN);
 	gd->malloc_ptr = 0;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	malloc_slab_init(CONFIG_SYS_MALLOC_SLAB_F_LEN);
+#endif
 #endif
 
 	return 0;
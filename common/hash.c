@@ -16,6 +16,7 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <hw_sha.h>
+#include <image.h>
 #include <asm/io.h>
 #include <linux/errno.h>
 #include <u-boot/crc.h>
@@ -26,6 +27,7 @@
 #endif /* !USE_HOSTCC*/
 
 #include <hash.h>
+#include <watchdog.h>
 #include <u-boot/crc.h>
 #include <u-boot/sha1.h>
 #include <u-boot/sha256.h>
@@ -278,7 +280,130 @@ int hash_progressive_lookup_algo(const char *algo_name,
 	return -EPROTONOSUPPORT;
 }
 
+int hash_stream_start(struct hash_stream *hs, const char *algo_name)
+{
+	int ret;
+
+	hs->ctx = NULL;
+	ret = hash_progressive_lookup_algo(algo_name, &hs->algo);
+	if (ret)
+		return ret;
+
+	ret = hs->algo->hash_init(hs->algo, &hs->ctx);
+	if (ret) {
+		hs->ctx = NULL;
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+int hash_stream_update(struct hash_stream *hs, const void *buf,
+		       unsigned int size)
+{
+	struct hash_algo *algo = hs->algo;
+	const char *ptr = buf;
+	unsigned int chunk;
+
+	if (!hs->ctx)
+		return -EINVAL;
+
+	while (size) {
+		chunk = size < algo->chunk_size ? size : algo->chunk_size;
+		/* hash_update() frees the context when it fails */
+		if (algo->hash_update(algo, hs->ctx, ptr, chunk, 0)) {
+			hs->ctx = NULL;
+			return -EIO;
+		}
+		ptr += chunk;
+		size -= chunk;
+		WATCHDOG_RESET();
+	}
+
+	return 0;
+}
+
+int hash_stream_finish(struct hash_stream *hs, void *output, int size)
+{
+	struct hash_algo *algo = hs->algo;
+	void *ctx = hs->ctx;
+
+	if (!ctx)
+		return -EINVAL;
+	if (size < algo->digest_size) {
+		hash_stream_abort(hs);
+		return -ENOSPC;
+	}
+	hs->ctx = NULL;
+
+	/* The last piece is only known now, so tell the algorithm here */
+	if (algo->hash_update(algo, ctx, NULL, 0, 1))
+		return -EIO;
+	if (algo->hash_finish(algo, ctx, output, size))
+		return -EIO;
+
+	return 0;
+}
+
+void hash_stream_abort(struct hash_stream *hs)
+{
+	uint8_t scratch[HASH_MAX_DIGEST_SIZE];
+
+	if (!hs->ctx)
+		return;
+
+	/* There is no separate free function, so finish into scratch space */
+	hs->algo->hash_finish(hs->algo, hs->ctx, scratch, sizeof(scratch));
+	hs->ctx = NULL;
+}
+
 #ifndef USE_HOSTCC
+/*
+ * This may run on a secondary CPU, so it only calls the algorithm's update
+ * function. The context is allocated before the work is queued and the
+ * digest is produced afterwards, both on the calling CPU.
+ */
+static int hash_calculate_work(void *arg)
+{
+	struct hash_calculation *hc = arg;
+	struct hash_algo *algo = hc->hs.algo;
+	int i;
+
+	for (i = 0; i < hc->region_count; i++) {
+		if (algo->hash_update(algo, hc->hs.ctx, hc->region[i].data,
+				      hc->region[i].size, 0)) {
+			/* hash_update() frees the context when it fails */
+			hc->hs.ctx = NULL;
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+int hash_calculate_queue(struct hash_calculation *hc, const char *algo_name,
+			 const struct image_region *region, int region_count)
+{
+	int ret;
+
+	ret = hash_stream_start(&hc->hs, algo_name);
+	if (ret)
+		return ret;
+	hc->region = region;
+	hc->region_count = region_count;
+	work_queue(&hc->work, hash_calculate_work, hc);
+
+	return 0;
+}
+
+int hash_calculate_wait(struct hash_calculation *hc, void *output)
+{
+	if (work_wait(&hc->work))
+		return -EIO;
+
+	return hash_stream_finish(&hc->hs, output, hc->hs.algo->digest_size);
+}
+
 int hash_parse_string(const char *algo_name, const char *str, uint8_t *result)
 {
 	struct hash_algo *algo;
@@ -20,6 +20,8 @@
 #include <mapmem.h>
 #include <asm/io.h>
 #include <malloc.h>
+#include <gzip.h>
+#include <workqueue.h>
 DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
 
@@ -1142,6 +1144,18 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 							CHUNKSZ_CRC32);
 		*((uint32_t *)value) = cpu_to_uimage(*((uint32_t *)value));
 		*value_len = 4;
+	} else if (IMAGE_ENABLE_HASH_STREAM &&
+		   ((IMAGE_ENABLE_SHA1 && strcmp(algo, "sha1") == 0) ||
+		    (IMAGE_ENABLE_SHA256 && strcmp(algo, "sha256") == 0))) {
+		struct hash_stream hs;
+
+		if (hash_stream_start(&hs, algo) ||
+		    hash_stream_update(&hs, data, data_len) ||
+		    hash_stream_finish(&hs, value, FIT_MAX_HASH_LEN)) {
+			debug("Hash calculation failed\n");
+			return -1;
+		}
+		*value_len = hs.algo->digest_size;
 	} else if (IMAGE_ENABLE_SHA1 && strcmp(algo, "sha1") == 0) {
 		sha1_csum_wd((unsigned char *)data, data_len,
 			     (unsigned char *)value, CHUNKSZ_SHA1);
@@ -1160,9 +1174,38 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 	return 0;
 }
 
+static const struct fit_stream_hash *
+fit_image_stream_find(const struct fit_image_stream *fs, int noffset)
+{
+	int i;
+
+	for (i = 0; i < fs->count; i++) {
+		if (fs->hash[i].noffset == noffset)
+			return &fs->hash[i];
+	}
+
+	return NULL;
+}
+
+const uint8_t *fit_image_stream_digest(const struct fit_image_stream *fs,
+				       int noffset)
+{
+	const struct fit_stream_hash *sh;
+
+	if (!fs)
+		return NULL;
+	sh = fit_image_stream_find(fs, noffset);
+	if (!sh || sh->value_len <= 0)
+		return NULL;
+
+	return sh->value;
+}
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
-				size_t size, char **err_msgp)
+				size_t size, const struct fit_image_stream *fs,
+				char **err_msgp)
 {
+	const struct fit_stream_hash *sh;
 	uint8_t value[FIT_MAX_HASH_LEN];
 	int value_len;
 	char *algo;
@@ -1192,7 +1235,16 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (fs) {
+		/* The digest was calculated while the image was loaded */
+		sh = fit_image_stream_find(fs, noffset);
+		if (!sh || sh->value_len <= 0) {
+			*err_msgp = "Hash not calculated";
+			return -1;
+		}
+		memcpy(value, sh->value, sh->value_len);
+		value_len = sh->value_len;
+	} else if (calculate_hash(data, size, algo, value, &value_len)) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
@@ -1208,8 +1260,144 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	return 0;
 }
 
-int fit_image_verify_with_data(const void *fit, int image_noffset,
-			       const void *data, size_t size)
+static bool fit_image_stream_algo_ok(const char *algo)
+{
+	return (IMAGE_ENABLE_CRC32 && !strcmp(algo, "crc32")) ||
+	       (IMAGE_ENABLE_SHA1 && !strcmp(algo, "sha1")) ||
+	       (IMAGE_ENABLE_SHA256 && !strcmp(algo, "sha256"));
+}
+
+/* Record that @sh holds a finished digest */
+static void fit_stream_hash_done(struct fit_stream_hash *sh,
+				 struct hash_algo *algo)
+{
+	sh->value_len = algo->digest_size;
+	/* Match calculate_hash(), which stores CRC32 big-endian */
+	if (!strcmp(algo->name, "crc32"))
+		*(uint32_t *)sh->value = cpu_to_uimage(*(uint32_t *)sh->value);
+}
+
+/* Finish the hashes in @fs, leaving the digests for fit_image_check_hash() */
+static void fit_image_stream_finish(struct fit_image_stream *fs)
+{
+	struct fit_stream_hash *sh;
+	int i;
+
+	for (i = 0; i < fs->count; i++) {
+		sh = &fs->hash[i];
+		if (hash_stream_finish(&sh->hs, sh->value, sizeof(sh->value))) {
+			sh->value_len = -1;
+			continue;
+		}
+		fit_stream_hash_done(sh, sh->hs.algo);
+	}
+}
+
+#if IMAGE_ENABLE_WORK_QUEUE
+/**
+ * fit_image_hash_parallel() - Calculate an image's hashes on several CPUs
+ *
+ * Each hash node, and the hash under each signature node, is calculated by
+ * a separate hash_calculate_queue(), leaving the results in @fs for
+ * fit_image_check_hash() and fit_image_check_sig().
+ *
+ * @return 0 if the digests are in @fs, -ve to calculate them one at a time
+ */
+static int fit_image_hash_parallel(const void *fit, int image_noffset,
+				   const void *data, size_t size,
+				   struct fit_image_stream *fs)
+{
+	struct hash_calculation hc[FIT_STREAM_MAX_HASHES];
+	const char *algos[FIT_STREAM_MAX_HASHES];
+	struct checksum_algo *checksum;
+	struct fit_stream_hash *sh;
+	struct image_region region;
+	const char *name;
+	int noffset;
+	int queued;
+	int ignore;
+	char *algo;
+	int ret = 0;
+	int i;
+
+	fs->fit = fit;
+	fs->image_noffset = image_noffset;
+	fs->count = 0;
+	if (!IMAGE_ENABLE_HASH_STREAM)
+		return -ENOSYS;
+
+	/* Check every node first, so nothing is queued if one is unsupported */
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		name = fit_get_name(fit, noffset, NULL);
+		if (IMAGE_ENABLE_VERIFY &&
+		    !strncmp(name, FIT_SIG_NODENAME, strlen(FIT_SIG_NODENAME))) {
+			/* Leave bad nodes for fit_image_check_sig() to report */
+			if (fit_image_hash_get_algo(fit, noffset, &algo))
+				continue;
+			checksum = image_get_checksum_algo(algo);
+			if (!checksum)
+				continue;
+			algo = (char *)checksum->name;
+		} else if (!strncmp(name, FIT_HASH_NODENAME,
+				    strlen(FIT_HASH_NODENAME))) {
+			if (fit_image_hash_get_algo(fit, noffset, &algo))
+				return -EPROTONOSUPPORT;
+			if (IMAGE_ENABLE_IGNORE) {
+				fit_image_hash_get_ignore(fit, noffset,
+							  &ignore);
+				if (ignore)
+					continue;
+			}
+		} else {
+			continue;
+		}
+		/* Leave other algorithms to be calculated one at a time */
+		if (fs->count == FIT_STREAM_MAX_HASHES ||
+		    !fit_image_stream_algo_ok(algo)) {
+			fs->count = 0;
+			return -EPROTONOSUPPORT;
+		}
+		sh = &fs->hash[fs->count];
+		sh->noffset = noffset;
+		sh->hs.ctx = NULL;
+		sh->value_len = 0;
+		algos[fs->count++] = algo;
+	}
+	if (fs->count < 2) {
+		fs->count = 0;
+		return -EAGAIN;
+	}
+
+	/* The CRC32 tables are built on first use; do that here, not twice */
+	if (IMAGE_ENABLE_CRC32)
+		crc32_get_backend();
+
+	region.data = data;
+	region.size = size;
+	for (queued = 0; queued < fs->count; queued++) {
+		if (hash_calculate_queue(&hc[queued], algos[queued], &region,
+					 1))
+			break;
+	}
+	for (i = 0; i < queued; i++) {
+		sh = &fs->hash[i];
+		if (hash_calculate_wait(&hc[i], sh->value))
+			ret = -EIO;
+		else
+			fit_stream_hash_done(sh, hc[i].hs.algo);
+	}
+	if (queued < fs->count || ret) {
+		fs->count = 0;
+		return -EIO;
+	}
+
+	return 0;
+}
+#endif
+
+static int fit_image_verify_common(const void *fit, int image_noffset,
+				   const void *data, size_t size,
+				   const struct fit_image_stream *fs)
 {
 	int		noffset = 0;
 	char		*err_msg = "";
@@ -1219,7 +1407,7 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 	/* Verify all required signatures */
 	if (IMAGE_ENABLE_VERIFY &&
 	    fit_image_verify_required_sigs(fit, image_noffset, data, size,
-					   gd_fdt_blob(), &verify_all)) {
+					   gd_fdt_blob(), fs, &verify_all)) {
 		err_msg = "Unable to verify required signature";
 		goto error;
 	}
@@ -1235,7 +1423,7 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 		 */
 		if (!strncmp(name, FIT_HASH_NODENAME,
 			     strlen(FIT_HASH_NODENAME))) {
-			if (fit_image_check_hash(fit, noffset, data, size,
+			if (fit_image_check_hash(fit, noffset, data, size, fs,
 						 &err_msg))
 				goto error;
 			puts("+ ");
@@ -1243,7 +1431,7 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 				!strncmp(name, FIT_SIG_NODENAME,
 					strlen(FIT_SIG_NODENAME))) {
 			ret = fit_image_check_sig(fit, noffset, data,
-							size, -1, &err_msg);
+							size, fs, -1, &err_msg);
 
 			/*
 			 * Show an indication on failure, but do not return
@@ -1272,6 +1460,108 @@ error:
 	return 0;
 }
 
+int fit_image_verify_with_data(const void *fit, int image_noffset,
+			       const void *data, size_t size)
+{
+#if IMAGE_ENABLE_WORK_QUEUE
+	struct fit_image_stream fs;
+
+	if (work_cpus() &&
+	    !fit_image_hash_parallel(fit, image_noffset, data, size, &fs))
+		return fit_image_verify_common(fit, image_noffset, data, size,
+					       &fs);
+#endif
+
+	return fit_image_verify_common(fit, image_noffset, data, size, NULL);
+}
+
+int fit_image_stream_start(struct fit_image_stream *fs, const void *fit,
+			   int image_noffset)
+{
+	struct fit_stream_hash *sh;
+	const char *name;
+	int noffset;
+	int ignore;
+	char *algo;
+
+	fs->fit = fit;
+	fs->image_noffset = image_noffset;
+	fs->count = 0;
+	if (!IMAGE_ENABLE_HASH_STREAM)
+		return -ENOSYS;
+
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		name = fit_get_name(fit, noffset, NULL);
+
+		/* Signatures are checked over the whole image in memory */
+		if (IMAGE_ENABLE_VERIFY &&
+		    !strncmp(name, FIT_SIG_NODENAME, strlen(FIT_SIG_NODENAME)))
+			goto unsupported;
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+
+		if (fit_image_hash_get_algo(fit, noffset, &algo))
+			goto unsupported;
+		if (IMAGE_ENABLE_IGNORE) {
+			fit_image_hash_get_ignore(fit, noffset, &ignore);
+			if (ignore)
+				continue;
+		}
+		if (fs->count == FIT_STREAM_MAX_HASHES ||
+		    !fit_image_stream_algo_ok(algo))
+			goto unsupported;
+
+		sh = &fs->hash[fs->count];
+		if (hash_stream_start(&sh->hs, algo))
+			goto unsupported;
+		sh->noffset = noffset;
+		sh->value_len = 0;
+		fs->count++;
+	}
+
+	return 0;
+
+unsupported:
+	fit_image_stream_abort(fs);
+
+	return -EPROTONOSUPPORT;
+}
+
+int fit_image_stream_update(struct fit_image_stream *fs, const void *data,
+			    size_t size)
+{
+	int ret;
+	int i;
+
+	for (i = 0; i < fs->count; i++) {
+		ret = hash_stream_update(&fs->hash[i].hs, data, size);
+		if (ret) {
+			fit_image_stream_abort(fs);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+void fit_image_stream_abort(struct fit_image_stream *fs)
+{
+	int i;
+
+	for (i = 0; i < fs->count; i++)
+		hash_stream_abort(&fs->hash[i].hs);
+	fs->count = 0;
+}
+
+int fit_image_stream_verify(struct fit_image_stream *fs, const void *data,
+			    size_t size)
+{
+	fit_image_stream_finish(fs);
+
+	return fit_image_verify_common(fs->fit, fs->image_noffset, data, size,
+				       fs);
+}
+
 /**
  * fit_image_verify - verify data integrity
  * @fit: pointer to the FIT format image header
@@ -1805,6 +2095,52 @@ static const char *fit_get_image_type_property(int type)
 	return "unknown";
 }
 
+int fit_image_decomp(const void *fit, int noffset, int comp, ulong load,
+		     ulong image_start, int type, void *load_buf,
+		     void *image_buf, ulong image_len, uint unc_len,
+		     ulong *load_end)
+{
+#if !defined(USE_HOSTCC) && defined(CONFIG_GZIP)
+	const fdt32_t *prop;
+	unsigned long len;
+	ulong total = 0;
+	u32 *sizes;
+	int count;
+	int ret;
+	int i;
+
+	prop = fdt_getprop(fit, noffset, FIT_COMP_CHUNKS_PROP, &count);
+	if (prop && comp == IH_COMP_GZIP) {
+		count /= sizeof(*prop);
+		printf("   Uncompressing %s in %d chunks\n",
+		       genimg_get_type_name(type), count);
+		*load_end = load;
+		sizes = malloc(count * sizeof(*sizes));
+		if (!sizes)
+			return -ENOMEM;
+		for (i = 0; i < count; i++) {
+			sizes[i] = fdt32_to_cpu(prop[i]);
+			total += sizes[i];
+		}
+		if (!count || total != image_len) {
+			puts("Error: chunk sizes do not add up to the image size\n");
+			ret = -EINVAL;
+		} else {
+			ret = gunzip_chunks(load_buf, unc_len, image_buf,
+					    sizes, count, &len);
+			if (!ret)
+				*load_end = load + len;
+		}
+		free(sizes);
+
+		return ret;
+	}
+#endif
+
+	return image_decomp(comp, load, image_start, type, load_buf, image_buf,
+			    image_len, unc_len, load_end);
+}
+
 int fit_image_load(bootm_headers_t *images, ulong addr,
 		   const char **fit_unamep, const char **fit_uname_configp,
 		   int arch, int image_type, int bootstage_id,
@@ -2011,8 +2347,9 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 		} else {
 			loadbuf = map_sysmem(load, max_decomp_len);
 		}
-		if (image_decomp(comp, load, data, image_type,
-				loadbuf, buf, len, max_decomp_len, &load_end)) {
+		if (fit_image_decomp(fit, noffset, comp, load, data,
+				     image_type, loadbuf, buf, len,
+				     max_decomp_len, &load_end)) {
 			printf("Error decompressing %s\n", prop_name);
 
 			return -ENOEXEC;
@@ -249,7 +249,8 @@ static int fit_image_setup_verify(struct image_sign_info *info,
 }
 
 int fit_image_check_sig(const void *fit, int noffset, const void *data,
-		size_t size, int required_keynode, char **err_msgp)
+		size_t size, const struct fit_image_stream *fs,
+		int required_keynode, char **err_msgp)
 {
 	struct image_sign_info info;
 	struct image_region region;
@@ -269,6 +270,7 @@ int fit_image_check_sig(const void *fit, int noffset, const void *data,
 
 	region.data = data;
 	region.size = size;
+	info.digest = fit_image_stream_digest(fs, noffset);
 
 	if (info.crypto->verify(&info, &region, 1, fit_value, fit_value_len)) {
 		*err_msgp = "Verification failed";
@@ -280,7 +282,7 @@ int fit_image_check_sig(const void *fit, int noffset, const void *data,
 
 static int fit_image_verify_sig(const void *fit, int image_noffset,
 		const char *data, size_t size, const void *sig_blob,
-		int sig_offset)
+		int sig_offset, const struct fit_image_stream *fs)
 {
 	int noffset;
 	char *err_msg = "";
@@ -294,7 +296,7 @@ static int fit_image_verify_sig(const void *fit, int image_noffset,
 		if (!strncmp(name, FIT_SIG_NODENAME,
 			     strlen(FIT_SIG_NODENAME))) {
 			ret = fit_image_check_sig(fit, noffset, data,
-							size, -1, &err_msg);
+							size, fs, -1, &err_msg);
 			if (ret) {
 				puts("- ");
 			} else {
@@ -321,7 +323,7 @@ error:
 
 int fit_image_verify_required_sigs(const void *fit, int image_noffset,
 		const char *data, size_t size, const void *sig_blob,
-		int *no_sigsp)
+		const struct fit_image_stream *fs, int *no_sigsp)
 {
 	int verify_count = 0;
 	int noffset;
@@ -344,7 +346,7 @@ int fit_image_verify_required_sigs(const void *fit, int image_noffset,
 		if (!required || strcmp(required, "image"))
 			continue;
 		ret = fit_image_verify_sig(fit, image_noffset, data, size,
-					sig_blob, noffset);
+					sig_blob, noffset, fs);
 		if (ret) {
 			printf("Failed to verify required signature '%s'\n",
 			       fit_get_name(sig_blob, noffset, NULL));
@@ -7,6 +7,7 @@
  */
 
 #include <common.h>
+#include <dm/lists.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -67,6 +68,9 @@ __weak void board_init_f_init_stack_protection(void)
  *  - the early malloc arena is not aligned, therefore it follows the stack
  *   alignment constraint of the architecture for which we are bulding.
  *
+ *  - the driver compatible-string table (CONFIG_DM_COMPAT_HASH) is
+ *   rounded up to a multiple of 16 bytes.
+ *
  *  - GD is allocated last, so that the return value of this functions is
  *   both the bottom of the reserved area and the address of GD, should
  *   the calling context need it.
@@ -77,6 +81,10 @@ ulong board_init_f_alloc_reserve(ulong top)
 	/* Reserve early malloc arena */
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
 	top -= CONFIG_VAL(SYS_MALLOC_F_LEN);
+#endif
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	/* Reserve the driver compatible-string table */
+	top -= roundup(lists_compat_size(), 16);
 #endif
 	/* LAST : reserve GD (rounded up to a multiple of 16 bytes) */
 	top = rounddown(top-sizeof(struct global_data), 16);
@@ -129,6 +137,9 @@ ulong board_init_f_alloc_reserve(ulong top)
 void board_init_f_init_reserve(ulong base)
 {
 	struct global_data *gd_ptr;
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	ulong size;
+#endif
 
 	/*
 	 * clear GD entirely and set it up.
@@ -161,6 +172,14 @@ void board_init_f_init_reserve(ulong base)
 	base += CONFIG_VAL(SYS_MALLOC_F_LEN);
 #endif
 
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	/* The table only holds linker-list indexes, so build it right away */
+	size = lists_compat_size();
+	if (size && !lists_compat_build((void *)base, size))
+		gd->dm_compat = (void *)base;
+	base += roundup(size, 16);
+#endif
+
 	if (CONFIG_IS_ENABLED(SYS_REPORT_STACK_F_USAGE))
 		board_init_f_init_stack_protection();
 }
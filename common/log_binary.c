@@ -0,0 +1,321 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Binary log driver
+ *
+ * This stores log records in a ring buffer at a fixed place in memory, with
+ * the format string and arguments kept as they are rather than formatted.
+ * The buffer is kept across a warm reset. See include/log_binary.h for the
+ * format.
+ */
+
+#include <common.h>
+#include <cpu_func.h>
+#include <fdtdec.h>
+#include <log.h>
+#include <log_binary.h>
+#include <mapmem.h>
+#include <spl.h>
+#include <time.h>
+#include <version.h>
+#include <asm/cache.h>
+
+/* Identifies the image in LOGBT_START records; the name is used by logdecode */
+const char log_binary_anchor[] = U_BOOT_VERSION_STRING;
+
+static struct logb_hdr *log_binary_hdr(void)
+{
+	return map_sysmem(CONFIG_LOG_BINARY_ADDR, CONFIG_LOG_BINARY_SIZE);
+}
+
+/* Write back what has changed so that it is kept over a reset */
+static void log_binary_sync(const void *ptr, int size)
+{
+	ulong start = (ulong)ptr;
+
+	flush_dcache_range(rounddown(start, ARCH_DMA_MINALIGN),
+			   roundup(start + size, ARCH_DMA_MINALIGN));
+}
+
+/* Drop the oldest records until none is in the part of the area being used */
+static void log_binary_make_room(struct logb_hdr *hdr, u32 start, u32 end)
+{
+	u8 *data = (u8 *)(hdr + 1);
+	u32 off;
+
+	while (hdr->tail != hdr->head) {
+		/* The oldest record may be at the start, after a wrap */
+		if (hdr->tail >= hdr->size ||
+		    !((struct logb_rec *)(data + hdr->tail))->size)
+			hdr->tail = 0;
+		if (hdr->tail == hdr->head || hdr->tail < start ||
+		    hdr->tail > end)
+			break;
+		off = hdr->tail;
+		if (!logb_next_rec(hdr, &off))
+			off = hdr->head;
+		hdr->tail = off;
+	}
+}
+
+static void log_binary_write(struct logb_hdr *hdr, const struct logb_rec *rec)
+{
+	u8 *data = (u8 *)(hdr + 1);
+	u32 pos = hdr->head;
+
+	if (pos + rec->size > hdr->size) {
+		log_binary_make_room(hdr, pos, hdr->size);
+		if (pos < hdr->size) {
+			((struct logb_rec *)(data + pos))->size = 0;
+			log_binary_sync(data + pos, sizeof(rec->size));
+		}
+		pos = 0;
+	}
+	log_binary_make_room(hdr, pos, pos + rec->size);
+	if (hdr->tail == hdr->head)
+		hdr->tail = pos;
+
+	memcpy(data + pos, rec, rec->size);
+	log_binary_sync(data + pos, rec->size);
+	hdr->head = pos + rec->size;
+	log_binary_sync(hdr, sizeof(*hdr));
+}
+
+/* Store a string at @ptr, returning the number of bytes used, -1 if no room */
+static int log_binary_put_str(u8 *ptr, u8 *end, const char *str)
+{
+	u16 len;
+
+	if (!str)
+		str = "<NULL>";
+	len = strnlen(str, LOGB_STR_MAX);
+	if (end - ptr < sizeof(len) + len)
+		return -1;
+	memcpy(ptr, &len, sizeof(len));
+	memcpy(ptr + sizeof(len), str, len);
+
+	return sizeof(len) + len;
+}
+
+/*
+ * Store the file name and the arguments for @fmt, returning the number of
+ * bytes used
+ */
+static int log_binary_pack(u8 *out, const char *file, const char *fmt,
+			   va_list args)
+{
+	u8 *end = out + LOGB_ARGS_MAX;
+	struct logb_conv conv;
+	enum logb_arg_t type;
+	const char *str;
+	u8 *ptr = out;
+	int len, i;
+	union {
+		u32 i;
+		ulong l;
+		u64 ll;
+	} val;
+
+	len = log_binary_put_str(ptr, end, file);
+	if (len < 0)
+		return 0;
+	ptr += len;
+
+	while ((type = logb_next_conv(fmt, &conv)) != LOGBA_END) {
+		fmt = conv.end;
+		for (i = 0; i < conv.stars; i++) {
+			val.i = va_arg(args, int);
+			if (end - ptr < sizeof(val.i))
+				return ptr - out;
+			memcpy(ptr, &val.i, sizeof(val.i));
+			ptr += sizeof(val.i);
+		}
+
+		switch (type) {
+		case LOGBA_INT:
+			val.i = va_arg(args, int);
+			break;
+		case LOGBA_LONG:
+			val.l = va_arg(args, long);
+			break;
+		case LOGBA_LLONG:
+			val.ll = va_arg(args, long long);
+			break;
+		case LOGBA_PTR:
+			val.l = (ulong)va_arg(args, void *);
+			break;
+		case LOGBA_SKIP:
+			va_arg(args, void *);
+			continue;
+		case LOGBA_STR:
+			str = va_arg(args, const char *);
+			len = log_binary_put_str(ptr, end, str);
+			if (len < 0)
+				return ptr - out;
+			ptr += len;
+			continue;
+		default:
+			continue;
+		}
+		len = logb_arg_size(type, sizeof(long));
+		if (end - ptr < len)
+			return ptr - out;
+		memcpy(ptr, &val, len);
+		ptr += len;
+	}
+
+	return ptr - out;
+}
+
+static int log_binary_emit(struct log_device *ldev, struct log_rec *rec)
+{
+	struct {
+		struct logb_rec rec;
+		u8 args[LOGB_ARGS_MAX + LOGB_ALIGN];
+	} buf;
+	va_list args;
+	int len;
+
+	va_copy(args, *rec->args);
+	len = log_binary_pack(buf.args, rec->file, rec->fmt, args);
+	va_end(args);
+	buf.rec.size = ALIGN(sizeof(buf.rec) + len, LOGB_ALIGN);
+	memset(buf.args + len, '\0', buf.rec.size - sizeof(buf.rec) - len);
+
+	buf.rec.type = LOGBT_MSG;
+	buf.rec.level = rec->level;
+	buf.rec.cat = rec->cat;
+	buf.rec.line = rec->line;
+	buf.rec.time = timer_get_us();
+	buf.rec.fmt = (ulong)rec->fmt;
+	buf.rec.file = 0;
+	log_binary_write(log_binary_hdr(), &buf.rec);
+
+	return 0;
+}
+
+static int log_binary_probe(struct log_device *ldev)
+{
+	struct logb_hdr *hdr = log_binary_hdr();
+	struct logb_rec rec;
+
+	/* Keep the records from before a reset, if they are still there */
+	if (logb_check_hdr(hdr, CONFIG_LOG_BINARY_SIZE) ||
+	    hdr->long_size != sizeof(long)) {
+		memset(hdr, '\0', sizeof(*hdr));
+		hdr->magic = LOGB_MAGIC;
+		hdr->version = LOGB_VERSION;
+		hdr->long_size = sizeof(long);
+		hdr->hdr_size = sizeof(*hdr);
+		hdr->size = rounddown(CONFIG_LOG_BINARY_SIZE - sizeof(*hdr),
+				      LOGB_ALIGN);
+	}
+
+	memset(&rec, '\0', sizeof(rec));
+	rec.size = sizeof(rec);
+	rec.type = LOGBT_START;
+	rec.level = spl_phase();
+	rec.time = timer_get_us();
+	rec.fmt = (ulong)log_binary_anchor;
+	rec.file = logb_hash(log_binary_anchor);
+	log_binary_write(hdr, &rec);
+
+	return 0;
+}
+
+#ifndef CONFIG_SPL_BUILD
+static const char *const log_binary_phase_name[] = {
+	[PHASE_TPL]	= "TPL",
+	[PHASE_SPL]	= "SPL",
+	[PHASE_BOARD_F]	= "U-Boot before relocation",
+	[PHASE_BOARD_R]	= "U-Boot",
+};
+
+int log_binary_dump(void)
+{
+	struct logb_hdr *hdr = log_binary_hdr();
+	const struct logb_rec *rec;
+	char msg[CONFIG_SYS_CBSIZE];
+	char file[LOGB_STR_MAX + 1];
+	bool known = false;
+	ulong offset = 0;
+	const u8 *args;
+	const char *fmt;
+	u32 off;
+	int len;
+
+	if (logb_check_hdr(hdr, CONFIG_LOG_BINARY_SIZE)) {
+		printf("No binary log\n");
+		return -ENOENT;
+	}
+
+	for (off = hdr->tail; (rec = logb_next_rec(hdr, &off));) {
+		if (rec->type == LOGBT_START) {
+			/* Addresses are only known in this image */
+			known = rec->level >= PHASE_BOARD_F &&
+				rec->file == logb_hash(log_binary_anchor);
+			offset = (ulong)log_binary_anchor - rec->fmt;
+			printf("%10llu --- %s started%s\n", rec->time,
+			       rec->level < ARRAY_SIZE(log_binary_phase_name) ?
+			       log_binary_phase_name[rec->level] : "?",
+			       known ? "" : " (not this image)");
+			continue;
+		}
+		if (rec->type != LOGBT_MSG)
+			continue;
+
+		printf("%10llu %s.%s,", rec->time,
+		       log_get_level_name(rec->level),
+		       log_get_cat_name(rec->cat));
+		args = (const u8 *)(rec + 1);
+		len = logb_get_str(args, rec->size - sizeof(*rec), file);
+		if (len < 0) {
+			printf("%d- corrupt record\n", rec->line);
+			continue;
+		}
+		args += len;
+		if (!known) {
+			printf("%s:%d- fmt %#llx\n", file, rec->line, rec->fmt);
+			continue;
+		}
+		fmt = (const char *)(ulong)(rec->fmt + offset);
+		len = logb_format(msg, sizeof(msg), fmt, args,
+				  (const u8 *)rec + rec->size - args,
+				  sizeof(long));
+		printf("%s:%d- %s%s", file, rec->line, msg,
+		       len && msg[len - 1] == '\n' ? "" : "\n");
+	}
+
+	return 0;
+}
+
+int log_binary_fdt_fixup(void *blob)
+{
+	struct fdt_memory mem = {
+		.start = CONFIG_LOG_BINARY_ADDR,
+		.end = CONFIG_LOG_BINARY_ADDR + CONFIG_LOG_BINARY_SIZE - 1,
+	};
+	int parent, node, ret;
+
+	ret = fdtdec_add_reserved_memory(blob, "u-boot-log", &mem, NULL);
+	if (ret)
+		return ret;
+
+	parent = fdt_path_offset(blob, "/reserved-memory");
+	fdt_for_each_subnode(node, blob, parent) {
+		const char *name = fdt_get_name(blob, node, NULL);
+
+		if (!strncmp(name, "u-boot-log@", 11))
+			return fdt_setprop_string(blob, node, "compatible",
+						  "u-boot,binary-log");
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+#endif /* !CONFIG_SPL_BUILD */
+
+LOG_DRIVER(binary) = {
+	.name	= "binary",
+	.flags	= LOGDF_RAW,
+	.probe	= log_binary_probe,
+	.emit	= log_binary_emit,
+};
@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Reading binary log records
+ *
+ * This is used by the binary log driver and by tools/logdecode.
+ */
+
+#ifdef USE_HOSTCC
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#else
+#include <common.h>
+#include <linux/ctype.h>
+#endif
+#include <log_binary.h>
+
+enum logb_arg_t logb_next_conv(const char *fmt, struct logb_conv *conv)
+{
+	const char *p;
+
+	p = strchr(fmt, '%');
+	if (!p)
+		return LOGBA_END;
+	conv->start = p++;
+	conv->stars = 0;
+	conv->qual = 0;
+
+	while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+		p++;
+	if (*p == '*') {
+		conv->stars++;
+		p++;
+	} else {
+		while (isdigit(*p))
+			p++;
+	}
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			conv->stars++;
+			p++;
+		} else {
+			while (isdigit(*p))
+				p++;
+		}
+	}
+	conv->spec_len = p - conv->start;
+	if (*p == 'h' || *p == 'l' || *p == 'L' || *p == 'Z' || *p == 'z' ||
+	    *p == 't') {
+		conv->qual = *p++;
+		if (conv->qual == 'l' && *p == 'l') {
+			conv->qual = 'L';
+			p++;
+		}
+	}
+
+	conv->conv = *p;
+	switch (*p) {
+	case 'c':
+		conv->type = LOGBA_INT;
+		break;
+	case 's':
+		conv->type = conv->qual == 'l' ? LOGBA_PTR : LOGBA_STR;
+		break;
+	case 'p':
+		conv->type = LOGBA_PTR;
+		while (isalnum(p[1]))
+			p++;
+		break;
+	case 'n':
+		conv->type = LOGBA_SKIP;
+		break;
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		if (conv->qual == 'L')
+			conv->type = LOGBA_LLONG;
+		else if (conv->qual && conv->qual != 'h')
+			conv->type = LOGBA_LONG;
+		else
+			conv->type = LOGBA_INT;
+		break;
+	default:
+		conv->type = LOGBA_NONE;
+		break;
+	}
+	conv->end = *p ? p + 1 : p;
+
+	return conv->type;
+}
+
+int logb_arg_size(enum logb_arg_t type, int long_size)
+{
+	switch (type) {
+	case LOGBA_INT:
+		return 4;
+	case LOGBA_LLONG:
+		return 8;
+	case LOGBA_LONG:
+	case LOGBA_PTR:
+		return long_size;
+	default:
+		return 0;
+	}
+}
+
+int logb_check_hdr(const struct logb_hdr *hdr, uint32_t size)
+{
+	if (hdr->magic != LOGB_MAGIC || hdr->version != LOGB_VERSION ||
+	    hdr->hdr_size != sizeof(*hdr))
+		return -1;
+	if (hdr->long_size != 4 && hdr->long_size != 8)
+		return -1;
+	if (size < sizeof(*hdr) || hdr->size > size - sizeof(*hdr) ||
+	    hdr->size % LOGB_ALIGN)
+		return -1;
+	if (hdr->head > hdr->size || hdr->head % LOGB_ALIGN ||
+	    hdr->tail > hdr->size || hdr->tail % LOGB_ALIGN)
+		return -1;
+
+	return 0;
+}
+
+const struct logb_rec *logb_next_rec(const struct logb_hdr *hdr,
+				     uint32_t *offp)
+{
+	const uint8_t *data = (const uint8_t *)hdr + hdr->hdr_size;
+	const struct logb_rec *rec;
+	uint32_t off = *offp;
+
+	if (off == hdr->head)
+		return NULL;
+
+	/* Go back to the start at the end of the area or a wrap marker */
+	if (off >= hdr->size || !((const struct logb_rec *)(data + off))->size)
+		off = 0;
+	if (off == hdr->head)
+		return NULL;
+
+	rec = (const struct logb_rec *)(data + off);
+	if (rec->size < sizeof(*rec) || rec->size % LOGB_ALIGN ||
+	    rec->size > hdr->size - off)
+		return NULL;
+	*offp = off + rec->size;
+
+	return rec;
+}
+
+/* Add @len bytes of @str to the message, which is always terminated */
+static int logb_add(char *buf, int size, int pos, const char *str, int len)
+{
+	if (len > size - 1 - pos)
+		len = size - 1 - pos;
+	if (len > 0) {
+		memcpy(buf + pos, str, len);
+		pos += len;
+	}
+	buf[pos] = '\0';
+
+	return pos;
+}
+
+/* Work out the new position after snprintf() at @pos returns @ret */
+static int logb_added(int size, int pos, int ret)
+{
+	if (ret < 0)
+		return pos;
+
+	return ret < size - 1 - pos ? pos + ret : size - 1;
+}
+
+static int logb_add_num(char *buf, int size, int pos, const char *spec,
+			const int *star, int stars, unsigned long long val)
+{
+	char *out = buf + pos;
+	int ret;
+
+	if (stars == 2)
+		ret = snprintf(out, size - pos, spec, star[0], star[1], val);
+	else if (stars == 1)
+		ret = snprintf(out, size - pos, spec, star[0], val);
+	else
+		ret = snprintf(out, size - pos, spec, val);
+
+	return logb_added(size, pos, ret);
+}
+
+static int logb_add_str(char *buf, int size, int pos, const char *spec,
+			const int *star, int stars, const char *str)
+{
+	char *out = buf + pos;
+	int ret;
+
+	if (stars == 2)
+		ret = snprintf(out, size - pos, spec, star[0], star[1], str);
+	else if (stars == 1)
+		ret = snprintf(out, size - pos, spec, star[0], str);
+	else
+		ret = snprintf(out, size - pos, spec, str);
+
+	return logb_added(size, pos, ret);
+}
+
+/* Read an integer argument of @bytes bytes, sign-extending if needed */
+static unsigned long long logb_get_num(const uint8_t *args, int bytes,
+				       bool sign)
+{
+	uint64_t val64;
+	uint32_t val32;
+
+	if (bytes == 8) {
+		memcpy(&val64, args, 8);
+		return val64;
+	}
+	memcpy(&val32, args, 4);
+
+	return sign ? (long long)(int32_t)val32 : val32;
+}
+
+int logb_get_str(const uint8_t *args, int len, char *str)
+{
+	uint16_t len16;
+
+	if (len < 2)
+		return -1;
+	memcpy(&len16, args, 2);
+	if (len16 > len - 2 || len16 > LOGB_STR_MAX)
+		return -1;
+	memcpy(str, args + 2, len16);
+	str[len16] = '\0';
+
+	return 2 + len16;
+}
+
+int logb_format(char *buf, int size, const char *fmt, const uint8_t *args,
+		int len, int long_size)
+{
+	const uint8_t *end = args + len;
+	char str[LOGB_STR_MAX + 1];
+	unsigned long long val;
+	struct logb_conv conv;
+	enum logb_arg_t type;
+	char spec[32];
+	int star[2];
+	int pos, bytes, width, i;
+	bool sign;
+
+	if (size <= 0)
+		return 0;
+	pos = logb_add(buf, size, 0, "", 0);
+	while ((type = logb_next_conv(fmt, &conv)) != LOGBA_END) {
+		pos = logb_add(buf, size, pos, fmt, conv.start - fmt);
+		fmt = conv.end;
+		if (type == LOGBA_SKIP)
+			continue;
+		if (type == LOGBA_NONE) {
+			if (conv.conv == '%')
+				pos = logb_add(buf, size, pos, "%", 1);
+			else
+				pos = logb_add(buf, size, pos, conv.start,
+					       conv.end - conv.start);
+			continue;
+		}
+
+		for (i = 0; i < conv.stars; i++) {
+			if (end - args < 4)
+				break;
+			star[i] = (int)logb_get_num(args, 4, true);
+			args += 4;
+		}
+		if (i < conv.stars)
+			goto missing;
+
+		/* Keep the flags, width and precision of the conversion */
+		if (conv.spec_len > (int)sizeof(spec) - 4)
+			goto missing;
+		memcpy(spec, conv.start, conv.spec_len);
+
+		if (type == LOGBA_STR) {
+			bytes = logb_get_str(args, end - args, str);
+			if (bytes < 0)
+				goto missing;
+			args += bytes;
+			strcpy(spec + conv.spec_len, "s");
+			pos = logb_add_str(buf, size, pos, spec, star,
+					   conv.stars, str);
+			continue;
+		}
+
+		bytes = logb_arg_size(type, long_size);
+		if (end - args < bytes)
+			goto missing;
+		sign = conv.conv == 'd' || conv.conv == 'i';
+		val = logb_get_num(args, bytes, sign);
+		args += bytes;
+
+		if (conv.conv == 'c') {
+			str[0] = val;
+			str[1] = '\0';
+			strcpy(spec + conv.spec_len, "s");
+			pos = logb_add_str(buf, size, pos, spec, star,
+					   conv.stars, str);
+		} else if (type == LOGBA_PTR) {
+			/* As vsnprintf(), without the extensions */
+			width = long_size * 2;
+			pos = logb_add_num(buf, size, pos, "%0*llx", &width, 1,
+					   val);
+		} else {
+			if (conv.qual == 'h')
+				val = sign ? (long long)(short)val :
+					(unsigned short)val;
+			spec[conv.spec_len] = 'l';
+			spec[conv.spec_len + 1] = 'l';
+			spec[conv.spec_len + 2] = conv.conv;
+			spec[conv.spec_len + 3] = '\0';
+			pos = logb_add_num(buf, size, pos, spec, star,
+					   conv.stars, val);
+		}
+		continue;
+missing:
+		pos = logb_add(buf, size, pos, "?", 1);
+		/* The rest of the arguments cannot be found */
+		args = end;
+	}
+	pos = logb_add(buf, size, pos, fmt, strlen(fmt));
+
+	return pos;
+}
+
+uint32_t logb_hash(const char *str)
+{
+	uint32_t hash = 2166136261U;
+
+	for (; *str; str++)
+		hash = (hash ^ (uint8_t)*str) * 16777619U;
+
+	return hash;
+}
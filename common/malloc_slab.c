@@ -0,0 +1,416 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Size-class slab allocator for small malloc() requests
+ *
+ * The slab area is a single block obtained from memalign(). It starts with a
+ * struct malloc_slab, holding a struct malloc_slab_page for each page, and
+ * the pages follow. Each page in use holds objects of a single size class.
+ * Free objects in a page are chained through their first two bytes, which
+ * hold the offset of the next free object plus one (0 for none). Pages with
+ * free objects are kept on a list for their class. Empty pages go back to a
+ * shared list so that memory freed in one class can be used by another.
+ */
+
+#define LOG_CATEGORY LOGC_ALLOC
+
+#include <common.h>
+#include <malloc.h>
+#include <malloc_slab.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define MALLOC_SLAB_NONE	0xffff	/* No page */
+#define MALLOC_SLAB_ALIGN	16	/* Alignment of the pages */
+
+/**
+ * struct malloc_slab_page - information about a page
+ *
+ * @cls: Size class of the objects in this page, if in use
+ * @used: Number of objects allocated from this page
+ * @free: Offset of the first free object plus one, 0 if the page is full
+ * @next: Next page in the list, or MALLOC_SLAB_NONE
+ * @prev: Previous page in the list, or MALLOC_SLAB_NONE
+ */
+struct malloc_slab_page {
+	u8 cls;
+	u8 used;
+	u16 free;
+	u16 next;
+	u16 prev;
+};
+
+/**
+ * struct malloc_slab - the slab area
+ *
+ * @base: Start of the first page
+ * @size: Size of the whole area in bytes
+ * @npages: Number of pages
+ * @free_count: Number of unused pages
+ * @free_pages: First page in the list of unused pages
+ * @early: true if the area was set up before relocation
+ * @enabled: true to allocate new objects, false to pass all requests on
+ * @trace: Trace buffer, or NULL if not tracing
+ * @trace_count: Number of calls traced so far
+ * @trace_max: Number of records that fit in @trace
+ * @cls: Information for each size class
+ * @page: Information for each page
+ */
+struct malloc_slab {
+	char *base;
+	ulong size;
+	uint npages;
+	uint free_count;
+	u16 free_pages;
+	bool early;
+	bool enabled;
+	struct malloc_slab_trace *trace;
+	int trace_count;
+	int trace_max;
+	struct malloc_slab_class cls[MALLOC_SLAB_CLASSES];
+	struct malloc_slab_page page[];
+};
+
+static const u16 slab_size[MALLOC_SLAB_CLASSES] = {
+	16, 32, 48, 64, 80, 96, 112, 128, 160, 256,
+};
+
+/* Size class for each request size, in units of 16 bytes rounded up */
+static const u8 slab_class[MALLOC_SLAB_MAX / 16 + 1] = {
+	0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 8, 9, 9, 9, 9, 9, 9,
+};
+
+static void slab_list_add(struct malloc_slab *slab, u16 *head, uint idx)
+{
+	struct malloc_slab_page *pg = &slab->page[idx];
+
+	pg->prev = MALLOC_SLAB_NONE;
+	pg->next = *head;
+	if (*head != MALLOC_SLAB_NONE)
+		slab->page[*head].prev = idx;
+	*head = idx;
+}
+
+static void slab_list_del(struct malloc_slab *slab, u16 *head, uint idx)
+{
+	struct malloc_slab_page *pg = &slab->page[idx];
+
+	if (pg->prev != MALLOC_SLAB_NONE)
+		slab->page[pg->prev].next = pg->next;
+	else
+		*head = pg->next;
+	if (pg->next != MALLOC_SLAB_NONE)
+		slab->page[pg->next].prev = pg->prev;
+}
+
+/* Return the page holding @ptr, or -1 if it is not in the slab area */
+static int slab_page_of(struct malloc_slab *slab, const void *ptr)
+{
+	ulong ofs = (const char *)ptr - slab->base;
+
+	if (ofs >= (ulong)slab->npages * MALLOC_SLAB_PAGE)
+		return -1;
+
+	return ofs / MALLOC_SLAB_PAGE;
+}
+
+/* Take a page from the free list and chain its objects together */
+static uint slab_new_page(struct malloc_slab *slab, uint cls)
+{
+	struct malloc_slab_class *sc = &slab->cls[cls];
+	uint idx, off;
+	char *base;
+
+	idx = slab->free_pages;
+	if (idx == MALLOC_SLAB_NONE)
+		return idx;
+	slab_list_del(slab, &slab->free_pages, idx);
+	slab->free_count--;
+
+	base = slab->base + idx * MALLOC_SLAB_PAGE;
+	for (off = 0; off + 2 * sc->size <= MALLOC_SLAB_PAGE; off += sc->size)
+		*(u16 *)(base + off) = off + sc->size + 1;
+	*(u16 *)(base + off) = 0;
+
+	slab->page[idx].cls = cls;
+	slab->page[idx].used = 0;
+	slab->page[idx].free = 1;
+	slab_list_add(slab, &sc->partial, idx);
+	sc->pages++;
+
+	return idx;
+}
+
+int malloc_slab_init(ulong size)
+{
+	struct malloc_slab *slab;
+	uint npages, i;
+
+	gd->malloc_slab = NULL;
+	if (size < sizeof(*slab) + MALLOC_SLAB_ALIGN)
+		return 0;
+	npages = (size - sizeof(*slab) - MALLOC_SLAB_ALIGN) /
+		(MALLOC_SLAB_PAGE + sizeof(struct malloc_slab_page));
+	npages = min_t(uint, npages, MALLOC_SLAB_NONE);
+	if (!npages)
+		return 0;
+
+	slab = memalign(MALLOC_SLAB_ALIGN, size);
+	if (!slab) {
+		log_debug("Cannot allocate %lx bytes\n", size);
+		return -ENOMEM;
+	}
+	memset(slab, '\0', sizeof(*slab));
+	slab->base = PTR_ALIGN((char *)&slab->page[npages], MALLOC_SLAB_ALIGN);
+	slab->size = size;
+	slab->npages = npages;
+	slab->early = !(gd->flags & GD_FLG_FULL_MALLOC_INIT);
+	slab->enabled = true;
+	for (i = 0; i < MALLOC_SLAB_CLASSES; i++) {
+		slab->cls[i].size = slab_size[i];
+		slab->cls[i].partial = MALLOC_SLAB_NONE;
+	}
+	slab->free_pages = MALLOC_SLAB_NONE;
+	for (i = npages; i-- > 0;)
+		slab_list_add(slab, &slab->free_pages, i);
+	slab->free_count = npages;
+	gd->malloc_slab = slab;
+	log_debug("%u pages at %p\n", npages, slab->base);
+
+	return 0;
+}
+
+/* Call malloc() with tracing suspended and record the result */
+static void *slab_trace_alloc(struct malloc_slab *slab, size_t bytes)
+{
+	struct malloc_slab_trace *trace = slab->trace;
+	void *ptr;
+
+	slab->trace = NULL;
+	ptr = malloc(bytes);
+	if (ptr) {
+		if (slab->trace_count < slab->trace_max) {
+			trace[slab->trace_count].ptr = ptr;
+			trace[slab->trace_count].size = bytes;
+		}
+		slab->trace_count++;
+	}
+	slab->trace = trace;
+
+	return ptr;
+}
+
+void *malloc_slab_alloc(size_t bytes)
+{
+	struct malloc_slab *slab = gd->malloc_slab;
+	struct malloc_slab_class *sc;
+	struct malloc_slab_page *pg;
+	uint cls, idx;
+	char *ptr;
+
+	if (!slab)
+		return NULL;
+	if (slab->trace)
+		return slab_trace_alloc(slab, bytes);
+	if (bytes > MALLOC_SLAB_MAX || !slab->enabled)
+		return NULL;
+	/* An area set up before relocation must not be used after it */
+	if (slab->early != !(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return NULL;
+
+	cls = slab_class[(bytes + 15) / 16];
+	sc = &slab->cls[cls];
+	idx = sc->partial;
+	if (idx == MALLOC_SLAB_NONE) {
+		idx = slab_new_page(slab, cls);
+		if (idx == MALLOC_SLAB_NONE) {
+			sc->fails++;
+			return NULL;
+		}
+	}
+	pg = &slab->page[idx];
+	ptr = slab->base + idx * MALLOC_SLAB_PAGE + pg->free - 1;
+	pg->free = *(u16 *)ptr;
+	pg->used++;
+	if (!pg->free)
+		slab_list_del(slab, &sc->partial, idx);
+	sc->allocs++;
+	if (++sc->in_use > sc->peak)
+		sc->peak = sc->in_use;
+
+	return ptr;
+}
+
+/* Call free() with tracing suspended and record the call */
+static bool slab_trace_free(struct malloc_slab *slab, void *ptr)
+{
+	struct malloc_slab_trace *trace = slab->trace;
+
+	slab->trace = NULL;
+	free(ptr);
+	if (ptr) {
+		if (slab->trace_count < slab->trace_max) {
+			trace[slab->trace_count].ptr = ptr;
+			trace[slab->trace_count].size = MALLOC_SLAB_TRACE_FREE;
+		}
+		slab->trace_count++;
+	}
+	slab->trace = trace;
+
+	return true;
+}
+
+bool malloc_slab_free(void *ptr)
+{
+	struct malloc_slab *slab = gd->malloc_slab;
+	struct malloc_slab_class *sc;
+	struct malloc_slab_page *pg;
+	int idx;
+
+	if (!slab)
+		return false;
+	if (slab->trace)
+		return slab_trace_free(slab, ptr);
+	idx = slab_page_of(slab, ptr);
+	if (idx < 0)
+		return false;
+
+	pg = &slab->page[idx];
+	sc = &slab->cls[pg->cls];
+	if (!pg->free)
+		slab_list_add(slab, &sc->partial, idx);
+	*(u16 *)ptr = pg->free;
+	pg->free = (char *)ptr - slab->base - idx * MALLOC_SLAB_PAGE + 1;
+	sc->frees++;
+	sc->in_use--;
+
+	/*
+	 * Give an empty page back for use by any class, unless it is the only
+	 * one in its class, to avoid chaining a new page for every allocation
+	 * when a single object is repeatedly allocated and freed.
+	 */
+	if (!--pg->used && (pg->prev != MALLOC_SLAB_NONE ||
+			    pg->next != MALLOC_SLAB_NONE)) {
+		slab_list_del(slab, &sc->partial, idx);
+		slab_list_add(slab, &slab->free_pages, idx);
+		slab->free_count++;
+		sc->pages--;
+	}
+
+	return true;
+}
+
+size_t malloc_slab_usable_size(void *ptr)
+{
+	struct malloc_slab *slab = gd->malloc_slab;
+	int idx;
+
+	if (!slab)
+		return 0;
+	idx = slab_page_of(slab, ptr);
+	if (idx < 0)
+		return 0;
+
+	return slab->cls[slab->page[idx].cls].size;
+}
+
+void *malloc_slab_realloc(void *ptr, size_t bytes)
+{
+	size_t size = malloc_slab_usable_size(ptr);
+	void *new;
+
+	/* Shrinking in place is fine since the object is small anyway */
+	if (bytes <= size)
+		return ptr;
+	new = malloc(bytes);
+	if (!new)
+		return NULL;
+	memcpy(new, ptr, size);
+	free(ptr);
+
+	return new;
+}
+
+ulong malloc_slab_unused(void)
+{
+	struct malloc_slab *slab = gd->malloc_slab;
+	ulong used = 0;
+	int i;
+
+	if (!slab)
+		return 0;
+	for (i = 0; i < MALLOC_SLAB_CLASSES; i++)
+		used += slab->cls[i].in_use * slab->cls[i].size;
+
+	return slab->size - used;
+}
+
+bool malloc_slab_set_enabled(bool enabled)
+{
+	struct malloc_slab *slab = gd->malloc_slab;
+	bool old;
+
+	if (!slab)
+		return false;
+	old = slab->enabled;
+	slab->enabled = enabled;
+
+	return old;
+}
+
+const struct malloc_slab_class *malloc_slab_get_class(int cls)
+{
+	struct malloc_slab *slab = gd->malloc_slab;
+
+	if (!slab || cls < 0 || cls >= MALLOC_SLAB_CLASSES)
+		return NULL;
+
+	return &slab->cls[cls];
+}
+
+void malloc_slab_info(void)
+{
+	struct malloc_slab *slab = gd->malloc_slab;
+	int i;
+
+	if (!slab) {
+		printf("No slab area\n");
+		return;
+	}
+	printf("Slab area: %lx bytes at %p, %u pages of %d bytes, %u free%s\n",
+	       slab->size, slab, slab->npages, MALLOC_SLAB_PAGE,
+	       slab->free_count, slab->enabled ? "" : " (disabled)");
+	printf(" size pages in use   peak     allocs      frees  fails\n");
+	for (i = 0; i < MALLOC_SLAB_CLASSES; i++) {
+		struct malloc_slab_class *sc = &slab->cls[i];
+
+		printf("%5u %5u %6u %6u %10u %10u %6u\n", sc->size,
+		       sc->pages, sc->in_use, sc->peak, sc->allocs, sc->frees,
+		       sc->fails);
+	}
+}
+
+int malloc_slab_trace_start(struct malloc_slab_trace *buf, int max)
+{
+	struct malloc_slab *slab = gd->malloc_slab;
+
+	if (!slab)
+		return -ENOSYS;
+	slab->trace_count = 0;
+	slab->trace_max = max;
+	slab->trace = buf;
+
+	return 0;
+}
+
+int malloc_slab_trace_stop(void)
+{
+	struct malloc_slab *slab = gd->malloc_slab;
+
+	if (!slab || !slab->trace)
+		return -ENOENT;
+	slab->trace = NULL;
+	if (slab->trace_count > slab->trace_max)
+		return -ENOSPC;
+
+	return slab->trace_count;
+}
@@ -11,6 +11,7 @@
 #include <gzip.h>
 #include <image.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <spl.h>
 #include <linux/libfdt.h>
 
@@ -217,6 +218,177 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return (data_size + info->bl_len - 1) / info->bl_len;
 }
 
+#if CONFIG_IS_ENABLED(FIT_STREAM)
+/**
+ * spl_fit_stream_image() - Load external image data a chunk at a time
+ * @info:	points to information about the device to load data from
+ * @sector:	the start sector of the FIT image on the device
+ * @fit:	points to the flattened device tree blob describing the FIT
+ *		image
+ * @node:	offset of the DT node describing the image to load
+ * @offset:	offset of the image data from @sector, in bytes
+ * @length:	size of the image data as stored, in bytes
+ * @gzip:	true to decompress the data
+ * @load_addr:	where the (uncompressed) image should end up
+ * @sizep:	returns the size of the loaded image
+ *
+ * With CONFIG_SPL_FIT_SIGNATURE each chunk is hashed straight after it is
+ * read. gzip data is then decompressed to @load_addr, so the data is only
+ * fetched from memory once. If the device has a double-buffered read
+ * (@info->queue), the next chunk of gzip data is read while the current one
+ * is hashed and decompressed.
+ *
+ * Compressed data reaches the decompressor before the hash over all of it
+ * can be checked. The decompressor only ever writes within @load_addr and
+ * CONFIG_SYS_BOOTM_LEN, and if the hash turns out to be wrong the image is
+ * rejected, so nothing runs the decompressed data.
+ *
+ * Return:	0 on success, -ENOTSUPP if the image must be loaded in one
+ *		piece instead, or another negative error number.
+ */
+static int spl_fit_stream_image(struct spl_load_info *info, ulong sector,
+				void *fit, int node, int offset, size_t length,
+				bool gzip, ulong load_addr, size_t *sizep)
+{
+	bool verify = IS_ENABLED(CONFIG_SPL_FIT_SIGNATURE);
+	int unit = info->filename ? 1 : info->bl_len;
+	int chunk = max(CONFIG_SPL_FIT_STREAM_CHUNK / unit, 1);
+	ulong overhead = get_aligned_image_overhead(info, offset);
+	int nr_sectors = get_aligned_image_size(info, length, offset);
+	ulong pos = sector + get_aligned_image_offset(info, offset);
+	struct gunzip_stream *gs = NULL;
+	struct fit_image_stream fs;
+	u8 *buf, *bounce = NULL, *bounce2 = NULL;
+	u8 *dst = (u8 *)load_addr;
+	bool queued = false;
+	size_t left = length;
+	size_t size;
+	ulong count;
+	int ret;
+
+	if (!gzip && !verify)
+		return -ENOTSUPP;
+
+	if (verify && fit_image_stream_start(&fs, fit, node))
+		return -ENOTSUPP;
+	if (gzip) {
+		bounce = malloc_cache_aligned(chunk * unit);
+		if (bounce)
+			gs = gunzip_stream_start(dst, CONFIG_SYS_BOOTM_LEN);
+		if (!gs) {
+			ret = -ENOMEM;
+			goto err;
+		}
+		buf = bounce;
+
+		/* With a second buffer, read ahead while this chunk is used */
+		if (info->queue)
+			bounce2 = malloc_cache_aligned(chunk * unit);
+		if (bounce2) {
+			ret = info->queue->start(info, pos, nr_sectors, bounce,
+						 bounce2, chunk);
+			if (ret)
+				goto err;
+			queued = true;
+		}
+	} else {
+		buf = (u8 *)ALIGN(load_addr, ARCH_DMA_MINALIGN);
+	}
+
+	while (nr_sectors) {
+		if (queued) {
+			ret = info->queue->next(info, (void **)&buf, &count);
+			if (!ret && (!count || count > (ulong)nr_sectors))
+				ret = -EIO;
+			if (ret)
+				goto err;
+		} else {
+			count = min(chunk, nr_sectors);
+			if (info->read(info, pos, count, buf) != count) {
+				ret = -EIO;
+				goto err;
+			}
+		}
+		size = min_t(size_t, left, count * unit - overhead);
+
+		if (gzip) {
+			/* The hash covers the compressed data */
+			if (verify) {
+				ret = fit_image_stream_update(&fs,
+							      buf + overhead,
+							      size);
+				if (ret)
+					goto err;
+			}
+			ret = gunzip_stream_feed(gs, buf + overhead, size);
+			if (ret)
+				goto err;
+		} else {
+			/*
+			 * Move the data down to the load address, if needed,
+			 * while it is in the cache. dst never passes buf, so
+			 * this cannot overwrite data which is still to come.
+			 */
+			if (dst != buf + overhead)
+				memmove(dst, buf + overhead, size);
+			buf += count * unit;
+			ret = fit_image_stream_update(&fs, dst, size);
+			if (ret)
+				goto err;
+		}
+
+		dst += size;
+		left -= size;
+		pos += count;
+		nr_sectors -= count;
+		overhead = 0;
+	}
+
+	*sizep = length;
+	if (gzip) {
+		ulong out_len;
+
+		ret = gunzip_stream_finish(gs, &out_len);
+		gs = NULL;
+		if (ret) {
+			puts("Uncompressing error\n");
+			goto err;
+		}
+		if (queued)
+			info->queue->stop(info);
+		queued = false;
+		free(bounce2);
+		bounce2 = NULL;
+		free(bounce);
+		bounce = NULL;
+		*sizep = out_len;
+	}
+
+	if (verify) {
+		/* The streamed hashes do not look at the data again */
+		printf("## Checking hash(es) for Image %s ... ",
+		       fit_get_name(fit, node, NULL));
+		if (!fit_image_stream_verify(&fs, (void *)load_addr, length))
+			return -EPERM;
+		puts("OK\n");
+	}
+
+	return 0;
+
+err:
+	if (queued)
+		info->queue->stop(info);
+	if (gs)
+		gunzip_stream_finish(gs, NULL);
+	free(bounce2);
+	free(bounce);
+	if (verify)
+		fit_image_stream_abort(&fs);
+
+	return ret;
+}
+#endif
+
 /**
  * spl_load_fit_image(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -250,6 +422,9 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	uint8_t image_comp = -1, type = -1;
 	const void *data;
 	bool external_data = false;
+#if CONFIG_IS_ENABLED(FIT_STREAM)
+	int ret;
+#endif
 
 	if (IS_ENABLED(CONFIG_SPL_FPGA_SUPPORT) ||
 	    (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP))) {
@@ -281,6 +456,17 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		if (fit_image_get_data_size(fit, node, &len))
 			return -ENOENT;
 
+#if CONFIG_IS_ENABLED(FIT_STREAM)
+		ret = spl_fit_stream_image(info, sector, fit, node, offset, len,
+					   IS_ENABLED(CONFIG_SPL_GZIP) &&
+					   image_comp == IH_COMP_GZIP,
+					   load_addr, &length);
+		if (!ret)
+			goto done;
+		if (ret != -ENOTSUPP)
+			return ret;
+#endif
+
 		load_ptr = (load_addr + align_len) & ~align_len;
 		length = len;
 
@@ -331,6 +517,9 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		memcpy((void *)load_addr, src, length);
 	}
 
+#if CONFIG_IS_ENABLED(FIT_STREAM)
+done:
+#endif
 	if (image_info) {
 		image_info->load_addr = load_addr;
 		image_info->size = length;
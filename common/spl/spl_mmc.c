@@ -49,6 +49,40 @@ static ulong h_spl_load_read(struct spl_load_info *load, ulong sector,
 	return blk_dread(mmc_get_blk_desc(mmc), sector, count, buf);
 }
 
+/* The queue is in load->priv */
+static int spl_mmc_queue_start(struct spl_load_info *load, ulong sector,
+			       ulong count, void *buf0, void *buf1,
+			       ulong chunk)
+{
+	struct mmc *mmc = load->dev;
+
+	return mmc_queue_start(load->priv, mmc_get_blk_desc(mmc), sector,
+			       count, buf0, buf1, chunk);
+}
+
+static int spl_mmc_queue_next(struct spl_load_info *load, void **bufp,
+			      ulong *countp)
+{
+	lbaint_t blocks;
+	int ret;
+
+	ret = mmc_queue_next(load->priv, bufp, &blocks);
+	*countp = blocks;
+
+	return ret;
+}
+
+static void spl_mmc_queue_stop(struct spl_load_info *load)
+{
+	mmc_queue_stop(load->priv);
+}
+
+static const struct spl_load_queue spl_mmc_queue = {
+	.start	= spl_mmc_queue_start,
+	.next	= spl_mmc_queue_next,
+	.stop	= spl_mmc_queue_stop,
+};
+
 static __maybe_unused
 int mmc_load_image_raw_sector(struct spl_image_info *spl_image,
 			      struct mmc *mmc, unsigned long sector)
@@ -71,6 +105,7 @@ int mmc_load_image_raw_sector(struct spl_image_info *spl_image,
 	if (IS_ENABLED(CONFIG_SPL_LOAD_FIT) &&
 	    image_get_magic(header) == FDT_MAGIC) {
 		struct spl_load_info load;
+		struct mmc_queue __maybe_unused queue;
 
 		debug("Found FIT\n");
 		load.dev = mmc;
@@ -78,6 +113,11 @@ int mmc_load_image_raw_sector(struct spl_image_info *spl_image,
 		load.filename = NULL;
 		load.bl_len = mmc->read_bl_len;
 		load.read = h_spl_load_read;
+		load.queue = NULL;
+		if (CONFIG_IS_ENABLED(MMC_QUEUE)) {
+			load.priv = &queue;
+			load.queue = &spl_mmc_queue;
+		}
 		ret = spl_load_simple_fit(spl_image, &load, sector, header);
 	} else if (IS_ENABLED(CONFIG_SPL_LOAD_IMX_CONTAINER)) {
 		struct spl_load_info load;
@@ -87,6 +127,7 @@ int mmc_load_image_raw_sector(struct spl_image_info *spl_image,
 		load.filename = NULL;
 		load.bl_len = mmc->read_bl_len;
 		load.read = h_spl_load_read;
+		load.queue = NULL;
 
 		ret = spl_load_imx_container(spl_image, &load, sector);
 	} else {
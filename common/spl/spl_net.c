@@ -52,6 +52,7 @@ static int spl_net_load_image(struct spl_image_info *spl_image,
 		debug("Found FIT\n");
 		load.bl_len = 1;
 		load.read = spl_net_load_read;
+		load.queue = NULL;
 		rv = spl_load_simple_fit(spl_image, &load, 0, header);
 	} else {
 		debug("Legacy image\n");
@@ -46,6 +46,7 @@ static int spl_nor_load_image(struct spl_image_info *spl_image,
 			debug("Found FIT\n");
 			load.bl_len = 1;
 			load.read = spl_nor_load_read;
+			load.queue = NULL;
 
 			ret = spl_load_simple_fit(spl_image, &load,
 						  CONFIG_SYS_OS_BASE,
@@ -93,6 +94,7 @@ static int spl_nor_load_image(struct spl_image_info *spl_image,
 		debug("Found FIT format U-Boot\n");
 		load.bl_len = 1;
 		load.read = spl_nor_load_read;
+		load.queue = NULL;
 		ret = spl_load_simple_fit(spl_image, &load,
 					  spl_nor_get_uboot_base(),
 					  (void *)header);
@@ -103,6 +105,7 @@ static int spl_nor_load_image(struct spl_image_info *spl_image,
 	if (IS_ENABLED(CONFIG_SPL_LOAD_IMX_CONTAINER)) {
 		load.bl_len = 1;
 		load.read = spl_nor_load_read;
+		load.queue = NULL;
 		return spl_load_imx_container(spl_image, &load,
 					      spl_nor_get_uboot_base());
 	}
@@ -138,6 +138,7 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 			load.filename = NULL;
 			load.bl_len = 1;
 			load.read = spl_spi_fit_read;
+			load.queue = NULL;
 			err = spl_load_simple_fit(spl_image, &load,
 						  payload_offs,
 						  header);
@@ -149,6 +150,7 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 			load.filename = NULL;
 			load.bl_len = 1;
 			load.read = spl_spi_fit_read;
+			load.queue = NULL;
 
 			err = spl_load_imx_container(spl_image, &load,
 						     payload_offs);
@@ -6,167 +6,595 @@
  */
 #include <config.h>
 #include <common.h>
+#include <blk.h>
+#include <dm.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <part.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * The cache is made of lines of max_blocks_per_entry blocks, each aligned to
+ * its own size on the device. Lines are grouped into sets of up to
+ * BLKCACHE_WAYS entries and a hash of (iftype, devnum, line number) selects
+ * the set, so a lookup only looks at a handful of lines. The least recently
+ * used line of a set is replaced on a miss.
+ *
+ * Each line keeps a bitmap of the blocks it holds, and in write-back mode a
+ * second bitmap of the blocks which have not reached the device yet.
+ */
+#define BLKCACHE_WAYS		4
+#define BLKCACHE_MAX_LINE	64	/* blocks, limited by the bitmaps */
 
 struct block_cache_node {
-	struct list_head lh;
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
+	lbaint_t start;		/* first block of the line */
 	unsigned long blksz;
+	u64 valid;		/* blocks present in @cache */
+	u64 dirty;		/* blocks not yet written to the device */
+	uint age;		/* value of cache_tick at last use */
 	char *cache;
 };
 
-static LIST_HEAD(block_cache);
+/* Per-device counters and read-ahead state */
+struct block_cache_dev {
+	struct list_head lh;
+	struct block_cache_dev_stats stats;
+	lbaint_t next;		/* block a sequential read would start at */
+	lbaint_t ra;		/* current read-ahead window, in blocks */
+};
+
+static struct block_cache_node *cache_lines;
+static unsigned cache_sets = 8;
+static unsigned cache_ways = BLKCACHE_WAYS;
+static uint cache_tick;
+static char *ra_buf;
+static size_t ra_buf_size;
+static LIST_HEAD(cache_devs);
 
 static struct block_cache_stats _stats = {
 	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_entries = 32,
+	.ways = BLKCACHE_WAYS,
 };
 
+static inline lbaint_t line_blocks(void)
+{
+	return _stats.max_blocks_per_entry;
+}
+
+/* Mask of @count blocks starting at @first within a line */
+static inline u64 line_mask(uint first, uint count)
+{
+	u64 mask = count >= 64 ? ~0ULL : (1ULL << count) - 1;
+
+	return mask << first;
+}
+
+/*
+ * Largest request which is cached, and also the largest read-ahead window.
+ * Anything bigger than a quarter of the cache (e.g. a kernel image) would
+ * only push out the metadata we want to keep.
+ */
+static lbaint_t cache_max_fill(void)
+{
+	return max(_stats.max_entries * line_blocks() / 4, line_blocks());
+}
+
+static bool cache_prepare(void)
+{
+	if (!_stats.max_entries || !_stats.max_blocks_per_entry)
+		return false;
+	if (!cache_lines)
+		cache_lines = calloc(_stats.max_entries, sizeof(*cache_lines));
+
+	return cache_lines != NULL;
+}
+
+static struct block_cache_dev *cache_dev(int iftype, int devnum, bool create)
+{
+	struct block_cache_dev *cdev;
+
+	list_for_each_entry(cdev, &cache_devs, lh)
+		if (cdev->stats.iftype == iftype &&
+		    cdev->stats.devnum == devnum)
+			return cdev;
+	if (!create)
+		return NULL;
+
+	cdev = calloc(1, sizeof(*cdev));
+	if (!cdev)
+		return NULL;
+	cdev->stats.iftype = iftype;
+	cdev->stats.devnum = devnum;
+	list_add_tail(&cdev->lh, &cache_devs);
+
+	return cdev;
+}
+
+static struct block_cache_node *cache_set(int iftype, int devnum,
+					  lbaint_t start)
+{
+	u32 hash;
+
+	hash = (u32)(start >> ilog2(line_blocks()));
+	hash ^= (u32)iftype << 24 ^ (u32)devnum << 16;
+	hash *= 0x9e3779b1;
+	if (cache_sets == 1)
+		return cache_lines;
+
+	return cache_lines + (hash >> (32 - ilog2(cache_sets))) * cache_ways;
+}
+
 static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+					   lbaint_t start, unsigned long blksz)
 {
-	struct block_cache_node *node;
+	struct block_cache_node *node = cache_set(iftype, devnum, start);
+	int i;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
+	start &= ~(line_blocks() - 1);
+	for (i = 0; i < cache_ways; i++, node++)
+		if (node->valid &&
+		    (node->iftype == iftype) &&
 		    (node->devnum == devnum) &&
 		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
+		    (node->start == start))
 			return node;
+
+	return NULL;
+}
+
+/* Write the dirty blocks of a line back to its device */
+static int cache_writeback(struct block_cache_node *node)
+{
+	struct block_cache_dev *cdev;
+	const struct blk_ops *ops;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	uint first, count;
+	int ret;
+
+	if (!node->dirty)
+		return 0;
+
+	ret = blk_find_device(node->iftype, node->devnum, &dev);
+	if (ret)
+		return ret;
+	desc = dev_get_uclass_platdata(dev);
+	ops = blk_get_ops(dev);
+	cdev = cache_dev(node->iftype, node->devnum, false);
+
+	for (first = 0; node->dirty; first += count) {
+		for (count = 0; first + count < line_blocks() &&
+		     (node->dirty & line_mask(first + count, 1)); count++)
+			;
+		if (!count) {
+			count = 1;
+			continue;
 		}
+		debug("writeback: start " LBAF ", count %u\n",
+		      node->start + first, count);
+		if (ops->write(dev, node->start + first, count,
+			       node->cache + first * desc->blksz) != count)
+			return -EIO;
+		node->dirty &= ~line_mask(first, count);
+		if (cdev)
+			cdev->stats.writebacks += count;
+	}
+
 	return 0;
 }
 
+static void cache_evict(struct block_cache_node *node)
+{
+	struct block_cache_dev *cdev;
+
+	debug("drop: start " LBAF "\n", node->start);
+	if (cache_writeback(node))
+		printf("blkcache: lost writes to %s %d at " LBAF "\n",
+		       blk_get_if_type_name(node->iftype), node->devnum,
+		       node->start);
+	cdev = cache_dev(node->iftype, node->devnum, false);
+	if (cdev)
+		cdev->stats.evictions++;
+	_stats.evictions++;
+	node->valid = 0;
+	node->dirty = 0;
+}
+
+static struct block_cache_node *cache_alloc(int iftype, int devnum,
+					    lbaint_t start,
+					    unsigned long blksz)
+{
+	struct block_cache_node *node = cache_set(iftype, devnum, start);
+	struct block_cache_node *victim = NULL;
+	int i;
+
+	for (i = 0; i < cache_ways; i++, node++) {
+		if (!node->valid) {
+			victim = node;
+			break;
+		}
+		if (!victim || (int)(node->age - victim->age) < 0)
+			victim = node;
+	}
+
+	if (victim->valid)
+		cache_evict(victim);
+
+	if (victim->cache && victim->blksz != blksz) {
+		free(victim->cache);
+		victim->cache = NULL;
+	}
+	if (!victim->cache) {
+		victim->cache = malloc(blksz * line_blocks());
+		if (!victim->cache)
+			return NULL;
+	}
+
+	victim->iftype = iftype;
+	victim->devnum = devnum;
+	victim->start = start & ~(line_blocks() - 1);
+	victim->blksz = blksz;
+
+	return victim;
+}
+
+/* Forget (without writing back) any cached copy of a range of blocks */
+static void cache_drop(int iftype, int devnum, lbaint_t start,
+		       lbaint_t blkcnt)
+{
+	struct block_cache_node *node;
+	lbaint_t lo, hi;
+	int i;
+
+	for (i = 0; i < _stats.max_entries; i++) {
+		node = &cache_lines[i];
+		if (!node->valid || node->iftype != iftype ||
+		    node->devnum != devnum ||
+		    node->start + line_blocks() <= start ||
+		    node->start >= start + blkcnt)
+			continue;
+		lo = max(node->start, start);
+		hi = min(node->start + line_blocks(), start + blkcnt);
+		node->valid &= ~line_mask(lo - node->start, hi - lo);
+		node->dirty &= node->valid;
+	}
+}
+
+/*
+ * Copy blocks which have not been written back over data just read from
+ * the device
+ */
+static void cache_overlay(int iftype, int devnum, lbaint_t start,
+			  lbaint_t blkcnt, unsigned long blksz, char *buffer)
+{
+	struct block_cache_node *node;
+	lbaint_t blk;
+	int i;
+	uint j;
+
+	for (i = 0; cache_lines && i < _stats.max_entries; i++) {
+		node = &cache_lines[i];
+		if (!node->dirty || node->iftype != iftype ||
+		    node->devnum != devnum || node->blksz != blksz ||
+		    node->start + line_blocks() <= start ||
+		    node->start >= start + blkcnt)
+			continue;
+		for (j = 0; j < line_blocks(); j++) {
+			blk = node->start + j;
+			if (blk < start || blk >= start + blkcnt ||
+			    !(node->dirty & line_mask(j, 1)))
+				continue;
+			memcpy(buffer + (blk - start) * blksz,
+			       node->cache + j * blksz, blksz);
+		}
+	}
+}
+
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
-		debug("hit: start " LBAF ", count " LBAFU "\n",
-		      start, blkcnt);
-		++_stats.hits;
-		return 1;
+	struct block_cache_dev *cdev = cache_dev(iftype, devnum, true);
+	struct block_cache_node *node;
+	lbaint_t blk, off, n, left;
+	bool sequential;
+	char *dst;
+
+	sequential = cdev && start == cdev->next;
+	if (cdev)
+		cdev->next = start + blkcnt;
+
+	if (!cache_lines || blkcnt > cache_max_fill())
+		goto miss;
+
+	for (left = blkcnt, blk = start, dst = buffer; left;
+	     blk += n, left -= n, dst += n * blksz) {
+		off = blk & (line_blocks() - 1);
+		n = min(left, line_blocks() - off);
+		node = cache_find(iftype, devnum, blk, blksz);
+		if (!node || (node->valid & line_mask(off, n)) !=
+		    line_mask(off, n))
+			goto miss;
+		node->age = ++cache_tick;
+		memcpy(dst, node->cache + off * blksz, n * blksz);
 	}
 
+	debug("hit: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+	++_stats.hits;
+	if (cdev)
+		cdev->stats.hits++;
+	return 1;
+
+miss:
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+	if (cdev) {
+		cdev->stats.misses++;
+		if (!sequential)
+			cdev->ra = 0;
+		else if (!cdev->ra)
+			cdev->ra = line_blocks();
+		else
+			cdev->ra = min(cdev->ra * 2, cache_max_fill());
+	}
 	return 0;
 }
 
+int blkcache_read_ahead(struct blk_desc *block_dev, lbaint_t start,
+			lbaint_t blkcnt, void *buffer)
+{
+	struct block_cache_dev *cdev;
+	const struct blk_ops *ops;
+	lbaint_t ra, total;
+	size_t size;
+
+	cdev = cache_dev(block_dev->if_type, block_dev->devnum, false);
+	if (!cdev || !cdev->ra || !cache_prepare() ||
+	    blkcnt >= cache_max_fill())
+		return 0;
+
+	ra = min(cdev->ra, cache_max_fill() - blkcnt);
+	if (start + blkcnt >= block_dev->lba)
+		return 0;
+	ra = min(ra, block_dev->lba - start - blkcnt);
+
+	total = blkcnt + ra;
+	size = total * block_dev->blksz;
+	if (size > ra_buf_size) {
+		free(ra_buf);
+		ra_buf = malloc_cache_aligned(size);
+		ra_buf_size = ra_buf ? size : 0;
+		if (!ra_buf)
+			return 0;
+	}
+
+	debug("read-ahead: start " LBAF ", count " LBAFU "\n",
+	      start + blkcnt, ra);
+	ops = blk_get_ops(block_dev->bdev);
+	if (ops->read(block_dev->bdev, start, total, ra_buf) != total)
+		return 0;
+
+	blkcache_fill(block_dev->if_type, block_dev->devnum, start, total,
+		      block_dev->blksz, ra_buf);
+	memcpy(buffer, ra_buf, blkcnt * block_dev->blksz);
+	cdev->stats.readahead += ra;
+
+	return 1;
+}
+
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
-		   unsigned long blksz, void const *buffer)
+		   unsigned long blksz, void *buffer)
 {
-	lbaint_t bytes;
 	struct block_cache_node *node;
+	lbaint_t off, n;
+	char *src;
+
+	/*
+	 * The cache may hold newer data than the device. Do this first, as
+	 * filling may evict lines and so write back blocks which were read.
+	 */
+	cache_overlay(iftype, devnum, start, blkcnt, blksz, buffer);
 
 	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
+	if (blkcnt > cache_max_fill())
 		return;
 
-	if (_stats.max_entries == 0)
+	if (!cache_prepare())
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
+	debug("fill: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+
+	for (src = buffer; blkcnt; start += n, blkcnt -= n, src += n * blksz) {
+		off = start & (line_blocks() - 1);
+		n = min(blkcnt, line_blocks() - off);
+		node = cache_find(iftype, devnum, start, blksz);
+		if (!node) {
+			node = cache_alloc(iftype, devnum, start, blksz);
+			if (!node)
+				return;
 		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
-	}
-
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
+		node->age = ++cache_tick;
+		memcpy(node->cache + off * blksz, src, n * blksz);
+		node->valid |= line_mask(off, n);
+	}
+}
+
+int blkcache_write(int iftype, int devnum,
+		   lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, const void *buffer)
+{
+	struct block_cache_node *node;
+	lbaint_t off, n, left, blk;
+	const char *src;
+
+	if (!cache_lines)
+		return 0;
+
+	if (!_stats.writeback || blkcnt > cache_max_fill())
+		goto write_through;
+
+	for (left = blkcnt, blk = start, src = buffer; left;
+	     blk += n, left -= n, src += n * blksz) {
+		off = blk & (line_blocks() - 1);
+		n = min(left, line_blocks() - off);
+		node = cache_find(iftype, devnum, blk, blksz);
+		if (!node) {
+			node = cache_alloc(iftype, devnum, blk, blksz);
+			if (!node)
+				goto write_through;
 		}
+		node->age = ++cache_tick;
+		memcpy(node->cache + off * blksz, src, n * blksz);
+		node->valid |= line_mask(off, n);
+		node->dirty |= line_mask(off, n);
 	}
+	debug("write: start " LBAF ", count " LBAFU "\n", start, blkcnt);
 
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
+	return 1;
+
+write_through:
+	cache_drop(iftype, devnum, start, blkcnt);
+	return 0;
+}
+
+int blkcache_flush(int iftype, int devnum)
+{
+	struct block_cache_node *node;
+	int i, ret = 0;
+
+	for (i = 0; cache_lines && i < _stats.max_entries; i++) {
+		node = &cache_lines[i];
+		if (node->dirty && (iftype == -1 || (node->iftype == iftype &&
+						    node->devnum == devnum))) {
+			if (cache_writeback(node) && !ret)
+				ret = -EIO;
+		}
+	}
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+	return ret;
+}
+
+void blkcache_flush_all(void)
+{
+	static bool flushing;
+
+	/* The cache is only set up after relocation */
+	if (!(gd->flags & GD_FLG_RELOC) || flushing)
+		return;
+
+	/* Do not come back here if writing panics */
+	flushing = true;
+	if (blkcache_flush(-1, 0))
+		printf("blkcache: lost writes\n");
+	flushing = false;
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
+	struct block_cache_dev *cdev;
 	struct block_cache_node *node;
+	int i;
+
+	if (blkcache_flush(iftype, devnum))
+		printf("blkcache: lost writes to %s %d\n",
+		       blk_get_if_type_name(iftype), devnum);
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	for (i = 0; cache_lines && i < _stats.max_entries; i++) {
+		node = &cache_lines[i];
 		if ((node->iftype == iftype) &&
 		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
+			node->valid = 0;
+			node->dirty = 0;
 		}
 	}
+
+	cdev = cache_dev(iftype, devnum, false);
+	if (cdev) {
+		cdev->next = 0;
+		cdev->ra = 0;
+	}
 }
 
 void blkcache_configure(unsigned blocks, unsigned entries)
 {
-	struct block_cache_node *node;
+	int i;
+
+	if (blocks > BLKCACHE_MAX_LINE)
+		blocks = BLKCACHE_MAX_LINE;
+	if (blocks)
+		blocks = rounddown_pow_of_two(blocks);
+	cache_ways = min(entries, (unsigned)BLKCACHE_WAYS);
+	cache_sets = cache_ways ? rounddown_pow_of_two(entries / cache_ways) :
+			0;
+	entries = cache_sets * cache_ways;
+
 	if ((blocks != _stats.max_blocks_per_entry) ||
 	    (entries != _stats.max_entries)) {
 		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
-		}
-		_stats.entries = 0;
+		blkcache_flush(-1, 0);
+		for (i = 0; cache_lines && i < _stats.max_entries; i++)
+			free(cache_lines[i].cache);
+		free(cache_lines);
+		cache_lines = NULL;
+		free(ra_buf);
+		ra_buf = NULL;
+		ra_buf_size = 0;
 	}
 
 	_stats.max_blocks_per_entry = blocks;
 	_stats.max_entries = entries;
+	_stats.ways = cache_ways;
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
+}
+
+void blkcache_set_writeback(bool enable)
+{
+	if (!enable)
+		blkcache_flush(-1, 0);
+	_stats.writeback = enable;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
 {
+	int i;
+
+	_stats.entries = 0;
+	for (i = 0; cache_lines && i < _stats.max_entries; i++)
+		if (cache_lines[i].valid)
+			_stats.entries++;
+
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
+}
+
+int blkcache_dev_stats(int idx, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *cdev;
+
+	list_for_each_entry(cdev, &cache_devs, lh) {
+		if (idx--)
+			continue;
+		memcpy(stats, &cdev->stats, sizeof(*stats));
+		memset(&cdev->stats.hits, '\0', sizeof(*stats) -
+		       offsetof(struct block_cache_dev_stats, hits));
+		return 0;
+	}
+
+	return -ENOENT;
 }
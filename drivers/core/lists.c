@@ -17,7 +17,12 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
+#include <linux/err.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -124,11 +129,203 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
-		   bool pre_reloc_only)
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+/* Marks an unused slot in the hash table */
+#define LISTS_COMPAT_EMPTY	0xffff
+
+/**
+ * struct lists_compat_ent - a compatible string in the hash table
+ *
+ * This uses indexes rather than pointers to keep the table small.
+ *
+ * @hash: Hash of the compatible string
+ * @drv: Index of the driver in the driver linker list
+ * @match: Index of the string in the driver's of_match list
+ */
+struct lists_compat_ent {
+	u32 hash;
+	u16 drv;
+	u16 match;
+};
+
+/**
+ * struct lists_compat_table - hash table of the compatible strings of drivers
+ *
+ * @mask: Number of slots less one; the number of slots is a power of two
+ * @ents: Slots, with collisions going in the next free slot
+ */
+struct lists_compat_table {
+	u32 mask;
+	struct lists_compat_ent ents[];
+};
+
+/* FNV-1a, which spreads similar strings well over the low bits */
+static u32 lists_compat_hash(const char *str)
+{
+	u32 hash = 2166136261U;
+
+	for (; *str; str++)
+		hash = (hash ^ (u8)*str) * 16777619U;
+
+	return hash;
+}
+
+/* Number of slots needed for the compatible strings of all drivers */
+static int lists_compat_slots(void)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	int count = 0;
+	int drv;
+
+	if (n_ents >= LISTS_COMPAT_EMPTY)
+		return 0;
+	for (drv = 0; drv < n_ents; drv++) {
+		for (id = driver[drv].of_match; id && id->compatible; id++)
+			count++;
+	}
+
+	/* Keep the table at most half full so that probes are short */
+	return __roundup_pow_of_two(max(count * 2, 16));
+}
+
+ulong lists_compat_size(void)
+{
+	int slots = lists_compat_slots();
+
+	if (!slots)
+		return 0;
+
+	return sizeof(struct lists_compat_table) +
+		slots * sizeof(struct lists_compat_ent);
+}
+
+int lists_compat_build(void *buf, ulong size)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct lists_compat_table *tbl = buf;
+	const struct udevice_id *id, *old;
+	struct lists_compat_ent *ent;
+	int slots, drv, match;
+	u32 hash, pos, mask;
+	const char *str;
+
+	slots = lists_compat_slots();
+	if (!slots)
+		return -E2BIG;
+	if (size < sizeof(*tbl) + slots * sizeof(*ent))
+		return -ENOSPC;
+	mask = slots - 1;
+	tbl->mask = mask;
+	memset(tbl->ents, '\xff', slots * sizeof(*ent));
+
+	/* Keep the first driver with each string, as the linear search does */
+	for (drv = 0; drv < n_ents; drv++) {
+		id = driver[drv].of_match;
+		for (match = 0; id && id[match].compatible; match++) {
+			str = id[match].compatible;
+			hash = lists_compat_hash(str);
+			for (pos = hash & mask;; pos = (pos + 1) & mask) {
+				ent = &tbl->ents[pos];
+				if (ent->drv == LISTS_COMPAT_EMPTY) {
+					ent->hash = hash;
+					ent->drv = drv;
+					ent->match = match;
+					break;
+				}
+				old = &driver[ent->drv].of_match[ent->match];
+				if (ent->hash == hash &&
+				    !strcmp(old->compatible, str))
+					break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Build the table in the full malloc() area */
+static struct lists_compat_table *lists_compat_alloc(void)
+{
+	ulong size = lists_compat_size();
+	void *tbl;
+	int ret;
+
+	if (!size)
+		return ERR_PTR(-E2BIG);
+	tbl = malloc(size);
+	if (!tbl)
+		return ERR_PTR(-ENOMEM);
+	ret = lists_compat_build(tbl, size);
+	if (ret) {
+		free(tbl);
+		return ERR_PTR(ret);
+	}
+	log_debug("compatible-string table of %lu bytes\n", size);
+
+	return tbl;
+}
+
+static int lists_compat_find(struct lists_compat_table *tbl,
+			     const char *compat, struct driver **drvp,
+			     const struct udevice_id **idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const struct udevice_id *id;
+	struct lists_compat_ent *ent;
+	u32 hash, pos;
+
+	hash = lists_compat_hash(compat);
+	for (pos = hash & tbl->mask;; pos = (pos + 1) & tbl->mask) {
+		ent = &tbl->ents[pos];
+		if (ent->drv == LISTS_COMPAT_EMPTY)
+			return -ENOENT;
+		if (ent->hash != hash)
+			continue;
+		id = &driver[ent->drv].of_match[ent->match];
+		if (!strcmp(id->compatible, compat)) {
+			*drvp = &driver[ent->drv];
+			*idp = id;
+			return 0;
+		}
+	}
+}
+#endif
+
+int lists_driver_lookup_compat(const char *compat, struct driver **drvp,
+			       const struct udevice_id **idp)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	/*
+	 * Before relocation the table is in memory reserved next to the
+	 * early malloc() area (see board_init_f_init_reserve()). After
+	 * relocation it is built again in the full malloc() area. It is
+	 * only built once: if that fails, keep searching linearly.
+	 */
+	if (!gd->dm_compat && (gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		gd->dm_compat = lists_compat_alloc();
+	if (gd->dm_compat && !IS_ERR(gd->dm_compat))
+		return lists_compat_find(gd->dm_compat, compat, drvp, idp);
+#endif
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, idp, compat)) {
+			*drvp = entry;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
+		   bool pre_reloc_only)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -165,13 +362,8 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		log_debug("   - attempt to match compatible string '%s'\n",
 			  compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		ret = lists_driver_lookup_compat(compat, &entry, &id);
+		if (ret)
 			continue;
 
 		if (pre_reloc_only) {
@@ -295,9 +295,8 @@ static struct device_node *__of_find_node_by_path(struct device_node *parent,
 		return NULL;
 
 	__for_each_child_of_node(parent, child) {
-		const char *name = strrchr(child->full_name, '/');
+		const char *name = child->full_name;
 
-		name++;
 		if (strncmp(path, name, len) == 0 && (strlen(name) == len))
 			return child;
 	}
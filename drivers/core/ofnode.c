@@ -39,8 +39,8 @@ int ofnode_read_u32(ofnode node, const char *propname, u32 *outp)
 		const fdt32_t *cell;
 		int len;
 
-		cell = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node),
-				   propname, &len);
+		cell = fdtdec_getprop(gd->fdt_blob, ofnode_to_offset(node),
+				      propname, &len);
 		if (!cell || len < sizeof(int)) {
 			debug("(not found)\n");
 			return -EINVAL;
@@ -79,8 +79,8 @@ int ofnode_read_u64(ofnode node, const char *propname, u64 *outp)
 	if (ofnode_is_np(node))
 		return of_read_u64(ofnode_to_np(node), propname, outp);
 
-	cell = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
-			   &len);
+	cell = fdtdec_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
+			      &len);
 	if (!cell || len < sizeof(*cell)) {
 		debug("(not found)\n");
 		return -EINVAL;
@@ -131,8 +131,8 @@ const char *ofnode_read_string(ofnode node, const char *propname)
 			len = prop->length;
 		}
 	} else {
-		str = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node),
-				  propname, &len);
+		str = fdtdec_getprop(gd->fdt_blob, ofnode_to_offset(node),
+				     propname, &len);
 	}
 	if (!str) {
 		debug("<not found>\n");
@@ -217,8 +217,8 @@ ofnode ofnode_get_parent(ofnode node)
 	if (ofnode_is_np(node))
 		parent = np_to_ofnode(of_get_parent(ofnode_to_np(node)));
 	else
-		parent.of_offset = fdt_parent_offset(gd->fdt_blob,
-						     ofnode_to_offset(node));
+		parent.of_offset = fdtdec_parent_offset(gd->fdt_blob,
+							ofnode_to_offset(node));
 
 	return parent;
 }
@@ -231,7 +231,7 @@ const char *ofnode_get_name(ofnode node)
 	}
 
 	if (ofnode_is_np(node))
-		return strrchr(node.np->full_name, '/') + 1;
+		return node.np->full_name;
 
 	return fdt_get_name(gd->fdt_blob, ofnode_to_offset(node), NULL);
 }
@@ -243,8 +243,7 @@ ofnode ofnode_get_by_phandle(uint phandle)
 	if (of_live_active())
 		node = np_to_ofnode(of_find_node_by_phandle(phandle));
 	else
-		node.of_offset = fdt_node_offset_by_phandle(gd->fdt_blob,
-							    phandle);
+		node.of_offset = fdtdec_node_by_phandle(gd->fdt_blob, phandle);
 
 	return node;
 }
@@ -260,8 +259,8 @@ int ofnode_read_size(ofnode node, const char *propname)
 		if (prop)
 			return prop->length;
 	} else {
-		if (fdt_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
-				&len))
+		if (fdtdec_getprop(gd->fdt_blob, ofnode_to_offset(node),
+				   propname, &len))
 			return len;
 	}
 
@@ -545,8 +544,8 @@ const void *ofnode_get_property(ofnode node, const char *propname, int *lenp)
 	if (ofnode_is_np(node))
 		return of_get_property(ofnode_to_np(node), propname, lenp);
 	else
-		return fdt_getprop(gd->fdt_blob, ofnode_to_offset(node),
-				   propname, lenp);
+		return fdtdec_getprop(gd->fdt_blob, ofnode_to_offset(node),
+				      propname, lenp);
 }
 
 bool ofnode_is_available(ofnode node)
@@ -816,7 +815,7 @@ ofnode ofnode_by_compatible(ofnode from, const char *compat)
 			(struct device_node *)ofnode_to_np(from), NULL,
 			compat));
 	} else {
-		return offset_to_ofnode(fdt_node_offset_by_compatible(
+		return offset_to_ofnode(fdtdec_node_by_compatible(
 				gd->fdt_blob, ofnode_to_offset(from), compat));
 	}
 }
@@ -7,6 +7,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <errno.h>
 #include <fdtdec.h>
 #include <malloc.h>
@@ -138,6 +139,16 @@ int dm_init(bool of_live)
 		return -EINVAL;
 	}
 	INIT_LIST_HEAD(&DM_UCLASS_ROOT_NON_CONST);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	/* Before relocation, save malloc() space by using the lists */
+	if (gd->uclass_by_id) {
+		memset(gd->uclass_by_id, '\0',
+		       UCLASS_COUNT * sizeof(*gd->uclass_by_id));
+	} else if (gd->flags & GD_FLG_FULL_MALLOC_INIT) {
+		gd->uclass_by_id = calloc(UCLASS_COUNT,
+					  sizeof(*gd->uclass_by_id));
+	}
+#endif
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 	fix_drivers();
@@ -376,6 +387,14 @@ int dm_init_and_scan(bool pre_reloc_only)
 	}
 
 	if (CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)) {
+		if (CONFIG_IS_ENABLED(OF_INDEX) && !of_live_active()) {
+			bootstage_start(BOOTSTAGE_ID_ACCUM_OF_INDEX, "of_index");
+			ret = fdtdec_index_init(gd->fdt_blob);
+			bootstage_accum(BOOTSTAGE_ID_ACCUM_OF_INDEX);
+			/* Lookups still work without the index, just slower */
+			if (ret)
+				debug("fdtdec_index_init() failed: %d\n", ret);
+		}
 		ret = dm_extended_scan_fdt(gd->fdt_blob, pre_reloc_only);
 		if (ret) {
 			debug("dm_extended_scan_dt() failed: %d\n", ret);
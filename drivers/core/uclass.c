@@ -21,17 +21,296 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/**
+ * struct uclass_node_ent - Entry in the hash table of device tree nodes
+ *
+ * @key: Node pointer (live tree) or offset (flat tree) of the device
+ * @dev: First device bound to this node, or NULL if the entry is empty
+ */
+struct uclass_node_ent {
+	ulong key;
+	struct udevice *dev;
+};
+
+/**
+ * struct uclass_index - Index of the devices in a uclass
+ *
+ * This mirrors the uclass's device list so that the common lookups do not
+ * need to walk it. It is updated as devices are bound, unbound, probed and
+ * removed. If it cannot be updated (e.g. out of memory) it is dropped and
+ * the list is used instead.
+ *
+ * @devs: Devices in the same order as the uclass's device list
+ * @dev_count: Number of devices in @devs
+ * @dev_alloc: Number of entries allocated in @devs
+ * @seq_devs: Probed devices indexed by sequence number
+ * @seq_alloc: Number of entries allocated in @seq_devs
+ * @nodes: Hash table of devices by device tree node, using linear probing
+ * @node_mask: Number of entries in @nodes minus one, or 0 if none
+ * @node_used: Number of entries in @nodes which are in use
+ */
+struct uclass_index {
+	struct udevice **devs;
+	int dev_count;
+	int dev_alloc;
+	struct udevice **seq_devs;
+	int seq_alloc;
+	struct uclass_node_ent *nodes;
+	uint node_mask;
+	uint node_used;
+};
+
+static ulong uclass_node_key(ofnode node)
+{
+	if (of_live_active())
+		return (ulong)ofnode_to_np(node);
+
+	return ofnode_to_offset(node);
+}
+
+static uint uclass_node_hash(ulong key)
+{
+	u32 hash = (u32)key ^ (u32)((u64)key >> 32);
+
+	/* Pointers and offsets are aligned, so mix in the upper bits */
+	hash *= 0x9e3779b1;
+
+	return hash ^ (hash >> 16);
+}
+
+static struct uclass_node_ent *uclass_node_slot(struct uclass_node_ent *nodes,
+						uint mask, ulong key)
+{
+	uint i;
+
+	for (i = uclass_node_hash(key) & mask;; i = (i + 1) & mask) {
+		if (!nodes[i].dev || nodes[i].key == key)
+			return &nodes[i];
+	}
+}
+
+static void uclass_index_drop(struct uclass *uc)
+{
+	struct uclass_index *idx = uc->index;
+
+	if (!idx)
+		return;
+	log_debug("Dropping index for uclass '%s'\n", uc->uc_drv->name);
+	free(idx->devs);
+	free(idx->seq_devs);
+	free(idx->nodes);
+	free(idx);
+	uc->index = NULL;
+}
+
+static int uclass_index_node_grow(struct uclass_index *idx)
+{
+	struct uclass_node_ent *nodes, *ent;
+	uint size, mask, i;
+
+	size = idx->nodes ? (idx->node_mask + 1) * 2 : 16;
+	nodes = calloc(size, sizeof(*nodes));
+	if (!nodes)
+		return -ENOMEM;
+	mask = size - 1;
+	for (i = 0; idx->nodes && i <= idx->node_mask; i++) {
+		ent = &idx->nodes[i];
+		if (ent->dev)
+			*uclass_node_slot(nodes, mask, ent->key) = *ent;
+	}
+	free(idx->nodes);
+	idx->nodes = nodes;
+	idx->node_mask = mask;
+
+	return 0;
+}
+
+static int uclass_index_add(struct uclass_index *idx, struct udevice *dev)
+{
+	struct uclass_node_ent *ent;
+	struct udevice **devs;
+	ulong key;
+	int ret;
+
+	if (idx->dev_count == idx->dev_alloc) {
+		int count = idx->dev_alloc ? idx->dev_alloc * 2 : 8;
+
+		devs = realloc(idx->devs, count * sizeof(*devs));
+		if (!devs)
+			return -ENOMEM;
+		idx->devs = devs;
+		idx->dev_alloc = count;
+	}
+	if (ofnode_valid(dev->node)) {
+		if (!idx->nodes || (idx->node_used + 1) * 4 >
+		    (idx->node_mask + 1) * 3) {
+			ret = uclass_index_node_grow(idx);
+			if (ret)
+				return ret;
+		}
+		key = uclass_node_key(dev->node);
+		ent = uclass_node_slot(idx->nodes, idx->node_mask, key);
+
+		/* Lookups return the first device, so keep that one */
+		if (!ent->dev) {
+			ent->key = key;
+			ent->dev = dev;
+			idx->node_used++;
+		}
+	}
+	idx->devs[idx->dev_count++] = dev;
+
+	return 0;
+}
+
+static bool uclass_index_node_remove(struct uclass_index *idx,
+				     struct udevice *dev, ulong *keyp)
+{
+	struct uclass_node_ent *nodes = idx->nodes;
+	uint mask = idx->node_mask;
+	uint i, j, k;
+
+	i = uclass_node_slot(nodes, mask, uclass_node_key(dev->node)) - nodes;
+	if (nodes[i].dev != dev) {
+		/* The driver may have changed the node since binding */
+		for (i = 0; i <= mask && nodes[i].dev != dev; i++)
+			;
+		if (i > mask)
+			return false;
+	}
+	*keyp = nodes[i].key;
+
+	/* Move later entries back so that no probe sequence is broken */
+	for (j = i;;) {
+		j = (j + 1) & mask;
+		if (!nodes[j].dev)
+			break;
+		k = uclass_node_hash(nodes[j].key) & mask;
+		if (i <= j ? (k <= i || k > j) : (k <= i && k > j)) {
+			nodes[i] = nodes[j];
+			i = j;
+		}
+	}
+	nodes[i].dev = NULL;
+	idx->node_used--;
+
+	return true;
+}
+
+static void uclass_index_remove(struct uclass_index *idx, struct udevice *dev)
+{
+	struct uclass_node_ent *ent;
+	struct udevice *other;
+	ulong key;
+	int i;
+
+	for (i = 0; i < idx->dev_count; i++) {
+		if (idx->devs[i] == dev) {
+			idx->dev_count--;
+			memmove(&idx->devs[i], &idx->devs[i + 1],
+				(idx->dev_count - i) * sizeof(*idx->devs));
+			break;
+		}
+	}
+	if (idx->node_used && uclass_index_node_remove(idx, dev, &key)) {
+		/* Another device may have the same node, so add the first */
+		for (i = 0; i < idx->dev_count; i++) {
+			other = idx->devs[i];
+			if (ofnode_valid(other->node) &&
+			    uclass_node_key(other->node) == key) {
+				ent = uclass_node_slot(idx->nodes,
+						       idx->node_mask, key);
+				ent->key = key;
+				ent->dev = other;
+				idx->node_used++;
+				break;
+			}
+		}
+	}
+	if (dev->seq >= 0 && dev->seq < idx->seq_alloc &&
+	    idx->seq_devs[dev->seq] == dev)
+		idx->seq_devs[dev->seq] = NULL;
+}
+
+static int uclass_index_set_seq(struct uclass_index *idx, struct udevice *dev,
+				int seq)
+{
+	struct udevice **seq_devs;
+
+	if (seq >= idx->seq_alloc) {
+		int count = max(seq + 1, idx->seq_alloc ? idx->seq_alloc * 2 :
+				8);
+
+		count = min(count, DM_MAX_SEQ);
+		seq_devs = realloc(idx->seq_devs, count * sizeof(*seq_devs));
+		if (!seq_devs)
+			return -ENOMEM;
+		memset(&seq_devs[idx->seq_alloc], '\0',
+		       (count - idx->seq_alloc) * sizeof(*seq_devs));
+		idx->seq_devs = seq_devs;
+		idx->seq_alloc = count;
+	}
+	if (idx->seq_devs[seq])
+		return -EEXIST;
+	idx->seq_devs[seq] = dev;
+
+	return 0;
+}
+
+/**
+ * uclass_index_find_node() - Find a device by node using the index
+ *
+ * @idx: Index to search
+ * @node: Node to search for
+ * @return first device in the uclass with that node, or NULL if the index
+ *	does not know of one (the caller must then walk the list)
+ */
+static struct udevice *uclass_index_find_node(struct uclass_index *idx,
+					      ofnode node)
+{
+	struct uclass_node_ent *ent;
+
+	if (!idx->node_used)
+		return NULL;
+	ent = uclass_node_slot(idx->nodes, idx->node_mask,
+			       uclass_node_key(node));
+	if (!ent->dev || !ofnode_equal(dev_ofnode(ent->dev), node))
+		return NULL;
+
+	return ent->dev;
+}
+#endif
+
+void uclass_set_seq(struct udevice *dev, int seq)
+{
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct uclass *uc = dev->uclass;
+	struct uclass_index *idx = uc->index;
+
+	if (idx) {
+		if (dev->seq >= 0 && dev->seq < idx->seq_alloc &&
+		    idx->seq_devs[dev->seq] == dev)
+			idx->seq_devs[dev->seq] = NULL;
+		/* Larger numbers are rare, so lookups just walk the list */
+		if (seq >= 0 && seq < DM_MAX_SEQ &&
+		    uclass_index_set_seq(idx, dev, seq))
+			uclass_index_drop(uc);
+	}
+#endif
+	dev->seq = seq;
+}
+
 struct uclass *uclass_find(enum uclass_id key)
 {
 	struct uclass *uc;
 
 	if (!gd->dm_root)
 		return NULL;
-	/*
-	 * TODO(sjg@chromium.org): Optimise this, perhaps moving the found
-	 * node to the start of the list, or creating a linear array mapping
-	 * id to node.
-	 */
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (gd->uclass_by_id && key >= 0 && key < UCLASS_COUNT)
+		return gd->uclass_by_id[key];
+#endif
 	list_for_each_entry(uc, &gd->uclass_root, sibling_node) {
 		if (uc->uc_drv->id == key)
 			return uc;
@@ -81,6 +360,14 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	INIT_LIST_HEAD(&uc->sibling_node);
 	INIT_LIST_HEAD(&uc->dev_head);
 	list_add(&uc->sibling_node, &DM_UCLASS_ROOT_NON_CONST);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (gd->uclass_by_id) {
+		gd->uclass_by_id[id] = uc;
+
+		/* If this fails the device list is used instead */
+		uc->index = calloc(1, sizeof(*uc->index));
+	}
+#endif
 
 	if (uc_drv->init) {
 		ret = uc_drv->init(uc);
@@ -96,6 +383,11 @@ fail:
 		free(uc->priv);
 		uc->priv = NULL;
 	}
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (gd->uclass_by_id)
+		gd->uclass_by_id[id] = NULL;
+	uclass_index_drop(uc);
+#endif
 	list_del(&uc->sibling_node);
 fail_mem:
 	free(uc);
@@ -129,6 +421,11 @@ int uclass_destroy(struct uclass *uc)
 	uc_drv = uc->uc_drv;
 	if (uc_drv->destroy)
 		uc_drv->destroy(uc);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (gd->uclass_by_id && gd->uclass_by_id[uc_drv->id] == uc)
+		gd->uclass_by_id[uc_drv->id] = NULL;
+	uclass_index_drop(uc);
+#endif
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto_alloc_size)
 		free(uc->priv);
@@ -206,6 +503,14 @@ int uclass_find_device(enum uclass_id id, int index, struct udevice **devp)
 		return ret;
 	if (list_empty(&uc->dev_head))
 		return -ENODEV;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->index) {
+		if (index < 0 || index >= uc->index->dev_count)
+			return -ENODEV;
+		*devp = uc->index->devs[index];
+		return 0;
+	}
+#endif
 
 	uclass_foreach_dev(dev, uc) {
 		if (!index--) {
@@ -311,6 +616,18 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 	ret = uclass_get(id, &uc);
 	if (ret)
 		return ret;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	/* Drivers may set req_seq themselves, so only seq is indexed */
+	if (uc->index && !find_req_seq && seq_or_req_seq < DM_MAX_SEQ) {
+		struct uclass_index *idx = uc->index;
+
+		if (seq_or_req_seq >= 0 && seq_or_req_seq < idx->seq_alloc)
+			*devp = idx->seq_devs[seq_or_req_seq];
+		log_debug("   - %sfound in index\n", *devp ? "" : "not ");
+
+		return *devp ? 0 : -ENODEV;
+	}
+#endif
 
 	uclass_foreach_dev(dev, uc) {
 		log_debug("   - %d %d '%s'\n",
@@ -340,6 +657,14 @@ int uclass_find_device_by_of_offset(enum uclass_id id, int node,
 	ret = uclass_get(id, &uc);
 	if (ret)
 		return ret;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->index && !of_live_active()) {
+		*devp = uclass_index_find_node(uc->index,
+					       offset_to_ofnode(node));
+		if (*devp)
+			return 0;
+	}
+#endif
 
 	uclass_foreach_dev(dev, uc) {
 		if (dev_of_offset(dev) == node) {
@@ -365,6 +690,13 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	ret = uclass_get(id, &uc);
 	if (ret)
 		return ret;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->index) {
+		*devp = uclass_index_find_node(uc->index, node);
+		if (*devp)
+			goto done;
+	}
+#endif
 
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
@@ -636,6 +968,10 @@ int uclass_bind_device(struct udevice *dev)
 
 	uc = dev->uclass;
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->index && uclass_index_add(uc->index, dev))
+		uclass_index_drop(uc);
+#endif
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -650,6 +986,10 @@ int uclass_bind_device(struct udevice *dev)
 	return 0;
 err:
 	/* There is no need to undo the parent's post_bind call */
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->index)
+		uclass_index_remove(uc->index, dev);
+#endif
 	list_del(&dev->uclass_node);
 
 	return ret;
@@ -668,6 +1008,10 @@ int uclass_unbind_device(struct udevice *dev)
 			return ret;
 	}
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->index)
+		uclass_index_remove(uc->index, dev);
+#endif
 	list_del(&dev->uclass_node);
 	return 0;
 }
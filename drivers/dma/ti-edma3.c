@@ -24,7 +24,13 @@
 #define EDMA3_CHMAP_PARSET_SHIFT		0x5
 #define EDMA3_CHMAP_TRIGWORD_SHIFT		0x2
 
+#define EDMA3_DCHMAP(ch)			(0x0100 + ((ch) << 2))
+#define EDMA3_EMCR				0x308
 #define EDMA3_QEMCR				0x314
+#define EDMA3_ECR				0x1008
+#define EDMA3_EECR				0x1028
+#define EDMA3_EESR				0x1030
+#define EDMA3_SECR				0x1040
 #define EDMA3_IPR				0x1068
 #define EDMA3_IPRH				0x106c
 #define EDMA3_ICR				0x1070
@@ -393,6 +399,60 @@ void qedma3_stop(u32 base, struct edma3_channel_config *cfg)
 	__raw_writel(0, base + EDMA3_QCHMAP(cfg->chnum));
 }
 
+/* Write the bit for @ch to a register pair covering channels 0-31, 32-63 */
+static void edma3_write_ch_bit(u32 base, u32 reg, int ch)
+{
+	__raw_writel(1 << (ch & 31), base + reg + (ch >= 32 ? 4 : 0));
+}
+
+/**
+ * edma3_start - enable an event-triggered dma channel
+ * @base: base address of edma
+ * @cfg: pointer to struct edma3_channel_config where you can set
+ * the slot number to associate with, the chnum, which is the dma
+ * event number 0-63, and the complete code to raise when the transfer
+ * in the slot is done. trigger_slot_word is not used.
+ *
+ * Each event from the peripheral then starts one transfer (one array,
+ * or one frame with AB sync) of the slot.
+ */
+void edma3_start(u32 base, struct edma3_channel_config *cfg)
+{
+	/* Clear the pending int bit */
+	edma3_write_ch_bit(base, EDMA3_ICR, cfg->complete_code);
+
+	/* Map parameter set to the channel */
+	__raw_writel((EDMA3_CHMAP_PARSET_MASK & cfg->slot)
+		     << EDMA3_CHMAP_PARSET_SHIFT,
+		     base + EDMA3_DCHMAP(cfg->chnum));
+
+	/* Clear stale and missed events */
+	edma3_write_ch_bit(base, EDMA3_ECR, cfg->chnum);
+	edma3_write_ch_bit(base, EDMA3_SECR, cfg->chnum);
+	edma3_write_ch_bit(base, EDMA3_EMCR, cfg->chnum);
+
+	/* Enable the event */
+	edma3_write_ch_bit(base, EDMA3_EESR, cfg->chnum);
+}
+
+/**
+ * edma3_stop - stops dma on the channel passed
+ * @base: base address of edma
+ * @cfg: pointer to struct edma3_channel_config which was passed
+ * to edma3_start when you started the channel
+ */
+void edma3_stop(u32 base, struct edma3_channel_config *cfg)
+{
+	/* Disable the event */
+	edma3_write_ch_bit(base, EDMA3_EECR, cfg->chnum);
+
+	/* Clean up the interrupt indication and any missed event */
+	edma3_write_ch_bit(base, EDMA3_ICR, cfg->complete_code);
+	edma3_write_ch_bit(base, EDMA3_ECR, cfg->chnum);
+	edma3_write_ch_bit(base, EDMA3_SECR, cfg->chnum);
+	edma3_write_ch_bit(base, EDMA3_EMCR, cfg->chnum);
+}
+
 void __edma3_transfer(unsigned long edma3_base_addr, unsigned int edma_slot_num,
 		      void *dst, void *src, size_t len, size_t s_len)
 {
@@ -136,6 +136,166 @@ int mmc_host_power_cycle(struct mmc *mmc)
 	return dm_mmc_host_power_cycle(mmc->dev);
 }
 
+#if CONFIG_IS_ENABLED(MMC_QUEUE)
+static bool dm_mmc_can_queue(struct udevice *dev)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	return ops->send_cmd_start && ops->send_cmd_wait;
+}
+
+int dm_mmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+	int ret;
+
+	if (!dm_mmc_can_queue(dev))
+		return dm_mmc_send_cmd(dev, cmd, data);
+
+	mmmc_trace_before_send(mmc, cmd);
+	ret = ops->send_cmd_start(dev, cmd, data);
+	mmmc_trace_after_send(mmc, cmd, ret);
+
+	return ret;
+}
+
+int dm_mmc_send_cmd_wait(struct udevice *dev, struct mmc_data *data)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (!dm_mmc_can_queue(dev))
+		return 0;
+	return ops->send_cmd_wait(dev, data);
+}
+
+/* Request the next chunk into buffer @idx */
+static int mmc_queue_request(struct mmc_queue *q, int idx)
+{
+	struct mmc *mmc = q->mmc;
+	lbaint_t cnt = min(q->left, q->chunk);
+	int ret;
+
+	q->count[idx] = 0;
+	if (!cnt)
+		return 0;
+
+	if (cnt > 1)
+		q->cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
+	else
+		q->cmd.cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
+	if (mmc->high_capacity)
+		q->cmd.cmdarg = q->next;
+	else
+		q->cmd.cmdarg = q->next * mmc->read_bl_len;
+	q->cmd.resp_type = MMC_RSP_R1;
+
+	q->data.dest = q->buf[idx];
+	q->data.blocks = cnt;
+	q->data.blocksize = mmc->read_bl_len;
+	q->data.flags = MMC_DATA_READ;
+
+	ret = dm_mmc_send_cmd_start(mmc->dev, &q->cmd, &q->data);
+	if (ret)
+		return ret;
+	q->count[idx] = cnt;
+	q->next += cnt;
+	q->left -= cnt;
+
+	return 0;
+}
+
+/* Wait for the request in flight and stop a multi-block transfer */
+static int mmc_queue_wait(struct mmc_queue *q)
+{
+	struct mmc_cmd cmd;
+	int ret;
+
+	ret = dm_mmc_send_cmd_wait(q->mmc->dev, &q->data);
+	if (ret)
+		return ret;
+
+	if (q->data.blocks > 1) {
+		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+		cmd.cmdarg = 0;
+		cmd.resp_type = MMC_RSP_R1b;
+		ret = mmc_send_cmd(q->mmc, &cmd, NULL);
+	}
+
+	return ret;
+}
+
+int mmc_queue_start(struct mmc_queue *q, struct blk_desc *desc,
+		    lbaint_t start, lbaint_t blkcnt, void *buf0, void *buf1,
+		    lbaint_t chunk)
+{
+	struct mmc *mmc;
+	int ret;
+
+	memset(q, '\0', sizeof(*q));
+	mmc = find_mmc_device(desc->devnum);
+	if (!mmc)
+		return -ENODEV;
+	if (start + blkcnt > desc->lba)
+		return -ERANGE;
+
+	ret = blk_dselect_hwpart(desc, desc->hwpart);
+	if (ret)
+		return ret;
+	ret = mmc_set_blocklen(mmc, mmc->read_bl_len);
+	if (ret)
+		return ret;
+
+	q->mmc = mmc;
+	q->next = start;
+	q->left = blkcnt;
+	q->chunk = min_t(lbaint_t, chunk, mmc->cfg->b_max);
+	if (!q->chunk)
+		return -EINVAL;
+	q->buf[0] = buf0;
+	q->buf[1] = buf1;
+
+	return mmc_queue_request(q, 0);
+}
+
+int mmc_queue_next(struct mmc_queue *q, void **bufp, lbaint_t *blocksp)
+{
+	int idx = q->cur;
+	int ret;
+
+	*bufp = NULL;
+	*blocksp = 0;
+	if (!q->count[idx])
+		return 0;
+
+	ret = mmc_queue_wait(q);
+	if (!ret)
+		ret = mmc_queue_request(q, !idx);
+	if (ret) {
+		q->count[0] = 0;
+		q->count[1] = 0;
+		q->left = 0;
+		return ret;
+	}
+
+	*bufp = q->buf[idx];
+	*blocksp = q->count[idx];
+	q->cur = !idx;
+
+	return 0;
+}
+
+void mmc_queue_stop(struct mmc_queue *q)
+{
+	if (q->count[q->cur])
+		mmc_queue_wait(q);
+	q->count[0] = 0;
+	q->count[1] = 0;
+	q->left = 0;
+}
+#endif
+
 int mmc_of_parse(struct udevice *dev, struct mmc_config *cfg)
 {
 	int val;
@@ -380,6 +540,11 @@ static int mmc_select_hwpart(struct udevice *bdev, int hwpart)
 	if (mmc->part_config == MMCPART_NOAVAILABLE)
 		return -EMEDIUMTYPE;
 
+	/* Dirty cached blocks belong to the current partition */
+	ret = blkcache_flush(desc->if_type, desc->devnum);
+	if (ret)
+		return ret;
+
 	ret = mmc_switch_part(mmc, hwpart);
 	if (!ret)
 		blkcache_invalidate(desc->if_type, desc->devnum);
@@ -60,6 +60,15 @@ DECLARE_GLOBAL_DATA_PTR;
 #undef OMAP_HSMMC_USE_GPIO
 #endif
 
+/* EDMA channels are found through the device tree, in U-Boot proper */
+#if defined(CONFIG_MMC_OMAP_HS_EDMA) && !defined(CONFIG_SPL_BUILD) && \
+	CONFIG_IS_ENABLED(DM_MMC) && CONFIG_IS_ENABLED(OF_CONTROL) && \
+	!CONFIG_IS_ENABLED(OF_PLATDATA)
+#define OMAP_HSMMC_USE_EDMA
+#include <asm/omap_common.h>
+#include <asm/ti-common/ti-edma3.h>
+#endif
+
 /* common definitions for all OMAPs */
 #define SYSCTL_SRC	(1 << 25)
 #define SYSCTL_SRD	(1 << 26)
@@ -97,6 +106,14 @@ struct omap_hsmmc_data {
 #ifdef CONFIG_MMC_OMAP_HS_ADMA
 	struct omap_hsmmc_adma_desc *adma_desc_table;
 	uint desc_slot;
+#endif
+#ifdef OMAP_HSMMC_USE_EDMA
+	u32 edma_base;
+	int edma_rx;		/* EDMA channel for reads, -ve if none */
+	int edma_tx;		/* EDMA channel for writes, -ve if none */
+	struct edma3_channel_config edma_ch;
+	struct mmc_data *edma_data;	/* data of the transfer in flight */
+	bool edma_async;	/* leave the transfer running on return */
 #endif
 	const char *hw_rev;
 	struct udevice *pbias_supply;
@@ -1027,6 +1044,130 @@ static void omap_hsmmc_dma_cleanup(struct mmc *mmc)
 #define omap_hsmmc_dma_cleanup
 #endif
 
+#ifdef OMAP_HSMMC_USE_EDMA
+/*
+ * Program the EDMA channel for @data. The controller raises one DMA event
+ * per block, so each event moves one AB-synchronized frame of blocksize / 4
+ * words between the data register and the buffer. Returns true if the data
+ * will be moved by DMA, false if it has to be moved by PIO.
+ */
+static bool omap_hsmmc_edma_prepare(struct omap_hsmmc_data *priv,
+				    struct mmc_data *data)
+{
+	struct hsmmc *mmc_base = priv->base_addr;
+	struct edma3_slot_config slot;
+	bool read = data->flags & MMC_DATA_READ;
+	int ch = read ? priv->edma_rx : priv->edma_tx;
+	ulong buf = read ? (ulong)data->dest : (ulong)data->src;
+	ulong len = data->blocksize * data->blocks;
+
+	if (ch < 0 || !IS_ALIGNED(buf, ARCH_DMA_MINALIGN) ||
+	    data->blocksize % 4)
+		return false;
+
+	if (read)
+		invalidate_dcache_range(buf, buf + ROUND(len,
+							 ARCH_DMA_MINALIGN));
+	else
+		flush_dcache_range(buf, buf + ROUND(len, ARCH_DMA_MINALIGN));
+
+	slot.opt = EDMA3_SLOPT_TRANS_COMP_INT_ENB |
+		   EDMA3_SLOPT_COMP_CODE(ch) | EDMA3_SLOPT_AB_SYNC;
+	slot.acnt = 4;
+	slot.bcnt = data->blocksize / 4;
+	slot.ccnt = data->blocks;
+	slot.bcntrld = 0;
+	slot.link = EDMA3_PARSET_NULL_LINK;
+	if (read) {
+		slot.src = (u32)&mmc_base->data;
+		slot.src_bidx = 0;
+		slot.src_cidx = 0;
+		slot.dst = buf;
+		slot.dst_bidx = 4;
+		slot.dst_cidx = data->blocksize;
+	} else {
+		slot.src = buf;
+		slot.src_bidx = 4;
+		slot.src_cidx = data->blocksize;
+		slot.dst = (u32)&mmc_base->data;
+		slot.dst_bidx = 0;
+		slot.dst_cidx = 0;
+	}
+	edma3_slot_configure(priv->edma_base, ch, &slot);
+
+	priv->edma_ch.slot = ch;
+	priv->edma_ch.chnum = ch;
+	priv->edma_ch.complete_code = ch;
+	edma3_start(priv->edma_base, &priv->edma_ch);
+	priv->edma_data = data;
+
+	return true;
+}
+
+/* Stop the EDMA channel, e.g. after a command error */
+static void omap_hsmmc_edma_abort(struct omap_hsmmc_data *priv)
+{
+	if (!priv->edma_data)
+		return;
+	edma3_stop(priv->edma_base, &priv->edma_ch);
+	priv->edma_data = NULL;
+}
+
+/* Wait for the transfer started by omap_hsmmc_edma_prepare() to finish */
+static int omap_hsmmc_edma_wait(struct omap_hsmmc_data *priv)
+{
+	struct mmc_data *data = priv->edma_data;
+	struct hsmmc *mmc_base = priv->base_addr;
+	ulong len = data->blocksize * data->blocks;
+	ulong start, timeout;
+	u32 mmc_stat;
+	int ret = 0;
+
+	timeout = DIV_ROUND_UP(len, 1 << 20) * DMA_TIMEOUT_PER_MB;
+	if (timeout < MAX_RETRY_MS)
+		timeout = MAX_RETRY_MS;
+
+	start = get_timer(0);
+	do {
+		mmc_stat = readl(&mmc_base->stat);
+		if (mmc_stat & ERRI_MASK) {
+			ret = -EIO;
+			break;
+		}
+		if (get_timer(start) > timeout) {
+			printf("%s : DMA timeout: No status update\n",
+			       __func__);
+			ret = -ETIMEDOUT;
+			break;
+		}
+	} while (!(mmc_stat & TC_MASK));
+	writel(TC_MASK, &mmc_base->stat);
+
+	while (!ret && edma3_check_for_transfer(priv->edma_base,
+						&priv->edma_ch)) {
+		if (get_timer(start) > timeout) {
+			printf("%s : DMA timeout: EDMA not complete\n",
+			       __func__);
+			ret = -ETIMEDOUT;
+		}
+	}
+
+	omap_hsmmc_edma_abort(priv);
+	if (ret)
+		mmc_reset_controller_fsm(mmc_base, SYSCTL_SRD);
+	else if (data->flags & MMC_DATA_READ)
+		invalidate_dcache_range((ulong)data->dest,
+					(ulong)data->dest +
+					ROUND(len, ARCH_DMA_MINALIGN));
+
+	return ret;
+}
+#else
+static inline void omap_hsmmc_edma_abort(struct omap_hsmmc_data *priv)
+{
+}
+#endif
+
 #if !CONFIG_IS_ENABLED(DM_MMC)
 static int omap_hsmmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			struct mmc_data *data)
@@ -1047,6 +1188,16 @@ static int omap_hsmmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 
 	mmc_base = priv->base_addr;
 
+#ifdef OMAP_HSMMC_USE_EDMA
+	/* Finish a transfer left running by omap_hsmmc_send_cmd_start() */
+	if (priv->edma_data) {
+		int ret = omap_hsmmc_edma_wait(priv);
+
+		if (ret)
+			return ret;
+	}
+#endif
+
 	if (cmd->cmdidx == MMC_CMD_STOP_TRANSMISSION)
 		return 0;
 
@@ -1124,6 +1275,11 @@ static int omap_hsmmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 			omap_hsmmc_prepare_data(mmc, data);
 			flags |= DE_ENABLE;
 		}
+#endif
+#ifdef OMAP_HSMMC_USE_EDMA
+		if (!mmc_is_tuning_cmd(cmd->cmdidx) &&
+		    omap_hsmmc_edma_prepare(priv, data))
+			flags |= DE_ENABLE;
 #endif
 	}
 
@@ -1138,15 +1294,19 @@ static int omap_hsmmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		mmc_stat = readl(&mmc_base->stat);
 		if (get_timer(start) > MAX_RETRY_MS) {
 			printf("%s : timeout: No status update\n", __func__);
+			omap_hsmmc_edma_abort(priv);
 			return -ETIMEDOUT;
 		}
 	} while (!mmc_stat);
 
 	if ((mmc_stat & IE_CTO) != 0) {
+		omap_hsmmc_edma_abort(priv);
 		mmc_reset_controller_fsm(mmc_base, SYSCTL_SRC);
 		return -ETIMEDOUT;
-	} else if ((mmc_stat & ERRI_MASK) != 0)
+	} else if ((mmc_stat & ERRI_MASK) != 0) {
+		omap_hsmmc_edma_abort(priv);
 		return -1;
+	}
 
 	if (mmc_stat & CC_MASK) {
 		writel(CC_MASK, &mmc_base->stat);
@@ -1197,6 +1357,13 @@ static int omap_hsmmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		return 0;
 	}
 #endif
+#ifdef OMAP_HSMMC_USE_EDMA
+	if (priv->edma_data) {
+		if (priv->edma_async)
+			return 0;
+		return omap_hsmmc_edma_wait(priv);
+	}
+#endif
 
 	if (data && (data->flags & MMC_DATA_READ)) {
 		mmc_read_data(mmc_base,	data->dest,
@@ -1500,9 +1667,40 @@ static int omap_hsmmc_getwp(struct mmc *mmc)
 #endif
 #endif
 
+#if defined(OMAP_HSMMC_USE_EDMA) && CONFIG_IS_ENABLED(MMC_QUEUE)
+static int omap_hsmmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+				     struct mmc_data *data)
+{
+	struct omap_hsmmc_data *priv = dev_get_priv(dev);
+	int ret;
+
+	priv->edma_async = true;
+	ret = omap_hsmmc_send_cmd(dev, cmd, data);
+	priv->edma_async = false;
+
+	return ret;
+}
+
+static int omap_hsmmc_send_cmd_wait(struct udevice *dev,
+				    struct mmc_data *data)
+{
+	struct omap_hsmmc_data *priv = dev_get_priv(dev);
+
+	/* Nothing in flight if the data was moved by PIO */
+	if (!priv->edma_data)
+		return 0;
+
+	return omap_hsmmc_edma_wait(priv);
+}
+#endif
+
 #if CONFIG_IS_ENABLED(DM_MMC)
 static const struct dm_mmc_ops omap_hsmmc_ops = {
 	.send_cmd	= omap_hsmmc_send_cmd,
+#if defined(OMAP_HSMMC_USE_EDMA) && CONFIG_IS_ENABLED(MMC_QUEUE)
+	.send_cmd_start	= omap_hsmmc_send_cmd_start,
+	.send_cmd_wait	= omap_hsmmc_send_cmd_wait,
+#endif
 	.set_ios	= omap_hsmmc_set_ios,
 #ifdef OMAP_HSMMC_USE_GPIO
 	.get_cd		= omap_hsmmc_getcd,
@@ -1936,6 +2134,50 @@ static int omap_hsmmc_ofdata_to_platdata(struct udevice *dev)
 }
 #endif
 
+#ifdef OMAP_HSMMC_USE_EDMA
+/*
+ * Look up the EDMA channel called @name in the "dmas" property. Returns
+ * the channel number and sets @basep to the EDMA3 controller, or returns
+ * -ve if there is no usable channel.
+ */
+static int omap_hsmmc_edma_channel(struct udevice *dev, const char *name,
+				   u32 *basep)
+{
+	struct ofnode_phandle_args args, master;
+	phys_addr_t base;
+	int idx, ret;
+
+	idx = dev_read_stringlist_search(dev, "dma-names", name);
+	if (idx < 0)
+		return idx;
+	ret = dev_read_phandle_with_args(dev, "dmas", "#dma-cells", 0, idx,
+					 &args);
+	if (ret)
+		return ret;
+	if (!args.args_count)
+		return -EINVAL;
+
+	/* The AM335x crossbar passes events through unless remapped */
+	if (ofnode_device_is_compatible(args.node,
+					"ti,am335x-edma-crossbar")) {
+		if (args.args_count > 2 && args.args[2])
+			return -ENOTSUPP;
+		ret = ofnode_parse_phandle_with_args(args.node, "dma-masters",
+						     NULL, 0, 0, &master);
+		if (ret)
+			return ret;
+		args.node = master.node;
+	}
+
+	base = ofnode_get_addr(args.node);
+	if (base == FDT_ADDR_T_NONE)
+		return -EINVAL;
+	*basep = base;
+
+	return args.args[0];
+}
+#endif
+
 #ifdef CONFIG_BLK
 
 static int omap_hsmmc_bind(struct udevice *dev)
@@ -1961,6 +2203,13 @@ static int omap_hsmmc_probe(struct udevice *dev)
 	priv->controller_flags = plat->controller_flags;
 	priv->hw_rev = plat->hw_rev;
 
+#ifdef OMAP_HSMMC_USE_EDMA
+	priv->edma_rx = omap_hsmmc_edma_channel(dev, "rx", &priv->edma_base);
+	priv->edma_tx = omap_hsmmc_edma_channel(dev, "tx", &priv->edma_base);
+	if (priv->edma_rx >= 0 || priv->edma_tx >= 0)
+		enable_edma3_clocks();
+#endif
+
 #ifdef CONFIG_BLK
 	mmc = plat->mmc;
 #else
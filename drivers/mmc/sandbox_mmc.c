@@ -89,6 +89,15 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(MMC_QUEUE)
+/* Commands complete immediately, so there is nothing to wait for */
+static int sandbox_mmc_send_cmd_wait(struct udevice *dev,
+				     struct mmc_data *data)
+{
+	return 0;
+}
+#endif
+
 static int sandbox_mmc_set_ios(struct udevice *dev)
 {
 	return 0;
@@ -101,6 +110,10 @@ static int sandbox_mmc_get_cd(struct udevice *dev)
 
 static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
+#if CONFIG_IS_ENABLED(MMC_QUEUE)
+	.send_cmd_start = sandbox_mmc_send_cmd,
+	.send_cmd_wait = sandbox_mmc_send_cmd_wait,
+#endif
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
 };
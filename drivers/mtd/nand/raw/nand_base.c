@@ -518,6 +518,38 @@ static int nand_block_isreserved(struct mtd_info *mtd, loff_t ofs)
 	return nand_isreserved_bbt(mtd, ofs);
 }
 
+/* Build the bad block table on first use */
+static void nand_scan_bbt_once(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+
+	if (!(chip->options & NAND_SKIP_BBTSCAN) &&
+	    !(chip->options & NAND_BBT_SCANNED)) {
+		chip->options |= NAND_BBT_SCANNED;
+		chip->scan_bbt(mtd);
+	}
+}
+
+/**
+ * nand_check_cached - check blocks known only from the bad block cache
+ * @mtd: MTD device structure
+ * @ofs: offset of the first byte to be erased or written
+ * @len: number of bytes to be erased or written
+ *
+ * The cache may miss blocks which were marked bad by another OS, so the
+ * marker of such blocks is read before they are first changed.
+ */
+static int nand_check_cached(struct mtd_info *mtd, loff_t ofs, loff_t len)
+{
+#if defined(CONFIG_NAND_BBT_CACHE) && !defined(CONFIG_SPL_BUILD)
+	nand_scan_bbt_once(mtd);
+
+	return nand_bbt_cache_verify(mtd, ofs, len);
+#else
+	return 0;
+#endif
+}
+
 /**
  * nand_block_checkbad - [GENERIC] Check if a block is marked bad
  * @mtd: MTD device structure
@@ -531,11 +563,7 @@ static int nand_block_checkbad(struct mtd_info *mtd, loff_t ofs, int allowbbt)
 {
 	struct nand_chip *chip = mtd_to_nand(mtd);
 
-	if (!(chip->options & NAND_SKIP_BBTSCAN) &&
-	    !(chip->options & NAND_BBT_SCANNED)) {
-		chip->options |= NAND_BBT_SCANNED;
-		chip->scan_bbt(mtd);
-	}
+	nand_scan_bbt_once(mtd);
 
 	if (!chip->bbt)
 		return chip->block_bad(mtd, ofs);
@@ -3445,6 +3473,9 @@ static int nand_write_oob(struct mtd_info *mtd, loff_t to,
 		return -EINVAL;
 	}
 
+	if (nand_check_cached(mtd, to, ops->datbuf ? ops->len : 1))
+		return -EIO;
+
 	nand_get_device(mtd, FL_WRITING);
 
 	switch (ops->mode) {
@@ -3519,6 +3550,12 @@ int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 	if (check_offs_len(mtd, instr->addr, instr->len))
 		return -EINVAL;
 
+	if (!instr->scrub &&
+	    nand_check_cached(mtd, instr->addr, instr->len)) {
+		instr->state = MTD_ERASE_FAILED;
+		return -EIO;
+	}
+
 	/* Grab the lock and see if the device is available */
 	nand_get_device(mtd, FL_ERASING);
 
@@ -59,6 +59,7 @@
 
 #include <common.h>
 #include <malloc.h>
+#include <nand.h>
 #include <linux/compat.h>
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/bbm.h>
@@ -1058,6 +1059,285 @@ static void verify_bbt_descr(struct mtd_info *mtd, struct nand_bbt_descr *bd)
 	BUG_ON(table_size > (1 << this->bbt_erase_shift));
 }
 
+#ifdef CONFIG_NAND_BBT_CACHE
+/*
+ * Blocks which the cache reports good, but whose bad block marker has not
+ * been read since, one bit per block. Only the first device has a cache.
+ */
+static u8 *bbt_cache_unchecked;
+
+static int nand_bbt_cache_update(struct mtd_info *mtd);
+
+/**
+ * nand_bbt_cache_restore - build the memory bbt from the bad block cache
+ * @mtd: MTD device structure
+ *
+ * Returns 0 if a cache matching the device was found, so that the device does
+ * not have to be scanned.
+ */
+static int nand_bbt_cache_restore(struct mtd_info *mtd)
+{
+	struct nand_chip *this = mtd_to_nand(mtd);
+	struct nand_bbt_cache *cache;
+	int i, nblocks = mtd->size >> this->bbt_erase_shift;
+	bool scanned;
+
+	/* Only the first device has a cache */
+	if (nand_mtd_to_devnum(mtd))
+		return -ENOENT;
+
+	kfree(bbt_cache_unchecked);
+	bbt_cache_unchecked = NULL;
+	cache = nand_bbt_cache_load(mtd);
+	if (!cache)
+		return -ENOENT;
+
+	bbt_cache_unchecked = kzalloc(DIV_ROUND_UP(nblocks, 8), GFP_KERNEL);
+	if (!bbt_cache_unchecked) {
+		free(cache);
+		return -ENOMEM;
+	}
+
+	/*
+	 * Generation 0 means SPL has just read every marker to build the
+	 * cache, so nothing is unchecked and it should be stored on flash
+	 */
+	scanned = !cache->generation;
+
+	/* Bad blocks in the reserved area stay bad */
+	for (i = 0; i < nblocks; i++) {
+		if (nand_bbt_cache_isbad(cache, i))
+			bbt_mark_entry(this, i, BBT_BLOCK_FACTORY_BAD);
+		else if (nand_bbt_cache_reserved(mtd, i))
+			bbt_mark_entry(this, i, BBT_BLOCK_RESERVED);
+		else if (!scanned)
+			bbt_cache_unchecked[i / 8] |= 1 << (i % 8);
+	}
+	free(cache);
+
+	if (scanned && IS_ENABLED(CONFIG_NAND_BBT_CACHE_FLASH) &&
+	    nand_bbt_cache_update(mtd))
+		pr_warn("nand_bbt: cannot store the bad block cache\n");
+
+	return 0;
+}
+
+/**
+ * nand_bbt_cache_update - store the memory bbt in the bad block cache
+ * @mtd: MTD device structure
+ *
+ * Good blocks in the reserved area are stored as good, they are marked
+ * reserved again when the cache is restored. Bad blocks there are stored as
+ * bad, like any other.
+ */
+static int nand_bbt_cache_update(struct mtd_info *mtd)
+{
+	struct nand_chip *this = mtd_to_nand(mtd);
+	struct nand_bbt_cache *cache;
+	int i, ret, nblocks = mtd->size >> this->bbt_erase_shift;
+
+	/* Only the first device has a cache */
+	if (nand_mtd_to_devnum(mtd))
+		return 0;
+
+	cache = kzalloc(nand_bbt_cache_size(nblocks), GFP_KERNEL);
+	if (!cache)
+		return -ENOMEM;
+	cache->erase_shift = this->bbt_erase_shift;
+	cache->nblocks = nblocks;
+
+	for (i = 0; i < nblocks; i++) {
+		switch (bbt_get_entry(this, i)) {
+		case BBT_BLOCK_GOOD:
+			break;
+		case BBT_BLOCK_RESERVED:
+			if (nand_bbt_cache_reserved(mtd, i))
+				break;
+			/* fall through */
+		default:
+			cache->bitmap[i / 8] |= 1 << (i % 8);
+			break;
+		}
+		if (nand_bbt_cache_reserved(mtd, i) &&
+		    bbt_get_entry(this, i) == BBT_BLOCK_GOOD)
+			bbt_mark_entry(this, i, BBT_BLOCK_RESERVED);
+	}
+	ret = nand_bbt_cache_save(mtd, cache);
+	kfree(cache);
+
+	return ret;
+}
+
+/**
+ * nand_bbt_cache_check_block - read the marker of a block restored as good
+ * @mtd: MTD device structure
+ * @block: block to check
+ *
+ * The cache only knows about blocks which were bad when it was stored. Another
+ * OS may since have marked a block bad in its OOB alone, so the marker of each
+ * block restored as good is read before the block is first erased or written.
+ * Reads trust the cache. A block found to be bad is marked in the memory bbt
+ * and in the cache.
+ *
+ * Returns 1 if the block is bad, 0 if it is good or was already checked, or a
+ * negative error if the marker cannot be read.
+ */
+static int nand_bbt_cache_check_block(struct mtd_info *mtd, int block)
+{
+	struct nand_chip *this = mtd_to_nand(mtd);
+	struct nand_bbt_descr *bd = this->badblock_pattern;
+	int numpages, res;
+	uint8_t *buf;
+	loff_t from;
+
+	if (!bbt_cache_unchecked || nand_mtd_to_devnum(mtd) ||
+	    !(bbt_cache_unchecked[block / 8] & (1 << (block % 8))))
+		return 0;
+
+	buf = kmalloc(mtd->oobsize, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+	numpages = bd->options & NAND_BBT_SCAN2NDPAGE ? 2 : 1;
+	from = (loff_t)block << this->bbt_erase_shift;
+	if (this->bbt_options & NAND_BBT_SCANLASTPAGE)
+		from += mtd->erasesize - (mtd->writesize * numpages);
+	res = scan_block_fast(mtd, bd, from, buf, numpages);
+	kfree(buf);
+	if (res < 0)
+		return res;
+
+	bbt_cache_unchecked[block / 8] &= ~(1 << (block % 8));
+	if (!res)
+		return 0;
+	pr_warn("nand_bbt: block %d is marked bad but was not in the cache\n",
+		block);
+	bbt_mark_entry(this, block, BBT_BLOCK_FACTORY_BAD);
+	mtd->ecc_stats.badblocks++;
+	if (nand_bbt_cache_update(mtd))
+		pr_warn("nand_bbt: cannot update the bad block cache\n");
+
+	return 1;
+}
+
+/**
+ * nand_bbt_cache_verify - check blocks from the cache before changing them
+ * @mtd: MTD device structure
+ * @offs: offset of the first byte to be erased or written
+ * @len: number of bytes to be erased or written
+ *
+ * Returns 0 if the blocks are good, -EIO if one of them is bad.
+ */
+int nand_bbt_cache_verify(struct mtd_info *mtd, loff_t offs, loff_t len)
+{
+	struct nand_chip *this = mtd_to_nand(mtd);
+	int block, last, res;
+
+	if (!bbt_cache_unchecked || len <= 0)
+		return 0;
+
+	last = (int)((offs + len - 1) >> this->bbt_erase_shift);
+	for (block = (int)(offs >> this->bbt_erase_shift); block <= last;
+	     block++) {
+		res = nand_bbt_cache_check_block(mtd, block);
+		if (res)
+			return res < 0 ? res : -EIO;
+	}
+
+	return 0;
+}
+
+static int nand_scan_bbt(struct mtd_info *mtd, struct nand_bbt_descr *bd);
+
+/**
+ * nand_bbt_cache_rebuild - scan the device and store a new bad block cache
+ * @mtd: MTD device structure
+ *
+ * The stored copies of the cache are dropped first, so that the memory bbt is
+ * built from the bad block markers on the device.
+ */
+int nand_bbt_cache_rebuild(struct mtd_info *mtd)
+{
+	struct nand_chip *this = mtd_to_nand(mtd);
+	int ret;
+
+	if (this->bbt_td)
+		return -ENOSYS;
+	ret = nand_bbt_cache_drop(mtd);
+	if (ret)
+		return ret;
+
+	kfree(bbt_cache_unchecked);
+	bbt_cache_unchecked = NULL;
+	kfree(this->bbt);
+	this->bbt = NULL;
+	this->options |= NAND_BBT_SCANNED;
+	mtd->ecc_stats.badblocks = 0;
+
+	return nand_scan_bbt(mtd, this->badblock_pattern);
+}
+
+/**
+ * nand_bbt_cache_reload - build the memory bbt again from the stored cache
+ * @mtd: MTD device structure
+ *
+ * The copy in the bloblist is dropped first, so that the cache is read from
+ * the reserved area of the device, as on a boot without SPL.
+ */
+int nand_bbt_cache_reload(struct mtd_info *mtd)
+{
+	struct nand_chip *this = mtd_to_nand(mtd);
+
+	if (this->bbt_td)
+		return -ENOSYS;
+	nand_bbt_cache_drop_handoff(mtd);
+
+	kfree(this->bbt);
+	this->bbt = NULL;
+	this->options |= NAND_BBT_SCANNED;
+	mtd->ecc_stats.badblocks = 0;
+
+	return nand_scan_bbt(mtd, this->badblock_pattern);
+}
+
+/**
+ * nand_bbt_cache_unchecked - count the blocks restored as good and not read
+ * @mtd: MTD device structure
+ *
+ * Returns the number of blocks whose marker has not been read since the
+ * memory bbt was restored from the cache, or -ENOENT if it was built by
+ * scanning the device.
+ */
+int nand_bbt_cache_unchecked(struct mtd_info *mtd)
+{
+	struct nand_chip *this = mtd_to_nand(mtd);
+	int i, count = 0, nblocks = mtd->size >> this->bbt_erase_shift;
+
+	/* The table is built on first use, as in nand_block_checkbad() */
+	if (!(this->options & (NAND_SKIP_BBTSCAN | NAND_BBT_SCANNED))) {
+		this->options |= NAND_BBT_SCANNED;
+		this->scan_bbt(mtd);
+	}
+	if (!bbt_cache_unchecked || nand_mtd_to_devnum(mtd))
+		return -ENOENT;
+	for (i = 0; i < nblocks; i++) {
+		if (bbt_cache_unchecked[i / 8] & (1 << (i % 8)))
+			count++;
+	}
+
+	return count;
+}
+#else
+static inline int nand_bbt_cache_restore(struct mtd_info *mtd)
+{
+	return -ENOSYS;
+}
+
+static inline int nand_bbt_cache_update(struct mtd_info *mtd)
+{
+	return 0;
+}
+#endif /* CONFIG_NAND_BBT_CACHE */
+
 /**
  * nand_scan_bbt - [NAND Interface] scan, find, read and maybe create bad block table(s)
  * @mtd: MTD device structure
@@ -1092,10 +1372,14 @@ static int nand_scan_bbt(struct mtd_info *mtd, struct nand_bbt_descr *bd)
 	 * memory based bad block table.
 	 */
 	if (!td) {
+		/* A cached table saves reading the marker of every block */
+		if (!nand_bbt_cache_restore(mtd))
+			return 0;
 		if ((res = nand_memory_bbt(mtd, bd))) {
 			pr_err("nand_bbt: can't scan flash and build the RAM-based BBT\n");
 			goto err;
 		}
+		nand_bbt_cache_update(mtd);
 		return 0;
 	}
 	verify_bbt_descr(mtd, td);
@@ -1366,8 +1650,12 @@ int nand_markbad_bbt(struct mtd_info *mtd, loff_t offs)
 	bbt_mark_entry(this, block, BBT_BLOCK_WORN);
 
 	/* Update flash-based bad block table */
-	if (this->bbt_options & NAND_BBT_USE_FLASH)
+	if (this->bbt_options & NAND_BBT_USE_FLASH) {
 		ret = nand_update_bbt(mtd, offs);
+	} else if (nand_bbt_cache_update(mtd)) {
+		/* The block is marked bad on the device, so this is not fatal */
+		pr_warn("nand_bbt: cannot update the bad block cache\n");
+	}
 
 	return ret;
 }
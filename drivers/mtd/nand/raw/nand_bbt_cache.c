@@ -0,0 +1,292 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Bad block cache for NAND devices without a flash-based bad block table
+ *
+ * The cache is a bitmap with one bit per eraseblock. SPL can read it from a
+ * reserved area of the device and pass it to U-Boot proper in the bloblist,
+ * so that neither phase has to read the bad block marker of every block.
+ */
+
+#include <common.h>
+#include <bloblist.h>
+#include <malloc.h>
+#include <nand.h>
+#include <linux/log2.h>
+#include <u-boot/crc.h>
+
+u32 nand_bbt_cache_crc(const struct nand_bbt_cache *cache)
+{
+	u32 crc;
+
+	crc = crc32(0, (const void *)cache,
+		    offsetof(struct nand_bbt_cache, crc));
+
+	return crc32(crc, cache->bitmap, DIV_ROUND_UP(cache->nblocks, 8));
+}
+
+int nand_bbt_cache_check(const struct nand_bbt_cache *cache, uint size)
+{
+	if (size < sizeof(*cache) || cache->magic != NAND_BBT_CACHE_MAGIC)
+		return -ENOENT;
+	if (!cache->nblocks || nand_bbt_cache_size(cache->nblocks) > size)
+		return -EBADMSG;
+	if (nand_bbt_cache_crc(cache) != cache->crc)
+		return -EBADMSG;
+
+	return 0;
+}
+
+int nand_bbt_cache_handoff(const struct nand_bbt_cache *cache)
+{
+	uint size = nand_bbt_cache_size(cache->nblocks);
+	void *blob;
+	int ret;
+
+	if (!CONFIG_IS_ENABLED(BLOBLIST))
+		return -ENOSYS;
+	ret = bloblist_ensure_size(BLOBLISTT_NAND_BBT, size, &blob);
+	if (ret)
+		return ret;
+	memcpy(blob, cache, size);
+
+	return 0;
+}
+
+#ifndef CONFIG_SPL_BUILD
+static uint bbt_cache_nblocks(struct mtd_info *mtd)
+{
+	return mtd->size >> ilog2(mtd->erasesize);
+}
+
+#ifdef CONFIG_NAND_BBT_CACHE_FLASH
+/* Generation of the newest copy on flash, the next one is written after it */
+static u32 bbt_cache_generation;
+
+static uint bbt_cache_first_block(struct mtd_info *mtd)
+{
+	return CONFIG_NAND_BBT_CACHE_OFFSET / mtd->erasesize;
+}
+
+bool nand_bbt_cache_reserved(struct mtd_info *mtd, uint block)
+{
+	uint first = bbt_cache_first_block(mtd);
+
+	/* Only the first device has a cache, see nand_bbt_cache_load() */
+	if (nand_mtd_to_devnum(mtd))
+		return false;
+
+	return block >= first && block < first + CONFIG_NAND_BBT_CACHE_BLOCKS;
+}
+
+static int bbt_cache_read_flash(struct mtd_info *mtd,
+				struct nand_bbt_cache **cachep)
+{
+	uint size = ALIGN(nand_bbt_cache_size(bbt_cache_nblocks(mtd)),
+			  mtd->writesize);
+	struct nand_bbt_cache *best, *cache;
+	size_t retlen;
+	loff_t offs;
+	int i, ret;
+
+	best = malloc(size);
+	cache = malloc(size);
+	if (!best || !cache) {
+		free(best);
+		free(cache);
+		return -ENOMEM;
+	}
+	best->magic = 0;
+	for (i = 0; i < CONFIG_NAND_BBT_CACHE_BLOCKS; i++) {
+		offs = CONFIG_NAND_BBT_CACHE_OFFSET + (loff_t)i * mtd->erasesize;
+		ret = mtd_read(mtd, offs, size, &retlen, (u_char *)cache);
+		if ((ret && ret != -EUCLEAN) ||
+		    nand_bbt_cache_check(cache, size))
+			continue;
+		if (!best->magic || cache->generation > best->generation)
+			swap(best, cache);
+	}
+	free(cache);
+	if (!best->magic) {
+		free(best);
+		return -ENOENT;
+	}
+	debug("%s: using generation %u\n", __func__, best->generation);
+	*cachep = best;
+
+	return 0;
+}
+
+static int bbt_cache_write_flash(struct mtd_info *mtd,
+				 const struct nand_bbt_cache *cache)
+{
+	uint first = bbt_cache_first_block(mtd);
+	uint size = nand_bbt_cache_size(cache->nblocks);
+	struct erase_info instr;
+	size_t retlen;
+	loff_t addr;
+	uint block;
+	u_char *buf;
+	int i, ret = -ENOSPC;
+
+	/* Align to a whole page, padding as if erased */
+	buf = malloc(ALIGN(size, mtd->writesize));
+	if (!buf)
+		return -ENOMEM;
+	memset(buf + size, 0xff, ALIGN(size, mtd->writesize) - size);
+	memcpy(buf, cache, size);
+
+	/* Start after the block holding the previous generation */
+	for (i = 1; i <= CONFIG_NAND_BBT_CACHE_BLOCKS; i++) {
+		block = first + (cache->generation - 1 + i) %
+			CONFIG_NAND_BBT_CACHE_BLOCKS;
+		addr = (loff_t)block * mtd->erasesize;
+		/*
+		 * The erase below is allowed to go ahead on reserved blocks,
+		 * so it must never be given a bad one
+		 */
+		if (nand_bbt_cache_isbad(cache, block) ||
+		    nand_isbad_bbt(mtd, addr, 1))
+			continue;
+
+		memset(&instr, '\0', sizeof(instr));
+		instr.mtd = mtd;
+		instr.addr = addr;
+		instr.len = mtd->erasesize;
+		ret = nand_erase_nand(mtd, &instr, 1);
+		if (!ret)
+			ret = mtd_write(mtd, instr.addr,
+					ALIGN(size, mtd->writesize), &retlen,
+					buf);
+		if (!ret)
+			break;
+		printf("NAND bad block cache: cannot write block %u (err=%d)\n",
+		       block, ret);
+	}
+	free(buf);
+
+	return ret;
+}
+
+/* Erase the good blocks of the reserved area, so that no copy is left */
+static int bbt_cache_erase_flash(struct mtd_info *mtd)
+{
+	uint first = bbt_cache_first_block(mtd);
+	struct erase_info instr;
+	int i, ret = 0;
+
+	for (i = 0; i < CONFIG_NAND_BBT_CACHE_BLOCKS; i++) {
+		memset(&instr, '\0', sizeof(instr));
+		instr.mtd = mtd;
+		instr.addr = (loff_t)(first + i) * mtd->erasesize;
+		instr.len = mtd->erasesize;
+		if (nand_isbad_bbt(mtd, instr.addr, 1))
+			continue;
+		if (nand_erase_nand(mtd, &instr, 1)) {
+			printf("NAND bad block cache: cannot erase block %u\n",
+			       first + i);
+			ret = -EIO;
+		}
+	}
+	bbt_cache_generation = 0;
+
+	return ret;
+}
+#else
+bool nand_bbt_cache_reserved(struct mtd_info *mtd, uint block)
+{
+	return false;
+}
+#endif /* CONFIG_NAND_BBT_CACHE_FLASH */
+
+static bool bbt_cache_matches(struct mtd_info *mtd,
+			      const struct nand_bbt_cache *cache)
+{
+	return cache->erase_shift == ilog2(mtd->erasesize) &&
+		cache->nblocks == bbt_cache_nblocks(mtd);
+}
+
+struct nand_bbt_cache *nand_bbt_cache_load(struct mtd_info *mtd)
+{
+	struct nand_bbt_cache *cache = NULL;
+	int size;
+
+	if (nand_mtd_to_devnum(mtd))
+		return NULL;
+
+	if (CONFIG_IS_ENABLED(BLOBLIST)) {
+		const struct nand_bbt_cache *blob;
+
+		size = nand_bbt_cache_size(bbt_cache_nblocks(mtd));
+		blob = bloblist_find(BLOBLISTT_NAND_BBT, size);
+		if (blob && !nand_bbt_cache_check(blob, size) &&
+		    bbt_cache_matches(mtd, blob)) {
+			cache = malloc(size);
+			if (!cache)
+				return NULL;
+			memcpy(cache, blob, size);
+		}
+	}
+#ifdef CONFIG_NAND_BBT_CACHE_FLASH
+	if (!cache && !bbt_cache_read_flash(mtd, &cache) &&
+	    !bbt_cache_matches(mtd, cache)) {
+		free(cache);
+		cache = NULL;
+	}
+	if (cache)
+		bbt_cache_generation = cache->generation;
+#endif
+
+	return cache;
+}
+
+int nand_bbt_cache_save(struct mtd_info *mtd, struct nand_bbt_cache *cache)
+{
+	int ret = 0;
+
+	if (nand_mtd_to_devnum(mtd))
+		return -ENODEV;
+
+	cache->magic = NAND_BBT_CACHE_MAGIC;
+#ifdef CONFIG_NAND_BBT_CACHE_FLASH
+	cache->generation = ++bbt_cache_generation;
+#endif
+	cache->crc = nand_bbt_cache_crc(cache);
+
+	if (CONFIG_IS_ENABLED(BLOBLIST))
+		nand_bbt_cache_handoff(cache);
+#ifdef CONFIG_NAND_BBT_CACHE_FLASH
+	ret = bbt_cache_write_flash(mtd, cache);
+#endif
+
+	return ret;
+}
+
+void nand_bbt_cache_drop_handoff(struct mtd_info *mtd)
+{
+	struct nand_bbt_cache *blob;
+
+	if (!CONFIG_IS_ENABLED(BLOBLIST) || nand_mtd_to_devnum(mtd))
+		return;
+	blob = bloblist_find(BLOBLISTT_NAND_BBT,
+			     nand_bbt_cache_size(bbt_cache_nblocks(mtd)));
+	if (blob)
+		blob->magic = 0;
+}
+
+int nand_bbt_cache_drop(struct mtd_info *mtd)
+{
+	int ret = 0;
+
+	if (nand_mtd_to_devnum(mtd))
+		return -ENODEV;
+
+	nand_bbt_cache_drop_handoff(mtd);
+#ifdef CONFIG_NAND_BBT_CACHE_FLASH
+	/* The memory bbt says which blocks of the area are bad */
+	nand_block_isbad(mtd, 0);
+	ret = bbt_cache_erase_flash(mtd);
+#endif
+
+	return ret;
+}
+#endif /* !CONFIG_SPL_BUILD */
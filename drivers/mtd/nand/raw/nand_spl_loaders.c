@@ -1,3 +1,119 @@
+#if CONFIG_IS_ENABLED(NAND_BBT_CACHE)
+static struct nand_bbt_cache *bbt_cache;
+static bool bbt_cache_loaded;
+
+/* Read and check the copy of the bad block cache held in @block */
+static struct nand_bbt_cache *nand_spl_read_bbt_cache(uint block,
+						      struct nand_bbt_cache *hdr)
+{
+	struct nand_bbt_cache *cache;
+	uint size, page;
+
+	nand_read_page(block, 0, hdr);
+	if (hdr->magic != NAND_BBT_CACHE_MAGIC ||
+	    hdr->erase_shift != ilog2(CONFIG_SYS_NAND_BLOCK_SIZE) ||
+	    (bbt_cache && hdr->generation <= bbt_cache->generation))
+		return NULL;
+
+	/* The table may span several pages */
+	size = ALIGN(nand_bbt_cache_size(hdr->nblocks),
+		     CONFIG_SYS_NAND_PAGE_SIZE);
+	if (size > CONFIG_SYS_NAND_BLOCK_SIZE)
+		return NULL;
+	cache = malloc(size);
+	if (!cache)
+		return NULL;
+	memcpy(cache, hdr, CONFIG_SYS_NAND_PAGE_SIZE);
+	for (page = 1; page < size / CONFIG_SYS_NAND_PAGE_SIZE; page++)
+		nand_read_page(block, page,
+			       (void *)cache + page * CONFIG_SYS_NAND_PAGE_SIZE);
+	if (nand_bbt_cache_check(cache, size)) {
+		free(cache);
+		return NULL;
+	}
+
+	return cache;
+}
+
+#ifdef CONFIG_SYS_NAND_SIZE
+/*
+ * Read the marker of every block once to build the cache. It has generation
+ * 0, which tells U-Boot proper to store it on flash for the next boot.
+ */
+static struct nand_bbt_cache *nand_spl_scan_bbt_cache(void)
+{
+	const uint nblocks = CONFIG_SYS_NAND_SIZE / CONFIG_SYS_NAND_BLOCK_SIZE;
+	struct nand_bbt_cache *cache;
+	uint block;
+
+	cache = calloc(1, nand_bbt_cache_size(nblocks));
+	if (!cache)
+		return NULL;
+	cache->magic = NAND_BBT_CACHE_MAGIC;
+	cache->erase_shift = ilog2(CONFIG_SYS_NAND_BLOCK_SIZE);
+	cache->nblocks = nblocks;
+	for (block = 0; block < nblocks; block++) {
+		if (nand_is_bad_block(block))
+			cache->bitmap[block / 8] |= 1 << (block % 8);
+	}
+	cache->crc = nand_bbt_cache_crc(cache);
+
+	return cache;
+}
+#endif
+
+/*
+ * Use the newest valid copy of the bad block cache from the reserved area, or
+ * build one, and pass it on to U-Boot proper
+ */
+static void nand_spl_load_bbt_cache(void)
+{
+	const uint first = CONFIG_NAND_BBT_CACHE_OFFSET /
+		CONFIG_SYS_NAND_BLOCK_SIZE;
+	struct nand_bbt_cache *hdr, *cache;
+	int i;
+
+	bbt_cache_loaded = true;
+	hdr = malloc(CONFIG_SYS_NAND_PAGE_SIZE);
+	if (!hdr)
+		return;
+	for (i = 0; i < CONFIG_NAND_BBT_CACHE_BLOCKS; i++) {
+		cache = nand_spl_read_bbt_cache(first + i, hdr);
+		if (cache) {
+			free(bbt_cache);
+			bbt_cache = cache;
+		}
+	}
+	free(hdr);
+#ifdef CONFIG_SYS_NAND_SIZE
+	if (!bbt_cache)
+		bbt_cache = nand_spl_scan_bbt_cache();
+#endif
+	if (!bbt_cache)
+		return;
+
+	debug("%s: generation %u\n", __func__, bbt_cache->generation);
+	nand_bbt_cache_handoff(bbt_cache);
+}
+
+/*
+ * The cache, which is protected by its CRC, is trusted for reads. U-Boot
+ * proper reads the marker of a block before erasing or writing it, in case
+ * another OS marked it bad since the cache was stored.
+ */
+static int nand_spl_is_bad_block(int block)
+{
+	if (!bbt_cache_loaded)
+		nand_spl_load_bbt_cache();
+	if (bbt_cache && block < bbt_cache->nblocks)
+		return nand_bbt_cache_isbad(bbt_cache, block);
+
+	return nand_is_bad_block(block);
+}
+#else
+#define nand_spl_is_bad_block	nand_is_bad_block
+#endif
+
 int nand_spl_load_image(uint32_t offs, unsigned int size, void *dst)
 {
 	unsigned int block, lastblock;
@@ -10,7 +126,7 @@ int nand_spl_load_image(uint32_t offs, unsigned int size, void *dst)
 	page_offset = offs % CONFIG_SYS_NAND_PAGE_SIZE;
 
 	while (block <= lastblock) {
-		if (!nand_is_bad_block(block)) {
+		if (!nand_spl_is_bad_block(block)) {
 			/* Skip bad blocks */
 			while (page < CONFIG_SYS_NAND_PAGE_COUNT) {
 				nand_read_page(block, page, dst);
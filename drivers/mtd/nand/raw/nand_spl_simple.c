@@ -5,8 +5,10 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <nand.h>
 #include <asm/io.h>
+#include <linux/log2.h>
 #include <linux/mtd/nand_ecc.h>
 
 static int nand_ecc_pos[] = CONFIG_SYS_NAND_ECCPOS;
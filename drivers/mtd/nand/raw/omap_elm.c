@@ -130,6 +130,86 @@ int elm_check_error(u8 *syndrome, enum bch_level bch_type, u32 *error_count,
 	return 0;
 }
 
+/**
+ * elm_check_error_page - Check the BCH syndromes of several sectors at once
+ * @syndromes: BCH syndrome of each sector, NULL for sectors to skip
+ * @nsect: number of sectors, at most ELM_MAX_CHANNELS
+ * @bch_type: BCH4/BCH8/BCH16
+ * @error_count: Returns number of errors of each sector, or -EBADMSG if
+ *		 the errors of that sector are not correctable
+ * @error_locations: Returns error locations (in decimal) of each sector
+ *
+ * Load each syndrome into its own polynomial set and let the ELM process
+ * all of them in page mode, so that only one completion is waited for per
+ * page instead of one per sector. Returns -EBADMSG if any sector is not
+ * correctable, else returns 0
+ */
+int elm_check_error_page(u8 **syndromes, int nsect, enum bch_level bch_type,
+			 int *error_count,
+			 u32 error_locations[][ELM_MAX_ERROR_COUNT])
+{
+	u32 mask = 0, location_status;
+	int poly, i, ret = 0;
+
+	if (nsect > ELM_MAX_CHANNELS)
+		return -EINVAL;
+
+	for (poly = 0; poly < nsect; poly++) {
+		error_count[poly] = 0;
+		if (syndromes[poly])
+			mask |= 0x1 << poly;
+	}
+	if (!mask)
+		return 0;
+
+	/* process the selected polynomial sets as one page */
+	writel(mask, &elm_cfg->page_ctrl);
+	writel(readl(&elm_cfg->irqenable) | ELM_IRQ_PAGE_VALID,
+	       &elm_cfg->irqenable);
+
+	for (poly = 0; poly < nsect; poly++) {
+		if (!syndromes[poly])
+			continue;
+		elm_load_syndromes(syndromes[poly], bch_type, poly);
+		writel((readl(&elm_cfg->syndrome_fragments[poly].
+			      syndrome_fragment_x[6]) |
+			ELM_SYNDROME_FRAGMENT_6_SYNDROME_VALID),
+		       &elm_cfg->syndrome_fragments[poly].syndrome_fragment_x[6]);
+	}
+
+	/* wait for processing of the whole page to complete */
+	while (!(readl(&elm_cfg->irqstatus) & ELM_IRQ_PAGE_VALID))
+		;
+	/* clear status */
+	writel(mask | ELM_IRQ_PAGE_VALID, &elm_cfg->irqstatus);
+
+	for (poly = 0; poly < nsect; poly++) {
+		if (!syndromes[poly])
+			continue;
+
+		location_status =
+			readl(&elm_cfg->error_location[poly].location_status);
+		if (!(location_status &
+		      ELM_LOCATION_STATUS_ECC_CORRECTABLE_MASK)) {
+			printf("%s: uncorrectable ECC errors\n", DRIVER_NAME);
+			error_count[poly] = -EBADMSG;
+			ret = -EBADMSG;
+			continue;
+		}
+
+		error_count[poly] = location_status &
+				    ELM_LOCATION_STATUS_ECC_NB_ERRORS_MASK;
+		for (i = 0; i < error_count[poly]; i++)
+			error_locations[poly][i] =
+				readl(&elm_cfg->error_location[poly].
+				      error_location_x[i]);
+	}
+
+	/* back to continuous mode, as set up by elm_config() */
+	writel(0, &elm_cfg->page_ctrl);
+
+	return ret;
+}
 
 /**
  * elm_config - Configure ELM module
@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <cpu_func.h>
 #include <asm/io.h>
 #include <linux/errno.h>
 #include <asm/arch/mem.h>
@@ -14,6 +15,11 @@
 #include <linux/compiler.h>
 #include <nand.h>
 #include <linux/mtd/omap_elm.h>
+#ifdef CONFIG_NAND_OMAP_GPMC_EDMA
+#include <asm/arch/hardware.h>
+#include <asm/omap_common.h>
+#include <asm/ti-common/ti-edma3.h>
+#endif
 
 #define BADBLOCK_MARKER_LENGTH	2
 #define SECTOR_BYTES		512
@@ -45,6 +51,7 @@ struct omap_nand_info {
 	enum omap_ecc ecc_scheme;
 	uint8_t cs;
 	uint8_t ws;		/* wait status pin (0,1) */
+	int read_err;		/* set when read_buf() lost page data */
 };
 
 /* We are wasting a bit of memory but al least we are safe */
@@ -169,12 +176,14 @@ static int __maybe_unused omap_correct_data(struct mtd_info *mtd, uint8_t *dat,
 }
 
 /*
- * omap_enable_hwecc - configures GPMC as per ECC scheme before read/write
+ * omap_enable_hwecc_sectors - configures GPMC as per ECC scheme before
+ * read/write of one or more consecutive sectors
  * @mtd:	MTD device structure
  * @mode:	Read/Write mode
+ * @nsectors:	number of sectors, each with its own ECC result registers
  */
-__maybe_unused
-static void omap_enable_hwecc(struct mtd_info *mtd, int32_t mode)
+static void omap_enable_hwecc_sectors(struct mtd_info *mtd, int32_t mode,
+				      int nsectors)
 {
 	struct nand_chip	*nand	= mtd_to_nand(mtd);
 	struct omap_nand_info	*info	= nand_get_controller_data(nand);
@@ -238,16 +247,27 @@ static void omap_enable_hwecc(struct mtd_info *mtd, int32_t mode)
 			(bch_type << 12)	| /* BCH4/BCH8/BCH16 */
 			(bch_wrapmode << 8)	| /* wrap mode */
 			(dev_width << 7)	| /* bus width */
-			(0x0 << 4)		| /* number of sectors */
+			((nsectors - 1) << 4)	| /* number of sectors */
 			(cs <<  1)		| /* ECC CS */
 			(0x1));			  /* enable ECC */
 	writel(ecc_config_val, &gpmc_cfg->ecc_config);
 }
 
 /*
- *  omap_calculate_ecc - Read ECC result
+ * omap_enable_hwecc - configures GPMC as per ECC scheme before read/write
+ * @mtd:	MTD device structure
+ * @mode:	Read/Write mode
+ */
+__maybe_unused
+static void omap_enable_hwecc(struct mtd_info *mtd, int32_t mode)
+{
+	omap_enable_hwecc_sectors(mtd, mode, 1);
+}
+
+/*
+ *  omap_calculate_ecc_sector - Read ECC result
  *  @mtd:	MTD structure
- *  @dat:	unused
+ *  @sector:	sector whose result registers to read
  *  @ecc_code:	ecc_code buffer
  *  Using noninverted ECC can be considered ugly since writing a blank
  *  page ie. padding will clear the ECC bytes. This is no problem as
@@ -258,8 +278,8 @@ static void omap_enable_hwecc(struct mtd_info *mtd, int32_t mode)
  *  is used, the result of read will be 0x0 while the ECC offsets of the
  *  spare area will be 0xFF which will result in an ECC mismatch.
  */
-static int omap_calculate_ecc(struct mtd_info *mtd, const uint8_t *dat,
-				uint8_t *ecc_code)
+static int omap_calculate_ecc_sector(struct mtd_info *mtd, int sector,
+				     uint8_t *ecc_code)
 {
 	struct nand_chip *chip = mtd_to_nand(mtd);
 	struct omap_nand_info *info = nand_get_controller_data(chip);
@@ -278,7 +298,7 @@ static int omap_calculate_ecc(struct mtd_info *mtd, const uint8_t *dat,
 	case OMAP_ECC_BCH8_CODE_HW_DETECTION_SW:
 #endif
 	case OMAP_ECC_BCH8_CODE_HW:
-		ptr = &gpmc_cfg->bch_result_0_3[0].bch_result_x[3];
+		ptr = &gpmc_cfg->bch_result_0_3[sector].bch_result_x[3];
 		val = readl(ptr);
 		ecc_code[i++] = (val >>  0) & 0xFF;
 		ptr--;
@@ -292,21 +312,21 @@ static int omap_calculate_ecc(struct mtd_info *mtd, const uint8_t *dat,
 		}
 		break;
 	case OMAP_ECC_BCH16_CODE_HW:
-		val = readl(&gpmc_cfg->bch_result_4_6[0].bch_result_x[2]);
+		val = readl(&gpmc_cfg->bch_result_4_6[sector].bch_result_x[2]);
 		ecc_code[i++] = (val >>  8) & 0xFF;
 		ecc_code[i++] = (val >>  0) & 0xFF;
-		val = readl(&gpmc_cfg->bch_result_4_6[0].bch_result_x[1]);
+		val = readl(&gpmc_cfg->bch_result_4_6[sector].bch_result_x[1]);
 		ecc_code[i++] = (val >> 24) & 0xFF;
 		ecc_code[i++] = (val >> 16) & 0xFF;
 		ecc_code[i++] = (val >>  8) & 0xFF;
 		ecc_code[i++] = (val >>  0) & 0xFF;
-		val = readl(&gpmc_cfg->bch_result_4_6[0].bch_result_x[0]);
+		val = readl(&gpmc_cfg->bch_result_4_6[sector].bch_result_x[0]);
 		ecc_code[i++] = (val >> 24) & 0xFF;
 		ecc_code[i++] = (val >> 16) & 0xFF;
 		ecc_code[i++] = (val >>  8) & 0xFF;
 		ecc_code[i++] = (val >>  0) & 0xFF;
 		for (j = 3; j >= 0; j--) {
-			val = readl(&gpmc_cfg->bch_result_0_3[0].bch_result_x[j]
+			val = readl(&gpmc_cfg->bch_result_0_3[sector].bch_result_x[j]
 									);
 			ecc_code[i++] = (val >> 24) & 0xFF;
 			ecc_code[i++] = (val >> 16) & 0xFF;
@@ -340,6 +360,18 @@ static int omap_calculate_ecc(struct mtd_info *mtd, const uint8_t *dat,
 	return 0;
 }
 
+/*
+ *  omap_calculate_ecc - Read ECC result of a single sector
+ *  @mtd:	MTD structure
+ *  @dat:	unused
+ *  @ecc_code:	ecc_code buffer
+ */
+static int omap_calculate_ecc(struct mtd_info *mtd, const uint8_t *dat,
+				uint8_t *ecc_code)
+{
+	return omap_calculate_ecc_sector(mtd, 0, ecc_code);
+}
+
 #ifdef CONFIG_NAND_OMAP_GPMC_PREFETCH
 
 #define PREFETCH_CONFIG1_CS_SHIFT	24
@@ -348,6 +380,11 @@ static int omap_calculate_ecc(struct mtd_info *mtd, const uint8_t *dat,
 #define PREFETCH_STATUS_COUNT(val)	(val & 0x00003fff)
 #define PREFETCH_STATUS_FIFO_CNT(val)	((val >> 24) & 0x7F)
 #define ENABLE_PREFETCH			(1 << 7)
+#define PREFETCH_DMA_MODE		(1 << 2)
+
+#if defined(CONFIG_NAND_OMAP_GPMC_EDMA) && !defined(CONFIG_SPL_BUILD)
+#define OMAP_GPMC_USE_EDMA
+#endif
 
 /**
  * omap_prefetch_enable - configures and starts prefetch transfer
@@ -356,7 +393,8 @@ static int omap_calculate_ecc(struct mtd_info *mtd, const uint8_t *dat,
  * @is_write: prefetch read(0) or write post(1) mode
  * @cs: chip select to use
  */
-static int omap_prefetch_enable(int fifo_th, unsigned int count, int is_write, int cs)
+static int omap_prefetch_enable(int fifo_th, unsigned int count, int is_write, int cs,
+				int dma)
 {
 	uint32_t val;
 
@@ -370,7 +408,8 @@ static int omap_prefetch_enable(int fifo_th, unsigned int count, int is_write, i
 	writel(count, &gpmc_cfg->prefetch_config2);
 
 	val = (cs << PREFETCH_CONFIG1_CS_SHIFT) | (is_write & 1) |
-		PREFETCH_FIFOTHRESHOLD(fifo_th) | ENABLE_PREFETCH;
+		PREFETCH_FIFOTHRESHOLD(fifo_th) | ENABLE_PREFETCH |
+		(dma ? PREFETCH_DMA_MODE : 0);
 	writel(val, &gpmc_cfg->prefetch_config1);
 
 	/*  Start the prefetch engine */
@@ -394,7 +433,8 @@ static int __read_prefetch_aligned(struct nand_chip *chip, uint32_t *buf, int le
 	uint32_t cnt;
 	struct omap_nand_info *info = nand_get_controller_data(chip);
 
-	ret = omap_prefetch_enable(PREFETCH_FIFOTHRESHOLD_MAX, len, 0, info->cs);
+	ret = omap_prefetch_enable(PREFETCH_FIFOTHRESHOLD_MAX, len, 0, info->cs,
+				   0);
 	if (ret < 0)
 		return ret;
 
@@ -415,6 +455,71 @@ static int __read_prefetch_aligned(struct nand_chip *chip, uint32_t *buf, int le
 	return 0;
 }
 
+#ifdef OMAP_GPMC_USE_EDMA
+#define GPMC_EDMA_CHANNEL	CONFIG_NAND_OMAP_GPMC_EDMA_CHANNEL
+/* Longest a page can take to leave the prefetch FIFO */
+#define GPMC_EDMA_TIMEOUT_MS	100
+
+/*
+ * Read @len bytes through the prefetch FIFO with EDMA. Each DMA request of
+ * the prefetch engine moves one AB-synchronized frame of FIFO threshold
+ * bytes. @buf must be cache aligned and @len a multiple of the threshold.
+ */
+static int __read_prefetch_edma(struct nand_chip *chip, uint8_t *buf, int len)
+{
+	struct omap_nand_info *info = nand_get_controller_data(chip);
+	struct edma3_channel_config ch = {
+		.slot = GPMC_EDMA_CHANNEL,
+		.chnum = GPMC_EDMA_CHANNEL,
+		.complete_code = GPMC_EDMA_CHANNEL,
+	};
+	struct edma3_slot_config slot;
+	ulong start;
+	int ret;
+
+	invalidate_dcache_range((ulong)buf, (ulong)buf + len);
+
+	slot.opt = EDMA3_SLOPT_TRANS_COMP_INT_ENB |
+		   EDMA3_SLOPT_COMP_CODE(GPMC_EDMA_CHANNEL) |
+		   EDMA3_SLOPT_AB_SYNC;
+	slot.src = CONFIG_SYS_NAND_BASE;
+	slot.dst = (u32)buf;
+	slot.acnt = 4;
+	slot.bcnt = PREFETCH_FIFOTHRESHOLD_MAX / 4;
+	slot.ccnt = len / PREFETCH_FIFOTHRESHOLD_MAX;
+	slot.src_bidx = 0;
+	slot.src_cidx = 0;
+	slot.dst_bidx = 4;
+	slot.dst_cidx = PREFETCH_FIFOTHRESHOLD_MAX;
+	slot.bcntrld = 0;
+	slot.link = EDMA3_PARSET_NULL_LINK;
+	edma3_slot_configure(EDMA3_BASE, GPMC_EDMA_CHANNEL, &slot);
+	edma3_start(EDMA3_BASE, &ch);
+
+	ret = omap_prefetch_enable(PREFETCH_FIFOTHRESHOLD_MAX, len, 0, info->cs,
+				   1);
+	if (ret < 0) {
+		edma3_stop(EDMA3_BASE, &ch);
+		return ret;
+	}
+
+	start = get_timer(0);
+	while (edma3_check_for_transfer(EDMA3_BASE, &ch)) {
+		if (get_timer(start) > GPMC_EDMA_TIMEOUT_MS) {
+			printf("nand: error: EDMA timeout\n");
+			ret = -ETIMEDOUT;
+			break;
+		}
+	}
+
+	edma3_stop(EDMA3_BASE, &ch);
+	omap_prefetch_reset();
+	invalidate_dcache_range((ulong)buf, (ulong)buf + len);
+
+	return ret;
+}
+#endif
+
 static inline void omap_nand_read(struct mtd_info *mtd, uint8_t *buf, int len)
 {
 	struct nand_chip *chip = mtd_to_nand(mtd);
@@ -430,6 +535,8 @@ static void omap_nand_read_prefetch(struct mtd_info *mtd, uint8_t *buf, int len)
 	int ret;
 	uint32_t head, tail;
 	struct nand_chip *chip = mtd_to_nand(mtd);
+	struct omap_nand_info *info __maybe_unused =
+		nand_get_controller_data(chip);
 
 	/*
 	 * If the destination buffer is unaligned, start with reading
@@ -448,6 +555,27 @@ static void omap_nand_read_prefetch(struct mtd_info *mtd, uint8_t *buf, int len)
 	 */
 	tail = len % 4;
 
+#ifdef OMAP_GPMC_USE_EDMA
+	/* Whole pages into aligned buffers go through EDMA */
+	if (IS_ALIGNED((ulong)buf, ARCH_DMA_MINALIGN) &&
+	    IS_ALIGNED(len, ARCH_DMA_MINALIGN) &&
+	    !(len % PREFETCH_FIFOTHRESHOLD_MAX)) {
+		ret = __read_prefetch_edma(chip, buf, len);
+		if (ret == -ETIMEDOUT) {
+			/*
+			 * The chip has moved on by however much the FIFO
+			 * took, so the data cannot be read again from here.
+			 * Fail the page rather than hand back a partial one.
+			 */
+			info->read_err = ret;
+			mtd->ecc_stats.failed++;
+		}
+		/* PIO can only take over if the engine did not start */
+		if (ret != -EBUSY)
+			return;
+	}
+#endif
+
 	ret = __read_prefetch_aligned(chip, (uint32_t *)buf, len - tail);
 	if (ret < 0) {
 		/* fallback in case the prefetch engine is busy */
@@ -478,29 +606,23 @@ static void omap_reverse_list(u8 *list, unsigned int length)
 }
 
 /*
- * omap_correct_data_bch - Compares the ecc read from nand spare area
- * with ECC registers values and corrects one bit error if it has occurred
+ * omap_bch_syndrome - prepares the syndrome of one sector for the ELM
  *
  * @mtd:	MTD device structure
- * @dat:	page data
- * @read_ecc:	ecc read from nand flash (ignored)
- * @calc_ecc:	ecc read from ECC registers
+ * @read_ecc:	ecc read from nand flash
+ * @calc_ecc:	ecc read from ECC registers, turned into the ELM syndrome
+ * @bch_type:	returns the BCH level to configure the ELM for
  *
- * @return 0 if data is OK or corrected, else returns -1
+ * @return 1 if the syndrome has to be checked, 0 if the sector is clean or
+ * erased, else -EINVAL
  */
-static int omap_correct_data_bch(struct mtd_info *mtd, uint8_t *dat,
-				uint8_t *read_ecc, uint8_t *calc_ecc)
+static int omap_bch_syndrome(struct mtd_info *mtd, uint8_t *read_ecc,
+			     uint8_t *calc_ecc, enum bch_level *bch_type)
 {
 	struct nand_chip *chip = mtd_to_nand(mtd);
 	struct omap_nand_info *info = nand_get_controller_data(chip);
 	struct nand_ecc_ctrl *ecc = &chip->ecc;
-	uint32_t error_count = 0, error_max;
-	uint32_t error_loc[ELM_MAX_ERROR_COUNT];
-	enum bch_level bch_type;
 	uint32_t i, ecc_flag = 0;
-	uint8_t count;
-	uint32_t byte_pos, bit_pos;
-	int err = 0;
 
 	/* check calculated ecc */
 	for (i = 0; i < ecc->bytes && !ecc_flag; i++) {
@@ -525,21 +647,42 @@ static int omap_correct_data_bch(struct mtd_info *mtd, uint8_t *dat,
 	 */
 	switch (info->ecc_scheme) {
 	case OMAP_ECC_BCH8_CODE_HW:
-		bch_type = BCH_8_BIT;
+		*bch_type = BCH_8_BIT;
 		omap_reverse_list(calc_ecc, ecc->bytes - 1);
 		break;
 	case OMAP_ECC_BCH16_CODE_HW:
-		bch_type = BCH_16_BIT;
+		*bch_type = BCH_16_BIT;
 		omap_reverse_list(calc_ecc, ecc->bytes);
 		break;
 	default:
 		return -EINVAL;
 	}
-	/* use elm module to check for errors */
-	elm_config(bch_type);
-	err = elm_check_error(calc_ecc, bch_type, &error_count, error_loc);
-	if (err)
-		return err;
+
+	return 1;
+}
+
+/*
+ * omap_fix_bch_errors - flips the bits located by the ELM in one sector
+ *
+ * @mtd:	MTD device structure
+ * @dat:	sector data
+ * @read_ecc:	ecc read from nand flash
+ * @error_count: number of errors located
+ * @error_loc:	error locations
+ *
+ * @return number of corrected bits, else -EBADMSG
+ */
+static int omap_fix_bch_errors(struct mtd_info *mtd, uint8_t *dat,
+			       uint8_t *read_ecc, uint32_t error_count,
+			       uint32_t *error_loc)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	struct omap_nand_info *info = nand_get_controller_data(chip);
+	struct nand_ecc_ctrl *ecc = &chip->ecc;
+	uint32_t error_max;
+	uint8_t count;
+	uint32_t byte_pos, bit_pos;
+	int err = 0;
 
 	/* correct bch error */
 	for (count = 0; count < error_count; count++) {
@@ -571,6 +714,92 @@ static int omap_correct_data_bch(struct mtd_info *mtd, uint8_t *dat,
 	return (err) ? err : error_count;
 }
 
+/*
+ * omap_correct_data_bch - Compares the ecc read from nand spare area
+ * with ECC registers values and corrects one bit error if it has occurred
+ *
+ * @mtd:	MTD device structure
+ * @dat:	page data
+ * @read_ecc:	ecc read from nand flash (ignored)
+ * @calc_ecc:	ecc read from ECC registers
+ *
+ * @return 0 if data is OK or corrected, else returns -1
+ */
+static int omap_correct_data_bch(struct mtd_info *mtd, uint8_t *dat,
+				uint8_t *read_ecc, uint8_t *calc_ecc)
+{
+	uint32_t error_count = 0;
+	uint32_t error_loc[ELM_MAX_ERROR_COUNT];
+	enum bch_level bch_type;
+	int err;
+
+	err = omap_bch_syndrome(mtd, read_ecc, calc_ecc, &bch_type);
+	if (err <= 0)
+		return err;
+
+	/* use elm module to check for errors */
+	elm_config(bch_type);
+	err = elm_check_error(calc_ecc, bch_type, &error_count, error_loc);
+	if (err)
+		return err;
+
+	return omap_fix_bch_errors(mtd, dat, read_ecc, error_count, error_loc);
+}
+
+/*
+ * omap_correct_page_bch - corrects all sectors of a page
+ *
+ * @mtd:	MTD device structure
+ * @buf:	page data
+ * @ecc_code:	ecc read from nand spare area
+ * @ecc_calc:	ecc read from ECC registers
+ *
+ * The syndromes of all sectors are handed to the ELM in one go, see
+ * elm_check_error_page(). Updates the ECC statistics of @mtd.
+ */
+static void omap_correct_page_bch(struct mtd_info *mtd, uint8_t *buf,
+				  uint8_t *ecc_code, uint8_t *ecc_calc)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	int eccsize = chip->ecc.size;
+	int eccbytes = chip->ecc.bytes;
+	int eccsteps = chip->ecc.steps;
+	u32 error_loc[ELM_MAX_CHANNELS][ELM_MAX_ERROR_COUNT];
+	int error_count[ELM_MAX_CHANNELS];
+	u8 *syndromes[ELM_MAX_CHANNELS];
+	enum bch_level bch_type = BCH_8_BIT;
+	int i, stat, check = 0;
+
+	for (i = 0; i < eccsteps; i++) {
+		stat = omap_bch_syndrome(mtd, &ecc_code[i * eccbytes],
+					 &ecc_calc[i * eccbytes], &bch_type);
+		if (stat < 0)
+			mtd->ecc_stats.failed++;
+		syndromes[i] = stat > 0 ? &ecc_calc[i * eccbytes] : NULL;
+		check |= stat > 0;
+	}
+	if (!check)
+		return;
+
+	elm_config(bch_type);
+	elm_check_error_page(syndromes, eccsteps, bch_type, error_count,
+			     error_loc);
+
+	for (i = 0; i < eccsteps; i++) {
+		if (!syndromes[i])
+			continue;
+		stat = error_count[i];
+		if (stat > 0)
+			stat = omap_fix_bch_errors(mtd, buf + i * eccsize,
+						   &ecc_code[i * eccbytes],
+						   stat, error_loc[i]);
+		if (stat < 0)
+			mtd->ecc_stats.failed++;
+		else
+			mtd->ecc_stats.corrected += stat;
+	}
+}
+
 /**
  * omap_read_page_bch - hardware ecc based page read function
  * @mtd:	mtd info structure
@@ -579,10 +808,15 @@ static int omap_correct_data_bch(struct mtd_info *mtd, uint8_t *dat,
  * @oob_required: caller expects OOB data read to chip->oob_poi
  * @page:	page number to read
  *
+ * If the GPMC has enough ECC result registers for all sectors of the page,
+ * the ECC engine runs over the whole page: the data is read in one go,
+ * then the ECC bytes, and all sectors are corrected with a single ELM
+ * request. Otherwise each sector is read and checked on its own.
  */
 static int omap_read_page_bch(struct mtd_info *mtd, struct nand_chip *chip,
 				uint8_t *buf, int oob_required, int page)
 {
+	struct omap_nand_info *info = nand_get_controller_data(chip);
 	int i, eccsize = chip->ecc.size;
 	int eccbytes = chip->ecc.bytes;
 	int eccsteps = chip->ecc.steps;
@@ -598,6 +832,24 @@ static int omap_read_page_bch(struct mtd_info *mtd, struct nand_chip *chip,
 	/* oob area start */
 	oob_pos = (eccsize * eccsteps) + chip->ecc.layout->eccpos[0];
 	oob += chip->ecc.layout->eccpos[0];
+	info->read_err = 0;
+
+	if (eccsteps <= GPMC_MAX_SECTORS) {
+		omap_enable_hwecc_sectors(mtd, NAND_ECC_READ, eccsteps);
+		/* the page read command left the column at 0 */
+		chip->read_buf(mtd, buf, eccsize * eccsteps);
+		chip->cmdfunc(mtd, NAND_CMD_RNDOUT, oob_pos, -1);
+		chip->read_buf(mtd, oob, chip->ecc.total);
+
+		for (i = 0; i < eccsteps; i++)
+			omap_calculate_ecc_sector(mtd, i,
+						  &ecc_calc[i * eccbytes]);
+		for (i = 0; i < chip->ecc.total; i++)
+			ecc_code[i] = chip->oob_poi[eccpos[i]];
+
+		omap_correct_page_bch(mtd, buf, ecc_code, ecc_calc);
+		return info->read_err ? -EIO : 0;
+	}
 
 	for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize,
 				oob += eccbytes) {
@@ -631,7 +883,7 @@ static int omap_read_page_bch(struct mtd_info *mtd, struct nand_chip *chip,
 		else
 			mtd->ecc_stats.corrected += stat;
 	}
-	return 0;
+	return info->read_err ? -EIO : 0;
 }
 #endif /* CONFIG_NAND_OMAP_ELM */
 
@@ -1033,5 +1285,9 @@ int board_nand_init(struct nand_chip *nand)
 
 	nand->dev_ready = omap_dev_ready;
 
+#ifdef OMAP_GPMC_USE_EDMA
+	enable_edma3_clocks();
+#endif
+
 	return 0;
 }
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Emulated NAND device for sandbox
+ *
+ * This behaves like a 128MiB SLC device with 2KiB pages, 64 bytes of OOB and
+ * 128KiB eraseblocks. Programming a page can only clear bits, as on a real
+ * device. A few blocks carry a factory bad block marker. Blocks are only
+ * given memory once they are written.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <nand.h>
+
+#define SANDBOX_NAND_PAGE_SIZE		2048
+#define SANDBOX_NAND_OOB_SIZE		64
+#define SANDBOX_NAND_RAW_SIZE	(SANDBOX_NAND_PAGE_SIZE + SANDBOX_NAND_OOB_SIZE)
+#define SANDBOX_NAND_BLOCK_PAGES	64
+#define SANDBOX_NAND_BLOCKS		1024
+#define SANDBOX_NAND_PAGES	(SANDBOX_NAND_BLOCKS * SANDBOX_NAND_BLOCK_PAGES)
+
+/* Samsung, 128MiB, SLC, 2KiB pages, 64 bytes of OOB, 128KiB blocks */
+static const u8 sandbox_nand_id[] = { NAND_MFR_SAMSUNG, 0xf1, 0x00, 0x15, 0x40 };
+
+/* Blocks which are marked bad when the device starts */
+static const int sandbox_nand_factory_bad[] = { 5, 700 };
+
+/**
+ * struct sandbox_nand - state of the emulated device
+ *
+ * @chip: NAND chip, as seen by the raw NAND core
+ * @blocks: contents of each block, NULL if the block is erased
+ * @buf: page register, holding a page with its OOB
+ * @column: offset in @buf of the next byte to read or write
+ * @page: page selected by the last read or program command
+ * @status: true if the next byte read is the status
+ */
+struct sandbox_nand {
+	struct nand_chip chip;
+	u8 *blocks[SANDBOX_NAND_BLOCKS];
+	u8 buf[SANDBOX_NAND_RAW_SIZE];
+	uint column;
+	int page;
+	bool status;
+};
+
+static u8 *sandbox_nand_page(struct sandbox_nand *priv, int page, bool alloc)
+{
+	int block = page / SANDBOX_NAND_BLOCK_PAGES;
+	uint size = SANDBOX_NAND_BLOCK_PAGES * SANDBOX_NAND_RAW_SIZE;
+
+	if (page < 0 || page >= SANDBOX_NAND_PAGES)
+		return NULL;
+	if (!priv->blocks[block]) {
+		if (!alloc)
+			return NULL;
+		priv->blocks[block] = malloc(size);
+		if (!priv->blocks[block])
+			return NULL;
+		memset(priv->blocks[block], 0xff, size);
+	}
+
+	return priv->blocks[block] +
+		(page % SANDBOX_NAND_BLOCK_PAGES) * SANDBOX_NAND_RAW_SIZE;
+}
+
+static void sandbox_nand_cmdfunc(struct mtd_info *mtd, unsigned int command,
+				 int column, int page_addr)
+{
+	struct sandbox_nand *priv = nand_get_controller_data(mtd_to_nand(mtd));
+	u8 *data;
+	int i;
+
+	priv->status = false;
+	switch (command) {
+	case NAND_CMD_RESET:
+		break;
+	case NAND_CMD_READID:
+		memset(priv->buf, '\0', sizeof(priv->buf));
+		memcpy(priv->buf, sandbox_nand_id, sizeof(sandbox_nand_id));
+		priv->column = 0;
+		break;
+	case NAND_CMD_PARAM:
+		/* There is no ONFI or JEDEC parameter page */
+		memset(priv->buf, '\0', sizeof(priv->buf));
+		priv->column = 0;
+		break;
+	case NAND_CMD_READOOB:
+		column += SANDBOX_NAND_PAGE_SIZE;
+		/* fall through */
+	case NAND_CMD_READ0:
+		/* READ0 without an address just leaves the status mode */
+		if (page_addr == -1)
+			break;
+		data = sandbox_nand_page(priv, page_addr, false);
+		if (data)
+			memcpy(priv->buf, data, SANDBOX_NAND_RAW_SIZE);
+		else
+			memset(priv->buf, 0xff, SANDBOX_NAND_RAW_SIZE);
+		priv->page = page_addr;
+		priv->column = column;
+		break;
+	case NAND_CMD_RNDOUT:
+	case NAND_CMD_RNDIN:
+		priv->column = column;
+		break;
+	case NAND_CMD_SEQIN:
+		memset(priv->buf, 0xff, SANDBOX_NAND_RAW_SIZE);
+		priv->page = page_addr;
+		priv->column = column;
+		break;
+	case NAND_CMD_PAGEPROG:
+		data = sandbox_nand_page(priv, priv->page, true);
+		if (!data)
+			break;
+		for (i = 0; i < SANDBOX_NAND_RAW_SIZE; i++)
+			data[i] &= priv->buf[i];
+		break;
+	case NAND_CMD_ERASE1:
+		i = page_addr / SANDBOX_NAND_BLOCK_PAGES;
+		if (page_addr >= 0 && i < SANDBOX_NAND_BLOCKS) {
+			free(priv->blocks[i]);
+			priv->blocks[i] = NULL;
+		}
+		break;
+	case NAND_CMD_ERASE2:
+		break;
+	case NAND_CMD_STATUS:
+		priv->status = true;
+		break;
+	default:
+		debug("%s: unknown command %x\n", __func__, command);
+		break;
+	}
+}
+
+static uint8_t sandbox_nand_read_byte(struct mtd_info *mtd)
+{
+	struct sandbox_nand *priv = nand_get_controller_data(mtd_to_nand(mtd));
+
+	if (priv->status)
+		return NAND_STATUS_READY | NAND_STATUS_WP;
+	if (priv->column >= SANDBOX_NAND_RAW_SIZE)
+		return 0xff;
+
+	return priv->buf[priv->column++];
+}
+
+static void sandbox_nand_read_buf(struct mtd_info *mtd, uint8_t *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = sandbox_nand_read_byte(mtd);
+}
+
+static void sandbox_nand_write_buf(struct mtd_info *mtd, const uint8_t *buf,
+				   int len)
+{
+	struct sandbox_nand *priv = nand_get_controller_data(mtd_to_nand(mtd));
+	int i;
+
+	for (i = 0; i < len && priv->column < SANDBOX_NAND_RAW_SIZE; i++)
+		priv->buf[priv->column++] = buf[i];
+}
+
+static void sandbox_nand_select_chip(struct mtd_info *mtd, int chipnr)
+{
+}
+
+static int sandbox_nand_dev_ready(struct mtd_info *mtd)
+{
+	return 1;
+}
+
+void board_nand_init(void)
+{
+	struct sandbox_nand *priv;
+	struct nand_chip *chip;
+	struct mtd_info *mtd;
+	u8 *oob;
+	int i, ret;
+
+	priv = calloc(1, sizeof(*priv));
+	if (!priv) {
+		printf("%s: Memory exhausted!\n", __func__);
+		return;
+	}
+	chip = &priv->chip;
+	mtd = nand_to_mtd(chip);
+	nand_set_controller_data(chip, priv);
+
+	chip->cmdfunc = sandbox_nand_cmdfunc;
+	chip->read_byte = sandbox_nand_read_byte;
+	chip->read_buf = sandbox_nand_read_buf;
+	chip->write_buf = sandbox_nand_write_buf;
+	chip->select_chip = sandbox_nand_select_chip;
+	chip->dev_ready = sandbox_nand_dev_ready;
+	chip->ecc.mode = NAND_ECC_SOFT;
+
+	for (i = 0; i < ARRAY_SIZE(sandbox_nand_factory_bad); i++) {
+		oob = sandbox_nand_page(priv, sandbox_nand_factory_bad[i] *
+					SANDBOX_NAND_BLOCK_PAGES, true);
+		if (oob)
+			oob[SANDBOX_NAND_PAGE_SIZE] = 0;
+	}
+
+	ret = nand_scan(mtd, 1);
+	if (!ret)
+		ret = nand_register(0, mtd);
+	if (ret)
+		printf("Sandbox NAND init failed (err %d)\n", ret);
+}
@@ -1157,10 +1157,10 @@ static void destroy_av(struct ubi_attach_info *ai, struct ubi_ainf_volume *av)
 }
 
 /**
- * destroy_ai - destroy attaching information.
+ * ubi_destroy_ai - destroy attaching information.
  * @ai: attaching information
  */
-static void destroy_ai(struct ubi_attach_info *ai)
+void ubi_destroy_ai(struct ubi_attach_info *ai)
 {
 	struct ubi_ainf_peb *aeb, *aeb_tmp;
 	struct ubi_ainf_volume *av;
@@ -1369,7 +1369,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 	if (fm_anchor < 0)
 		return UBI_NO_FASTMAP;
 
-	destroy_ai(*ai);
+	ubi_destroy_ai(*ai);
 	*ai = alloc_ai();
 	if (!*ai)
 		return -ENOMEM;
@@ -1398,6 +1398,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 {
 	int err;
 	struct ubi_attach_info *ai;
+	unsigned long start = timer_get_us();
 
 	ai = alloc_ai();
 	if (!ai)
@@ -1416,7 +1417,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 		err = scan_fast(ubi, &ai);
 		if (err > 0 || mtd_is_eccerr(err)) {
 			if (err != UBI_NO_FASTMAP) {
-				destroy_ai(ai);
+				ubi_destroy_ai(ai);
 				ai = alloc_ai();
 				if (!ai)
 					return -ENOMEM;
@@ -1439,18 +1440,33 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 	ubi->max_ec = ai->max_ec;
 	ubi->mean_ec = ai->mean_ec;
 	dbg_gen("max. sequence number:       %llu", ai->max_sqnum);
+	ubi->attach_us.scan = timer_get_us() - start;
 
+	start = timer_get_us();
 	err = ubi_read_volume_table(ubi, ai);
 	if (err)
 		goto out_ai;
+	ubi->attach_us.vtbl = timer_get_us() - start;
 
+	start = timer_get_us();
 	err = ubi_wl_init(ubi, ai);
 	if (err)
 		goto out_vtbl;
+	ubi->attach_us.wl = timer_get_us() - start;
 
+#ifdef CONFIG_MTD_UBI_LAZY_EBA
+	/* Trust the fastmap, EBA tables are built when volumes are used */
+	if (ubi->fm)
+		ubi->lazy_ai = ai;
+#endif
+	start = timer_get_us();
 	err = ubi_eba_init(ubi, ai);
 	if (err)
 		goto out_wl;
+	ubi->attach_us.eba = timer_get_us() - start;
+
+	if (ubi->lazy_ai)
+		return 0;
 
 #ifdef CONFIG_MTD_UBI_FASTMAP
 	if (ubi->fm && ubi_dbg_chk_fastmap(ubi)) {
@@ -1464,28 +1480,29 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 
 		err = scan_all(ubi, scan_ai, 0);
 		if (err) {
-			destroy_ai(scan_ai);
+			ubi_destroy_ai(scan_ai);
 			goto out_wl;
 		}
 
 		err = self_check_eba(ubi, ai, scan_ai);
-		destroy_ai(scan_ai);
+		ubi_destroy_ai(scan_ai);
 
 		if (err)
 			goto out_wl;
 	}
 #endif
 
-	destroy_ai(ai);
+	ubi_destroy_ai(ai);
 	return 0;
 
 out_wl:
+	ubi->lazy_ai = NULL;
 	ubi_wl_close(ubi);
 out_vtbl:
 	ubi_free_internal_volumes(ubi);
 	vfree(ubi->vtbl);
 out_ai:
-	destroy_ai(ai);
+	ubi_destroy_ai(ai);
 	return err;
 }
 
@@ -1059,7 +1059,9 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 #ifndef __UBOOT__
 	wake_up_process(ubi->bgt_thread);
 #else
+	ubi->attach_us.works = timer_get_us();
 	ubi_do_worker(ubi);
+	ubi->attach_us.works = timer_get_us() - ubi->attach_us.works;
 #endif
 
 	spin_unlock(&ubi->wl_lock);
@@ -1075,6 +1077,7 @@ out_uif:
 	ubi_assert(ref);
 	uif_close(ubi);
 out_detach:
+	ubi_eba_free_lazy_ai(ubi);
 	ubi_wl_close(ubi);
 	ubi_free_internal_volumes(ubi);
 	vfree(ubi->vtbl);
@@ -1154,6 +1157,7 @@ int ubi_detach_mtd_dev(int ubi_num, int anyway)
 	ubi_debugfs_exit_dev(ubi);
 	uif_close(ubi);
 
+	ubi_eba_free_lazy_ai(ubi);
 	ubi_wl_close(ubi);
 	ubi_free_internal_volumes(ubi);
 	vfree(ubi->vtbl);
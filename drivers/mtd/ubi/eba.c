@@ -322,6 +322,10 @@ int ubi_eba_unmap_leb(struct ubi_device *ubi, struct ubi_volume *vol,
 	if (ubi->ro_mode)
 		return -EROFS;
 
+	err = ubi_eba_build_table(ubi, vol);
+	if (err)
+		return err;
+
 	err = leb_write_lock(ubi, vol_id, lnum);
 	if (err)
 		return err;
@@ -369,6 +373,10 @@ int ubi_eba_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
 	struct ubi_vid_hdr *vid_hdr;
 	uint32_t uninitialized_var(crc);
 
+	err = ubi_eba_build_table(ubi, vol);
+	if (err)
+		return err;
+
 	err = leb_read_lock(ubi, vol_id, lnum);
 	if (err)
 		return err;
@@ -661,6 +669,10 @@ int ubi_eba_write_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
 	if (ubi->ro_mode)
 		return -EROFS;
 
+	err = ubi_eba_build_table(ubi, vol);
+	if (err)
+		return err;
+
 	err = leb_write_lock(ubi, vol_id, lnum);
 	if (err)
 		return err;
@@ -795,6 +807,10 @@ int ubi_eba_write_leb_st(struct ubi_device *ubi, struct ubi_volume *vol,
 	if (ubi->ro_mode)
 		return -EROFS;
 
+	err = ubi_eba_build_table(ubi, vol);
+	if (err)
+		return err;
+
 	if (lnum == used_ebs - 1)
 		/* If this is the last LEB @len may be unaligned */
 		len = ALIGN(data_size, ubi->min_io_size);
@@ -912,6 +928,10 @@ int ubi_eba_atomic_leb_change(struct ubi_device *ubi, struct ubi_volume *vol,
 	if (ubi->ro_mode)
 		return -EROFS;
 
+	err = ubi_eba_build_table(ubi, vol);
+	if (err)
+		return err;
+
 	if (len == 0) {
 		/*
 		 * Special case when data length is zero. In this case the LEB
@@ -1086,6 +1106,10 @@ int ubi_eba_copy_leb(struct ubi_device *ubi, int from, int to,
 		return MOVE_CANCEL_RACE;
 	}
 
+	err = ubi_eba_build_table(ubi, vol);
+	if (err)
+		return err;
+
 	/*
 	 * We do not want anybody to write to this logical eraseblock while we
 	 * are moving it, so lock it.
@@ -1374,6 +1398,92 @@ out_free:
 	return ret;
 }
 
+#ifdef CONFIG_MTD_UBI_LAZY_EBA
+/**
+ * ubi_eba_build_table - build the EBA table of a volume on first use.
+ * @ubi: UBI device description object
+ * @vol: volume description object
+ *
+ * When the device was attached from a fastmap, EBA tables are built from the
+ * attaching information kept in @ubi->lazy_ai the first time a volume is
+ * accessed. Returns zero in case of success and %-ENOMEM on failure.
+ */
+int ubi_eba_build_table(struct ubi_device *ubi, struct ubi_volume *vol)
+{
+	struct ubi_ainf_volume *av;
+	struct ubi_ainf_peb *aeb;
+	unsigned long start;
+	struct rb_node *rb;
+	int i;
+
+	if (vol->eba_tbl || !ubi->lazy_ai)
+		return 0;
+
+	start = timer_get_us();
+	vol->eba_tbl = kmalloc(vol->reserved_pebs * sizeof(int), GFP_KERNEL);
+	if (!vol->eba_tbl)
+		return -ENOMEM;
+
+	for (i = 0; i < vol->reserved_pebs; i++)
+		vol->eba_tbl[i] = UBI_LEB_UNMAPPED;
+
+	av = ubi_find_av(ubi->lazy_ai, vol->vol_id);
+	if (av) {
+		ubi_rb_for_each_entry(rb, aeb, &av->root, u.rb) {
+			/*
+			 * LEBs beyond the volume size are left from an
+			 * interrupted re-size, ubi_eba_init() drops them too.
+			 */
+			if (aeb->lnum < vol->reserved_pebs)
+				vol->eba_tbl[aeb->lnum] = aeb->pnum;
+		}
+	}
+	dbg_eba("built EBA table of volume %d", vol->vol_id);
+	ubi->lazy_eba_us += timer_get_us() - start;
+
+	return 0;
+}
+
+/**
+ * ubi_eba_build_all - build the EBA tables of all volumes.
+ * @ubi: UBI device description object
+ *
+ * This is needed before writing a fastmap, which holds all EBA tables. The
+ * attaching information is not needed anymore afterwards. Returns zero in
+ * case of success and %-ENOMEM on failure.
+ */
+int ubi_eba_build_all(struct ubi_device *ubi)
+{
+	int i, err;
+
+	if (!ubi->lazy_ai)
+		return 0;
+
+	for (i = 0; i < ubi->vtbl_slots + UBI_INT_VOL_COUNT; i++) {
+		if (!ubi->volumes[i])
+			continue;
+		err = ubi_eba_build_table(ubi, ubi->volumes[i]);
+		if (err)
+			return err;
+	}
+	ubi_eba_free_lazy_ai(ubi);
+
+	return 0;
+}
+
+/**
+ * ubi_eba_free_lazy_ai - free the attaching information kept after attach.
+ * @ubi: UBI device description object
+ */
+void ubi_eba_free_lazy_ai(struct ubi_device *ubi)
+{
+	if (ubi->lazy_ai) {
+		ubi_destroy_ai(ubi->lazy_ai);
+		ubi->lazy_ai = NULL;
+	}
+}
+#endif
+
 /**
  * ubi_eba_init - initialize the EBA sub-system using attaching information.
  * @ubi: UBI device description object
@@ -1406,6 +1516,10 @@ int ubi_eba_init(struct ubi_device *ubi, struct ubi_attach_info *ai)
 
 		cond_resched();
 
+		/* Left to ubi_eba_build_table() when attached lazily */
+		if (ubi->lazy_ai)
+			continue;
+
 		vol->eba_tbl = kmalloc(vol->reserved_pebs * sizeof(int),
 				       GFP_KERNEL);
 		if (!vol->eba_tbl) {
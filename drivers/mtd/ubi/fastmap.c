@@ -1497,6 +1497,11 @@ int ubi_update_fastmap(struct ubi_device *ubi)
 	struct ubi_fastmap_layout *new_fm, *old_fm;
 	struct ubi_wl_entry *tmp_e;
 
+	/* The fastmap holds the EBA tables of all volumes */
+	ret = ubi_eba_build_all(ubi);
+	if (ret)
+		return ret;
+
 	down_write(&ubi->fm_protect);
 
 	ubi_refill_pools(ubi);
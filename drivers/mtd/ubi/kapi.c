@@ -196,6 +196,12 @@ struct ubi_volume_desc *ubi_open_volume(int ubi_num, int vol_id, int mode)
 	desc->mode = mode;
 
 	mutex_lock(&ubi->ckvol_mutex);
+	err = ubi_eba_build_table(ubi, vol);
+	if (err) {
+		mutex_unlock(&ubi->ckvol_mutex);
+		ubi_close_volume(desc);
+		return ERR_PTR(err);
+	}
 	if (!vol->checked && !vol->skip_check) {
 		/* This is the first open - check the volume */
 		err = ubi_check_volume(ubi, vol_id);
@@ -529,6 +529,13 @@ struct ubi_debug_info {
  * @ckvol_mutex: serializes static volume checking when opening
  *
  * @dbg: debugging information for this UBI device
+ *
+ * @lazy_ai: attaching information kept to build the EBA tables which were
+ *           not built at attach time (%CONFIG_MTD_UBI_LAZY_EBA)
+ * @attach_us: attach time in microseconds, split in scanning (or reading the
+ *             fastmap), reading the volume table, WL and EBA initialization
+ *             and the works run at the end of attach
+ * @lazy_eba_us: time spent building EBA tables after attach
  */
 struct ubi_device {
 	struct cdev cdev;
@@ -628,6 +635,18 @@ struct ubi_device {
 	struct mutex ckvol_mutex;
 
 	struct ubi_debug_info dbg;
+
+#ifdef __UBOOT__
+	struct ubi_attach_info *lazy_ai;
+	struct {
+		unsigned long scan;
+		unsigned long vtbl;
+		unsigned long wl;
+		unsigned long eba;
+		unsigned long works;
+	} attach_us;
+	unsigned long lazy_eba_us;
+#endif
 };
 
 /**
@@ -862,6 +881,26 @@ int ubi_eba_atomic_leb_change(struct ubi_device *ubi, struct ubi_volume *vol,
 int ubi_eba_copy_leb(struct ubi_device *ubi, int from, int to,
 		     struct ubi_vid_hdr *vid_hdr);
 int ubi_eba_init(struct ubi_device *ubi, struct ubi_attach_info *ai);
+#ifdef CONFIG_MTD_UBI_LAZY_EBA
+int ubi_eba_build_table(struct ubi_device *ubi, struct ubi_volume *vol);
+int ubi_eba_build_all(struct ubi_device *ubi);
+void ubi_eba_free_lazy_ai(struct ubi_device *ubi);
+#else
+static inline int ubi_eba_build_table(struct ubi_device *ubi,
+				      struct ubi_volume *vol)
+{
+	return 0;
+}
+
+static inline int ubi_eba_build_all(struct ubi_device *ubi)
+{
+	return 0;
+}
+
+static inline void ubi_eba_free_lazy_ai(struct ubi_device *ubi)
+{
+}
+#endif
 unsigned long long ubi_next_sqnum(struct ubi_device *ubi);
 int self_check_eba(struct ubi_device *ubi, struct ubi_attach_info *ai_fastmap,
 		   struct ubi_attach_info *ai_scan);
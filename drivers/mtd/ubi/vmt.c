@@ -454,6 +454,10 @@ int ubi_resize_volume(struct ubi_volume_desc *desc, int reserved_pebs)
 	if (reserved_pebs == vol->reserved_pebs)
 		return 0;
 
+	err = ubi_eba_build_table(ubi, vol);
+	if (err)
+		return err;
+
 	new_mapping = kmalloc(reserved_pebs * sizeof(int), GFP_KERNEL);
 	if (!new_mapping)
 		return -ENOMEM;
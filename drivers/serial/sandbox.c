@@ -41,8 +41,20 @@ struct sandbox_serial_platdata {
 	int colour;	/* Text colour to use for output, -1 for none */
 };
 
+/**
+ * struct sandbox_serial_priv - Private data for the sandbox uart
+ *
+ * @start_of_line: true if the next character starts a new line
+ * @busy: Number of putc() calls which report that the uart is busy
+ * @written: Number of characters written
+ * @written_at_change: Value of @written when the baud rate or line settings
+ *	were last changed
+ */
 struct sandbox_serial_priv {
 	bool start_of_line;
+	int busy;
+	int written;
+	int written_at_change;
 };
 
 /**
@@ -93,6 +105,11 @@ static int sandbox_serial_putc(struct udevice *dev, const char ch)
 	struct sandbox_serial_priv *priv = dev_get_priv(dev);
 	struct sandbox_serial_platdata *plat = dev->platdata;
 
+	if (priv->busy) {
+		priv->busy--;
+		return -EAGAIN;
+	}
+
 	if (priv->start_of_line && plat->colour != -1) {
 		priv->start_of_line = false;
 		output_ansi_colour(plat->colour);
@@ -101,6 +118,32 @@ static int sandbox_serial_putc(struct udevice *dev, const char ch)
 	os_write(1, &ch, 1);
 	if (ch == '\n')
 		priv->start_of_line = true;
+	priv->written++;
+
+	return 0;
+}
+
+void sandbox_serial_set_busy(struct udevice *dev, int count)
+{
+	struct sandbox_serial_priv *priv = dev_get_priv(dev);
+
+	priv->busy = count;
+}
+
+int sandbox_serial_get_written(struct udevice *dev, int *at_changep)
+{
+	struct sandbox_serial_priv *priv = dev_get_priv(dev);
+
+	*at_changep = priv->written_at_change;
+
+	return priv->written;
+}
+
+static int sandbox_serial_setbrg(struct udevice *dev, int baudrate)
+{
+	struct sandbox_serial_priv *priv = dev_get_priv(dev);
+
+	priv->written_at_change = priv->written;
 
 	return 0;
 }
@@ -180,10 +223,12 @@ static int sandbox_serial_setconfig(struct udevice *dev, uint serial_config)
 	u8 parity = SERIAL_GET_PARITY(serial_config);
 	u8 bits = SERIAL_GET_BITS(serial_config);
 	u8 stop = SERIAL_GET_STOP(serial_config);
+	struct sandbox_serial_priv *priv = dev_get_priv(dev);
 
 	if (bits != SERIAL_8_BITS || stop != SERIAL_ONE_STOP ||
 	    parity != SERIAL_PAR_NONE)
 		return -ENOTSUPP; /* not supported in driver*/
+	priv->written_at_change = priv->written;
 
 	return 0;
 }
@@ -238,6 +283,7 @@ static int sandbox_serial_ofdata_to_platdata(struct udevice *dev)
 }
 
 static const struct dm_serial_ops sandbox_serial_ops = {
+	.setbrg = sandbox_serial_setbrg,
 	.putc = sandbox_serial_putc,
 	.pending = sandbox_serial_pending,
 	.getc = sandbox_serial_getc,
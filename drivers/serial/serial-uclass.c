@@ -172,6 +172,91 @@ void serial_initialize(void)
 	serial_init();
 }
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+/* Move characters from the TX buffer to the uart, optionally until empty */
+static void _serial_drain(struct udevice *dev, bool wait)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	int ch, err;
+
+	if (!upriv->txbuf.start || upriv->draining)
+		return;
+
+	upriv->draining = true;
+	while ((ch = membuff_peekbyte(&upriv->txbuf)) != -1) {
+		err = ops->putc(dev, ch);
+		if (err == -EAGAIN) {
+			if (!wait)
+				break;
+			WATCHDOG_RESET();
+			continue;
+		}
+		/* A character the uart rejects is dropped */
+		membuff_getbyte(&upriv->txbuf);
+	}
+	upriv->draining = false;
+}
+
+static bool _serial_buffer(struct udevice *dev, char ch)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	/* Write directly if there is no buffer or the driver writes output */
+	if (!upriv->txbuf.start || upriv->draining)
+		return false;
+
+	while (!membuff_putbyte(&upriv->txbuf, ch))
+		_serial_drain(dev, false);
+	_serial_drain(dev, false);
+
+	return true;
+}
+
+void serial_drain(void)
+{
+	if (gd->cur_serial_dev)
+		_serial_drain(gd->cur_serial_dev, false);
+}
+
+void serial_flush(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+
+	if (uclass_get(UCLASS_SERIAL, &uc))
+		return;
+	uclass_foreach_dev(dev, uc) {
+		if (device_active(dev))
+			_serial_drain(dev, true);
+	}
+}
+#else
+static void _serial_drain(struct udevice *dev, bool wait)
+{
+}
+
+static bool _serial_buffer(struct udevice *dev, char ch)
+{
+	return false;
+}
+#endif /* CONFIG_IS_ENABLED(SERIAL_TX_BUFFER) */
+
+/*
+ * Wait until all output has left the uart, so that it is not garbled by a
+ * change of baud rate or line settings
+ */
+static void _serial_flush(struct udevice *dev)
+{
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+
+	_serial_drain(dev, true);
+	if (ops->pending) {
+		while (ops->pending(dev, false) > 0)
+			WATCHDOG_RESET();
+	}
+}
+
 static void _serial_putc(struct udevice *dev, char ch)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
@@ -180,6 +265,9 @@ static void _serial_putc(struct udevice *dev, char ch)
 	if (ch == '\n')
 		_serial_putc(dev, '\r');
 
+	if (_serial_buffer(dev, ch))
+		return;
+
 	do {
 		err = ops->putc(dev, ch);
 	} while (err == -EAGAIN);
@@ -198,8 +286,10 @@ static int __serial_getc(struct udevice *dev)
 
 	do {
 		err = ops->getc(dev);
-		if (err == -EAGAIN)
+		if (err == -EAGAIN) {
 			WATCHDOG_RESET();
+			_serial_drain(dev, false);
+		}
 	} while (err == -EAGAIN);
 
 	return err >= 0 ? err : 0;
@@ -209,6 +299,7 @@ static int __serial_tstc(struct udevice *dev)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+	_serial_drain(dev, false);
 	if (ops->pending)
 		return ops->pending(dev, true);
 
@@ -292,8 +383,10 @@ void serial_setbrg(void)
 		return;
 
 	ops = serial_get_ops(gd->cur_serial_dev);
-	if (ops->setbrg)
+	if (ops->setbrg) {
+		_serial_flush(gd->cur_serial_dev);
 		ops->setbrg(gd->cur_serial_dev, gd->baudrate);
+	}
 }
 
 int serial_getconfig(struct udevice *dev, uint *config)
@@ -312,8 +405,10 @@ int serial_setconfig(struct udevice *dev, uint config)
 	struct dm_serial_ops *ops;
 
 	ops = serial_get_ops(dev);
-	if (ops->setconfig)
+	if (ops->setconfig) {
+		_serial_flush(dev);
 		return ops->setconfig(dev, config);
+	}
 
 	return 0;
 }
@@ -402,6 +497,8 @@ static int on_baudrate(const char *name, const char *value, enum env_op op,
 			udelay(50000);
 		}
 
+		/* Let the message above out at the old rate */
+		serial_flush();
 		gd->baudrate = baudrate;
 
 		serial_setbrg();
@@ -480,6 +577,10 @@ static int serial_post_probe(struct udevice *dev)
 	/* Allocate the RX buffer */
 	upriv->buf = malloc(CONFIG_SERIAL_RX_BUFFER_SIZE);
 #endif
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	/* Output is written directly if this fails */
+	membuff_new(&upriv->txbuf, CONFIG_SERIAL_TX_BUFFER_SIZE);
+#endif
 
 	stdio_register_dev(&sdev, &upriv->sdev);
 #endif
@@ -488,12 +589,17 @@ static int serial_post_probe(struct udevice *dev)
 
 static int serial_pre_remove(struct udevice *dev)
 {
-#if CONFIG_IS_ENABLED(SYS_STDIO_DEREGISTER)
-	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	__maybe_unused struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
 
+	_serial_drain(dev, true);
+#if CONFIG_IS_ENABLED(SYS_STDIO_DEREGISTER)
 	if (stdio_deregister_dev(upriv->sdev, true))
 		return -EPERM;
 #endif
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	free(upriv->txbuf.start);
+	membuff_uninit(&upriv->txbuf);
+#endif
 
 	return 0;
 }
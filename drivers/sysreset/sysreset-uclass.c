@@ -7,10 +7,12 @@
 #define LOG_CATEGORY UCLASS_SYSRESET
 
 #include <common.h>
+#include <blk.h>
 #include <sysreset.h>
 #include <dm.h>
 #include <errno.h>
 #include <regmap.h>
+#include <serial.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/root.h>
@@ -112,6 +114,8 @@ void reset_cpu(ulong addr)
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	printf("resetting ...\n");
+	blkcache_flush_all();
+	serial_flush();
 
 	sysreset_walk_halt(SYSRESET_COLD);
 
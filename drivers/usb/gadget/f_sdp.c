@@ -714,6 +714,7 @@ static void sdp_handle_in_ep(struct spl_image_info *spl_image)
 				load.dev = header;
 				load.bl_len = 1;
 				load.read = sdp_fit_read;
+				load.queue = NULL;
 				spl_load_simple_fit(spl_image, &load, 0,
 						    header);
 
@@ -7,6 +7,7 @@
 #include <common.h>
 #include <env.h>
 #include <env_internal.h>
+#include <errno.h>
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 DECLARE_GLOBAL_DATA_PTR;
@@ -120,6 +121,32 @@ static int set_callback(const char *name, const char *value, void *priv)
 	return 0;
 }
 
+int env_callback_bind(const char *name, const char *callback)
+{
+	struct env_entry e, *ep;
+	struct env_clbk_tbl *clbkp;
+	int (*func)(const char *name, const char *value, enum env_op op,
+		    int flags);
+
+	clbkp = find_env_callback(callback);
+	e.key	= name;
+	e.data	= NULL;
+	e.callback = NULL;
+	hsearch_r(e, ENV_FIND, &ep, &env_htab, 0);
+	if (!ep || !clbkp)
+		return -ENOENT;
+
+	func = clbkp->callback;
+#if defined(CONFIG_NEEDS_MANUAL_RELOC)
+	func += gd->reloc_off;
+#endif
+	if (ep->callback && ep->callback != func)
+		return -EEXIST;
+	ep->callback = func;
+
+	return 0;
+}
+
 static int on_callbacks(const char *name, const char *value, enum env_op op,
 	int flags)
 {
@@ -0,0 +1,276 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Journal of environment changes
+ *
+ * Each save appends a record with the variables which changed since the
+ * previous one, in the format of the stored environment: "name=value" for a
+ * new or changed variable and a bare "name" for a deleted one. Records are
+ * aligned to the write unit of the device and written one after the other,
+ * so that NAND pages are only programmed once between erases. Every record
+ * carries the CRC of the base it applies to and a sequence number, so that
+ * records left over from an older base, or a record which was only partly
+ * written, are never replayed.
+ */
+
+#include <common.h>
+#include <env.h>
+#include <env_internal.h>
+#include <errno.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <search.h>
+#include <linux/string.h>
+#include <u-boot/crc.h>
+
+#define ENV_JOURNAL_MAGIC	0x4c4e4a45	/* "EJNL" */
+
+struct env_journal_rec {
+	u32 magic;
+	u32 base_crc;	/* CRC of the base the record applies to */
+	u32 seq;	/* 0 for the first record after the base */
+	u32 len;	/* bytes of data after the header */
+	u32 crc;	/* CRC of the header up to here and the data */
+};
+
+static u32 env_journal_rec_crc(const struct env_journal_rec *rec)
+{
+	u32 crc;
+
+	crc = crc32(0, (const void *)rec, offsetof(struct env_journal_rec, crc));
+
+	return crc32(crc, (const void *)(rec + 1), rec->len);
+}
+
+/* Compare the names of two "name=value" strings, as hexport_r() sorts them */
+static int env_journal_keycmp(const char *a, const char *b)
+{
+	for (; *a == *b && *a && *a != '='; a++, b++)
+		;
+
+	return (*a == '=' ? 0 : (uchar)*a) - (*b == '=' ? 0 : (uchar)*b);
+}
+
+long env_journal_diff(const char *old, const char *new, char *out,
+		      ulong max)
+{
+	const char *entry;
+	ulong len = 0, n;
+	int cmp;
+
+	while (*old || *new) {
+		if (!*old)
+			cmp = 1;
+		else if (!*new)
+			cmp = -1;
+		else
+			cmp = env_journal_keycmp(old, new);
+
+		if (cmp < 0) {
+			/* Deleted, only keep the name */
+			entry = old;
+			n = strchrnul(old, '=') - old;
+			old += strlen(old) + 1;
+		} else {
+			entry = new;
+			n = strlen(new);
+			new += n + 1;
+			if (!cmp) {
+				cmp = strcmp(old, entry);
+				old += strlen(old) + 1;
+				if (!cmp)
+					continue;
+			}
+		}
+
+		if (len + n + 2 > max)
+			return -ENOSPC;
+		memcpy(out + len, entry, n);
+		out[len + n] = '\0';
+		len += n + 1;
+	}
+	out[len++] = '\0';
+
+	return len;
+}
+
+static bool env_journal_blank(const u8 *buf, ulong len)
+{
+	ulong i;
+
+	for (i = 1; i < len && buf[i] == buf[0]; i++)
+		;
+
+	return i == len && (buf[0] == 0 || buf[0] == 0xff);
+}
+
+/* Remember the running environment as the stored one */
+static int env_journal_snap(struct env_journal *jnl)
+{
+	char *res = NULL;
+
+	if (hexport_r(&env_htab, '\0', 0, &res, 0, 0, NULL) < 0)
+		return -ENOMEM;
+	free(jnl->snap);
+	jnl->snap = res;
+	jnl->active = true;
+
+	return 0;
+}
+
+static ulong env_journal_max_rec(struct env_journal *jnl)
+{
+	return ALIGN(sizeof(struct env_journal_rec) + ENV_SIZE, jnl->unit);
+}
+
+int env_journal_replay(struct env_journal *jnl, u32 base_crc)
+{
+	struct env_journal_rec *rec;
+	ulong len;
+	int ret = 0;
+
+	jnl->active = false;
+	jnl->base_crc = base_crc;
+	jnl->seq = 0;
+	jnl->end = 0;
+
+	rec = malloc_cache_aligned(env_journal_max_rec(jnl));
+	if (!rec)
+		return -ENOMEM;
+
+	while (jnl->end + jnl->unit <= jnl->size) {
+		if (jnl->ops->read(jnl, jnl->end, jnl->unit, rec))
+			break;
+		if (rec->magic != ENV_JOURNAL_MAGIC ||
+		    rec->base_crc != base_crc || rec->seq != jnl->seq ||
+		    rec->len > ENV_SIZE)
+			break;
+		len = ALIGN(sizeof(*rec) + rec->len, jnl->unit);
+		if (jnl->end + len > jnl->size)
+			break;
+		if (len > jnl->unit &&
+		    jnl->ops->read(jnl, jnl->end + jnl->unit, len - jnl->unit,
+				   (char *)rec + jnl->unit))
+			break;
+		if (env_journal_rec_crc(rec) != rec->crc)
+			break;
+
+		if (!himport_r(&env_htab, (char *)(rec + 1), rec->len, '\0',
+			       H_NOCLEAR, 0, 0, NULL)) {
+			pr_err("Cannot import journal record %u\n", rec->seq);
+			ret = -EIO;
+			break;
+		}
+		jnl->end += len;
+		jnl->seq++;
+	}
+	debug("%s: %u records, %lu bytes\n", __func__, jnl->seq, jnl->end);
+
+	/*
+	 * Only carry on after the last record if the rest is unused. Anything
+	 * else, such as a record which was cut short, must be erased first.
+	 */
+	jnl->dirty = jnl->size;
+	if (jnl->end + jnl->unit > jnl->size ||
+	    (!jnl->ops->read(jnl, jnl->end, jnl->unit, rec) &&
+	     env_journal_blank((u8 *)rec, jnl->unit)))
+		jnl->dirty = jnl->end;
+	free(rec);
+
+	if (!ret)
+		ret = env_journal_snap(jnl);
+
+	return ret;
+}
+
+int env_journal_append(struct env_journal *jnl)
+{
+	struct env_journal_rec *rec;
+	char *res = NULL;
+	ulong len, room;
+	ssize_t size;
+	long dlen;
+	int ret;
+
+	if (!jnl->active || jnl->dirty > jnl->end ||
+	    jnl->end + jnl->unit > jnl->size)
+		return -ENOSPC;
+
+	size = hexport_r(&env_htab, '\0', 0, &res, 0, 0, NULL);
+	if (size < 0)
+		return -ENOMEM;
+	/* Let the caller report an environment which has become too large */
+	if (size > ENV_SIZE) {
+		free(res);
+		return -ENOSPC;
+	}
+
+	/* A record larger than the environment is not worth it */
+	room = min(env_journal_max_rec(jnl), jnl->size - jnl->end);
+	rec = malloc_cache_aligned(room);
+	if (!rec) {
+		free(res);
+		return -ENOMEM;
+	}
+
+	dlen = env_journal_diff(jnl->snap, res, (char *)(rec + 1),
+				room - sizeof(*rec));
+	if (dlen < 0) {
+		ret = dlen;
+		goto err;
+	}
+	if (dlen == 1) {
+		debug("%s: no changes\n", __func__);
+		ret = 0;
+		goto err;
+	}
+
+	rec->magic = ENV_JOURNAL_MAGIC;
+	rec->base_crc = jnl->base_crc;
+	rec->seq = jnl->seq;
+	rec->len = dlen;
+	rec->crc = env_journal_rec_crc(rec);
+	len = ALIGN(sizeof(*rec) + dlen, jnl->unit);
+	memset((char *)(rec + 1) + dlen, 0xff, len - sizeof(*rec) - dlen);
+
+	/* Whatever happens, this part of the area is now in use */
+	jnl->dirty = jnl->end + len;
+	ret = jnl->ops->write(jnl, jnl->end, len, rec);
+	if (ret) {
+		jnl->active = false;
+		goto err;
+	}
+	debug("%s: record %u, %ld bytes at %lx\n", __func__, jnl->seq, dlen,
+	      jnl->end);
+	jnl->end += len;
+	jnl->seq++;
+
+	free(jnl->snap);
+	jnl->snap = res;
+	free(rec);
+
+	return 0;
+
+err:
+	free(rec);
+	free(res);
+
+	return ret;
+}
+
+int env_journal_reset(struct env_journal *jnl, const env_t *env)
+{
+	int ret;
+
+	jnl->active = false;
+	if (jnl->dirty) {
+		ret = jnl->ops->erase(jnl, jnl->dirty);
+		if (ret)
+			return ret;
+	}
+	jnl->dirty = 0;
+	jnl->base_crc = env->crc;
+	jnl->seq = 0;
+	jnl->end = 0;
+
+	return env_journal_snap(jnl);
+}
@@ -173,6 +173,10 @@ static void fini_mmc_for_env(struct mmc *mmc)
 #endif
 }
 
+#if defined(CONFIG_ENV_JOURNAL) && !defined(CONFIG_SPL_BUILD)
+static struct env_journal *env_mmc_journal(struct mmc *mmc);
+#endif
+
 #if defined(CONFIG_CMD_SAVEENV) && !defined(CONFIG_SPL_BUILD)
 static inline int write_env(struct mmc *mmc, unsigned long size,
 			    unsigned long offset, const void *buffer)
@@ -203,6 +207,14 @@ static int env_mmc_save(void)
 		return 1;
 	}
 
+#ifdef CONFIG_ENV_JOURNAL
+	/* Only write the whole environment if the journal is full */
+	if (!env_journal_append(env_mmc_journal(mmc))) {
+		ret = 0;
+		goto fini;
+	}
+#endif
+
 	ret = env_export(env_new);
 	if (ret)
 		goto fini;
@@ -229,6 +241,10 @@ static int env_mmc_save(void)
 #ifdef CONFIG_ENV_OFFSET_REDUND
 	gd->env_valid = gd->env_valid == ENV_REDUND ? ENV_VALID : ENV_REDUND;
 #endif
+#ifdef CONFIG_ENV_JOURNAL
+	if (env_journal_reset(env_mmc_journal(mmc), env_new))
+		puts("Cannot reset the environment journal\n");
+#endif
 
 fini:
 	fini_mmc_for_env(mmc);
@@ -269,6 +285,9 @@ static int env_mmc_erase(void)
 		return CMD_RET_FAILURE;
 
 	ret = erase_env(mmc, CONFIG_ENV_SIZE, offset);
+#ifdef CONFIG_ENV_JOURNAL
+	env_journal_invalidate(env_mmc_journal(mmc));
+#endif
 
 #ifdef CONFIG_ENV_OFFSET_REDUND
 	copy = 1;
@@ -298,6 +317,63 @@ static inline int read_env(struct mmc *mmc, unsigned long size,
 	return (n == blk_cnt) ? 0 : -1;
 }
 
+#if defined(CONFIG_ENV_JOURNAL) && !defined(CONFIG_SPL_BUILD)
+static int env_mmc_journal_read(struct env_journal *jnl, ulong offset,
+				ulong len, void *buf)
+{
+	return read_env(jnl->priv, len, CONFIG_ENV_JOURNAL_OFFSET + offset,
+			buf);
+}
+
+static int env_mmc_journal_write(struct env_journal *jnl, ulong offset,
+				 ulong len, const void *buf)
+{
+	return write_env(jnl->priv, len, CONFIG_ENV_JOURNAL_OFFSET + offset,
+			 buf);
+}
+
+/* Overwrite the used part with zeroes, erasing an eMMC is too coarse */
+static int env_mmc_journal_erase(struct env_journal *jnl, ulong len)
+{
+	void *buf;
+	int ret;
+
+	len = ALIGN(len, jnl->unit);
+	buf = malloc_cache_aligned(len);
+	if (!buf)
+		return -ENOMEM;
+	memset(buf, '\0', len);
+	ret = write_env(jnl->priv, len, CONFIG_ENV_JOURNAL_OFFSET, buf);
+	free(buf);
+
+	return ret;
+}
+
+static const struct env_journal_ops env_mmc_journal_ops = {
+	.read	= env_mmc_journal_read,
+	.write	= env_mmc_journal_write,
+	.erase	= env_mmc_journal_erase,
+};
+
+static struct env_journal env_mmc_jnl;
+
+static struct env_journal *env_mmc_journal(struct mmc *mmc)
+{
+	struct env_journal *jnl = &env_mmc_jnl;
+
+	jnl->priv = mmc;
+	if (!jnl->ops) {
+		jnl->ops = &env_mmc_journal_ops;
+		jnl->size = CONFIG_ENV_JOURNAL_SIZE;
+		jnl->unit = mmc->write_bl_len;
+		/* Nothing is known about the area until it was replayed */
+		jnl->dirty = jnl->size;
+	}
+
+	return jnl;
+}
+#endif /* CONFIG_ENV_JOURNAL && !CONFIG_SPL_BUILD */
+
 #ifdef CONFIG_ENV_OFFSET_REDUND
 static int env_mmc_load(void)
 {
@@ -333,6 +409,12 @@ static int env_mmc_load(void)
 
 	ret = env_import_redund((char *)tmp_env1, read1_fail, (char *)tmp_env2,
 				read2_fail);
+#if defined(CONFIG_ENV_JOURNAL) && !defined(CONFIG_SPL_BUILD)
+	if (!ret)
+		env_journal_replay(env_mmc_journal(mmc),
+				   gd->env_valid == ENV_REDUND ?
+				   tmp_env2->crc : tmp_env1->crc);
+#endif
 
 fini:
 	fini_mmc_for_env(mmc);
@@ -374,6 +456,10 @@ static int env_mmc_load(void)
 	}
 
 	ret = env_import(buf, 1);
+#if defined(CONFIG_ENV_JOURNAL) && !defined(CONFIG_SPL_BUILD)
+	if (!ret)
+		env_journal_replay(env_mmc_journal(mmc), ((env_t *)buf)->crc);
+#endif
 
 fini:
 	fini_mmc_for_env(mmc);
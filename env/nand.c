@@ -151,6 +151,122 @@ static int writeenv(size_t offset, u_char *buf)
 	return 0;
 }
 
+#ifdef CONFIG_ENV_JOURNAL
+/* Find the journal offset @offset, skipping bad blocks in the area */
+static int env_nand_journal_addr(struct mtd_info *mtd, ulong offset,
+				 loff_t *addrp)
+{
+	ulong end = CONFIG_ENV_JOURNAL_OFFSET + CONFIG_ENV_JOURNAL_SIZE;
+	ulong block = offset / mtd->erasesize;
+	loff_t addr;
+
+	for (addr = CONFIG_ENV_JOURNAL_OFFSET; addr < end;
+	     addr += mtd->erasesize) {
+		if (nand_block_isbad(mtd, addr))
+			continue;
+		if (!block--) {
+			*addrp = addr + offset % mtd->erasesize;
+			return 0;
+		}
+	}
+
+	return -ENOSPC;
+}
+
+static int env_nand_journal_rw(struct env_journal *jnl, ulong offset,
+			       ulong len, u_char *buf, bool write)
+{
+	struct mtd_info *mtd = jnl->priv;
+	size_t chunk;
+	loff_t addr;
+	int ret;
+
+	while (len) {
+		ret = env_nand_journal_addr(mtd, offset, &addr);
+		if (ret)
+			return ret;
+		chunk = min(len, mtd->erasesize - offset % mtd->erasesize);
+		if (write)
+			ret = nand_write(mtd, addr, &chunk, buf);
+		else
+			ret = nand_read(mtd, addr, &chunk, buf);
+		if (ret && ret != -EUCLEAN)
+			return ret;
+		offset += chunk;
+		buf += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+static int env_nand_journal_read(struct env_journal *jnl, ulong offset,
+				 ulong len, void *buf)
+{
+	return env_nand_journal_rw(jnl, offset, len, buf, false);
+}
+
+static int env_nand_journal_write(struct env_journal *jnl, ulong offset,
+				  ulong len, const void *buf)
+{
+	return env_nand_journal_rw(jnl, offset, len, (u_char *)buf, true);
+}
+
+static int env_nand_journal_erase(struct env_journal *jnl, ulong len)
+{
+	struct mtd_info *mtd = jnl->priv;
+	loff_t addr;
+	ulong offset;
+	int ret;
+
+	for (offset = 0; offset < len; offset += mtd->erasesize) {
+		ret = env_nand_journal_addr(mtd, offset, &addr);
+		if (!ret)
+			ret = nand_erase(mtd, addr, mtd->erasesize);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static const struct env_journal_ops env_nand_journal_ops = {
+	.read	= env_nand_journal_read,
+	.write	= env_nand_journal_write,
+	.erase	= env_nand_journal_erase,
+};
+
+static struct env_journal env_nand_jnl;
+
+static struct env_journal *env_nand_journal(void)
+{
+	struct env_journal *jnl = &env_nand_jnl;
+	struct mtd_info *mtd;
+	loff_t addr;
+
+	if (jnl->ops)
+		return jnl;
+
+	mtd = get_nand_dev_by_index(0);
+	if (!mtd)
+		return NULL;
+
+	jnl->priv = mtd;
+	jnl->unit = mtd->writesize;
+	for (addr = CONFIG_ENV_JOURNAL_OFFSET;
+	     addr < CONFIG_ENV_JOURNAL_OFFSET + CONFIG_ENV_JOURNAL_SIZE;
+	     addr += mtd->erasesize) {
+		if (!nand_block_isbad(mtd, addr))
+			jnl->size += mtd->erasesize;
+	}
+	/* Nothing is known about the area until it was replayed */
+	jnl->dirty = jnl->size;
+	jnl->ops = &env_nand_journal_ops;
+
+	return jnl;
+}
+#endif /* CONFIG_ENV_JOURNAL */
+
 struct nand_env_location {
 	const char *name;
 	const nand_erase_options_t erase_opts;
@@ -182,6 +298,9 @@ static int env_nand_save(void)
 	int	ret = 0;
 	ALLOC_CACHE_ALIGN_BUFFER(env_t, env_new, 1);
 	int	env_idx = 0;
+#ifdef CONFIG_ENV_JOURNAL
+	struct env_journal *jnl;
+#endif
 	static const struct nand_env_location location[] = {
 		{
 			.name = "NAND",
@@ -205,6 +324,13 @@ static int env_nand_save(void)
 	if (CONFIG_ENV_RANGE < CONFIG_ENV_SIZE)
 		return 1;
 
+#ifdef CONFIG_ENV_JOURNAL
+	/* Only write the whole environment if the journal is full */
+	jnl = env_nand_journal();
+	if (jnl && !env_journal_append(jnl))
+		return 0;
+#endif
+
 	ret = env_export(env_new);
 	if (ret)
 		return ret;
@@ -219,14 +345,18 @@ static int env_nand_save(void)
 		/* preset other copy for next write */
 		gd->env_valid = gd->env_valid == ENV_REDUND ? ENV_VALID :
 				ENV_REDUND;
-		return ret;
+	} else {
+		env_idx = (env_idx + 1) & 1;
+		ret = erase_and_write_env(&location[env_idx],
+					  (u_char *)env_new);
+		if (!ret)
+			printf("Warning: primary env write failed,"
+					" redundancy is lost!\n");
 	}
-
-	env_idx = (env_idx + 1) & 1;
-	ret = erase_and_write_env(&location[env_idx], (u_char *)env_new);
-	if (!ret)
-		printf("Warning: primary env write failed,"
-				" redundancy is lost!\n");
+#endif
+#ifdef CONFIG_ENV_JOURNAL
+	if (!ret && jnl && env_journal_reset(jnl, env_new))
+		puts("Cannot reset the environment journal\n");
 #endif
 
 	return ret;
@@ -332,6 +462,12 @@ static int env_nand_load(void)
 
 	ret = env_import_redund((char *)tmp_env1, read1_fail, (char *)tmp_env2,
 				read2_fail);
+#if defined(CMD_SAVEENV) && defined(CONFIG_ENV_JOURNAL)
+	if (!ret && env_nand_journal())
+		env_journal_replay(env_nand_journal(),
+				   gd->env_valid == ENV_REDUND ?
+				   tmp_env2->crc : tmp_env1->crc);
+#endif
 
 done:
 	free(tmp_env1);
@@ -372,7 +508,13 @@ static int env_nand_load(void)
 		return -EIO;
 	}
 
-	return env_import(buf, 1);
+	ret = env_import(buf, 1);
+#if defined(CMD_SAVEENV) && defined(CONFIG_ENV_JOURNAL)
+	if (!ret && env_nand_journal())
+		env_journal_replay(env_nand_journal(), ((env_t *)buf)->crc);
+#endif
+
+	return ret;
 #endif /* ! ENV_IS_EMBEDDED */
 
 	return 0;
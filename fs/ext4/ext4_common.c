@@ -31,6 +31,7 @@
 
 struct ext2_data *ext4fs_root;
 struct ext2fs_node *ext4fs_file;
+struct ext_extent_cache ext4fs_file_extents;
 __le32 *ext4fs_indir1_block;
 int ext4fs_indir1_size;
 int ext4fs_indir1_blkno = -1;
@@ -1563,6 +1564,141 @@ static struct ext4_extent_header *ext4fs_get_extent_block
 	}
 }
 
+static int ext4fs_extent_cache_add(struct ext_extent_cache *ec,
+				   uint32_t block, uint32_t len, uint64_t start)
+{
+	struct ext_extent_map *last = ec->count ? &ec->map[ec->count - 1] :
+				      NULL;
+
+	if (last) {
+		/* Extents must be sorted and must not overlap */
+		if (block < last->block + last->len)
+			return -EINVAL;
+		if (block == last->block + last->len &&
+		    start == last->start + last->len) {
+			last->len += len;
+			return 0;
+		}
+	}
+
+	if (ec->count == ec->size) {
+		struct ext_extent_map *map;
+		int size = ec->size ? ec->size * 2 : 16;
+
+		map = realloc(ec->map, size * sizeof(*map));
+		if (!map)
+			return -ENOMEM;
+		ec->map = map;
+		ec->size = size;
+	}
+	ec->map[ec->count].block = block;
+	ec->map[ec->count].len = len;
+	ec->map[ec->count].start = start;
+	ec->count++;
+
+	return 0;
+}
+
+static int ext4fs_extent_cache_walk(struct ext_extent_cache *ec,
+				    struct ext4_extent_header *eh, int depth)
+{
+	int blksz = EXT2_BLOCK_SIZE(ext4fs_root);
+	int log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root) -
+		get_fs()->dev_desc->log2blksz;
+	int entries = le16_to_cpu(eh->eh_entries);
+	int i, ret;
+
+	if (le16_to_cpu(eh->eh_magic) != EXT4_EXT_MAGIC ||
+	    le16_to_cpu(eh->eh_depth) != depth)
+		return -EINVAL;
+
+	if (!depth) {
+		struct ext4_extent *extent = (struct ext4_extent *)(eh + 1);
+
+		for (i = 0; i < entries; i++) {
+			uint64_t start;
+			uint32_t len = le16_to_cpu(extent[i].ee_len);
+
+			if (len > EXT_INIT_MAX_LEN)
+				continue;
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			ret = ext4fs_extent_cache_add(ec,
+					le32_to_cpu(extent[i].ee_block),
+					len, start);
+			if (ret)
+				return ret;
+		}
+
+		return 0;
+	}
+
+	for (i = 0; i < entries; i++) {
+		struct ext4_extent_idx *index =
+			(struct ext4_extent_idx *)(eh + 1) + i;
+		unsigned long long block;
+		char *buf;
+
+		block = le16_to_cpu(index->ei_leaf_hi);
+		block = (block << 32) + le32_to_cpu(index->ei_leaf_lo);
+		buf = malloc(blksz);
+		if (!buf)
+			return -ENOMEM;
+		if (!ext4fs_devread((lbaint_t)block << log2_blksz, 0, blksz,
+				    buf)) {
+			free(buf);
+			return -EIO;
+		}
+		ret = ext4fs_extent_cache_walk(ec,
+				(struct ext4_extent_header *)buf, depth - 1);
+		free(buf);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * ext4fs_extent_cache_build() - Collect the extents of a file
+ *
+ * Walk the whole extent tree of @inode once and store its extents in @ec,
+ * merging those which are both logically and physically contiguous. Reads
+ * can then be mapped without going through the index blocks again.
+ *
+ * @ec:		extent cache to fill, freed first
+ * @inode:	inode using extents
+ * @return 0 if OK, -ve on error, in which case @ec is left empty
+ */
+int ext4fs_extent_cache_build(struct ext_extent_cache *ec,
+			      struct ext2_inode *inode)
+{
+	struct ext4_extent_header *eh;
+	int ret;
+
+	ext4fs_extent_cache_free(ec);
+	if (!(le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL))
+		return -EINVAL;
+
+	eh = (struct ext4_extent_header *)inode->b.blocks.dir_blocks;
+	if (le16_to_cpu(eh->eh_depth) > EXT4_MAX_EXTENT_DEPTH)
+		return -EINVAL;
+	ret = ext4fs_extent_cache_walk(ec, eh, le16_to_cpu(eh->eh_depth));
+	if (ret) {
+		debug("ext4fs: cannot cache extents (err=%d)\n", ret);
+		ext4fs_extent_cache_free(ec);
+	}
+
+	return ret;
+}
+
+void ext4fs_extent_cache_free(struct ext_extent_cache *ec)
+{
+	free(ec->map);
+	memset(ec, 0, sizeof(*ec));
+}
+
 static int ext4fs_blockgroup
 	(struct ext2_data *data, int group, struct ext2_block_group *blkgrp)
 {
@@ -2031,6 +2167,7 @@ void ext4fs_close(void)
 		ext4fs_free_node(ext4fs_file, &ext4fs_root->diropen);
 		ext4fs_file = NULL;
 	}
+	ext4fs_extent_cache_free(&ext4fs_file_extents);
 	if (ext4fs_root != NULL) {
 		free(ext4fs_root);
 		ext4fs_root = NULL;
@@ -2339,6 +2476,7 @@ int ext4fs_open(const char *filename, loff_t *len)
 		return -1;
 
 	ext4fs_file = NULL;
+	ext4fs_extent_cache_free(&ext4fs_file_extents);
 	status = ext4fs_find_file(filename, &ext4fs_root->diropen, &fdiro,
 				  FILETYPE_REG);
 	if (status == 0)
@@ -2352,6 +2490,9 @@ int ext4fs_open(const char *filename, loff_t *len)
 	}
 	*len = le32_to_cpu(fdiro->inode.size);
 	ext4fs_file = fdiro;
+	if (le32_to_cpu(fdiro->inode.flags) & EXT4_EXTENTS_FL)
+		ext4fs_extent_cache_build(&ext4fs_file_extents,
+					  &fdiro->inode);
 
 	return 0;
 fail:
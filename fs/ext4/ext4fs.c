@@ -40,6 +40,58 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
 		free(node);
 }
 
+/* Largest read passed to ext4fs_devread(), which takes an int length */
+#define EXT4_READ_MAX	(1 << 30)
+
+/*
+ * Read using the extent cache built when the file was opened: each
+ * physically contiguous range is a single device read, and holes and
+ * unwritten extents are zeroed.
+ */
+static int ext4fs_read_mapped(struct ext_extent_cache *ec, loff_t pos,
+			      loff_t len, char *buf)
+{
+	int log2blksz = get_fs()->dev_desc->log2blksz;
+	int log2_blocksize = LOG2_BLOCK_SIZE(ext4fs_root);
+	loff_t end = pos + len;
+	int i = 0;
+
+	while (pos < end) {
+		uint64_t fileblock = pos >> log2_blocksize;
+		struct ext_extent_map *m;
+		loff_t n;
+
+		while (i < ec->count &&
+		       ec->map[i].block + ec->map[i].len <= fileblock)
+			i++;
+		m = i < ec->count ? &ec->map[i] : NULL;
+
+		if (!m || m->block > fileblock) {
+			n = end - pos;
+			if (m)
+				n = min(n, ((loff_t)m->block <<
+					    log2_blocksize) - pos);
+			memset(buf, 0, n);
+		} else {
+			loff_t off = pos - ((loff_t)m->block << log2_blocksize);
+			lbaint_t sector;
+
+			n = ((loff_t)m->len << log2_blocksize) - off;
+			n = min(n, end - pos);
+			n = min(n, (loff_t)EXT4_READ_MAX);
+			sector = (m->start << (log2_blocksize - log2blksz)) +
+				 (off >> log2blksz);
+			if (!ext4fs_devread(sector, off & ((1 << log2blksz) - 1),
+					    n, buf))
+				return -1;
+		}
+		pos += n;
+		buf += n;
+	}
+
+	return 0;
+}
+
 /*
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
@@ -76,6 +128,14 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		return -1;
 	}
 
+	if (node == ext4fs_file && ext4fs_file_extents.count) {
+		ext_cache_fini(&cache);
+		if (ext4fs_read_mapped(&ext4fs_file_extents, pos, len, buf))
+			return -1;
+		*actread = len;
+		return 0;
+	}
+
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
 	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
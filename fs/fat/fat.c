@@ -301,6 +301,61 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/* A run of consecutive clusters */
+struct fat_extent {
+	__u32 clust;
+	__u32 count;
+};
+
+/* Maximum number of extents gathered from the FAT before reading data */
+#define FAT_EXTENTS	16
+
+/**
+ * get_extents() - split part of a cluster chain into contiguous runs
+ *
+ * Follow the chain starting at *clust until 'size' bytes are covered or
+ * 'max' extents have been filled. The FAT is only read here, so that the
+ * data reads which follow are not interleaved with FAT window reloads.
+ *
+ * @mydata:	file system description
+ * @clust:	first cluster; updated to the first cluster not covered
+ * @size:	number of bytes left to read
+ * @ext:	returns the extents
+ * @max:	number of entries in @ext
+ * Return:	number of extents filled in, or -1 on an invalid FAT entry
+ */
+static int get_extents(fsdata *mydata, __u32 *clust, loff_t size,
+		       struct fat_extent *ext, int max)
+{
+	loff_t bytesperclust = mydata->clust_size * mydata->sect_size;
+	__u32 curclust = *clust;
+	__u32 newclust;
+	int n = 0;
+
+	ext[0].clust = curclust;
+	ext[0].count = 1;
+	while (size > bytesperclust) {
+		size -= bytesperclust;
+		newclust = get_fatent(mydata, curclust);
+		if (CHECK_CLUST(newclust, mydata->fatsize)) {
+			debug("curclust: 0x%x\n", newclust);
+			return -1;
+		}
+		curclust = newclust;
+		if (curclust == ext[n].clust + ext[n].count) {
+			ext[n].count++;
+			continue;
+		}
+		if (++n == max)
+			break;
+		ext[n].clust = curclust;
+		ext[n].count = 1;
+	}
+	*clust = curclust;
+
+	return n < max ? n + 1 : n;
+}
+
 /**
  * get_contents() - read from file
  *
@@ -322,7 +377,7 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
+	struct fat_extent ext[FAT_EXTENTS];
 	loff_t actsize;
 
 	*gotsize = 0;
@@ -389,50 +444,31 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 		}
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				printf("Invalid FAT entry\n");
-				return -1;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
-		}
+	while (filesize) {
+		int i, n;
 
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
+		n = get_extents(mydata, &curclust, filesize, ext,
+				ARRAY_SIZE(ext));
+		if (n < 0) {
+			printf("Invalid FAT entry\n");
 			return -1;
 		}
-		*gotsize += (int)actsize;
-		filesize -= actsize;
-		buffer += actsize;
 
-		curclust = get_fatent(mydata, endclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return -1;
+		for (i = 0; i < n; i++) {
+			actsize = min(filesize,
+				      (loff_t)ext[i].count * bytesperclust);
+			if (get_cluster(mydata, ext[i].clust, buffer,
+					actsize) != 0) {
+				printf("Error reading cluster\n");
+				return -1;
+			}
+			*gotsize += actsize;
+			filesize -= actsize;
+			buffer += actsize;
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	}
+
+	return 0;
 }
 
 /*
@@ -1156,7 +1156,11 @@ int ubifs_lookup_level0(struct ubifs_info *c, const union ubifs_key *key,
 {
 	int err, exact;
 	struct ubifs_znode *znode;
+#ifndef __UBOOT__
 	unsigned long time = get_seconds();
+#else
+	unsigned long time = c->tnc_age;
+#endif
 
 	dbg_tnck(key, "search key ");
 	ubifs_assert(key_type(c, key) < UBIFS_INVALID_KEY);
@@ -2870,6 +2874,49 @@ void ubifs_tnc_close(struct ubifs_info *c)
 	destroy_old_idx(c);
 }
 
+#ifdef __UBOOT__
+/**
+ * ubifs_tnc_trim - keep the TNC within its configured size.
+ * @c: UBIFS file-system description object
+ *
+ * The TNC is kept from one file read to the next, so that index nodes do not
+ * have to be read from the media again. Once it grows beyond
+ * %CONFIG_UBIFS_TNC_CACHE_SIZE, this function frees the subtrees which were
+ * not used by the current read, and then any others below the root, until it
+ * is down to half of that size. It must only be called while no znode is
+ * referenced, e.g. between two blocks of a file read.
+ */
+void ubifs_tnc_trim(struct ubifs_info *c)
+{
+	long max_zn = CONFIG_UBIFS_TNC_CACHE_SIZE * 1024L / c->max_znode_sz;
+	struct ubifs_znode *znode, *zprev;
+	long freed;
+	int pass;
+
+	if (atomic_long_read(&c->clean_zn_cnt) <= max_zn || !c->zroot.znode)
+		return;
+
+	for (pass = 0; pass < 2; pass++) {
+		zprev = NULL;
+		znode = ubifs_tnc_levelorder_next(c->zroot.znode, NULL);
+		while (znode &&
+		       atomic_long_read(&c->clean_zn_cnt) > max_zn / 2) {
+			if (znode->parent && !ubifs_zn_dirty(znode) &&
+			    (pass || znode->time != c->tnc_age)) {
+				znode->parent->zbranch[znode->iip].znode = NULL;
+				freed = ubifs_destroy_tnc_subtree(znode);
+				atomic_long_sub(freed, &ubifs_clean_zn_cnt);
+				atomic_long_sub(freed, &c->clean_zn_cnt);
+				znode = zprev;
+			}
+			zprev = znode;
+			znode = ubifs_tnc_levelorder_next(c->zroot.znode,
+							  znode);
+		}
+	}
+}
+#endif
+
 /**
  * left_znode - get the znode to the left.
  * @c: UBIFS file-system description object
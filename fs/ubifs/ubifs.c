@@ -667,43 +667,62 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+/**
+ * decompress_block - decompress a data node into the destination buffer.
+ * @inode: inode the data node belongs to
+ * @addr: where to put the data
+ * @max_len: room at @addr, up to %UBIFS_BLOCK_SIZE
+ * @block: block number, for error messages
+ * @dn: data node
+ *
+ * The data is decompressed straight into @addr when it fits, and only goes
+ * through a bounce buffer when the read stops part way into the block. Any
+ * room left at @addr after the data is zeroed out.
+ */
+static int decompress_block(struct inode *inode, void *addr, int max_len,
+			    unsigned int block, struct ubifs_data_node *dn)
 {
 	struct ubifs_info *c = inode->i_sb->s_fs_info;
-	int err, len, out_len;
-	union ubifs_key key;
+	int err, len, out_len, compr_type;
 	unsigned int dlen;
-
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
-	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
+	void *buff = NULL;
 
 	len = le32_to_cpu(dn->size);
 	if (len <= 0 || len > UBIFS_BLOCK_SIZE)
 		goto dump;
 
 	dlen = le32_to_cpu(dn->ch.len) - UBIFS_DATA_NODE_SZ;
-	out_len = UBIFS_BLOCK_SIZE;
-	err = ubifs_decompress(c, &dn->data, dlen, addr, &out_len,
-			       le16_to_cpu(dn->compr_type));
-	if (err || len != out_len)
+	compr_type = le16_to_cpu(dn->compr_type);
+	/* Uncompressed data is copied as is, so it must be exactly the size */
+	if (compr_type == UBIFS_COMPR_NONE && dlen != len)
 		goto dump;
 
-	/*
-	 * Data length can be less than a full block, even for blocks that are
-	 * not the last in the file (e.g., as a result of making a hole and
-	 * appending data). Ensure that the remainder is zeroed out.
-	 */
-	if (len < UBIFS_BLOCK_SIZE)
-		memset(addr + len, 0, UBIFS_BLOCK_SIZE - len);
+	if (len > max_len) {
+		buff = malloc_cache_aligned(UBIFS_BLOCK_SIZE);
+		if (!buff)
+			return -ENOMEM;
+	}
+
+	out_len = buff ? UBIFS_BLOCK_SIZE : max_len;
+	err = ubifs_decompress(c, &dn->data, dlen, buff ? buff : addr,
+			       &out_len, compr_type);
+	if (err || len != out_len) {
+		free(buff);
+		goto dump;
+	}
+
+	if (buff) {
+		memcpy(addr, buff, max_len);
+		free(buff);
+	} else if (len < max_len) {
+		/*
+		 * Data length can be less than a full block, even for blocks
+		 * that are not the last in the file (e.g., as a result of
+		 * making a hole and appending data). Ensure that the remainder
+		 * is zeroed out.
+		 */
+		memset(addr + len, 0, max_len - len);
+	}
 
 	return 0;
 
@@ -714,13 +733,34 @@ dump:
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, int max_len,
+		      unsigned int block, struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	union ubifs_key key;
+	int err;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, max_len);
+		return err;
+	}
+
+	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
+
+	return decompress_block(inode, addr, max_len, block, dn);
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
-		       struct page *page, int last_block_size)
+		       struct page *page, int last_block_size,
+		       struct ubifs_data_node *dn)
 {
 	void *addr;
 	int err = 0, i;
 	unsigned int block, beyond;
-	struct ubifs_data_node *dn;
 	loff_t i_size = inode->i_size;
 
 	dbg_gen("ino %lu, pg %lu, i_size %lld",
@@ -736,13 +776,9 @@ static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		goto out;
 	}
 
-	dn = kmalloc(UBIFS_MAX_DATA_NODE_SZ, GFP_NOFS);
-	if (!dn)
-		return -ENOMEM;
-
 	i = 0;
 	while (1) {
-		int ret;
+		int ret, max_len = UBIFS_BLOCK_SIZE;
 
 		if (block >= beyond) {
 			/* Reading beyond inode */
@@ -753,50 +789,17 @@ static int do_readpage(struct ubifs_info *c, struct inode *inode,
 			 * Reading last block? Make sure to not write beyond
 			 * the requested size in the destination buffer.
 			 */
-			if (((block + 1) == beyond) || last_block_size) {
-				void *buff;
-				int dlen;
-
-				/*
-				 * We need to buffer the data locally for the
-				 * last block. This is to not pad the
-				 * destination area to a multiple of
-				 * UBIFS_BLOCK_SIZE.
-				 */
-				buff = malloc_cache_aligned(UBIFS_BLOCK_SIZE);
-				if (!buff) {
-					printf("%s: Error, malloc fails!\n",
-					       __func__);
-					err = -ENOMEM;
+			if (last_block_size)
+				max_len = last_block_size;
+			else if ((block + 1) == beyond)
+				max_len = i_size -
+					  ((loff_t)block << UBIFS_BLOCK_SHIFT);
+
+			ret = read_block(inode, addr, max_len, block, dn);
+			if (ret) {
+				err = ret;
+				if (err != -ENOENT)
 					break;
-				}
-
-				/* Read block-size into temp buffer */
-				ret = read_block(inode, buff, block, dn);
-				if (ret) {
-					err = ret;
-					if (err != -ENOENT) {
-						free(buff);
-						break;
-					}
-				}
-
-				if (last_block_size)
-					dlen = last_block_size;
-				else
-					dlen = le32_to_cpu(dn->size);
-
-				/* Now copy required size back to dest */
-				memcpy(addr, buff, dlen);
-
-				free(buff);
-			} else {
-				ret = read_block(inode, addr, block, dn);
-				if (ret) {
-					err = ret;
-					if (err != -ENOENT)
-						break;
-				}
 			}
 		}
 		if (++i >= UBIFS_BLOCKS_PER_PAGE)
@@ -808,32 +811,88 @@ static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		if (err == -ENOENT) {
 			/* Not found, so it must be a hole */
 			dbg_gen("hole");
-			goto out_free;
+			goto out;
 		}
 		ubifs_err(c, "cannot read page %lu of inode %lu, error %d",
 			  page->index, inode->i_ino, err);
-		goto error;
+		return err;
 	}
 
-out_free:
-	kfree(dn);
 out:
 	return 0;
+}
 
-error:
-	kfree(dn);
-	return err;
+/**
+ * read_bulk - read consecutive data blocks with one LEB read.
+ * @c: UBIFS file-system description object
+ * @inode: inode to read from
+ * @addr: destination buffer
+ * @block: first block to read
+ * @nblocks: number of whole blocks which may be written to @addr
+ *
+ * This function looks up the data nodes following @block which lie one after
+ * another in the same LEB, reads them all into the bulk-read buffer and
+ * decompresses each of them straight into @addr, zeroing out any holes in
+ * between. Returns the number of blocks read, %0 if the caller should read
+ * @block on its own, or a negative error code in case of failure.
+ */
+static int read_bulk(struct ubifs_info *c, struct inode *inode, void *addr,
+		     unsigned int block, unsigned int nblocks)
+{
+	struct bu_info *bu = &c->bu;
+	unsigned int next = 0, n;
+	void *buf;
+	int err, i;
+
+	bu->buf_len = c->max_bu_buf_len;
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		return err;
+
+	/* Leave holes at the start and single nodes to read_block() */
+	if (bu->cnt < 2 || key_block(c, &bu->zbranch[0].key) != block)
+		return 0;
+	for (i = 0; i < bu->cnt; i++)
+		if (key_block(c, &bu->zbranch[i].key) - block >= nblocks)
+			break;
+	bu->cnt = i;
+	if (bu->cnt < 2)
+		return 0;
+
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		return err;
+
+	buf = bu->buf;
+	for (i = 0; i < bu->cnt; i++) {
+		n = key_block(c, &bu->zbranch[i].key) - block;
+		if (n > next)
+			memset(addr + next * UBIFS_BLOCK_SIZE, 0,
+			       (n - next) * UBIFS_BLOCK_SIZE);
+
+		err = decompress_block(inode, addr + n * UBIFS_BLOCK_SIZE,
+				       UBIFS_BLOCK_SIZE, block + n, buf);
+		if (err)
+			return err;
+
+		next = n + 1;
+		buf += ALIGN(bu->zbranch[i].len, 8);
+	}
+
+	return next;
 }
 
 int ubifs_read(const char *filename, void *buf, loff_t offset,
 	       loff_t size, loff_t *actread)
 {
 	struct ubifs_info *c = ubifs_sb->s_fs_info;
+	struct ubifs_data_node *dn;
 	unsigned long inum;
 	struct inode *inode;
 	struct page page;
 	int err = 0;
-	int i;
+	int i, n;
 	int count;
 	int last_block_size = 0;
 
@@ -846,6 +905,8 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	}
 
 	c->ubi = ubi_open_volume(c->vi.ubi_num, c->vi.vol_id, UBI_READONLY);
+	/* Index nodes used from now on are the ones to keep in the TNC */
+	c->tnc_age++;
 	/* ubifs_findfile will resolve symlinks, so we know that we get
 	 * the real file here */
 	inum = ubifs_findfile(ubifs_sb, (char *)filename);
@@ -880,6 +941,12 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 
 	count = (size + UBIFS_BLOCK_SIZE - 1) >> UBIFS_BLOCK_SHIFT;
 
+	dn = kmalloc(UBIFS_MAX_DATA_NODE_SZ, GFP_NOFS);
+	if (!dn) {
+		err = -ENOMEM;
+		goto put_inode;
+	}
+
 	page.addr = buf;
 	page.index = offset / PAGE_SIZE;
 	page.inode = inode;
@@ -890,13 +957,33 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 		if (((i + 1) == count) && (size < inode->i_size))
 			last_block_size = size - (i * PAGE_SIZE);
 
-		err = do_readpage(c, inode, &page, last_block_size);
-		if (err)
-			break;
+		/*
+		 * All but the last block of the read are whole blocks in the
+		 * destination, so runs of them can be bulk-read
+		 */
+		n = 0;
+		if (c->bulk_read && (i + 1) < count) {
+			n = read_bulk(c, inode, page.addr, page.index,
+				      count - 1 - i);
+			if (n < 0) {
+				err = n;
+				break;
+			}
+		}
+		if (n) {
+			i += n - 1;
+		} else {
+			err = do_readpage(c, inode, &page, last_block_size, dn);
+			if (err)
+				break;
+			n = 1;
+		}
 
-		page.addr += PAGE_SIZE;
-		page.index++;
+		page.addr += n * PAGE_SIZE;
+		page.index += n;
+		ubifs_tnc_trim(c);
 	}
+	kfree(dn);
 
 	if (err) {
 		printf("Error reading file '%s'\n", filename);
@@ -1654,6 +1654,8 @@ struct ubifs_debug_info;
  * @max_bu_buf_len: maximum bulk-read buffer length
  * @bu_mutex: protects the pre-allocated bulk-read buffer and @c->bu
  * @bu: pre-allocated bulk-read information
+ * @tnc_age: number of the current file read, stamped into the znodes it uses
+ *           so that 'ubifs_tnc_trim()' can tell which ones are stale
  *
  * @write_reserve_mutex: protects @write_reserve_buf
  * @write_reserve_buf: on the write path we allocate memory, which might
@@ -1896,6 +1898,9 @@ struct ubifs_info {
 	int max_bu_buf_len;
 	struct mutex bu_mutex;
 	struct bu_info bu;
+#ifdef __UBOOT__
+	unsigned long tnc_age;
+#endif
 
 	struct mutex write_reserve_mutex;
 	void *write_reserve_buf;
@@ -2405,5 +2410,6 @@ int ubifs_decompress(const struct ubifs_info *c, const void *buf, int len,
 
 #ifdef __UBOOT__
 void ubifs_umount(struct ubifs_info *c);
+void ubifs_tnc_trim(struct ubifs_info *c);
 #endif
 #endif /* !__UBIFS_H__ */
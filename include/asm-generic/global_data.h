@@ -68,6 +68,12 @@ typedef struct global_data {
 	struct udevice	*dm_root_f;	/* Pre-relocation root instance */
 	struct list_head uclass_root;	/* Head of core tree */
 #endif
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	struct lists_compat_table *dm_compat;	/* Compatible-string table */
+#endif
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct uclass **uclass_by_id;	/* Uclasses indexed by uclass ID */
+#endif
 #if CONFIG_IS_ENABLED(TIMER)
 	struct udevice	*timer;		/* Timer instance for Driver Model */
 #endif
@@ -78,6 +84,10 @@ typedef struct global_data {
 #ifdef CONFIG_OF_LIVE
 	struct device_node *of_root;
 #endif
+#if CONFIG_IS_ENABLED(OF_INDEX)
+	struct fdtdec_index *fdt_index;	/* Index of fdt_blob, NULL if none */
+	struct fdtdec_index *new_fdt_index;	/* Relocated index */
+#endif
 
 #if CONFIG_IS_ENABLED(MULTI_DTB_FIT)
 	const void *multi_dtb_fit;	/* uncompressed multi-dtb FIT image */
@@ -100,6 +110,9 @@ typedef struct global_data {
 	unsigned long malloc_limit;	/* limit address */
 	unsigned long malloc_ptr;	/* current address */
 #endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	struct malloc_slab *malloc_slab;	/* Slab area for small objects */
+#endif
 #ifdef CONFIG_PCI
 	struct pci_controller *hose;	/* PCI hose for early use */
 	phys_addr_t pci_ram_top;	/* top of region accessible to PCI */
@@ -116,6 +116,9 @@ struct blk_desc {
 /**
  * blkcache_read() - attempt to read a set of blocks from cache
  *
+ * This also tracks sequential reads, so that a following call to
+ * blkcache_read_ahead() knows how far to read ahead.
+ *
  * @param iftype - IF_TYPE_x for type of device
  * @param dev - device index of particular type
  * @param start - starting block number
@@ -129,10 +132,30 @@ int blkcache_read(int iftype, int dev,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer);
 
+/**
+ * blkcache_read_ahead() - read a set of blocks and the blocks following it
+ *
+ * After a cache miss on a sequential stream of reads, this reads the
+ * requested blocks together with a growing window of following blocks in a
+ * single device request, and adds them all to the cache.
+ *
+ * @param block_dev - block device to read from
+ * @param start - starting block number
+ * @param blkcnt - number of blocks to read
+ * @param buf - buffer to contain the requested blocks
+ *
+ * @return - '1' if the blocks were read, '0' if the caller should read them
+ */
+int blkcache_read_ahead(struct blk_desc *block_dev, lbaint_t start,
+			lbaint_t blkcnt, void *buffer);
+
 /**
  * blkcache_fill() - make data read from a block device available
  * to the block cache
  *
+ * Blocks which have been written to the cache but not yet to the device
+ * are copied back into @buf, so that it holds the latest data.
+ *
  * @param iftype - IF_TYPE_x for type of device
  * @param dev - device index of particular type
  * @param start - starting block number
@@ -143,12 +166,53 @@ int blkcache_read(int iftype, int dev,
  */
 void blkcache_fill(int iftype, int dev,
 		   lbaint_t start, lbaint_t blkcnt,
-		   unsigned long blksz, void const *buffer);
+		   unsigned long blksz, void *buffer);
+
+/**
+ * blkcache_write() - tell the block cache about a write
+ *
+ * In write-back mode small writes are kept in the cache until they are
+ * flushed. Otherwise any cached copy of the blocks is dropped and the
+ * caller must write them to the device.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks to write
+ * @param blksz - size in bytes of each block
+ * @param buf - buffer containing data to write
+ *
+ * @return - '1' if the cache took the data, '0' otherwise.
+ */
+int blkcache_write(int iftype, int dev,
+		   lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, const void *buffer);
+
+/**
+ * blkcache_flush() - write back the dirty blocks of a device
+ *
+ * @param iftype - IF_TYPE_x for type of device, or -1 for all devices
+ * @param dev - device index of particular type
+ *
+ * @return - 0 if OK, -ve on error
+ */
+int blkcache_flush(int iftype, int dev);
+
+/**
+ * blkcache_flush_all() - write back all dirty blocks before leaving U-Boot
+ *
+ * This is called on reset, on panic and before booting an OS, since dirty
+ * blocks in write-back mode would otherwise be lost. Errors are reported but
+ * otherwise ignored.
+ */
+void blkcache_flush_all(void);
 
 /**
  * blkcache_invalidate() - discard the cache for a set of blocks
  * because of a write or device (re)initialization.
  *
+ * Dirty blocks are written back first.
+ *
  * @param iftype - IF_TYPE_x for type of device
  * @param dev - device index of particular type
  */
@@ -157,20 +221,45 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
+ * @param blocks - blocks per entry, rounded down to a power of two
  * @param entries - maximum entries in cache
  */
 void blkcache_configure(unsigned blocks, unsigned entries);
 
+/**
+ * blkcache_set_writeback() - select write-back or write-through mode
+ *
+ * Leaving write-back mode flushes the cache.
+ *
+ * @param enable - true for write-back
+ */
+void blkcache_set_writeback(bool enable);
+
 /*
  * statistics of the block cache
  */
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
+	unsigned evictions;
 	unsigned entries; /* current entry count */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
+	unsigned ways; /* entries per hash set */
+	bool writeback;
+};
+
+/*
+ * statistics of the block cache for one device
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned misses;
+	unsigned evictions;
+	unsigned readahead; /* blocks read ahead */
+	unsigned writebacks; /* dirty blocks written back */
 };
 
 /**
@@ -180,6 +269,16 @@ struct block_cache_stats {
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics for a device and reset
+ *
+ * @param idx - index of the device, in the order the cache first saw them
+ * @param stats - statistics are copied here
+ *
+ * @return - 0 if OK, -ENOENT if there is no device @idx
+ */
+int blkcache_dev_stats(int idx, struct block_cache_dev_stats *stats);
+
 #else
 
 static inline int blkcache_read(int iftype, int dev,
@@ -189,9 +288,30 @@ static inline int blkcache_read(int iftype, int dev,
 	return 0;
 }
 
+static inline int blkcache_read_ahead(struct blk_desc *block_dev,
+				      lbaint_t start, lbaint_t blkcnt,
+				      void *buffer)
+{
+	return 0;
+}
+
 static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
-				 unsigned long blksz, void const *buffer) {}
+				 unsigned long blksz, void *buffer) {}
+
+static inline int blkcache_write(int iftype, int dev,
+				 lbaint_t start, lbaint_t blkcnt,
+				 unsigned long blksz, const void *buffer)
+{
+	return 0;
+}
+
+static inline int blkcache_flush(int iftype, int dev)
+{
+	return 0;
+}
+
+static inline void blkcache_flush_all(void) {}
 
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
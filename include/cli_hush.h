@@ -20,6 +20,20 @@ int set_local_var(const char *s, int flg_export);
 void unset_local_var(const char *name);
 char *get_local_var(const char *s);
 
+/**
+ * hush_cache_watch() - Drop the parsed form of a variable when it changes
+ *
+ * This is used for variables which are run as scripts, so that the parsed
+ * form of the old value does not stay in the cache.
+ *
+ * @name: Name of the variable
+ */
+#ifdef CONFIG_HUSH_CACHE
+void hush_cache_watch(const char *name);
+#else
+static inline void hush_cache_watch(const char *name) {}
+#endif
+
 #if defined(CONFIG_HUSH_INIT_VAR)
 extern int hush_init_var (void);
 #endif
@@ -74,6 +74,9 @@
 #define CONFIG_BOOTP_SEND_HOSTNAME
 #define CONFIG_BOOTP_SERVERIP
 
+/* Room for two TFTP windows of 32 blocks in the test driver's queue */
+#define CONFIG_SYS_RX_ETH_BUFFER	64
+
 #ifndef SANDBOX_NO_SDL
 #define CONFIG_SANDBOX_SDL
 #endif
@@ -137,6 +140,8 @@
 
 #define CONFIG_SYS_SATA_MAX_DEVICE	2
 
+#define CONFIG_SYS_MAX_NAND_DEVICE	1
+
 #define CONFIG_MISC_INIT_F
 
 #endif
@@ -12,6 +12,8 @@
 #include <dm/ofnode.h>
 #include <dm/uclass-id.h>
 
+struct udevice_id;
+
 /**
  * lists_driver_lookup_name() - Return u_boot_driver corresponding to name
  *
@@ -61,6 +63,44 @@ int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only);
 int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		   bool pre_reloc_only);
 
+/**
+ * lists_driver_lookup_compat() - Find the driver for a compatible string
+ *
+ * If more than one driver has the string, this finds the first one in the
+ * driver linker list. With CONFIG_DM_COMPAT_HASH this uses a hash table,
+ * which is set up by board_init_f_init_reserve() before relocation and
+ * built in the full malloc() area on first use after it.
+ *
+ * @compat: Compatible string to look up
+ * @drvp: Returns the driver
+ * @idp: Returns the entry in the driver's of_match list
+ * @return 0 if found, -ENOENT if no driver has the string
+ */
+int lists_driver_lookup_compat(const char *compat, struct driver **drvp,
+			       const struct udevice_id **idp);
+
+/**
+ * lists_compat_size() - Get the size of the compatible-string table
+ *
+ * @return number of bytes needed by lists_compat_build(), or 0 if there are
+ * too many drivers for the table
+ */
+ulong lists_compat_size(void);
+
+/**
+ * lists_compat_build() - Build the compatible-string table
+ *
+ * This only reads the driver linker list, so it can be used before
+ * relocation, before gd is set up. Point gd->dm_compat at the table to use
+ * it in lists_driver_lookup_compat().
+ *
+ * @buf: Place to build the table
+ * @size: Number of bytes at @buf
+ * @return 0 if OK, -ENOSPC if @size is less than lists_compat_size(), -E2BIG
+ * if there are too many drivers
+ */
+int lists_compat_build(void *buf, ulong size);
+
 /**
  * device_bind_driver() - bind a device to a driver
  *
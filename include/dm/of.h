@@ -34,7 +34,8 @@ struct property {
  * @name: Node name
  * @type: Node type (value of device_type property) or "<NULL>" if none
  * @phandle: Phandle value of this none, or 0 if none
- * @full_name: Full path to node, e.g. "/bus@1/spi@1100"
+ * @full_name: Name of the node including any unit address, e.g. "spi@1100",
+ *	or "" for the root node. This points into the flat tree.
  * @properties: Pointer to head of list of properties, or NULL if none
  * @parent: Pointer to parent node, or NULL if this is the root node
  * @child: Pointer to head of child node list, or NULL if no children
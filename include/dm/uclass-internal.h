@@ -233,6 +233,17 @@ int uclass_pre_remove_device(struct udevice *dev);
 static inline int uclass_pre_remove_device(struct udevice *dev) { return 0; }
 #endif
 
+/**
+ * uclass_set_seq() - Set the sequence number of a device
+ *
+ * This sets dev->seq and keeps the uclass's index of sequence numbers up to
+ * date. It must be used for all changes to dev->seq.
+ *
+ * @dev:	Pointer to the device
+ * @seq:	New sequence number, or -1 if the device has none
+ */
+void uclass_set_seq(struct udevice *dev, int seq);
+
 /**
  * uclass_find() - Find uclass by its id
  *
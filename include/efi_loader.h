@@ -578,7 +578,7 @@ efi_status_t efi_dp_from_name(const char *dev, const char *devnr,
 efi_status_t efi_init_runtime_supported(void);
 
 /* Update CRC32 in table header */
-void __efi_runtime efi_update_table_header_crc32(struct efi_table_hdr *table);
+void efi_update_table_header_crc32(struct efi_table_hdr *table);
 
 /* Call this with mmio_ptr as the _pointer_ to a pointer to an MMIO region
  * to make it available at runtime */
@@ -56,6 +56,20 @@ struct env_clbk_tbl {
 	{#name, callback}
 #endif
 
+/**
+ * env_callback_bind() - Associate a callback with a variable
+ *
+ * This is for code which wants to hear about changes to a variable chosen at
+ * run time. A variable which already has a callback keeps it. The association
+ * lasts until the variable is deleted or the ".callbacks" variable changes.
+ *
+ * @name: Name of the variable
+ * @callback: Name of the callback, as given to U_BOOT_ENV_CALLBACK()
+ * @return 0 if OK, -ENOENT if the variable or callback does not exist, -EEXIST
+ *	if the variable has another callback
+ */
+int env_callback_bind(const char *name, const char *callback);
+
 /** enum env_redund_flags - Flags for the redundand_environment */
 enum env_redund_flags {
 	ENV_REDUND_OBSOLETE = 0,
@@ -209,6 +209,146 @@ struct env_driver {
 
 extern struct hsearch_data env_htab;
 
+struct env_journal;
+
+/**
+ * struct env_journal_ops - Access to the journal area of an env location
+ *
+ * Offsets are relative to the start of the journal area and lengths are
+ * multiples of the write unit.
+ */
+struct env_journal_ops {
+	/**
+	 * read() - Read from the journal area
+	 *
+	 * @jnl: Journal to read from
+	 * @offset: Offset to read from
+	 * @len: Number of bytes to read
+	 * @buf: Buffer to read into
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*read)(struct env_journal *jnl, ulong offset, ulong len,
+		    void *buf);
+
+	/**
+	 * write() - Write to an erased part of the journal area
+	 *
+	 * @jnl: Journal to write to
+	 * @offset: Offset to write to
+	 * @len: Number of bytes to write
+	 * @buf: Data to write
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*write)(struct env_journal *jnl, ulong offset, ulong len,
+		     const void *buf);
+
+	/**
+	 * erase() - Erase the start of the journal area
+	 *
+	 * Afterwards the area must not hold any valid record and must be
+	 * writable again.
+	 *
+	 * @jnl: Journal to erase
+	 * @len: Number of bytes to erase, rounded up as needed by the device
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*erase)(struct env_journal *jnl, ulong len);
+};
+
+/**
+ * struct env_journal - Journal of changes to a stored environment
+ *
+ * Rather than writing the whole environment on each save, the variables
+ * which changed since the last save are appended to the journal as a record.
+ * The stored environment (the base) plus the records is the saved
+ * environment. When the journal is full, the base is written again and the
+ * journal is started afresh.
+ *
+ * @ops: Access to the journal area
+ * @priv: Private data for @ops
+ * @size: Usable size of the journal area in bytes
+ * @unit: Write unit in bytes, records are aligned to it
+ * @active: true if @snap matches what is stored, so records can be appended
+ * @base_crc: CRC of the base the records apply to
+ * @seq: Sequence number of the next record
+ * @end: Offset of the next record
+ * @dirty: Number of bytes from the start of the area which may not be erased
+ * @snap: Environment as stored, in the format of env_t.data
+ */
+struct env_journal {
+	const struct env_journal_ops *ops;
+	void *priv;
+	ulong size;
+	ulong unit;
+	bool active;
+	u32 base_crc;
+	u32 seq;
+	ulong end;
+	ulong dirty;
+	char *snap;
+};
+
+/**
+ * env_journal_diff() - Work out the changes between two environments
+ *
+ * Both environments are lists of "name=value" strings sorted by name, as
+ * written by hexport_r(), ending with a double '\0'. The result has the same
+ * format: "name=value" for each new or changed variable and a bare "name" for
+ * each deleted one.
+ *
+ * @old: Environment before the changes
+ * @new: Environment after the changes
+ * @out: Buffer for the changes
+ * @max: Size of @out in bytes
+ * @return length of the changes including the final '\0', which is 1 if
+ *	nothing changed, or -ENOSPC if more than @max bytes are needed
+ */
+long env_journal_diff(const char *old, const char *new, char *out, ulong max);
+
+/**
+ * env_journal_replay() - Apply the journal to a freshly loaded environment
+ *
+ * This must be called after the base was imported. Records for another base
+ * are ignored, as is a record which was only partly written.
+ *
+ * @jnl: Journal to replay
+ * @base_crc: CRC of the imported base
+ * @return 0 if OK (including when there were no records), -ve on error
+ */
+int env_journal_replay(struct env_journal *jnl, u32 base_crc);
+
+/**
+ * env_journal_append() - Save the running environment as a journal record
+ *
+ * Nothing is written if no variable changed since the last save.
+ *
+ * @jnl: Journal to append to
+ * @return 0 if OK, -ENOSPC if the whole environment must be written instead,
+ *	other -ve on error
+ */
+int env_journal_append(struct env_journal *jnl);
+
+/**
+ * env_journal_reset() - Start an empty journal after writing a new base
+ *
+ * @jnl: Journal to reset
+ * @env: Environment which was written as the new base
+ * @return 0 if OK, -ve on error
+ */
+int env_journal_reset(struct env_journal *jnl, const env_t *env);
+
+/**
+ * env_journal_invalidate() - Stop using the journal until the next reset
+ *
+ * This is used when the base was erased, so that the next save writes it.
+ *
+ * @jnl: Journal to invalidate
+ */
+static inline void env_journal_invalidate(struct env_journal *jnl)
+{
+	jnl->active = false;
+}
+
 #endif /* DO_DEPS_ONLY */
 
 #endif /* _ENV_INTERNAL_H_ */
@@ -70,6 +70,11 @@ struct ext4_extent_idx {
 	__u16	ei_unused;
 };
 
+/* Longer extents are unwritten (preallocated) and read as zeroes */
+#define EXT_INIT_MAX_LEN	(1 << 15)
+/* Maximum depth of an extent tree, as in Linux */
+#define EXT4_MAX_EXTENT_DEPTH	5
+
 /* Each block (leaves and indexes), even inode-stored has header. */
 struct ext4_extent_header {
 	__le16	eh_magic;	/* probably will support different formats */
@@ -123,8 +128,23 @@ struct ext_block_cache {
 	int size;
 };
 
+/* File blocks [block, block + len) are stored at [start, start + len) */
+struct ext_extent_map {
+	uint32_t block;
+	uint32_t len;
+	uint64_t start;
+};
+
+/* All written extents of a file, sorted by logical block */
+struct ext_extent_cache {
+	struct ext_extent_map *map;
+	int count;
+	int size;
+};
+
 extern struct ext2_data *ext4fs_root;
 extern struct ext2fs_node *ext4fs_file;
+extern struct ext_extent_cache ext4fs_file_extents;
 
 #if defined(CONFIG_EXT4_WRITE)
 extern struct ext2_inode *g_parent_inode;
@@ -164,4 +184,7 @@ int ext4fs_uuid(char *uuid_str);
 void ext_cache_init(struct ext_block_cache *cache);
 void ext_cache_fini(struct ext_block_cache *cache);
 int ext_cache_read(struct ext_block_cache *cache, lbaint_t block, int size);
+int ext4fs_extent_cache_build(struct ext_extent_cache *ec,
+			      struct ext2_inode *inode);
+void ext4fs_extent_cache_free(struct ext_extent_cache *ec);
 #endif
@@ -23,7 +23,14 @@
 #define DIRENTSPERCLUST	((mydata->clust_size * mydata->sect_size) / \
 			 sizeof(dir_entry))
 
+#if defined(CONFIG_SPL_BUILD) || !defined(CONFIG_FS_FAT_FATBUF_SECTORS)
 #define FATBUFBLOCKS	6
+#else
+#define FATBUFBLOCKS	CONFIG_FS_FAT_FATBUF_SECTORS
+#endif
+#if FATBUFBLOCKS % 3
+#error "FAT buffer size must be a multiple of 3 sectors for FAT12"
+#endif
 #define FATBUFSIZE	(mydata->sect_size * FATBUFBLOCKS)
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
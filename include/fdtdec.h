@@ -1220,4 +1220,138 @@ int fdtdec_decode_ram_size(const void *blob, const char *area, int board_id,
 			   phys_addr_t *basep, phys_size_t *sizep,
 			   struct bd_info *bd);
 
+/**
+ * struct fdtdec_index - index of a flat device tree
+ *
+ * This is private to lib/fdtdec_index.c. It is a single block of memory
+ * holding only offsets into the tree, so it can be copied when U-Boot
+ * relocates.
+ */
+struct fdtdec_index;
+
+#if CONFIG_IS_ENABLED(OF_INDEX)
+/**
+ * fdtdec_index_init() - Build the index of a device tree
+ *
+ * This does nothing if the index already covers @blob. Otherwise it builds
+ * the index with malloc() and sets gd->fdt_index to it. Lookups in other
+ * trees, or in @blob if this fails, walk the tree as usual.
+ *
+ * The tree must not be changed after this, except in place, without calling
+ * fdtdec_index_invalidate().
+ *
+ * @blob: Device tree to index
+ * @return 0 if OK, -ENOMEM if out of memory, -EINVAL if the tree is invalid
+ */
+int fdtdec_index_init(const void *blob);
+
+/**
+ * fdtdec_index_invalidate() - Stop using the index of a device tree
+ *
+ * This must be called before nodes or properties are added to, or removed
+ * from, a tree which may be indexed, since that changes the offsets.
+ *
+ * @blob: Device tree which is about to change
+ */
+void fdtdec_index_invalidate(const void *blob);
+
+/**
+ * fdtdec_index_size() - Get the size of the index
+ *
+ * @return number of bytes used by gd->fdt_index, 0 if there is none
+ */
+int fdtdec_index_size(void);
+
+/**
+ * fdtdec_index_relocate() - Copy the index to a new place
+ *
+ * This is called by board_init_f() once the device tree has been copied to
+ * its new place, at gd->fdt_blob. The copy is used from then on.
+ *
+ * @new_index: Place to copy to, with fdtdec_index_size() bytes available
+ */
+void fdtdec_index_relocate(void *new_index);
+
+/**
+ * fdtdec_getprop() - Look up a property, using the index if possible
+ *
+ * This behaves like fdt_getprop().
+ *
+ * @blob: Device tree blob
+ * @node: Offset of the node
+ * @name: Name of the property
+ * @lenp: Returns the length of the property, or an error code, if not NULL
+ * @return pointer to the property value, or NULL if not found
+ */
+const void *fdtdec_getprop(const void *blob, int node, const char *name,
+			   int *lenp);
+
+/**
+ * fdtdec_node_by_phandle() - Find a node from its phandle
+ *
+ * This behaves like fdt_node_offset_by_phandle().
+ *
+ * @blob: Device tree blob
+ * @phandle: Phandle to look up
+ * @return offset of the node, or -ve FDT_ERR_... on error
+ */
+int fdtdec_node_by_phandle(const void *blob, uint32_t phandle);
+
+/**
+ * fdtdec_node_by_compatible() - Find the next node with a compatible string
+ *
+ * This behaves like fdt_node_offset_by_compatible().
+ *
+ * @blob: Device tree blob
+ * @startoffset: Only consider nodes after this one (-1 for all nodes)
+ * @compat: Compatible string to look for
+ * @return offset of the node, or -ve FDT_ERR_... on error
+ */
+int fdtdec_node_by_compatible(const void *blob, int startoffset,
+			      const char *compat);
+
+/**
+ * fdtdec_parent_offset() - Find the parent of a node
+ *
+ * This behaves like fdt_parent_offset().
+ *
+ * @blob: Device tree blob
+ * @node: Offset of the node
+ * @return offset of the parent, or -ve FDT_ERR_... on error
+ */
+int fdtdec_parent_offset(const void *blob, int node);
+#else
+static inline int fdtdec_index_init(const void *blob)
+{
+	return 0;
+}
+
+static inline void fdtdec_index_invalidate(const void *blob)
+{
+}
+
+static inline const void *fdtdec_getprop(const void *blob, int node,
+					 const char *name, int *lenp)
+{
+	return fdt_getprop(blob, node, name, lenp);
+}
+
+static inline int fdtdec_node_by_phandle(const void *blob, uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
+static inline int fdtdec_node_by_compatible(const void *blob,
+					    int startoffset,
+					    const char *compat)
+{
+	return fdt_node_offset_by_compatible(blob, startoffset, compat);
+}
+
+static inline int fdtdec_parent_offset(const void *blob, int node)
+{
+	return fdt_parent_offset(blob, node);
+}
+#endif
+
 #endif
@@ -29,6 +29,64 @@ int gzip_parse_header(const unsigned char *src, unsigned long len);
  */
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp);
 
+struct gunzip_stream;
+
+/**
+ * gunzip_stream_start() - Start decompressing gzip data fed in pieces
+ *
+ * This allows data to be decompressed as it is read from a device, without
+ * first collecting the whole compressed image in memory.
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * @return stream to pass to gunzip_stream_feed(), or NULL if out of memory
+ */
+struct gunzip_stream *gunzip_stream_start(void *dst, unsigned long dstlen);
+
+/**
+ * gunzip_stream_feed() - Decompress the next piece of gzip data
+ *
+ * The first piece must hold the whole gzip header. Data after the end of
+ * the compressed stream (i.e. the gzip trailer) is ignored.
+ *
+ * @gs: Stream from gunzip_stream_start()
+ * @src: Compressed data
+ * @len: Number of bytes at @src
+ * @return 0 if OK, -EINVAL for a bad header, -EIO if the data is corrupt or
+ * the destination buffer is full
+ */
+int gunzip_stream_feed(struct gunzip_stream *gs, const void *src,
+		       unsigned long len);
+
+/**
+ * gunzip_stream_finish() - Finish decompression and free the stream
+ *
+ * @gs: Stream from gunzip_stream_start()
+ * @lenp: Returns length of uncompressed data (may be NULL)
+ * @return 0 if OK, -EIO if the compressed stream was incomplete
+ */
+int gunzip_stream_finish(struct gunzip_stream *gs, unsigned long *lenp);
+
+/**
+ * gunzip_chunks() - Decompress gzip data made of independent chunks
+ *
+ * The data is a series of complete gzip files (chunks), each compressed
+ * separately, whose uncompressed data follows on in the output. Since no
+ * chunk depends on another, they are decompressed on as many CPUs as the
+ * work queue provides. Each chunk's output size comes from its gzip trailer.
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * @src: Chunks to decompress, one after the other
+ * @sizes: Compressed size of each chunk
+ * @count: Number of chunks
+ * @lenp: Returns length of uncompressed data
+ * @return 0 if OK, -EINVAL for a bad header, -ENOSPC if the destination
+ * buffer is too small, -EIO if a chunk is corrupt, -ENOMEM if out of memory
+ */
+int gunzip_chunks(void *dst, unsigned long dstlen, const void *src,
+		  const u32 *sizes, int count, unsigned long *lenp);
+
 /**
  * zunzip() - Uncompress blocks compressed with zlib without headers
  *
@@ -6,6 +6,10 @@
 #ifndef _HASH_H
 #define _HASH_H
 
+#ifndef USE_HOSTCC
+#include <workqueue.h>
+#endif
+
 /*
  * Maximum digest size for all algorithms we support. Having this value
  * avoids a malloc() or C99 local declaration in common/cmd_hash.c.
@@ -72,6 +76,114 @@ struct hash_algo {
 			   int size);
 };
 
+/**
+ * struct hash_stream - Digest calculated over data supplied in pieces
+ *
+ * This wraps the progressive functions of a hash_algo so that callers which
+ * receive data piecemeal (e.g. while an image is still being loaded) need
+ * not know when the last piece arrives, nor deal with watchdog chunking.
+ *
+ * @algo:	Algorithm in use
+ * @ctx:	Algorithm context, NULL once the stream is finished or failed
+ */
+struct hash_stream {
+	struct hash_algo *algo;
+	void *ctx;
+};
+
+/**
+ * hash_stream_start() - Start a streaming hash
+ *
+ * @hs:		Stream to set up
+ * @algo_name:	Hash algorithm to use
+ * @return 0 if ok, -EPROTONOSUPPORT for an unknown algorithm or one
+ * without progressive support, other -ve on error
+ */
+int hash_stream_start(struct hash_stream *hs, const char *algo_name);
+
+/**
+ * hash_stream_update() - Add data to a streaming hash
+ *
+ * Large buffers are split into chunks of the algorithm's chunk_size, with
+ * the watchdog reset after each one.
+ *
+ * @hs:		Stream to update
+ * @buf:	Data to hash
+ * @size:	Number of bytes in @buf
+ * @return 0 if ok, -ve on error (the stream is then finished)
+ */
+int hash_stream_update(struct hash_stream *hs, const void *buf,
+		       unsigned int size);
+
+/**
+ * hash_stream_finish() - Complete a streaming hash
+ *
+ * @hs:		Stream to finish
+ * @output:	Place to put the digest
+ * @size:	Number of bytes available at @output
+ * @return 0 if ok, -ENOSPC if @size is smaller than the digest, other -ve
+ * on error
+ */
+int hash_stream_finish(struct hash_stream *hs, void *output, int size);
+
+/**
+ * hash_stream_abort() - Discard a streaming hash
+ *
+ * This releases the context of a stream which will not be finished. It
+ * does nothing if the stream has already finished or failed.
+ *
+ * @hs:		Stream to discard
+ */
+void hash_stream_abort(struct hash_stream *hs);
+
+#ifndef USE_HOSTCC
+struct image_region;
+
+/**
+ * struct hash_calculation - A hash_calculate() which runs on another CPU
+ *
+ * @hs:			Hash being calculated
+ * @region:		Regions to hash, which must stay valid until
+ *			hash_calculate_wait() returns
+ * @region_count:	Number of regions in @region
+ * @work:		Work item doing the calculation
+ */
+struct hash_calculation {
+	struct hash_stream hs;
+	const struct image_region *region;
+	int region_count;
+	struct work work;
+};
+
+/**
+ * hash_calculate_queue() - Start calculating a hash over some regions
+ *
+ * This is hash_calculate() split in two, so that the caller can start
+ * several calculations before waiting for them. The hash context is
+ * allocated here and the calculation is queued with work_queue(); it runs
+ * on the calling CPU if no other is free. Unlike hash_calculate() it does
+ * not reset the watchdog while hashing.
+ *
+ * @hc:			Calculation to set up
+ * @algo_name:		Hash algorithm to use
+ * @region:		Regions over which to calculate the hash
+ * @region_count:	Number of regions in @region
+ * @return 0 if queued, -ve on error (nothing is queued)
+ */
+int hash_calculate_queue(struct hash_calculation *hc, const char *algo_name,
+			 const struct image_region *region, int region_count);
+
+/**
+ * hash_calculate_wait() - Finish a hash started by hash_calculate_queue()
+ *
+ * @hc:		Calculation to wait for
+ * @output:	Place to put the digest, which must hold the algorithm's
+ *		digest_size bytes
+ * @return 0 if OK, -ve on error
+ */
+int hash_calculate_wait(struct hash_calculation *hc, void *output);
+#endif
+
 #ifndef USE_HOSTCC
 /**
  * hash_command: Process a hash command for a particular algorithm
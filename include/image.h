@@ -37,6 +37,7 @@ struct fdt_region;
 
 #define IMAGE_ENABLE_IGNORE	0
 #define IMAGE_INDENT_STRING	""
+#define IMAGE_ENABLE_WORK_QUEUE	0
 
 #else
 
@@ -50,6 +51,7 @@ struct fdt_region;
 
 #define IMAGE_ENABLE_FIT	CONFIG_IS_ENABLED(FIT)
 #define IMAGE_ENABLE_OF_LIBFDT	CONFIG_IS_ENABLED(OF_LIBFDT)
+#define IMAGE_ENABLE_WORK_QUEUE	CONFIG_IS_ENABLED(WORK_QUEUE)
 
 #endif /* USE_HOSTCC */
 
@@ -92,6 +94,17 @@ struct fdt_region;
 #define IMAGE_ENABLE_SHA256	0
 #endif
 
+/* FIT hashes go through the hash_algo table when common/hash.c is built */
+#if defined(USE_HOSTCC)
+#define IMAGE_ENABLE_HASH_STREAM	1
+#elif defined(CONFIG_SPL_BUILD)
+#define IMAGE_ENABLE_HASH_STREAM	CONFIG_IS_ENABLED(HASH_SUPPORT)
+#elif defined(CONFIG_HASH)
+#define IMAGE_ENABLE_HASH_STREAM	1
+#else
+#define IMAGE_ENABLE_HASH_STREAM	0
+#endif
+
 #endif /* IMAGE_ENABLE_FIT */
 
 #ifdef CONFIG_SYS_BOOT_GET_CMDLINE
@@ -634,6 +647,22 @@ int boot_get_fdt_fit(bootm_headers_t *images, ulong addr,
 		   const char **fit_unamep, const char **fit_uname_configp,
 		   int arch, ulong *datap, ulong *lenp);
 
+/**
+ * fit_image_decomp() - decompress an image from a FIT
+ *
+ * This is image_decomp() for an image node. A gzip image with a
+ * "compression-chunks" property is made of independently compressed
+ * chunks, which are decompressed on as many CPUs as are available.
+ *
+ * @fit:	FIT holding the image node
+ * @noffset:	Image node
+ * The other parameters and the return value are as for image_decomp()
+ */
+int fit_image_decomp(const void *fit, int noffset, int comp, ulong load,
+		     ulong image_start, int type, void *load_buf,
+		     void *image_buf, ulong image_len, uint unc_len,
+		     ulong *load_end);
+
 /**
  * fit_image_load() - load an image from a FIT
  *
@@ -940,6 +969,7 @@ int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
 #define FIT_TYPE_PROP		"type"
 #define FIT_OS_PROP		"os"
 #define FIT_COMP_PROP		"compression"
+#define FIT_COMP_CHUNKS_PROP	"compression-chunks"
 #define FIT_ENTRY_PROP		"entry"
 #define FIT_LOAD_PROP		"load"
 
@@ -1052,6 +1082,93 @@ int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 			      const char *comment, int require_keys,
 			      const char *engine_id, const char *cmdname);
 
+/* Maximum number of hash nodes which can be calculated while streaming */
+#define FIT_STREAM_MAX_HASHES	4
+
+/**
+ * struct fit_image_stream - Hashes of an image calculated as it is loaded
+ *
+ * This allows the hash nodes of an image to be checked without a second
+ * pass over the data, e.g. when the data is decompressed as it is read.
+ *
+ * @fit:		FIT holding the image node
+ * @image_noffset:	Image node
+ * @count:		Number of entries in @hash
+ * @hash:		One entry for each hash node being calculated
+ */
+struct fit_image_stream {
+	const void *fit;
+	int image_noffset;
+	int count;
+	struct fit_stream_hash {
+		int noffset;
+		struct hash_stream hs;
+		uint8_t value[FIT_MAX_HASH_LEN];
+		int value_len;
+	} hash[FIT_STREAM_MAX_HASHES];
+};
+
+/**
+ * fit_image_stream_start() - Start hashing an image which is being loaded
+ *
+ * Streaming is refused for images with signature nodes, since those must
+ * be checked against the whole image, and for hash algorithms without
+ * progressive support (e.g. md5). The caller should then load the whole
+ * image and use fit_image_verify_with_data().
+ *
+ * @fs:			Stream to set up
+ * @fit:		FIT holding the image node
+ * @image_noffset:	Image node to verify
+ * @return 0 if OK, -EPROTONOSUPPORT if the image cannot be streamed,
+ * -ENOSYS if there is no hashing support
+ */
+int fit_image_stream_start(struct fit_image_stream *fs, const void *fit,
+			   int image_noffset);
+
+/**
+ * fit_image_stream_update() - Add the next piece of image data
+ *
+ * @fs:		Stream to update
+ * @data:	Image data, in order
+ * @size:	Number of bytes at @data
+ * @return 0 if OK, -ve on error (the stream is then aborted)
+ */
+int fit_image_stream_update(struct fit_image_stream *fs, const void *data,
+			    size_t size);
+
+/**
+ * fit_image_stream_abort() - Discard a stream without verifying
+ *
+ * @fs:		Stream to discard
+ */
+void fit_image_stream_abort(struct fit_image_stream *fs);
+
+/**
+ * fit_image_stream_digest() - Find a digest calculated for a node
+ *
+ * @fs:		Calculated hashes, or NULL
+ * @noffset:	Hash or signature node
+ * @return the digest, or NULL if it was not calculated
+ */
+const uint8_t *fit_image_stream_digest(const struct fit_image_stream *fs,
+				       int noffset);
+
+/**
+ * fit_image_stream_verify() - Finish the hashes and check the image
+ *
+ * This behaves like fit_image_verify_with_data() but uses the digests
+ * calculated by the stream. Required signatures are still checked against
+ * @data, which may be NULL if it was not kept. Nothing should be done with
+ * the data, such as decompressing it, until this has accepted it.
+ *
+ * @fs:		Stream to finish
+ * @data:	Whole image data, or NULL
+ * @size:	Size of image data
+ * @return 1 if all hashes are valid, 0 otherwise
+ */
+int fit_image_stream_verify(struct fit_image_stream *fs, const void *data,
+			    size_t size);
+
 int fit_image_verify_with_data(const void *fit, int image_noffset,
 			       const void *data, size_t size);
 int fit_image_verify(const void *fit, int noffset);
@@ -1136,6 +1253,7 @@ struct image_sign_info {
 	int required_keynode;		/* Node offset of key to use: -1=any */
 	const char *require_keys;	/* Value for 'required' property */
 	const char *engine_id;		/* Engine to use for signing */
+	const uint8_t *digest;		/* Hash of the regions, if known */
 };
 #endif /* Allow struct image_region to always be defined for rsa.h */
 
@@ -1255,6 +1373,7 @@ struct padding_algo *image_get_padding_algo(const char *name);
  * @data:		Image data to check
  * @size:		Size of image data
  * @sig_blob:		FDT containing public keys
+ * @fs:			Hashes already calculated over @data, or NULL
  * @no_sigsp:		Returns 1 if no signatures were required, and
  *			therefore nothing was checked. The caller may wish
  *			to fall back to other mechanisms, or refuse to
@@ -1263,7 +1382,7 @@ struct padding_algo *image_get_padding_algo(const char *name);
  */
 int fit_image_verify_required_sigs(const void *fit, int image_noffset,
 		const char *data, size_t size, const void *sig_blob,
-		int *no_sigsp);
+		const struct fit_image_stream *fs, int *no_sigsp);
 
 /**
  * fit_image_check_sig() - Check a single image signature node
@@ -1272,6 +1391,9 @@ int fit_image_verify_required_sigs(const void *fit, int image_noffset,
  * @noffset:		Offset of signature node to check
  * @data:		Image data to check
  * @size:		Size of image data
+ * @fs:			Hashes already calculated over @data, or NULL. If
+ *			@fs has the hash for this node it is used instead of
+ *			hashing @data again.
  * @required_keynode:	Offset in the control FDT of the required key node,
  *			if any. If this is given, then the image wil not
  *			pass verification unless that key is used. If this is
@@ -1281,7 +1403,8 @@ int fit_image_verify_required_sigs(const void *fit, int image_noffset,
  * @return 0 if all verified ok, <0 on error
  */
 int fit_image_check_sig(const void *fit, int noffset, const void *data,
-		size_t size, int required_keynode, char **err_msgp);
+		size_t size, const struct fit_image_stream *fs,
+		int required_keynode, char **err_msgp);
 
 /**
  * fit_region_make_list() - Make a list of regions to hash
@@ -22,6 +22,7 @@
 #define ELM_SYNDROME_FRAGMENT_6_SYNDROME_VALID		(0x00010000)
 #define ELM_LOCATION_STATUS_ECC_CORRECTABLE_MASK	(0x100)
 #define ELM_LOCATION_STATUS_ECC_NB_ERRORS_MASK		(0x1F)
+#define ELM_IRQ_PAGE_VALID				(0x100)
 
 #define ELM_MAX_CHANNELS				8
 #define ELM_MAX_ERROR_COUNT				16
@@ -72,6 +73,9 @@ struct elm {
 
 int elm_check_error(u8 *syndrome, enum bch_level bch_type, u32 *error_count,
 		u32 *error_locations);
+int elm_check_error_page(u8 **syndromes, int nsect, enum bch_level bch_type,
+			 int *error_count,
+			 u32 error_locations[][ELM_MAX_ERROR_COUNT]);
 int elm_config(enum bch_level level);
 void elm_reset(void);
 void elm_init(void);
@@ -1117,6 +1117,7 @@ int nand_default_bbt(struct mtd_info *mtd);
 int nand_markbad_bbt(struct mtd_info *mtd, loff_t offs);
 int nand_isreserved_bbt(struct mtd_info *mtd, loff_t offs);
 int nand_isbad_bbt(struct mtd_info *mtd, loff_t offs, int allowbbt);
+int nand_bbt_cache_verify(struct mtd_info *mtd, loff_t offs, loff_t len);
 int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 			   int allowbbt);
 int nand_do_read(struct mtd_info *mtd, loff_t from, size_t len,
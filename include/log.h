@@ -9,6 +9,7 @@
 #ifndef __LOG_H
 #define __LOG_H
 
+#include <stdarg.h>
 #include <dm/uclass-id.h>
 #include <linux/list.h>
 
@@ -262,7 +263,9 @@ void __assert_fail(const char *assertion, const char *file, unsigned int line,
  * @file: Name of file where the log record was generated (not allocated)
  * @line: Line number where the log record was generated
  * @func: Function where the log record was generated (not allocated)
- * @msg: Log message (allocated)
+ * @fmt: printf() format string for the message (not allocated)
+ * @args: Arguments for @fmt. A driver must use va_copy() to read them
+ * @msg: Log message (allocated), only set for drivers without LOGDF_RAW
  */
 struct log_rec {
 	enum log_category_t cat;
@@ -270,18 +273,35 @@ struct log_rec {
 	const char *file;
 	int line;
 	const char *func;
+	const char *fmt;
+	va_list *args;
 	const char *msg;
 };
 
 struct log_device;
 
+enum log_driver_flags {
+	LOGDF_RAW	= 1 << 0,	/* Uses @fmt and @args, not @msg */
+};
+
 /**
  * struct log_driver - a driver which accepts and processes log records
  *
  * @name: Name of driver
+ * @flags: Flags for this driver (enum log_driver_flags)
  */
 struct log_driver {
 	const char *name;
+	int flags;
+	/**
+	 * probe() - set up the driver
+	 *
+	 * This is optional. It is called by log_init(), so once before and
+	 * once after relocation.
+	 *
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*probe)(struct log_device *ldev);
 	/**
 	 * emit() - emit a log record
 	 *
@@ -425,6 +445,35 @@ int log_add_filter(const char *drv_name, enum log_category_t cat_list[],
  */
 int log_remove_filter(const char *drv_name, int filter_num);
 
+#if defined(CONFIG_LOG_BINARY) && !defined(CONFIG_SPL_BUILD)
+/**
+ * log_binary_dump() - Show the records in the binary log
+ *
+ * This includes records from before the last reset, as long as the memory
+ * holding the log kept its contents. Only the messages of records written by
+ * this U-Boot image can be shown; tools/logdecode can show the others.
+ *
+ * @return 0 if OK, -ENOENT if there is no log
+ */
+int log_binary_dump(void);
+
+/**
+ * log_binary_fdt_fixup() - Tell the OS where the binary log is
+ *
+ * This adds a node for the log buffer to /reserved-memory, with a compatible
+ * string of "u-boot,binary-log".
+ *
+ * @blob: Device tree to update
+ * @return 0 if OK, -ve FDT_ERR_... on error
+ */
+int log_binary_fdt_fixup(void *blob);
+#else
+static inline int log_binary_fdt_fixup(void *blob)
+{
+	return 0;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(LOG)
 /**
  * log_init() - Set up the log system ready for use
@@ -0,0 +1,221 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Binary log format
+ *
+ * This is shared with tools/logdecode so only uses fixed-size types. The
+ * buffer is stored in the byte order of the machine writing it.
+ */
+
+#ifndef __LOG_BINARY_H
+#define __LOG_BINARY_H
+
+#ifdef USE_HOSTCC
+#include <stdint.h>
+#else
+#include <linux/types.h>
+#endif
+
+#define LOGB_MAGIC	0x474f4c55	/* "ULOG" */
+#define LOGB_VERSION	2
+
+/* Records start on this boundary and their size is a multiple of it */
+#define LOGB_ALIGN	8
+
+/* Longest string argument stored; longer ones are truncated */
+#define LOGB_STR_MAX	128
+
+/* Most argument bytes stored for one record */
+#define LOGB_ARGS_MAX	512
+
+/**
+ * struct logb_hdr - header at the start of the binary log buffer
+ *
+ * The record area follows the header. The oldest record is at @tail and the
+ * next one is written at @head, so the area is empty when they are equal. A
+ * record never wraps: if it does not fit before the end of the area, a record
+ * with a size of 0 is written in its place (if there is room for the size) and
+ * the record goes at the start of the area.
+ *
+ * @magic: LOGB_MAGIC
+ * @version: LOGB_VERSION
+ * @long_size: sizeof(long) on the machine writing the log, which is also the
+ *	size of a pointer
+ * @hdr_size: sizeof(struct logb_hdr)
+ * @size: Size of the record area in bytes, a multiple of LOGB_ALIGN
+ * @head: Offset of the next record to write in the record area
+ * @tail: Offset of the oldest record in the record area
+ * @reserved: Must be 0
+ */
+struct logb_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint8_t long_size;
+	uint8_t hdr_size;
+	uint32_t size;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t reserved;
+};
+
+/** enum logb_rec_type - types of record */
+enum logb_rec_type {
+	LOGBT_MSG,	/* a log message */
+	LOGBT_START,	/* the log started in a new phase, e.g. after reset */
+};
+
+/**
+ * struct logb_rec - header of a record in the binary log
+ *
+ * For a LOGBT_MSG record the name of the file follows the header, stored as
+ * a string (see below), since the caller's copy may not outlive the call.
+ * Then come the arguments for the format string, packed without padding in
+ * the order they are used. An integer is
+ * stored in 4 bytes, or 8 for the 'll' qualifier. One with the 'l', 'z', 'Z'
+ * or 't' qualifier takes @long_size bytes, as does a pointer. A string is
+ * stored as a 16-bit length and that many bytes, without a terminator. If
+ * the file name and arguments do not fit in LOGB_ARGS_MAX bytes, the last
+ * arguments are left out.
+ *
+ * A LOGBT_START record has no arguments. It marks where a phase of U-Boot
+ * started logging, and allows the addresses in the records after it to be
+ * turned into addresses in the ELF file for that phase. Its @level holds the
+ * phase (enum u_boot_phase) and @fmt the address of log_binary_anchor[].
+ * Its @file is a hash of the contents of log_binary_anchor[], which holds
+ * the version string, so that the right ELF file can be checked.
+ *
+ * @size: Size of the record in bytes, including the arguments, a multiple of
+ *	LOGB_ALIGN
+ * @type: Type of record (enum logb_rec_type)
+ * @level: Log level (enum log_level_t)
+ * @cat: Log category (enum log_category_t)
+ * @line: Line number where the record was generated
+ * @time: Time of the record in microseconds, from timer_get_us()
+ * @fmt: Address of the printf() format string
+ * @file: 0 for a LOGBT_MSG record, see above for LOGBT_START
+ */
+struct logb_rec {
+	uint16_t size;
+	uint8_t type;
+	uint8_t level;
+	uint16_t cat;
+	uint16_t line;
+	uint64_t time;
+	uint64_t fmt;
+	uint64_t file;
+};
+
+/** enum logb_arg_t - types of argument used by a conversion */
+enum logb_arg_t {
+	LOGBA_END,	/* end of the format string */
+	LOGBA_NONE,	/* no argument, e.g. %% */
+	LOGBA_SKIP,	/* argument which is not stored (%n) */
+	LOGBA_INT,	/* int */
+	LOGBA_LONG,	/* long, size_t or ptrdiff_t */
+	LOGBA_LLONG,	/* long long */
+	LOGBA_PTR,	/* pointer */
+	LOGBA_STR,	/* string */
+};
+
+/**
+ * struct logb_conv - a conversion in a format string
+ *
+ * @start: Position of the '%'
+ * @end: Position just after the conversion, including any suffix of %p
+ * @stars: Number of '*' for the width and precision, each of which takes an
+ *	int argument before the one for the conversion
+ * @spec_len: Length of the conversion up to the qualifier, i.e. the '%' and
+ *	any flags, width and precision
+ * @qual: Qualifier: 'h', 'l', 'L' (for 'll'), 'z', 'Z', 't', or 0 for none
+ * @conv: Conversion character
+ * @type: Type of argument (enum logb_arg_t)
+ */
+struct logb_conv {
+	const char *start;
+	const char *end;
+	int stars;
+	int spec_len;
+	char qual;
+	char conv;
+	enum logb_arg_t type;
+};
+
+/**
+ * logb_next_conv() - Find the next conversion in a format string
+ *
+ * This follows the rules of U-Boot's vsnprintf().
+ *
+ * @fmt: Position in the format string to search from
+ * @conv: Returns information about the conversion
+ * @return type of argument used by the conversion, LOGBA_END if none
+ */
+enum logb_arg_t logb_next_conv(const char *fmt, struct logb_conv *conv);
+
+/**
+ * logb_arg_size() - Get the number of bytes used to store an argument
+ *
+ * @type: Type of argument, not LOGBA_STR
+ * @long_size: Size of a long, from struct logb_hdr
+ * @return number of bytes
+ */
+int logb_arg_size(enum logb_arg_t type, int long_size);
+
+/**
+ * logb_check_hdr() - Check that a binary log header is valid
+ *
+ * @hdr: Header to check
+ * @size: Total size of the buffer, including the header
+ * @return 0 if valid, -1 if not
+ */
+int logb_check_hdr(const struct logb_hdr *hdr, uint32_t size);
+
+/**
+ * logb_next_rec() - Get the next record from a binary log buffer
+ *
+ * To read all the records, start with @offp set to @hdr->tail.
+ *
+ * @hdr: Header of the buffer, which must be valid
+ * @offp: Offset of the record to get, updated to that of the next one
+ * @return pointer to the record, or NULL if there are no more or the record
+ *	is corrupt
+ */
+const struct logb_rec *logb_next_rec(const struct logb_hdr *hdr,
+				     uint32_t *offp);
+
+/**
+ * logb_get_str() - Get a string stored in a binary log record
+ *
+ * @args: Position of the string in the record
+ * @len: Number of bytes left in the record from @args
+ * @str: Returns the string, with a terminator; must hold LOGB_STR_MAX + 1
+ *	bytes
+ * @return number of bytes used by the string in the record, -1 if it is
+ *	corrupt
+ */
+int logb_get_str(const uint8_t *args, int len, char *str);
+
+/**
+ * logb_format() - Format the message of a binary log record
+ *
+ * This is like snprintf() but takes the arguments stored in a record. A
+ * missing argument is shown as '?'.
+ *
+ * @buf: Buffer for the message
+ * @size: Size of the buffer, including space for the terminator
+ * @fmt: Format string for the record
+ * @args: Arguments for the record
+ * @len: Number of bytes of arguments
+ * @long_size: Size of a long, from struct logb_hdr
+ * @return length of the message (which may be truncated)
+ */
+int logb_format(char *buf, int size, const char *fmt, const uint8_t *args,
+		int len, int long_size);
+
+/**
+ * logb_hash() - Hash a string to identify the image which wrote a log
+ *
+ * @str: String to hash
+ * @return hash value
+ */
+uint32_t logb_hash(const char *str);
+
+#endif
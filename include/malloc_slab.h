@@ -0,0 +1,210 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Size-class slab allocator for small malloc() requests
+ *
+ * Small allocations (up to MALLOC_SLAB_MAX bytes) are served from fixed-size
+ * pages, each holding objects of a single size class. This avoids the
+ * per-chunk overhead and bin searches of dlmalloc, and lets free() return
+ * small objects for reuse before relocation, when malloc_simple() cannot.
+ */
+
+#ifndef __MALLOC_SLAB_H
+#define __MALLOC_SLAB_H
+
+#include <linux/types.h>
+
+enum {
+	MALLOC_SLAB_PAGE	= 512,	/* Bytes in each slab page */
+	MALLOC_SLAB_MAX		= 256,	/* Largest request served by a slab */
+	MALLOC_SLAB_CLASSES	= 10,	/* Number of size classes */
+};
+
+/* Size recorded in a struct malloc_slab_trace for a call to free() */
+#define MALLOC_SLAB_TRACE_FREE	(~0U)
+
+/**
+ * struct malloc_slab_class - statistics for a size class
+ *
+ * @size: Size of objects in this class in bytes
+ * @pages: Number of pages currently holding objects of this class
+ * @in_use: Number of objects currently allocated
+ * @peak: Highest value of @in_use seen
+ * @allocs: Number of objects allocated
+ * @frees: Number of objects freed
+ * @fails: Number of requests passed to the main allocator because there
+ *	were no free pages
+ * @partial: Index of the first page with free objects, or MALLOC_SLAB_NONE.
+ *	This is internal to the allocator.
+ */
+struct malloc_slab_class {
+	uint size;
+	uint pages;
+	uint in_use;
+	uint peak;
+	uint allocs;
+	uint frees;
+	uint fails;
+	u16 partial;
+};
+
+/**
+ * struct malloc_slab_trace - a record of a malloc() or free() call
+ *
+ * @ptr: Pointer that was returned by malloc() or passed to free()
+ * @size: Number of bytes requested, or MALLOC_SLAB_TRACE_FREE for free()
+ */
+struct malloc_slab_trace {
+	void *ptr;
+	uint size;
+};
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+/**
+ * malloc_slab_init() - Set up the slab area
+ *
+ * This allocates the slab area with memalign(), so before relocation it
+ * comes from the malloc_simple() pool. Any previous area is forgotten, but
+ * not freed, since that happens across relocation when the old area is no
+ * longer owned by the allocator.
+ *
+ * @size: Size of area in bytes, including the headers, 0 to disable
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int malloc_slab_init(ulong size);
+
+/**
+ * malloc_slab_alloc() - Allocate a small object
+ *
+ * This is called by malloc() before it does anything else.
+ *
+ * @bytes: Number of bytes required
+ * @return pointer to memory, or NULL if the request should be handled by the
+ *	main allocator
+ */
+void *malloc_slab_alloc(size_t bytes);
+
+/**
+ * malloc_slab_free() - Free an object
+ *
+ * This is called by free() before it does anything else.
+ *
+ * @ptr: Pointer to free (may be NULL)
+ * @return true if the pointer was handled here, false if it belongs to the
+ *	main allocator
+ */
+bool malloc_slab_free(void *ptr);
+
+/**
+ * malloc_slab_usable_size() - Get the size of an object
+ *
+ * @ptr: Pointer to check
+ * @return size of the object's size class, or 0 if @ptr is not in the slab
+ *	area
+ */
+size_t malloc_slab_usable_size(void *ptr);
+
+/**
+ * malloc_slab_realloc() - Change the size of an object in the slab area
+ *
+ * The object stays where it is if the new size is in the same size class.
+ * Otherwise a new object is allocated with malloc(), the contents copied
+ * and the old one freed.
+ *
+ * @ptr: Pointer to an object in the slab area
+ * @bytes: New size in bytes
+ * @return new pointer, or NULL if out of memory (in which case @ptr is
+ *	unchanged)
+ */
+void *malloc_slab_realloc(void *ptr, size_t bytes);
+
+/**
+ * malloc_slab_unused() - Get the number of bytes in the area not in use
+ *
+ * This is used by mallinfo() so that objects in the slab area are counted as
+ * allocated, rather than the area as a whole.
+ *
+ * @return number of bytes not holding allocated objects
+ */
+ulong malloc_slab_unused(void);
+
+/**
+ * malloc_slab_set_enabled() - Enable or disable new slab allocations
+ *
+ * While disabled all requests go to the main allocator. Existing objects can
+ * still be freed.
+ *
+ * @enabled: true to enable, false to disable
+ * @return previous setting
+ */
+bool malloc_slab_set_enabled(bool enabled);
+
+/**
+ * malloc_slab_get_class() - Get the statistics for a size class
+ *
+ * @cls: Size class (0 to MALLOC_SLAB_CLASSES - 1)
+ * @return pointer to the class information, or NULL if there is no slab
+ *	area or @cls is invalid
+ */
+const struct malloc_slab_class *malloc_slab_get_class(int cls);
+
+/**
+ * malloc_slab_info() - Show information about the slab area
+ *
+ * This prints the size of the area and the statistics for each size class.
+ */
+void malloc_slab_info(void);
+
+/**
+ * malloc_slab_trace_start() - Start recording malloc() and free() calls
+ *
+ * Calls to malloc(), calloc() and free() are recorded until
+ * malloc_slab_trace_stop() is called. Calls to realloc() and memalign() are
+ * not recorded, although memalign() may show up as the malloc() and free()
+ * calls that it makes itself. This is intended for benchmarking the allocator
+ * with a real allocation pattern.
+ *
+ * @buf: Buffer to hold the records
+ * @max: Maximum number of records
+ * @return 0 if OK, -ENOSYS if there is no slab area
+ */
+int malloc_slab_trace_start(struct malloc_slab_trace *buf, int max);
+
+/**
+ * malloc_slab_trace_stop() - Stop recording malloc() and free() calls
+ *
+ * @return number of records written, -ENOSPC if the buffer overflowed,
+ *	-ENOENT if no trace was started
+ */
+int malloc_slab_trace_stop(void);
+#else
+static inline int malloc_slab_init(ulong size)
+{
+	return 0;
+}
+
+static inline void *malloc_slab_alloc(size_t bytes)
+{
+	return NULL;
+}
+
+static inline bool malloc_slab_free(void *ptr)
+{
+	return false;
+}
+
+static inline size_t malloc_slab_usable_size(void *ptr)
+{
+	return 0;
+}
+
+static inline ulong malloc_slab_unused(void)
+{
+	return 0;
+}
+
+static inline void malloc_slab_info(void)
+{
+}
+#endif
+
+#endif
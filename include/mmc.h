@@ -423,6 +423,34 @@ struct dm_mmc_ops {
 	int (*send_cmd)(struct udevice *dev, struct mmc_cmd *cmd,
 			struct mmc_data *data);
 
+#if CONFIG_IS_ENABLED(MMC_QUEUE)
+	/**
+	 * send_cmd_start() - Send a data command without waiting for the data
+	 *
+	 * This is like send_cmd() but returns once the command response has
+	 * been received, leaving the data to move in the background (e.g. by
+	 * DMA). send_cmd_wait() must be called before the next command is
+	 * sent. Drivers may fall back to a complete transfer here, in which
+	 * case send_cmd_wait() has nothing to do.
+	 *
+	 * @dev:	Device to receive the command
+	 * @cmd:	Command to send
+	 * @data:	Data to send/receive
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*send_cmd_start)(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data);
+
+	/**
+	 * send_cmd_wait() - Wait for the data of a command to complete
+	 *
+	 * @dev:	Device which received the command
+	 * @data:	Data passed to send_cmd_start()
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*send_cmd_wait)(struct udevice *dev, struct mmc_data *data);
+#endif
+
 	/**
 	 * set_ios() - Set the I/O speed/width for an MMC device
 	 *
@@ -495,6 +523,9 @@ int dm_mmc_get_wp(struct udevice *dev);
 int dm_mmc_execute_tuning(struct udevice *dev, uint opcode);
 int dm_mmc_wait_dat0(struct udevice *dev, int state, int timeout_us);
 int dm_mmc_host_power_cycle(struct udevice *dev);
+int dm_mmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data);
+int dm_mmc_send_cmd_wait(struct udevice *dev, struct mmc_data *data);
 
 /* Transition functions for compatibility */
 int mmc_set_ios(struct mmc *mmc);
@@ -886,4 +917,83 @@ int mmc_get_env_dev(void);
  */
 struct blk_desc *mmc_get_blk_desc(struct mmc *mmc);
 
+/**
+ * struct mmc_queue - Double-buffered sequential read from an MMC device
+ *
+ * The queue reads a range of blocks in chunks, alternating between two
+ * buffers. Each call to mmc_queue_next() returns a filled buffer and, on
+ * hosts which support it, starts reading the next chunk into the other
+ * buffer, so the transfer runs while the caller consumes the data.
+ *
+ * This is separate from blk_dread(), which returns only when all the data
+ * has been read and so has nothing to overlap with the transfer. SPL uses
+ * it to decompress FIT images while they are read (CONFIG_SPL_MMC_QUEUE).
+ *
+ * @mmc:	MMC device being read
+ * @next:	Next block to request
+ * @left:	Number of blocks not yet requested
+ * @chunk:	Maximum number of blocks per request
+ * @buf:	The two buffers, each large enough for @chunk blocks
+ * @count:	Number of blocks requested into each buffer, 0 if none
+ * @cur:	Buffer to be returned by the next call to mmc_queue_next()
+ * @cmd:	Command for the request in flight
+ * @data:	Data for the request in flight
+ */
+struct mmc_queue {
+	struct mmc *mmc;
+	lbaint_t next;
+	lbaint_t left;
+	lbaint_t chunk;
+	void *buf[2];
+	lbaint_t count[2];
+	int cur;
+	struct mmc_cmd cmd;
+	struct mmc_data data;
+};
+
+/**
+ * mmc_queue_start() - Start a double-buffered read
+ *
+ * This selects the hardware partition of @desc and requests the first
+ * chunk into @buf0.
+ *
+ * @q:		Queue to set up
+ * @desc:	Block device to read from
+ * @start:	First block to read
+ * @blkcnt:	Number of blocks to read
+ * @buf0:	First buffer, cache-aligned and large enough for @chunk blocks
+ * @buf1:	Second buffer, likewise
+ * @chunk:	Maximum number of blocks to read per request
+ * @return 0 if OK, -ve on error
+ */
+int mmc_queue_start(struct mmc_queue *q, struct blk_desc *desc,
+		    lbaint_t start, lbaint_t blkcnt, void *buf0, void *buf1,
+		    lbaint_t chunk);
+
+/**
+ * mmc_queue_next() - Get the next chunk of a double-buffered read
+ *
+ * This waits for the oldest request to complete and then requests the next
+ * chunk into the buffer returned by the previous call, which the caller
+ * must be finished with.
+ *
+ * @q:		Queue to read from
+ * @bufp:	Returns a pointer to the data
+ * @blocksp:	Returns the number of blocks at @bufp, 0 when the read is
+ *		complete
+ * @return 0 if OK, -ve on error
+ */
+int mmc_queue_next(struct mmc_queue *q, void **bufp, lbaint_t *blocksp);
+
+/**
+ * mmc_queue_stop() - Stop a double-buffered read
+ *
+ * This waits for any request in flight, so the buffers may be freed
+ * afterwards. It must be called if the caller stops calling
+ * mmc_queue_next() before the read is complete.
+ *
+ * @q:		Queue to stop
+ */
+void mmc_queue_stop(struct mmc_queue *q);
+
 #endif /* _MMC_H_ */
@@ -152,4 +152,168 @@ void sunxi_nand_init(void);
  */
 struct mtd_info *get_nand_dev_by_index(int dev);
 
+/*****************************************************************************
+ * declarations from nand_bbt_cache.c
+ ****************************************************************************/
+
+#define NAND_BBT_CACHE_MAGIC	0x43544242	/* "BBTC" in little-endian */
+
+#if defined(CONFIG_NAND_BBT_CACHE_FLASH) && \
+	!defined(CONFIG_NAND_BBT_CACHE_OFFSET)
+#error "Set CONFIG_NAND_BBT_CACHE_OFFSET to the area for the bad block cache"
+#endif
+
+/**
+ * struct nand_bbt_cache - compact bad block table of a NAND device
+ *
+ * This holds one bit per eraseblock, set if the block is bad. It is passed
+ * from SPL to U-Boot proper in a bloblist and may also be stored in a
+ * reserved area of the NAND device, so that the bad block markers do not
+ * have to be scanned again on every boot.
+ *
+ * @magic: NAND_BBT_CACHE_MAGIC
+ * @generation: Incremented each time the table is written, the copy with the
+ *	highest generation wins. 0 for a cache SPL has just built by reading
+ *	every marker, which is not stored on the device yet
+ * @erase_shift: log2 of the eraseblock size
+ * @nblocks: Number of eraseblocks covered by @bitmap
+ * @crc: CRC32 of this header up to @crc, followed by @bitmap
+ * @bitmap: Bad block bitmap, bit (n % 8) of byte (n / 8) is block n
+ */
+struct nand_bbt_cache {
+	u32 magic;
+	u32 generation;
+	u32 erase_shift;
+	u32 nblocks;
+	u32 crc;
+	u8 bitmap[];
+};
+
+static inline uint nand_bbt_cache_size(uint nblocks)
+{
+	return sizeof(struct nand_bbt_cache) + DIV_ROUND_UP(nblocks, 8);
+}
+
+static inline bool nand_bbt_cache_isbad(const struct nand_bbt_cache *cache,
+					uint block)
+{
+	return cache->bitmap[block / 8] & (1 << (block % 8));
+}
+
+/**
+ * nand_bbt_cache_crc() - Calculate the checksum of a bad block cache
+ *
+ * @cache: Cache to check, with a valid @nblocks
+ * @return CRC32 to store in @cache->crc
+ */
+u32 nand_bbt_cache_crc(const struct nand_bbt_cache *cache);
+
+/**
+ * nand_bbt_cache_check() - Check that a bad block cache is valid
+ *
+ * @cache: Cache to check
+ * @size: Number of bytes available at @cache
+ * @return 0 if OK, -ENOENT if there is no cache, -EBADMSG if it is corrupted
+ */
+int nand_bbt_cache_check(const struct nand_bbt_cache *cache, uint size);
+
+/**
+ * nand_bbt_cache_handoff() - Pass a bad block cache to the next boot phase
+ *
+ * This stores a copy of @cache in the bloblist, if there is one.
+ *
+ * @cache: Valid cache to pass on
+ * @return 0 if OK, -ENOSPC if the bloblist is full, -ENOSYS if there is no
+ *	bloblist
+ */
+int nand_bbt_cache_handoff(const struct nand_bbt_cache *cache);
+
+/**
+ * nand_bbt_cache_load() - Find the bad block cache for a NAND device
+ *
+ * This looks in the bloblist first, then in the reserved area on @mtd if
+ * CONFIG_NAND_BBT_CACHE_FLASH is enabled. Only the first NAND device is
+ * supported.
+ *
+ * @mtd: NAND device
+ * @return allocated copy of the cache, which must be freed by the caller,
+ *	or NULL if there is no valid cache matching the device
+ */
+struct nand_bbt_cache *nand_bbt_cache_load(struct mtd_info *mtd);
+
+/**
+ * nand_bbt_cache_save() - Store a new bad block cache for a NAND device
+ *
+ * This stores @cache in the bloblist and, if CONFIG_NAND_BBT_CACHE_FLASH is
+ * enabled, in the next good block of the reserved area on @mtd. The
+ * generation and checksum are updated.
+ *
+ * @mtd: NAND device
+ * @cache: Cache to store, with @nblocks, @erase_shift and @bitmap filled in
+ * @return 0 if OK, -ve on error
+ */
+int nand_bbt_cache_save(struct mtd_info *mtd, struct nand_bbt_cache *cache);
+
+/**
+ * nand_bbt_cache_reserved() - Check if a block holds the bad block cache
+ *
+ * @mtd: NAND device
+ * @block: Eraseblock number
+ * @return true if @block is inside the reserved area
+ */
+bool nand_bbt_cache_reserved(struct mtd_info *mtd, uint block);
+
+/**
+ * nand_bbt_cache_drop_handoff() - Forget the copy of the cache in the bloblist
+ *
+ * @mtd: NAND device
+ */
+void nand_bbt_cache_drop_handoff(struct mtd_info *mtd);
+
+/**
+ * nand_bbt_cache_drop() - Forget the stored bad block cache of a NAND device
+ *
+ * This invalidates the copy in the bloblist and erases the reserved area on
+ * @mtd, so that the next boot scans the device again.
+ *
+ * @mtd: NAND device
+ * @return 0 if OK, -ve on error
+ */
+int nand_bbt_cache_drop(struct mtd_info *mtd);
+
+/**
+ * nand_bbt_cache_rebuild() - Scan a NAND device and store a new cache
+ *
+ * This drops the stored cache, builds the memory bad block table from the
+ * bad block markers of all blocks and stores the result.
+ *
+ * @mtd: NAND device
+ * @return 0 if OK, -ve on error
+ */
+int nand_bbt_cache_rebuild(struct mtd_info *mtd);
+
+/**
+ * nand_bbt_cache_reload() - Build the bad block table from the stored cache
+ *
+ * This drops the copy of the cache in the bloblist and builds the memory bad
+ * block table again, which reads the cache from the reserved area on @mtd if
+ * there is one and scans the device if not.
+ *
+ * @mtd: NAND device
+ * @return 0 if OK, -ve on error
+ */
+int nand_bbt_cache_reload(struct mtd_info *mtd);
+
+/**
+ * nand_bbt_cache_unchecked() - Count blocks known only from the cache
+ *
+ * Blocks which the cache reports good have their bad block marker read when
+ * they are first used. This counts those not used yet.
+ *
+ * @mtd: NAND device
+ * @return number of blocks, or -ENOENT if the bad block table was built by
+ *	scanning the device
+ */
+int nand_bbt_cache_unchecked(struct mtd_info *mtd);
+
 #endif /* _NAND_H_ */
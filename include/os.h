@@ -375,4 +375,32 @@ int os_read_file(const char *name, void **bufp, int *sizep);
  */
 void *os_find_text_base(void);
 
+/**
+ * os_work_start() - Start host threads to stand in for secondary CPUs
+ *
+ * Threads only run functions passed to os_work_submit(). Calling this again
+ * does not start more threads.
+ *
+ * @count:	Number of threads to start
+ * @return number of threads running
+ */
+int os_work_start(int count);
+
+/**
+ * os_work_submit() - Queue a function to run on a host thread
+ *
+ * @func:	Function to run; it must set a flag for os_work_wait() to see
+ * @arg:	Argument to pass to @func
+ * @return 0 if queued, -ENOSPC if the queue is full, -ENODEV if no threads
+ * are running
+ */
+int os_work_submit(void (*func)(void *arg), void *arg);
+
+/**
+ * os_work_wait() - Sleep until a flag set by a queued function is non-zero
+ *
+ * @flag:	Flag to wait for
+ */
+void os_work_wait(volatile int *flag);
+
 #endif
@@ -42,9 +42,18 @@ struct env_entry {
 
 /* Data type for reentrant functions.  */
 struct hsearch_data {
-	struct env_entry_node *table;
-	unsigned int size;
-	unsigned int filled;
+	struct env_entry_node **nodes;	/* blocks of entries, never moved */
+	unsigned int size;		/* number of nodes in @nodes */
+	unsigned int filled;		/* number of entries */
+	unsigned int free_node;		/* first unused node, 0 if none */
+	unsigned int *index;		/* hash table of node numbers */
+	unsigned int index_size;	/* slots in @index, a power of two */
+	unsigned int index_used;	/* slots in use or deleted */
+	unsigned int *old_index;	/* index being rehashed into @index */
+	unsigned int old_size;		/* slots in @old_index */
+	unsigned int rehash_pos;	/* next slot of @old_index to move */
+	struct env_entry_node **sorted;	/* entries in order of their keys */
+	int sorted_valid;		/* @sorted is up to date */
 /*
  * Callback function which will check whether the given change for variable
  * "item" to "newval" may be applied or not, and possibly apply such change.
@@ -56,7 +65,7 @@ struct hsearch_data {
 			 enum env_op, int flag);
 };
 
-/* Create a new hash table which will contain at most "nel" elements.  */
+/* Create a new hash table sized for "nel" elements; it grows as needed.  */
 int hcreate_r(size_t nel, struct hsearch_data *htab);
 
 /* Destroy current internal hash table.  */
@@ -1,6 +1,7 @@
 #ifndef __SERIAL_H__
 #define __SERIAL_H__
 
+#include <membuff.h>
 #include <post.h>
 
 struct serial_device {
@@ -270,6 +271,9 @@ struct dm_serial_ops {
  * @buf:	Pointer to the RX buffer
  * @rd_ptr:	Read pointer in the RX buffer
  * @wr_ptr:	Write pointer in the RX buffer
+ *
+ * @txbuf:	TX buffer, holding output not yet written to the uart
+ * @draining:	true while characters are being moved from @txbuf to the uart
  */
 struct serial_dev_priv {
 	struct stdio_dev *sdev;
@@ -277,6 +281,9 @@ struct serial_dev_priv {
 	char *buf;
 	int rd_ptr;
 	int wr_ptr;
+
+	struct membuff txbuf;
+	bool draining;
 };
 
 /* Access the serial operations for a device */
@@ -315,6 +322,29 @@ int serial_setconfig(struct udevice *dev, uint config);
  */
 int serial_getinfo(struct udevice *dev, struct serial_device_info *info);
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+/**
+ * serial_drain() - Write out buffered console output without waiting
+ *
+ * This moves characters from the TX buffer of the console uart to the uart
+ * until it has no more room. It is called from places which wait anyway,
+ * such as udelay(), so that output keeps flowing while U-Boot is busy.
+ */
+void serial_drain(void);
+
+/**
+ * serial_flush() - Write out all buffered output
+ *
+ * This waits until the TX buffer of every active uart is empty. It must be
+ * called before anything which stops the uart from being used, such as a
+ * reset or starting an OS.
+ */
+void serial_flush(void);
+#else
+static inline void serial_drain(void) {}
+static inline void serial_flush(void) {}
+#endif
+
 void atmel_serial_initialize(void);
 void mcf_serial_initialize(void);
 void mpc85xx_serial_initialize(void);
@@ -155,6 +155,7 @@ struct spl_image_info {
  * @bl_len: Block length for reading in bytes
  * @filename: Name of the fit image file.
  * @read: Function to call to read from the device
+ * @queue: Double-buffered read for the device, or NULL if there is none
  */
 struct spl_load_info {
 	void *dev;
@@ -163,6 +164,28 @@ struct spl_load_info {
 	const char *filename;
 	ulong (*read)(struct spl_load_info *load, ulong sector, ulong count,
 		      void *buf);
+	const struct spl_load_queue *queue;
+};
+
+/*
+ * Double-buffered sequential read from a device
+ *
+ * Devices which can transfer data in the background provide this so that a
+ * loader can work on one chunk while the next one is read. It is used by
+ * spl_load_simple_fit() to decompress images as they are read.
+ *
+ * @start: Start reading @count sectors from @sector into @buf0 and @buf1
+ *	in turn, at most @chunk sectors at a time
+ * @next: Wait for the next chunk and return it in @bufp and @countp. This
+ *	starts reading into the buffer returned by the previous call, which
+ *	the caller must be finished with. @countp is 0 once all is read
+ * @stop: Wait for any read still in flight, so the buffers may be freed
+ */
+struct spl_load_queue {
+	int (*start)(struct spl_load_info *load, ulong sector, ulong count,
+		     void *buf0, void *buf1, ulong chunk);
+	int (*next)(struct spl_load_info *load, void **bufp, ulong *countp);
+	void (*stop)(struct spl_load_info *load);
 };
 
 /*
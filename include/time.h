@@ -113,4 +113,15 @@ unsigned long timer_get_us(void);
  */
 uint64_t get_ticks(void);
 
+/**
+ * get_cpu_cycles() - Get the CPU cycle counter
+ *
+ * This is a free-running counter which may wrap, so subtract two readings
+ * as unsigned long to get the number of cycles between them. It is only
+ * meant for timing short sections of code.
+ *
+ * @return current cycle count, or 0 if the CPU has no usable cycle counter
+ */
+unsigned long get_cpu_cycles(void);
+
 #endif /* _TIME_H */
@@ -93,6 +93,104 @@ uint32_t crc32_no_comp(uint32_t crc, const unsigned char *buf, uint len);
 void crc32_wd_buf(const uint8_t *input, uint ilen, uint8_t *output,
 		  uint chunk_sz);
 
+/**
+ * enum crc32_backend - ways of calculating CRC32 and CRC32C
+ *
+ * @CRC32_BACKEND_BYTE:		One table lookup per byte
+ * @CRC32_BACKEND_SLICE8:	Slice-by-8, eight table lookups per 8 bytes
+ * @CRC32_BACKEND_ARM:		ARMv8 CRC32 instructions
+ */
+enum crc32_backend {
+	CRC32_BACKEND_BYTE,
+	CRC32_BACKEND_SLICE8,
+	CRC32_BACKEND_ARM,
+
+	CRC32_BACKEND_COUNT,
+};
+
+/**
+ * crc32_get_backend() - Get the backend used by crc32() and crc32c_no_comp()
+ *
+ * The fastest available backend is selected on first use after relocation.
+ * Before that the byte-at-a-time table is used.
+ *
+ * @return backend in use
+ */
+enum crc32_backend crc32_get_backend(void);
+
+/**
+ * crc32_backend_available() - Check whether a backend can be used
+ *
+ * @backend:	Backend to check
+ * @return 1 if it is built in and supported by the CPU, 0 if not
+ */
+int crc32_backend_available(enum crc32_backend backend);
+
+/**
+ * crc32_set_backend() - Select the backend used by crc32() and crc32c_no_comp()
+ *
+ * @backend:	Backend to use
+ * @return 0 if OK, -ENOSYS if the backend is not available
+ */
+int crc32_set_backend(enum crc32_backend backend);
+
+/**
+ * crc32_backend_name() - Get the name of a backend
+ *
+ * @backend:	Backend to look up
+ * @return name, or "unknown"
+ */
+const char *crc32_backend_name(enum crc32_backend backend);
+
+/**
+ * crc32_slice8_init() - Set up the tables for crc32_slice8()
+ *
+ * @tab:	Place to put the tables, 8 * 256 entries
+ * @poly:	Bit-reflected polynomial
+ */
+void crc32_slice8_init(uint32_t *tab, uint32_t poly);
+
+/**
+ * crc32_slice8() - Calculate a bit-reflected CRC using slice-by-8
+ *
+ * @crc:	Previous CRC (no one's complement is applied)
+ * @buf:	Data to checksum
+ * @len:	Number of bytes to process
+ * @tab:	Tables set up by crc32_slice8_init()
+ * @return CRC value
+ */
+uint32_t crc32_slice8(uint32_t crc, const uint8_t *buf, uint len,
+		      const uint32_t *tab);
+
+/**
+ * crc32_arm_available() - Check for the ARMv8 CRC32 instructions
+ *
+ * arch/arm/lib/crc32.c
+ *
+ * @return 1 if the CPU has them, 0 if not
+ */
+int crc32_arm_available(void);
+
+/**
+ * crc32_arm() - Calculate a CRC32 using the ARMv8 CRC32 instructions
+ *
+ * @crc:	Previous CRC (no one's complement is applied)
+ * @buf:	Data to checksum
+ * @len:	Number of bytes to process
+ * @return CRC value
+ */
+uint32_t crc32_arm(uint32_t crc, const uint8_t *buf, uint len);
+
+/**
+ * crc32c_arm() - Calculate a CRC32C using the ARMv8 CRC32 instructions
+ *
+ * @crc:	Previous CRC (no one's complement is applied)
+ * @buf:	Data to checksum
+ * @len:	Number of bytes to process
+ * @return CRC value
+ */
+uint32_t crc32c_arm(uint32_t crc, const uint8_t *buf, uint len);
+
 /* lib/crc32c.c */
 
 /**
@@ -118,6 +216,18 @@ void crc32c_init(uint32_t *crc32c_table, uint32_t pol);
  * @return checksum value
  */
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
-		    uint32_t *crc32c_table);
+		    const uint32_t *crc32c_table);
+
+/**
+ * crc32c_no_comp() - Calculate the CRC32C (Castagnoli) of a buffer
+ *
+ * This uses the backend selected for crc32(), with tables of its own.
+ *
+ * @crc: Previous crc (no one's complement is applied)
+ * @buf: Data bytes to checksum
+ * @len: Number of bytes to process
+ * @return checksum value
+ */
+uint32_t crc32c_no_comp(uint32_t crc, const void *buf, uint len);
 
 #endif /* _UBOOT_CRC_H */
@@ -81,6 +81,33 @@ void sha1_csum(const unsigned char *input, unsigned int ilen,
 void sha1_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/**
+ * sha1_ce_available() - Check for the ARMv8 SHA-1 instructions
+ *
+ * @return non-zero if ID_AA64ISAR0_EL1 reports the SHA-1 instructions
+ */
+int sha1_ce_available(void);
+
+/**
+ * sha1_ce_transform() - Run SHA-1 blocks with the ARMv8 instructions
+ *
+ * @state:	Intermediate digest, updated in place
+ * @data:	Input, @blocks * 64 bytes
+ * @blocks:	Number of 64-byte blocks to process (must be non-zero)
+ */
+void sha1_ce_transform(uint32_t state[5], const unsigned char *data,
+		       unsigned int blocks);
+
+/**
+ * sha1_armv7_transform() - Run SHA-1 blocks with scalar ARM code
+ *
+ * @state:	Intermediate digest, updated in place
+ * @data:	Input, @blocks * 64 bytes, with any alignment
+ * @blocks:	Number of 64-byte blocks to process (must be non-zero)
+ */
+void sha1_armv7_transform(uint32_t state[5], const unsigned char *data,
+			  unsigned int blocks);
+
 /**
  * \brief	   Output = HMAC-SHA-1( input buffer, hmac key )
  *
@@ -22,4 +22,31 @@ void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/**
+ * sha256_ce_available() - Check for the ARMv8 SHA-256 instructions
+ *
+ * @return non-zero if ID_AA64ISAR0_EL1 reports the SHA-256 instructions
+ */
+int sha256_ce_available(void);
+
+/**
+ * sha256_ce_transform() - Run SHA-256 blocks with the ARMv8 instructions
+ *
+ * @state:	Intermediate digest, updated in place
+ * @data:	Input, @blocks * 64 bytes
+ * @blocks:	Number of 64-byte blocks to process (must be non-zero)
+ */
+void sha256_ce_transform(uint32_t state[8], const uint8_t *data,
+			 unsigned int blocks);
+
+/**
+ * sha256_armv7_transform() - Run SHA-256 blocks with scalar ARM code
+ *
+ * @state:	Intermediate digest, updated in place
+ * @data:	Input, @blocks * 64 bytes, with any alignment
+ * @blocks:	Number of 64-byte blocks to process (must be non-zero)
+ */
+void sha256_armv7_transform(uint32_t state[8], const uint8_t *data,
+			    unsigned int blocks);
+
 #endif /* _SHA256_H */
@@ -661,6 +661,13 @@ ZEXTERN int ZEXPORT inflateEnd OF((z_streamp strm));
 
 ZEXTERN int ZEXPORT inflateReset OF((z_streamp strm));
 
+/*
+     U-Boot: stops inflate() from resetting the watchdog, which it otherwise
+   does once per block. This is needed when it runs on a secondary CPU. The
+   caller must then reset the watchdog itself.
+*/
+ZEXTERN int ZEXPORT inflateNoWatchdog OF((z_streamp strm));
+
                         /* utility functions */
 
 /*
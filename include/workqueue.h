@@ -0,0 +1,159 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Running work items on secondary CPUs
+ */
+
+#ifndef __WORKQUEUE_H
+#define __WORKQUEUE_H
+
+/**
+ * struct work - A function call which may run on another CPU
+ *
+ * Work items are owned by the caller, typically on its stack, and must stay
+ * valid until work_wait() returns for them. The function runs without the
+ * console or malloc(), neither of which may be used from a secondary CPU;
+ * anything it needs must be set up before it is queued.
+ *
+ * @func:	Function to run
+ * @arg:	Argument to pass to @func
+ * @ret:	Return value of @func, valid once @done is set
+ * @done:	Set (with a barrier) once @func has returned
+ */
+struct work {
+	int (*func)(void *arg);
+	void *arg;
+	int ret;
+	volatile int done;
+};
+
+#if CONFIG_IS_ENABLED(WORK_QUEUE)
+/**
+ * work_cpus() - Get the number of CPUs available to run work
+ *
+ * @return number of secondary CPUs which accept work, 0 if work runs on the
+ * calling CPU only
+ */
+int work_cpus(void);
+
+/**
+ * work_queue() - Queue a function call
+ *
+ * The call is handed to a secondary CPU if one is available and its queue
+ * has room. Otherwise it runs on the calling CPU before this returns, so
+ * the caller does not need a fallback path.
+ *
+ * @work:	Work item to fill in and queue
+ * @func:	Function to run
+ * @arg:	Argument to pass to @func
+ */
+void work_queue(struct work *work, int (*func)(void *arg), void *arg);
+
+/**
+ * work_wait() - Wait for a work item to finish
+ *
+ * @work:	Work item previously passed to work_queue()
+ * @return value returned by the work function
+ */
+int work_wait(struct work *work);
+
+/**
+ * work_wait_all() - Wait for a number of work items to finish
+ *
+ * This is a completion barrier: all items have finished when it returns,
+ * even if some of them failed.
+ *
+ * @work:	Array of work items previously passed to work_queue()
+ * @count:	Number of items in @work
+ * @return 0 if all functions returned 0, else the first non-zero return
+ * value in array order
+ */
+int work_wait_all(struct work *work, int count);
+
+/**
+ * work_run() - Run a work item and mark it done
+ *
+ * This is for use by the code which runs work on secondary CPUs.
+ *
+ * @work:	Work item to run
+ */
+void work_run(struct work *work);
+
+/**
+ * work_stop() - Hand the secondary CPUs back before booting an OS
+ *
+ * All queued work must have been waited for. Work queued afterwards runs on
+ * the calling CPU.
+ */
+void work_stop(void);
+
+/*
+ * CPU backend hooks, provided by arch/sandbox/cpu/workqueue.c and
+ * arch/arm/cpu/armv8/workqueue.c
+ */
+
+/**
+ * arch_work_cpus() - Get the number of secondary CPUs which accept work
+ *
+ * @return number of CPUs, 0 if none
+ */
+int arch_work_cpus(void);
+
+/**
+ * arch_work_submit() - Hand a work item to a secondary CPU
+ *
+ * The secondary CPU must call work_run() on the item.
+ *
+ * @work:	Work item to run
+ * @return 0 if queued, -ve if it must run on the calling CPU instead
+ */
+int arch_work_submit(struct work *work);
+
+/**
+ * arch_work_wait() - Wait until a queued work item is done
+ *
+ * @work:	Work item to wait for
+ */
+void arch_work_wait(struct work *work);
+
+/**
+ * arch_work_stop() - Give the secondary CPUs back to the firmware
+ */
+void arch_work_stop(void);
+#else
+static inline int work_cpus(void)
+{
+	return 0;
+}
+
+static inline void work_queue(struct work *work, int (*func)(void *arg),
+			      void *arg)
+{
+	work->func = func;
+	work->arg = arg;
+	work->ret = func(arg);
+	work->done = 1;
+}
+
+static inline int work_wait(struct work *work)
+{
+	return work->ret;
+}
+
+static inline int work_wait_all(struct work *work, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (work[i].ret)
+			return work[i].ret;
+	}
+
+	return 0;
+}
+
+static inline void work_stop(void)
+{
+}
+#endif
+
+#endif /* __WORKQUEUE_H */
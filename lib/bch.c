@@ -336,25 +336,30 @@ static inline int parity(unsigned int x)
 	return (x >> 28) & 1;
 }
 
-/* Galois field basic operations: multiply, divide, inverse, etc. */
+/*
+ * Galois field basic operations: multiply, divide, inverse, etc.
+ *
+ * a_pow_tab holds 2n+1 entries, so that a sum of two logarithms can be used
+ * as an index without reducing it modulo n first.
+ */
 
 static inline unsigned int gf_mul(struct bch_control *bch, unsigned int a,
 				  unsigned int b)
 {
-	return (a && b) ? bch->a_pow_tab[mod_s(bch, bch->a_log_tab[a]+
-					       bch->a_log_tab[b])] : 0;
+	return (a && b) ? bch->a_pow_tab[bch->a_log_tab[a]+
+					 bch->a_log_tab[b]] : 0;
 }
 
 static inline unsigned int gf_sqr(struct bch_control *bch, unsigned int a)
 {
-	return a ? bch->a_pow_tab[mod_s(bch, 2*bch->a_log_tab[a])] : 0;
+	return a ? bch->a_pow_tab[2*bch->a_log_tab[a]] : 0;
 }
 
 static inline unsigned int gf_div(struct bch_control *bch, unsigned int a,
 				  unsigned int b)
 {
-	return a ? bch->a_pow_tab[mod_s(bch, bch->a_log_tab[a]+
-					GF_N(bch)-bch->a_log_tab[b])] : 0;
+	return a ? bch->a_pow_tab[bch->a_log_tab[a]+
+				  GF_N(bch)-bch->a_log_tab[b]] : 0;
 }
 
 static inline unsigned int gf_inv(struct bch_control *bch, unsigned int a)
@@ -379,35 +384,49 @@ static inline int a_ilog(struct bch_control *bch, unsigned int x)
 
 /*
  * compute 2t syndromes of ecc polynomial, i.e. ecc(a^j) for j=1..2t
+ *
+ * Odd syndromes are evaluated with Horner's rule one byte at a time: each step
+ * multiplies the partial result by a^(8j) and adds the precomputed value of
+ * the next byte at a^j, instead of adding a^(j*i) for every set bit i.
  */
 static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 			      unsigned int *syn)
 {
-	int i, j, s;
-	unsigned int m;
+	int i, j, k, l, pad;
+	unsigned int m, b, *s;
 	uint32_t poly;
 	const int t = GF_T(bch);
-
-	s = bch->ecc_bits;
+	const int n = GF_N(bch);
+	const unsigned int words = DIV_ROUND_UP(bch->ecc_bits, 32);
+	const uint16_t *tab;
 
 	/* make sure extra bits in last ecc word are cleared */
-	m = ((unsigned int)s) & 31;
+	m = bch->ecc_bits & 31;
 	if (m)
-		ecc[s/32] &= ~((1u << (32-m))-1);
+		ecc[bch->ecc_bits/32] &= ~((1u << (32-m))-1);
 	memset(syn, 0, 2*t*sizeof(*syn));
 
-	/* compute v(a^j) for j=1 .. 2t-1 */
-	do {
-		poly = *ecc++;
-		s -= 32;
-		while (poly) {
-			i = deg(poly);
-			for (j = 0; j < 2*t; j += 2)
-				syn[j] ^= a_pow(bch, (j+1)*(i+s));
-
-			poly ^= (1 << i);
+	/* compute v(a^j).a^(j.pad) for j=1 .. 2t-1 */
+	for (i = 0; i < (int)words; i++) {
+		poly = ecc[i];
+		for (k = 24; k >= 0; k -= 8) {
+			b = (poly >> k) & 0xff;
+			tab = bch->syn_tab;
+			for (j = 0, l = 8; j < 2*t; j += 2, l = mod_s(bch, l+16)) {
+				s = &syn[j];
+				*s = (*s ? bch->a_pow_tab[a_log(bch, *s)+l] : 0)^
+					tab[b];
+				tab += 256;
+			}
 		}
-	} while (s > 0);
+	}
+
+	/* remove the zero padding following the last ecc bit */
+	pad = 32*words-bch->ecc_bits;
+	for (j = 0; j < 2*t; j += 2)
+		if (syn[j])
+			syn[j] = a_pow(bch, a_log(bch, syn[j])+
+				       (n-(j+1)*pad%n));
 
 	/* v(a^(2j)) = v(a^j)^2 */
 	for (j = 0; j < t; j++)
@@ -778,8 +797,7 @@ static void gf_poly_mod(struct bch_control *bch, struct gf_poly *a,
 			for (i = 0; i < d; i++, p++) {
 				m = rep[i];
 				if (m >= 0)
-					c[p] ^= bch->a_pow_tab[mod_s(bch,
-								     m+la)];
+					c[p] ^= bch->a_pow_tab[m+la];
 			}
 		}
 	}
@@ -1112,12 +1130,32 @@ static int build_gf_tables(struct bch_control *bch, unsigned int poly)
 		if (x & k)
 			x ^= poly;
 	}
-	bch->a_pow_tab[GF_N(bch)] = 1;
+	/* duplicate the table to avoid reductions in gf_mul() and friends */
+	for (i = GF_N(bch); i <= 2*GF_N(bch); i++)
+		bch->a_pow_tab[i] = bch->a_pow_tab[i-GF_N(bch)];
 	bch->a_log_tab[0] = 0;
 
 	return 0;
 }
 
+/*
+ * compute byte value tables for fast syndrome computation
+ */
+static void build_syn_tables(struct bch_control *bch)
+{
+	unsigned int i, j, b;
+	uint16_t *tab = bch->syn_tab;
+
+	for (j = 1; j < 2*GF_T(bch); j += 2, tab += 256) {
+		tab[0] = 0;
+		/* tab[b] = b(a^j), built from the value without its top bit */
+		for (b = 1; b < 256; b++) {
+			i = deg(b);
+			tab[b] = tab[b ^ (1 << i)]^a_pow(bch, j*i);
+		}
+	}
+}
+
 /*
  * compute generator polynomial remainder tables for fast encoding
  */
@@ -1341,9 +1379,10 @@ struct bch_control *init_bch(int m, int t, unsigned int prim_poly)
 	bch->n = (1 << m)-1;
 	words  = DIV_ROUND_UP(m*t, 32);
 	bch->ecc_bytes = DIV_ROUND_UP(m*t, 8);
-	bch->a_pow_tab = bch_alloc((1+bch->n)*sizeof(*bch->a_pow_tab), &err);
+	bch->a_pow_tab = bch_alloc((1+2*bch->n)*sizeof(*bch->a_pow_tab), &err);
 	bch->a_log_tab = bch_alloc((1+bch->n)*sizeof(*bch->a_log_tab), &err);
 	bch->mod8_tab  = bch_alloc(words*1024*sizeof(*bch->mod8_tab), &err);
+	bch->syn_tab   = bch_alloc(t*256*sizeof(*bch->syn_tab), &err);
 	bch->ecc_buf   = bch_alloc(words*sizeof(*bch->ecc_buf), &err);
 	bch->ecc_buf2  = bch_alloc(words*sizeof(*bch->ecc_buf2), &err);
 	bch->xi_tab    = bch_alloc(m*sizeof(*bch->xi_tab), &err);
@@ -1369,6 +1408,8 @@ struct bch_control *init_bch(int m, int t, unsigned int prim_poly)
 	build_mod8_tables(bch, genpoly);
 	kfree(genpoly);
 
+	build_syn_tables(bch);
+
 	err = build_deg2_base(bch);
 	if (err)
 		goto fail;
@@ -1392,6 +1433,7 @@ void free_bch(struct bch_control *bch)
 		kfree(bch->a_pow_tab);
 		kfree(bch->a_log_tab);
 		kfree(bch->mod8_tab);
+		kfree(bch->syn_tab);
 		kfree(bch->ecc_buf);
 		kfree(bch->ecc_buf2);
 		kfree(bch->xi_tab);
@@ -10,10 +10,10 @@
 
 #ifdef USE_HOSTCC
 #include <arpa/inet.h>
+#include <errno.h>
 #include <u-boot/crc.h>
 #else
 #include <common.h>
-#include <efi_loader.h>
 #endif
 #include <compiler.h>
 #include <u-boot/crc.h>
@@ -24,17 +24,28 @@
 #include "u-boot/zlib.h"
 
 #ifdef USE_HOSTCC
-#define __efi_runtime
-#define __efi_runtime_data
+#define CRC32_SLICE8	1
+#define CRC32_ARM	0
+#elif defined(CONFIG_SPL_BUILD)
+/* SPL keeps to the byte table, which needs no RAM */
+#define CRC32_SLICE8	0
+#define CRC32_ARM	0
+#else
+#define CRC32_SLICE8	IS_ENABLED(CONFIG_CRC32_SLICE_BY_8)
+#define CRC32_ARM	IS_ENABLED(CONFIG_CRC32_ARM)
+#endif
+
+#ifndef USE_HOSTCC
+DECLARE_GLOBAL_DATA_PTR;
 #endif
 
 #define tole(x) cpu_to_le32(x)
 
 #ifdef CONFIG_DYNAMIC_CRC_TABLE
 
-static int __efi_runtime_data crc_table_empty = 1;
-static uint32_t __efi_runtime_data crc_table[256];
-static void __efi_runtime make_crc_table OF((void));
+static int crc_table_empty = 1;
+static uint32_t crc_table[256];
+static void make_crc_table OF((void));
 
 /*
   Generate a table for a byte-wise 32-bit CRC calculation on the polynomial:
@@ -60,13 +71,13 @@ static void __efi_runtime make_crc_table OF((void));
   the information needed to generate CRC's on data a byte at a time for all
   combinations of CRC register values and incoming bytes.
 */
-static void __efi_runtime make_crc_table(void)
+static void make_crc_table(void)
 {
   uint32_t c;
   int n, k;
   uLong poly;		/* polynomial exclusive-or pattern */
   /* terms of polynomial defining this crc (except x^32): */
-  static Byte __efi_runtime_data p[] = {
+  static Byte p[] = {
 		0, 1, 2, 4, 5, 7, 8, 10, 11, 12, 16, 22, 23, 26};
 
   /* make exclusive-or pattern from polynomial (0xedb88320L) */
@@ -88,7 +99,7 @@ static void __efi_runtime make_crc_table(void)
  * Table of CRC-32's of all single-byte values (made by make_crc_table)
  */
 
-static const uint32_t __efi_runtime_data crc_table[256] = {
+static const uint32_t crc_table[256] = {
 tole(0x00000000L), tole(0x77073096L), tole(0xee0e612cL), tole(0x990951baL),
 tole(0x076dc419L), tole(0x706af48fL), tole(0xe963a535L), tole(0x9e6495a3L),
 tole(0x0edb8832L), tole(0x79dcb8a4L), tole(0xe0d5e91eL), tole(0x97d2d988L),
@@ -178,10 +189,8 @@ const uint32_t * ZEXPORT get_crc_table()
 
 /* ========================================================================= */
 
-/* No ones complement version. JFFS2 (and other things ?)
- * don't use ones compliment in their CRC calculations.
- */
-uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+/* Byte-at-a-time version, which needs no setup */
+static uint32_t crc32_byte(uint32_t crc, const Bytef *buf, uInt len)
 {
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
@@ -223,7 +232,160 @@ uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 }
 #undef DO_CRC
 
-uint32_t __efi_runtime crc32(uint32_t crc, const Bytef *p, uInt len)
+/*
+ * Slice-by-8: tab[0] is the usual byte table, in CPU order, and entry n of
+ * tab[k] is the CRC of byte n followed by k zero bytes. Eight lookups then
+ * advance the CRC over eight bytes of input at once.
+ */
+void crc32_slice8_init(uint32_t *tab, uint32_t poly)
+{
+	uint32_t c;
+	int n, k;
+
+	for (n = 0; n < 256; n++) {
+		c = n;
+		for (k = 0; k < 8; k++)
+			c = c & 1 ? poly ^ (c >> 1) : c >> 1;
+		tab[n] = c;
+	}
+	for (k = 1; k < 8; k++) {
+		for (n = 0; n < 256; n++) {
+			c = tab[(k - 1) * 256 + n];
+			tab[k * 256 + n] = (c >> 8) ^ tab[c & 0xff];
+		}
+	}
+}
+
+uint32_t crc32_slice8(uint32_t crc, const uint8_t *buf, uint len,
+		      const uint32_t *tab)
+{
+	uint32_t one, two;
+
+	for (; len && ((long)buf & 3); len--)
+		crc = tab[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+	for (; len >= 8; len -= 8, buf += 8) {
+		one = le32_to_cpu(*(const uint32_t *)buf) ^ crc;
+		two = le32_to_cpu(*(const uint32_t *)(buf + 4));
+		crc = tab[7 * 256 + (one & 0xff)] ^
+		      tab[6 * 256 + ((one >> 8) & 0xff)] ^
+		      tab[5 * 256 + ((one >> 16) & 0xff)] ^
+		      tab[4 * 256 + (one >> 24)] ^
+		      tab[3 * 256 + (two & 0xff)] ^
+		      tab[2 * 256 + ((two >> 8) & 0xff)] ^
+		      tab[1 * 256 + ((two >> 16) & 0xff)] ^
+		      tab[two >> 24];
+	}
+
+	for (; len; len--)
+		crc = tab[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+/*
+ * No EFI runtime service calculates a CRC: the EFI table headers are only
+ * updated at boot time and by SetVirtualAddressMap(), which still runs with
+ * physical addresses. So none of this is in the EFI runtime sections.
+ */
+#if CRC32_SLICE8
+static uint32_t crc32_slice8_table[8 * 256];
+#endif
+
+/*
+ * CRC32_BACKEND_COUNT means no choice has been made yet. This is not zero so
+ * that it lives in .data, which can be read before relocation.
+ */
+static enum crc32_backend crc32_backend = CRC32_BACKEND_COUNT;
+
+int crc32_backend_available(enum crc32_backend backend)
+{
+	switch (backend) {
+	case CRC32_BACKEND_BYTE:
+		return 1;
+	case CRC32_BACKEND_SLICE8:
+		return CRC32_SLICE8;
+#if CRC32_ARM
+	case CRC32_BACKEND_ARM:
+		return crc32_arm_available();
+#endif
+	default:
+		return 0;
+	}
+}
+
+static void crc32_use_backend(enum crc32_backend backend)
+{
+#if CRC32_SLICE8
+	if (backend == CRC32_BACKEND_SLICE8 && !crc32_slice8_table[1])
+		crc32_slice8_init(crc32_slice8_table, 0xedb88320);
+#endif
+	crc32_backend = backend;
+}
+
+int crc32_set_backend(enum crc32_backend backend)
+{
+	if (!crc32_backend_available(backend))
+		return -ENOSYS;
+	crc32_use_backend(backend);
+
+	return 0;
+}
+
+enum crc32_backend crc32_get_backend(void)
+{
+	if (crc32_backend != CRC32_BACKEND_COUNT)
+		return crc32_backend;
+
+#ifndef USE_HOSTCC
+	/* The slice-by-8 tables are in BSS */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return CRC32_BACKEND_BYTE;
+#endif
+	if (crc32_backend_available(CRC32_BACKEND_ARM))
+		crc32_use_backend(CRC32_BACKEND_ARM);
+	else if (crc32_backend_available(CRC32_BACKEND_SLICE8))
+		crc32_use_backend(CRC32_BACKEND_SLICE8);
+	else
+		crc32_use_backend(CRC32_BACKEND_BYTE);
+
+	return crc32_backend;
+}
+
+const char *crc32_backend_name(enum crc32_backend backend)
+{
+	static const char *const names[CRC32_BACKEND_COUNT] = {
+		"byte",
+		"slice-by-8",
+		"armv8-crc",
+	};
+
+	if (backend >= CRC32_BACKEND_COUNT)
+		return "unknown";
+
+	return names[backend];
+}
+
+/* No ones complement version. JFFS2 (and other things ?)
+ * don't use ones compliment in their CRC calculations.
+ */
+uint32_t crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+{
+	switch (crc32_get_backend()) {
+#if CRC32_ARM
+	case CRC32_BACKEND_ARM:
+		return crc32_arm(crc, buf, len);
+#endif
+#if CRC32_SLICE8
+	case CRC32_BACKEND_SLICE8:
+		return crc32_slice8(crc, buf, len, crc32_slice8_table);
+#endif
+	default:
+		return crc32_byte(crc, buf, len);
+	}
+}
+
+uint32_t crc32(uint32_t crc, const Bytef *p, uInt len)
 {
      return crc32_no_comp(crc ^ 0xffffffffL, p, len) ^ 0xffffffffL;
 }
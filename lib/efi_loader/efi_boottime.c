@@ -17,6 +17,7 @@
 #include <pe.h>
 #include <u-boot/crc.h>
 #include <watchdog.h>
+#include <workqueue.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -1989,6 +1990,9 @@ static efi_status_t EFIAPI efi_exit_boot_services(efi_handle_t image_handle,
 
 	board_quiesce_devices();
 
+	/* The secondary CPUs belong to the operating system from here on */
+	work_stop();
+
 	/* Patch out unsupported runtime function */
 	efi_runtime_detach();
 
@@ -118,9 +118,12 @@ efi_status_t efi_init_runtime_supported(void)
 /**
  * efi_update_table_header_crc32() - Update crc32 in table header
  *
+ * This is only called at boot time and from SetVirtualAddressMap(), which
+ * runs before the switch to virtual addresses, so it is not runtime code.
+ *
  * @table:	EFI table
  */
-void __efi_runtime efi_update_table_header_crc32(struct efi_table_hdr *table)
+void efi_update_table_header_crc32(struct efi_table_hdr *table)
 {
 	table->crc32 = 0;
 	table->crc32 = crc32(0, (const unsigned char *)table,
@@ -0,0 +1,406 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Index of a flat device tree
+ *
+ * libfdt finds a property by walking the properties of a node and comparing
+ * each name, a phandle or compatible string by walking the whole tree, and
+ * the parent of a node by walking down from the root. This builds tables
+ * once so that these are much quicker, which helps driver model bind
+ * devices before relocation.
+ */
+
+#define LOG_CATEGORY	LOGC_DT
+
+#include <common.h>
+#include <fdtdec.h>
+#include <malloc.h>
+#include <sort.h>
+#include <linux/libfdt.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* The index was allocated with malloc() */
+#define FDTDEC_INDEXF_ALLOC	(1 << 0)
+
+/*
+ * Phandles are normally allocated from 1 by dtc. If they are too sparse for
+ * a table indexed by phandle, phandle lookups walk the tree instead.
+ */
+#define FDTDEC_INDEX_SPARE_PHANDLES	64
+
+/**
+ * struct fdtdec_index_node - information about a node
+ *
+ * @offset: Offset of the node in the tree
+ * @parent: Offset of its parent, -FDT_ERR_NOTFOUND for the root node
+ * @first_prop: Index of its first property in the property table; the
+ *	properties of the node end where those of the next node start
+ */
+struct fdtdec_index_node {
+	s32 offset;
+	s32 parent;
+	u32 first_prop;
+};
+
+/**
+ * struct fdtdec_index_ent - a property, or a node with a compatible string
+ *
+ * @hash: Hash of the property name or compatible string
+ * @offset: Offset of the property, or of the node
+ */
+struct fdtdec_index_ent {
+	u32 hash;
+	s32 offset;
+};
+
+/**
+ * struct fdtdec_index - index of a flat device tree
+ *
+ * This is followed by the tables, in this order:
+ *	struct fdtdec_index_node nodes[node_count + 1], the last one only
+ *		giving the end of the property table
+ *	struct fdtdec_index_ent props[prop_count]
+ *	struct fdtdec_index_ent compats[compat_count], sorted by hash then
+ *		node offset
+ *	s32 phandles[phandle_count], the offset of the node for each phandle
+ *		or -FDT_ERR_NOTFOUND
+ *
+ * @blob: Device tree which this indexes
+ * @size: Size of the index including the tables, in bytes
+ * @flags: FDTDEC_INDEXF_...
+ * @node_count: Number of nodes
+ * @prop_count: Number of properties
+ * @compat_count: Number of compatible strings
+ * @phandle_count: Number of entries in the phandle table (largest phandle
+ *	plus 1), or 0 to walk the tree
+ */
+struct fdtdec_index {
+	const void *blob;
+	u32 size;
+	u32 flags;
+	u32 node_count;
+	u32 prop_count;
+	u32 compat_count;
+	u32 phandle_count;
+};
+
+static inline struct fdtdec_index_node *
+fdtdec_index_nodes(const struct fdtdec_index *idx)
+{
+	return (struct fdtdec_index_node *)(idx + 1);
+}
+
+static inline struct fdtdec_index_ent *
+fdtdec_index_props(const struct fdtdec_index *idx)
+{
+	return (struct fdtdec_index_ent *)(fdtdec_index_nodes(idx) +
+					   idx->node_count + 1);
+}
+
+static inline struct fdtdec_index_ent *
+fdtdec_index_compats(const struct fdtdec_index *idx)
+{
+	return fdtdec_index_props(idx) + idx->prop_count;
+}
+
+static inline s32 *fdtdec_index_phandles(const struct fdtdec_index *idx)
+{
+	return (s32 *)(fdtdec_index_compats(idx) + idx->compat_count);
+}
+
+/* FNV-1a, which is quick and good enough to make collisions rare */
+static u32 fdtdec_index_hash(const char *str)
+{
+	u32 hash = 2166136261U;
+
+	for (; *str; str++)
+		hash = (hash ^ (u8)*str) * 16777619U;
+
+	return hash;
+}
+
+/* Get the index for @blob, or NULL if there is none */
+static const struct fdtdec_index *fdtdec_index_get(const void *blob)
+{
+	const struct fdtdec_index *idx = gd->fdt_index;
+
+	return idx && idx->blob == blob ? idx : NULL;
+}
+
+/* Find the entry for the node at @offset, or NULL if there is none */
+static const struct fdtdec_index_node *
+fdtdec_index_find_node(const struct fdtdec_index *idx, int offset)
+{
+	const struct fdtdec_index_node *nodes = fdtdec_index_nodes(idx);
+	int low = 0, high = idx->node_count;
+
+	while (low < high) {
+		int mid = (low + high) / 2;
+
+		if (nodes[mid].offset == offset)
+			return &nodes[mid];
+		if (nodes[mid].offset < offset)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return NULL;
+}
+
+static int fdtdec_index_compat_cmp(const void *s1, const void *s2)
+{
+	const struct fdtdec_index_ent *e1 = s1, *e2 = s2;
+
+	if (e1->hash != e2->hash)
+		return e1->hash < e2->hash ? -1 : 1;
+
+	return e1->offset - e2->offset;
+}
+
+/* Count the strings in a compatible property */
+static int fdtdec_index_count_compats(const void *blob, int node)
+{
+	const char *list;
+	int len, count, i;
+
+	list = fdt_getprop(blob, node, "compatible", &len);
+	if (!list)
+		return 0;
+	for (i = 0, count = 0; i < len; i += strnlen(list + i, len - i) + 1)
+		count++;
+
+	return count;
+}
+
+int fdtdec_index_init(const void *blob)
+{
+	u32 node_count = 0, prop_count = 0, compat_count = 0, max_phandle = 0;
+	int parent[FDT_MAX_DEPTH];
+	struct fdtdec_index_ent *props, *compats;
+	struct fdtdec_index_node *nodes;
+	struct fdtdec_index *idx;
+	const char *list, *name;
+	int node, depth, prop, len, i;
+	u32 phandle, size, hash;
+	s32 *phandles;
+
+	if (fdtdec_index_get(blob))
+		return 0;
+	if (fdt_check_header(blob))
+		return -EINVAL;
+
+	/* Work out how big the tables are */
+	for (node = 0, depth = 0; node >= 0 && depth >= 0;
+	     node = fdt_next_node(blob, node, &depth)) {
+		if (depth >= FDT_MAX_DEPTH)
+			return -EINVAL;
+		node_count++;
+		fdt_for_each_property_offset(prop, blob, node)
+			prop_count++;
+		compat_count += fdtdec_index_count_compats(blob, node);
+		phandle = fdt_get_phandle(blob, node);
+		if (phandle != (u32)-1 && phandle > max_phandle)
+			max_phandle = phandle;
+	}
+	if (node < 0 && node != -FDT_ERR_NOTFOUND)
+		return -EINVAL;
+	if (max_phandle > 2 * node_count + FDTDEC_INDEX_SPARE_PHANDLES)
+		max_phandle = 0;
+
+	size = sizeof(*idx) + (node_count + 1) * sizeof(*nodes) +
+		(prop_count + compat_count) * sizeof(*props);
+	if (max_phandle)
+		size += (max_phandle + 1) * sizeof(*phandles);
+	idx = malloc(size);
+	if (!idx) {
+		log_debug("No memory for index of %d nodes (%d bytes)\n",
+			  node_count, size);
+		return -ENOMEM;
+	}
+	idx->blob = blob;
+	idx->size = size;
+	idx->flags = FDTDEC_INDEXF_ALLOC;
+	idx->node_count = node_count;
+	idx->prop_count = prop_count;
+	idx->compat_count = compat_count;
+	idx->phandle_count = max_phandle ? max_phandle + 1 : 0;
+
+	nodes = fdtdec_index_nodes(idx);
+	props = fdtdec_index_props(idx);
+	compats = fdtdec_index_compats(idx);
+	phandles = fdtdec_index_phandles(idx);
+	for (i = 0; i < idx->phandle_count; i++)
+		phandles[i] = -FDT_ERR_NOTFOUND;
+
+	parent[0] = -FDT_ERR_NOTFOUND;
+	prop_count = 0;
+	compat_count = 0;
+	for (node = 0, depth = 0; node >= 0 && depth >= 0;
+	     node = fdt_next_node(blob, node, &depth), nodes++) {
+		if (depth + 1 < FDT_MAX_DEPTH)
+			parent[depth + 1] = node;
+		nodes->offset = node;
+		nodes->parent = parent[depth];
+		nodes->first_prop = prop_count;
+
+		fdt_for_each_property_offset(prop, blob, node) {
+			name = NULL;
+			fdt_getprop_by_offset(blob, prop, &name, NULL);
+			props[prop_count].hash = name ?
+				fdtdec_index_hash(name) : 0;
+			props[prop_count++].offset = prop;
+		}
+
+		list = fdt_getprop(blob, node, "compatible", &len);
+		for (i = 0; list && i < len;
+		     i += strnlen(list + i, len - i) + 1) {
+			hash = fdtdec_index_hash(list + i);
+			compats[compat_count].hash = hash;
+			compats[compat_count++].offset = node;
+		}
+
+		phandle = fdt_get_phandle(blob, node);
+		if (phandle && phandle < idx->phandle_count &&
+		    phandles[phandle] < 0)
+			phandles[phandle] = node;
+	}
+	nodes->offset = -FDT_ERR_NOTFOUND;
+	nodes->parent = -FDT_ERR_NOTFOUND;
+	nodes->first_prop = prop_count;
+	qsort(compats, compat_count, sizeof(*compats),
+	      fdtdec_index_compat_cmp);
+
+	gd->fdt_index = idx;
+	log_debug("Indexed %d nodes, %d properties in %d bytes\n",
+		  idx->node_count, idx->prop_count, idx->size);
+
+	return 0;
+}
+
+void fdtdec_index_invalidate(const void *blob)
+{
+	struct fdtdec_index *idx = gd->fdt_index;
+
+	if (!idx || idx->blob != blob)
+		return;
+	gd->fdt_index = NULL;
+	if (idx->flags & FDTDEC_INDEXF_ALLOC)
+		free(idx);
+}
+
+int fdtdec_index_size(void)
+{
+	return gd->fdt_index ? gd->fdt_index->size : 0;
+}
+
+void fdtdec_index_relocate(void *new_index)
+{
+	struct fdtdec_index *idx = new_index;
+
+	if (!gd->fdt_index)
+		return;
+
+	/* The tree has been copied, so the offsets are still correct */
+	memcpy(idx, gd->fdt_index, gd->fdt_index->size);
+	idx->blob = gd->fdt_blob;
+	idx->flags &= ~FDTDEC_INDEXF_ALLOC;
+	gd->fdt_index = idx;
+}
+
+const void *fdtdec_getprop(const void *blob, int node, const char *name,
+			   int *lenp)
+{
+	const struct fdtdec_index *idx = fdtdec_index_get(blob);
+	const struct fdtdec_index_node *ent;
+	const struct fdtdec_index_ent *props;
+	const char *pname;
+	const void *val;
+	u32 hash, i;
+	int len;
+
+	ent = idx ? fdtdec_index_find_node(idx, node) : NULL;
+	if (!ent)
+		return fdt_getprop(blob, node, name, lenp);
+
+	props = fdtdec_index_props(idx);
+	hash = fdtdec_index_hash(name);
+	for (i = ent->first_prop; i < ent[1].first_prop; i++) {
+		if (props[i].hash != hash)
+			continue;
+		val = fdt_getprop_by_offset(blob, props[i].offset, &pname,
+					    &len);
+		if (val && !strcmp(pname, name)) {
+			if (lenp)
+				*lenp = len;
+			return val;
+		}
+	}
+	if (lenp)
+		*lenp = -FDT_ERR_NOTFOUND;
+
+	return NULL;
+}
+
+int fdtdec_node_by_phandle(const void *blob, uint32_t phandle)
+{
+	const struct fdtdec_index *idx = fdtdec_index_get(blob);
+
+	if (!idx || !idx->phandle_count || !phandle || phandle == (u32)-1)
+		return fdt_node_offset_by_phandle(blob, phandle);
+	if (phandle >= idx->phandle_count)
+		return -FDT_ERR_NOTFOUND;
+
+	return fdtdec_index_phandles(idx)[phandle];
+}
+
+int fdtdec_node_by_compatible(const void *blob, int startoffset,
+			      const char *compat)
+{
+	const struct fdtdec_index *idx = fdtdec_index_get(blob);
+	const struct fdtdec_index_ent *compats;
+	int low, high;
+	u32 hash;
+
+	if (!idx)
+		return fdt_node_offset_by_compatible(blob, startoffset, compat);
+
+	/* Find the first node after @startoffset with this hash */
+	compats = fdtdec_index_compats(idx);
+	hash = fdtdec_index_hash(compat);
+	low = 0;
+	high = idx->compat_count;
+	while (low < high) {
+		int mid = (low + high) / 2;
+
+		if (compats[mid].hash < hash ||
+		    (compats[mid].hash == hash &&
+		     compats[mid].offset <= startoffset))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	/* Check the string, in case another one has the same hash */
+	for (; low < (int)idx->compat_count; low++) {
+		if (compats[low].hash != hash)
+			break;
+		if (!fdt_node_check_compatible(blob, compats[low].offset,
+					       compat))
+			return compats[low].offset;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdtdec_parent_offset(const void *blob, int node)
+{
+	const struct fdtdec_index *idx = fdtdec_index_get(blob);
+	const struct fdtdec_index_node *ent;
+
+	ent = idx ? fdtdec_index_find_node(idx, node) : NULL;
+	if (!ent)
+		return fdt_parent_offset(blob, node);
+
+	return ent->parent;
+}
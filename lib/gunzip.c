@@ -14,6 +14,7 @@
 #include <memalign.h>
 #include <u-boot/crc.h>
 #include <watchdog.h>
+#include <workqueue.h>
 #include <u-boot/zlib.h>
 
 #define HEADER0			'\x1f'
@@ -26,6 +27,11 @@
 #define RESERVED		0xe0
 #define DEFLATED		8
 
+/* Room for the inflate state and its 32KiB window, used by each chunk */
+#define GUNZIP_CHUNK_HEAP	(48 << 10)
+/* Maximum number of chunks decompressed at once */
+#define GUNZIP_MAX_WORK		8
+
 void *gzalloc(void *x, unsigned items, unsigned size)
 {
 	void *p;
@@ -81,6 +87,231 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	return zunzip(dst, dstlen, src, lenp, 1, offset);
 }
 
+/**
+ * struct gunzip_stream - Decompression of gzip data arriving in pieces
+ *
+ * @s:		zlib state
+ * @dst:	Start of the output buffer
+ * @header:	true until the gzip header has been skipped
+ * @done:	true once the end of the deflate stream has been seen
+ */
+struct gunzip_stream {
+	z_stream s;
+	void *dst;
+	bool header;
+	bool done;
+};
+
+struct gunzip_stream *gunzip_stream_start(void *dst, unsigned long dstlen)
+{
+	struct gunzip_stream *gs;
+	int r;
+
+	gs = calloc(1, sizeof(*gs));
+	if (!gs)
+		return NULL;
+
+	gs->s.zalloc = gzalloc;
+	gs->s.zfree = gzfree;
+	r = inflateInit2(&gs->s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		free(gs);
+		return NULL;
+	}
+	gs->s.next_out = dst;
+	gs->s.avail_out = dstlen;
+	gs->dst = dst;
+	gs->header = true;
+
+	return gs;
+}
+
+int gunzip_stream_feed(struct gunzip_stream *gs, const void *src,
+		       unsigned long len)
+{
+	int offset = 0;
+	int r;
+
+	/* Anything after the deflate stream is the gzip trailer */
+	if (gs->done || !len)
+		return 0;
+
+	if (gs->header) {
+		offset = gzip_parse_header(src, len);
+		if (offset < 0)
+			return -EINVAL;
+		gs->header = false;
+	}
+
+	gs->s.next_in = (unsigned char *)src + offset;
+	gs->s.avail_in = len - offset;
+	while (gs->s.avail_in) {
+		r = inflate(&gs->s, Z_NO_FLUSH);
+		if (r == Z_STREAM_END) {
+			gs->done = true;
+			break;
+		}
+		if (r != Z_OK) {
+			printf("Error: inflate() returned %d\n", r);
+			return -EIO;
+		}
+		WATCHDOG_RESET();
+	}
+
+	return 0;
+}
+
+int gunzip_stream_finish(struct gunzip_stream *gs, unsigned long *lenp)
+{
+	int ret = 0;
+
+	if (!gs->done) {
+		puts("Error: gunzip out of data\n");
+		ret = -EIO;
+	}
+	if (lenp)
+		*lenp = gs->s.next_out - (unsigned char *)gs->dst;
+	inflateEnd(&gs->s);
+	free(gs);
+
+	return ret;
+}
+
+/**
+ * struct gunzip_chunk - One independently compressed piece of the data
+ *
+ * zlib allocates its state from @heap, so that inflate() can run on a CPU
+ * which cannot use malloc().
+ *
+ * @s:		zlib state
+ * @dstlen:	Uncompressed size, from the gzip trailer
+ * @heap:	GUNZIP_CHUNK_HEAP bytes for zlib to allocate from
+ * @heap_used:	Number of bytes allocated from @heap
+ */
+struct gunzip_chunk {
+	z_stream s;
+	unsigned long dstlen;
+	char *heap;
+	unsigned int heap_used;
+};
+
+static void *gunzip_chunk_alloc(void *opaque, unsigned items, unsigned size)
+{
+	struct gunzip_chunk *gc = opaque;
+	void *p;
+
+	size *= items;
+	size = (size + ZALLOC_ALIGNMENT - 1) & ~(ZALLOC_ALIGNMENT - 1);
+	if (gc->heap_used + size > GUNZIP_CHUNK_HEAP)
+		return NULL;
+	p = gc->heap + gc->heap_used;
+	gc->heap_used += size;
+
+	return p;
+}
+
+static void gunzip_chunk_free(void *opaque, void *addr, unsigned nb)
+{
+	/* The heap is freed as a whole by gunzip_chunks() */
+}
+
+static int gunzip_chunk_start(struct gunzip_chunk *gc, char *heap,
+			      const unsigned char *src, unsigned long len,
+			      void *dst, unsigned long dstlen)
+{
+	u32 size;
+	int offset;
+	int r;
+
+	offset = gzip_parse_header(src, len);
+	if (offset < 0 || offset + 8 > len)
+		return -EINVAL;
+	memcpy(&size, src + len - 4, sizeof(size));
+	size = le32_to_cpu(size);
+	if (size > dstlen) {
+		puts("Error: gunzip output too large\n");
+		return -ENOSPC;
+	}
+
+	memset(gc, '\0', sizeof(*gc));
+	gc->heap = heap;
+	gc->s.zalloc = gunzip_chunk_alloc;
+	gc->s.zfree = gunzip_chunk_free;
+	gc->s.opaque = gc;
+	r = inflateInit2(&gc->s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		return -EIO;
+	}
+	inflateNoWatchdog(&gc->s);
+	gc->s.next_in = (unsigned char *)src + offset;
+	gc->s.avail_in = len - offset - 8;
+	gc->s.next_out = dst;
+	gc->s.avail_out = size;
+	gc->dstlen = size;
+
+	return 0;
+}
+
+/* This may run on a secondary CPU, so it must not print anything */
+static int gunzip_chunk_work(void *arg)
+{
+	struct gunzip_chunk *gc = arg;
+
+	if (inflate(&gc->s, Z_FINISH) != Z_STREAM_END ||
+	    gc->s.total_out != gc->dstlen)
+		return -EIO;
+
+	return 0;
+}
+
+int gunzip_chunks(void *dst, unsigned long dstlen, const void *src,
+		  const u32 *sizes, int count, unsigned long *lenp)
+{
+	struct gunzip_chunk gc[GUNZIP_MAX_WORK];
+	struct work work[GUNZIP_MAX_WORK];
+	const unsigned char *in = src;
+	unsigned long out = 0;
+	int batch, n, i, j;
+	char *heap;
+	int ret = 0;
+
+	batch = min(work_cpus() + 1, GUNZIP_MAX_WORK);
+	heap = malloc(batch * GUNZIP_CHUNK_HEAP);
+	if (!heap)
+		return -ENOMEM;
+
+	for (i = 0; i < count && !ret; i += n) {
+		/* Set up each chunk here, since workers cannot malloc() */
+		for (n = 0; n < batch && i + n < count; n++) {
+			ret = gunzip_chunk_start(&gc[n],
+						 heap + n * GUNZIP_CHUNK_HEAP,
+						 in, sizes[i + n], dst + out,
+						 dstlen - out);
+			if (ret)
+				break;
+			in += sizes[i + n];
+			out += gc[n].dstlen;
+		}
+
+		for (j = 0; j < n; j++)
+			work_queue(&work[j], gunzip_chunk_work, &gc[j]);
+		if (work_wait_all(work, n) && !ret) {
+			puts("Error: gunzip chunk is corrupt\n");
+			ret = -EIO;
+		}
+		for (j = 0; j < n; j++)
+			inflateEnd(&gc[j].s);
+		WATCHDOG_RESET();
+	}
+	free(heap);
+	if (!ret)
+		*lenp = out;
+
+	return ret;
+}
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(u64 expectedsize)
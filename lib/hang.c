@@ -10,6 +10,7 @@
 #include <common.h>
 #include <bootstage.h>
 #include <os.h>
+#include <serial.h>
 
 /**
  * hang - stop processing by staying in an endless loop
@@ -26,6 +27,7 @@ void hang(void)
 		 CONFIG_IS_ENABLED(SERIAL_SUPPORT))
 	puts("### ERROR ### Please RESET the board ###\n");
 #endif
+	serial_flush();
 	bootstage_error(BOOTSTAGE_ID_NEED_RESET);
 	if (IS_ENABLED(CONFIG_SANDBOX))
 		os_exit(1);
@@ -41,8 +41,14 @@
 #define	CONFIG_ENV_MAX_ENTRIES 512
 #endif
 
-#define USED_FREE 0
-#define USED_DELETED -1
+#define INDEX_FREE	0
+#define INDEX_DELETED	(~0U)
+
+#define ENV_NODE_BLOCK	64	/* nodes allocated at a time */
+#define ENV_REHASH_STEP	16	/* index slots moved on each operation */
+
+#define NODE_KEY_HEAP	(1 << 0) /* key was allocated with strdup() */
+#define NODE_DATA_HEAP	(1 << 1) /* data was allocated with strdup() */
 
 #include <env_callback.h>
 #include <env_flags.h>
@@ -60,44 +66,77 @@
  * which describes the current status.
  */
 
+/*
+ * Entries are kept in nodes, which are allocated ENV_NODE_BLOCK at a time
+ * and never move. The number of a node (starting at 1) is what hsearch_r()
+ * returns as index, and it stays valid for as long as the entry exists, as
+ * does the address of the entry. The hash table itself is an index of node
+ * numbers, using open addressing with triangular probing over a power of
+ * two number of slots. When it fills up a larger index is allocated and the
+ * old one is moved over a few slots at a time by the following operations,
+ * so no single operation has to rehash the whole table.
+ */
 struct env_entry_node {
 	int used;
+	unsigned int hval;	/* hash of the key, or next free node */
+	unsigned int flags;	/* NODE_... */
+	struct env_arena *arena;
 	struct env_entry entry;
 };
 
+/*
+ * Imported entries do not get a copy of their key and data. Instead the
+ * strings point into the buffer which himport_r() parsed, and the buffer is
+ * freed when the last of these entries is deleted.
+ */
+struct env_arena {
+	unsigned int refs;	/* number of nodes using the arena */
+	char buf[];
+};
 
 static void _hdelete(const char *key, struct hsearch_data *htab,
 		     struct env_entry *ep, int idx);
 
-/*
- * hcreate()
- */
+static inline struct env_entry_node *hnode(struct hsearch_data *htab,
+					   unsigned int idx)
+{
+	--idx;
+	return &htab->nodes[idx / ENV_NODE_BLOCK][idx % ENV_NODE_BLOCK];
+}
 
-/*
- * For the used double hash method the table size has to be a prime. To
- * correct the user given table size we need a prime test.  This trivial
- * algorithm is adequate because
- * a)  the code is (most probably) called a few times per program run and
- * b)  the number is small because the table must fit in the core
- * */
-static int isprime(unsigned int number)
+/* FNV-1a, which spreads similar keys well over the low bits */
+static unsigned int hash_key(const char *key)
 {
-	/* no even number will be passed */
-	unsigned int div = 3;
+	unsigned int hval = 2166136261U;
 
-	while (div * div < number && number % div != 0)
-		div += 2;
+	while (*key) {
+		hval ^= (unsigned char)*key++;
+		hval *= 16777619U;
+	}
 
-	return number % div != 0;
+	return hval;
+}
+
+/* Smallest index size which keeps @nel entries at most half full */
+static unsigned int index_size_for(unsigned int nel)
+{
+	unsigned int size = 16;
+
+	while (size < 2 * nel)
+		size <<= 1;
+
+	return size;
 }
 
+/*
+ * hcreate()
+ */
+
 /*
  * Before using the hash table we must allocate memory for it.
- * Test for an existing table are done. We allocate one element
- * more as the found prime number says. This is done for more effective
- * indexing as explained in the comment for the hsearch function.
- * The contents of the table is zeroed, especially the field used
- * becomes zero.
+ * Test for an existing table are done. Only the index is allocated here,
+ * sized for "nel" elements; nodes are added as entries are created and the
+ * index grows as needed, so "nel" is a hint rather than a limit.
  */
 
 int hcreate_r(size_t nel, struct hsearch_data *htab)
@@ -109,27 +148,70 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	}
 
 	/* There is still another table active. Return with error. */
-	if (htab->table != NULL)
+	if (htab->index != NULL)
 		return 0;
 
-	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->index_size = index_size_for(nel);
+	htab->index_used = 0;
 	htab->filled = 0;
 
 	/* allocate memory and zero out */
-	htab->table = (struct env_entry_node *)calloc(htab->size + 1,
-						sizeof(struct env_entry_node));
-	if (htab->table == NULL)
+	htab->index = calloc(htab->index_size, sizeof(*htab->index));
+	if (htab->index == NULL)
 		return 0;
 
+	/* An empty table is trivially sorted */
+	htab->sorted_valid = 1;
+
 	/* everything went alright */
 	return 1;
 }
 
+/*
+ * Free the strings of a node and put it on the free list. The node must
+ * already have been removed from the index and the sorted list.
+ */
+static void node_release(struct hsearch_data *htab, unsigned int idx)
+{
+	struct env_entry_node *np = hnode(htab, idx);
+
+	if (np->flags & NODE_KEY_HEAP)
+		free((void *)np->entry.key);
+	if (np->flags & NODE_DATA_HEAP)
+		free(np->entry.data);
+	if (np->arena && !--np->arena->refs)
+		free(np->arena);
+
+	memset(np, '\0', sizeof(*np));
+	np->hval = htab->free_node;
+	htab->free_node = idx;
+}
+
+/*
+ * Delete all entries, keeping the nodes and the index allocated so that
+ * they can be reused by the next import.
+ */
+static void hclear(struct hsearch_data *htab)
+{
+	unsigned int idx;
+
+	for (idx = htab->size; idx > 0; --idx) {
+		if (hnode(htab, idx)->used)
+			node_release(htab, idx);
+	}
+	htab->free_node = htab->size ? 1 : 0;
+	for (idx = 1; idx < htab->size; ++idx)
+		hnode(htab, idx)->hval = idx + 1;
+	if (htab->size)
+		hnode(htab, htab->size)->hval = 0;
+
+	free(htab->old_index);
+	htab->old_index = NULL;
+	memset(htab->index, '\0', htab->index_size * sizeof(*htab->index));
+	htab->index_used = 0;
+	htab->filled = 0;
+	htab->sorted_valid = 1;
+}
 
 /*
  * hdestroy()
@@ -142,7 +224,7 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 
 void hdestroy_r(struct hsearch_data *htab)
 {
-	int i;
+	unsigned int i;
 
 	/* Test for correct arguments.  */
 	if (htab == NULL) {
@@ -151,18 +233,236 @@ void hdestroy_r(struct hsearch_data *htab)
 	}
 
 	/* free used memory */
-	for (i = 1; i <= htab->size; ++i) {
-		if (htab->table[i].used > 0) {
-			struct env_entry *ep = &htab->table[i].entry;
+	if (htab->index)
+		hclear(htab);
+	for (i = 0; i < htab->size / ENV_NODE_BLOCK; ++i)
+		free(htab->nodes[i]);
+	free(htab->nodes);
+	free(htab->sorted);
+	free(htab->index);
+
+	/* the sign for an existing table is an value != NULL in index */
+	htab->nodes = NULL;
+	htab->sorted = NULL;
+	htab->index = NULL;
+	htab->size = 0;
+	htab->free_node = 0;
+}
+
+/* Take a node off the free list, adding a block of nodes if needed */
+static unsigned int node_alloc(struct hsearch_data *htab)
+{
+	struct env_entry_node **nodes, *block;
+	struct env_entry_node **sorted;
+	unsigned int nblocks = htab->size / ENV_NODE_BLOCK;
+	unsigned int idx, i;
+
+	if (!htab->free_node) {
+		block = calloc(ENV_NODE_BLOCK, sizeof(*block));
+		nodes = realloc(htab->nodes, (nblocks + 1) * sizeof(*nodes));
+		if (nodes)
+			htab->nodes = nodes;
+		sorted = realloc(htab->sorted, (htab->size + ENV_NODE_BLOCK) *
+				 sizeof(*sorted));
+		if (sorted)
+			htab->sorted = sorted;
+		if (!block || !nodes || !sorted) {
+			free(block);
+			return 0;
+		}
+
+		htab->nodes[nblocks] = block;
+		for (i = 0; i < ENV_NODE_BLOCK - 1; ++i)
+			block[i].hval = htab->size + i + 2;
+		htab->free_node = htab->size + 1;
+		htab->size += ENV_NODE_BLOCK;
+	}
+
+	idx = htab->free_node;
+	htab->free_node = hnode(htab, idx)->hval;
+
+	return idx;
+}
+
+/*
+ * Look for "key" in one index. Returns the slot holding its node number, or
+ * NULL if it is not there.
+ */
+static unsigned int *index_find(struct hsearch_data *htab,
+				unsigned int *index, unsigned int size,
+				const char *key, unsigned int hval)
+{
+	unsigned int mask = size - 1;
+	unsigned int i = hval & mask;
+	unsigned int step;
 
-			free((void *)ep->key);
-			free(ep->data);
+	for (step = 1; step <= size && index[i] != INDEX_FREE; ++step) {
+		if (index[i] != INDEX_DELETED) {
+			struct env_entry_node *np = hnode(htab, index[i]);
+
+			if (np->hval == hval && strcmp(key, np->entry.key) == 0)
+				return &index[i];
 		}
+		i = (i + step) & mask;
 	}
-	free(htab->table);
 
-	/* the sign for an existing table is an value != NULL in htable */
-	htab->table = NULL;
+	return NULL;
+}
+
+static unsigned int *hfind(struct hsearch_data *htab, const char *key,
+			   unsigned int hval)
+{
+	unsigned int *slot;
+
+	slot = index_find(htab, htab->index, htab->index_size, key, hval);
+	if (!slot && htab->old_index)
+		slot = index_find(htab, htab->old_index, htab->old_size, key,
+				  hval);
+
+	return slot;
+}
+
+/* Put node "idx" in the first free or deleted slot of its probe sequence */
+static void index_insert(struct hsearch_data *htab, unsigned int idx)
+{
+	unsigned int mask = htab->index_size - 1;
+	unsigned int i = hnode(htab, idx)->hval & mask;
+	unsigned int step = 1;
+
+	while (htab->index[i] != INDEX_FREE &&
+	       htab->index[i] != INDEX_DELETED)
+		i = (i + step++) & mask;
+
+	if (htab->index[i] == INDEX_FREE)
+		++htab->index_used;
+	htab->index[i] = idx;
+}
+
+/* Move up to "count" slots of the old index over to the new one */
+static void rehash_step(struct hsearch_data *htab, unsigned int count)
+{
+	unsigned int idx;
+
+	while (htab->old_index && count--) {
+		if (htab->rehash_pos == htab->old_size) {
+			free(htab->old_index);
+			htab->old_index = NULL;
+			break;
+		}
+
+		idx = htab->old_index[htab->rehash_pos];
+		if (idx != INDEX_FREE && idx != INDEX_DELETED) {
+			index_insert(htab, idx);
+			/* Keep the probe sequences through this slot intact */
+			htab->old_index[htab->rehash_pos] = INDEX_DELETED;
+		}
+		++htab->rehash_pos;
+	}
+}
+
+/*
+ * Make room in the index for one more entry. When it gets three quarters
+ * full (counting deleted slots) a new index is allocated, sized for twice
+ * the number of entries, and the current one becomes the old index which
+ * rehash_step() empties into it.
+ */
+static int index_reserve(struct hsearch_data *htab)
+{
+	unsigned int *index;
+	unsigned int size;
+
+	if ((htab->index_used + 1) * 4 <= htab->index_size * 3)
+		return 0;
+
+	/* Only one rehash at a time: finish the previous one */
+	rehash_step(htab, ~0U);
+
+	size = index_size_for(htab->filled + 1);
+	index = calloc(size, sizeof(*index));
+	if (!index)
+		return -ENOMEM;
+
+	debug("Rehash Table: %u -> %u slots, %u entries\n",
+	      htab->index_size, size, htab->filled);
+	htab->old_index = htab->index;
+	htab->old_size = htab->index_size;
+	htab->rehash_pos = 0;
+	htab->index = index;
+	htab->index_size = size;
+	htab->index_used = 0;
+
+	/*
+	 * A smaller index could fill up with new entries before the old one
+	 * is drained, so move everything now. This only happens after many
+	 * deletes, and moves no more than htab->filled entries.
+	 */
+	if (size < htab->old_size)
+		rehash_step(htab, ~0U);
+
+	return 0;
+}
+
+/*
+ * The entries are also kept in a list sorted by key, so that hexport_r()
+ * does not have to sort the whole table each time. Rather than keeping the
+ * list sorted during an import, the import marks it invalid and the next
+ * export sorts it once.
+ */
+static unsigned int sorted_find(struct hsearch_data *htab, unsigned int n,
+				const char *key, int *found)
+{
+	unsigned int lo = 0, hi = n;
+	int cmp;
+
+	*found = 0;
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		cmp = strcmp(key, htab->sorted[mid]->entry.key);
+		if (!cmp) {
+			*found = 1;
+			return mid;
+		}
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo;
+}
+
+/* Called before the new entry is counted in htab->filled */
+static void sorted_add(struct hsearch_data *htab, struct env_entry_node *np)
+{
+	unsigned int pos;
+	int found;
+
+	if (!htab->sorted_valid)
+		return;
+
+	pos = sorted_find(htab, htab->filled, np->entry.key, &found);
+	memmove(&htab->sorted[pos + 1], &htab->sorted[pos],
+		(htab->filled - pos) * sizeof(*htab->sorted));
+	htab->sorted[pos] = np;
+}
+
+/* Called before the entry is taken off htab->filled */
+static void sorted_del(struct hsearch_data *htab, struct env_entry_node *np)
+{
+	unsigned int pos;
+	int found;
+
+	if (!htab->sorted_valid)
+		return;
+
+	pos = sorted_find(htab, htab->filled, np->entry.key, &found);
+	if (!found) {
+		htab->sorted_valid = 0;
+		return;
+	}
+	memmove(&htab->sorted[pos], &htab->sorted[pos + 1],
+		(htab->filled - pos - 1) * sizeof(*htab->sorted));
 }
 
 /*
@@ -170,19 +470,11 @@ void hdestroy_r(struct hsearch_data *htab)
  */
 
 /*
- * This is the search function. It uses double hashing with open addressing.
- * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
- *
- * We use an trick to speed up the lookup. The table is created by hcreate
- * with one more element available. This enables us to use the index zero
- * special. This index will never be used because we store the first hash
- * index in the field used where zero means not used. Every other value
- * means used. The used field can be used as a first fast comparison for
- * equality of the stored and the parameter value. This helps to prevent
- * unnecessary expensive calls of strcmp.
+ * This is the search function. It hashes item.key and looks it up in the
+ * index described above; while the index is being grown the old one is
+ * searched too. The hash value is kept in the node, which allows a fast
+ * first comparison for equality of the stored and the parameter value and
+ * helps to prevent unnecessary expensive calls of strcmp.
  *
  * This implementation differs from the standard library version of
  * this function in a number of ways:
@@ -192,14 +484,15 @@ void hdestroy_r(struct hsearch_data *htab)
  *   works with NUL terminated strings only.
  * - Instead of storing just pointers to the original objects, we
  *   create local copies so the caller does not need to care about the
- *   data any more.
+ *   data any more. Entries created by himport_r() share one copy of
+ *   the imported data instead.
  * - The standard implementation does not provide a way to update an
  *   existing entry.  This version will create a new entry or update an
  *   existing one when both "action == ENV_ENTER" and "item.data != NULL".
- * - Instead of returning 1 on success, we return the index into the
- *   internal hash table, which is also guaranteed to be positive.
- *   This allows us direct access to the found hash table slot for
- *   example for functions like hdelete().
+ * - Instead of returning 1 on success, we return the index of the entry
+ *   (the number of its node), which is also guaranteed to be positive.
+ *   This allows us direct access to the found entry for example for
+ *   functions like hdelete().
  */
 
 int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
@@ -208,11 +501,13 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 	unsigned int idx;
 	size_t key_len = strlen(match);
 
-	for (idx = last_idx + 1; idx < htab->size; ++idx) {
-		if (htab->table[idx].used <= 0)
+	for (idx = last_idx + 1; idx <= htab->size; ++idx) {
+		struct env_entry_node *np = hnode(htab, idx);
+
+		if (!np->used)
 			continue;
-		if (!strncmp(match, htab->table[idx].entry.key, key_len)) {
-			*retval = &htab->table[idx].entry;
+		if (!strncmp(match, np->entry.key, key_len)) {
+			*retval = &np->entry;
 			return idx;
 		}
 	}
@@ -223,198 +518,157 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 }
 
 /*
- * Compare an existing entry with the desired key, and overwrite if the action
- * is ENV_ENTER.  This is simply a helper function for hsearch_r().
+ * Overwrite an existing entry if the action is ENV_ENTER.  This is simply a
+ * helper function for hsearch_r().
  */
-static inline int _compare_and_overwrite_entry(struct env_entry item,
+static inline int _overwrite_entry(struct env_entry item,
 		enum env_action action, struct env_entry **retval,
-		struct hsearch_data *htab, int flag, unsigned int hval,
-		unsigned int idx)
+		struct hsearch_data *htab, int flag, unsigned int idx,
+		struct env_arena *arena)
 {
-	if (htab->table[idx].used == hval
-	    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
-		/* Overwrite existing value? */
-		if (action == ENV_ENTER && item.data) {
-			/* check for permission */
-			if (htab->change_ok != NULL && htab->change_ok(
-			    &htab->table[idx].entry, item.data,
-			    env_op_overwrite, flag)) {
-				debug("change_ok() rejected setting variable "
-					"%s, skipping it!\n", item.key);
-				__set_errno(EPERM);
-				*retval = NULL;
-				return 0;
-			}
+	struct env_entry_node *np = hnode(htab, idx);
+	char *data;
 
-			/* If there is a callback, call it */
-			if (htab->table[idx].entry.callback &&
-			    htab->table[idx].entry.callback(item.key,
-			    item.data, env_op_overwrite, flag)) {
-				debug("callback() rejected setting variable "
-					"%s, skipping it!\n", item.key);
-				__set_errno(EINVAL);
-				*retval = NULL;
-				return 0;
-			}
+	/* Overwrite existing value? */
+	if (action == ENV_ENTER && item.data) {
+		/* check for permission */
+		if (htab->change_ok != NULL && htab->change_ok(
+		    &np->entry, item.data, env_op_overwrite, flag)) {
+			debug("change_ok() rejected setting variable "
+				"%s, skipping it!\n", item.key);
+			__set_errno(EPERM);
+			*retval = NULL;
+			return 0;
+		}
 
-			free(htab->table[idx].entry.data);
-			htab->table[idx].entry.data = strdup(item.data);
-			if (!htab->table[idx].entry.data) {
+		/* If there is a callback, call it */
+		if (np->entry.callback &&
+		    np->entry.callback(item.key, item.data, env_op_overwrite,
+				       flag)) {
+			debug("callback() rejected setting variable "
+				"%s, skipping it!\n", item.key);
+			__set_errno(EINVAL);
+			*retval = NULL;
+			return 0;
+		}
+
+		/* The new data may only stay in place if it is our arena */
+		if (arena && arena == np->arena) {
+			data = item.data;
+		} else {
+			data = strdup(item.data);
+			if (!data) {
 				__set_errno(ENOMEM);
 				*retval = NULL;
 				return 0;
 			}
 		}
-		/* return found entry */
-		*retval = &htab->table[idx].entry;
-		return idx;
+		if (np->flags & NODE_DATA_HEAP)
+			free(np->entry.data);
+		np->entry.data = data;
+		if (data == item.data)
+			np->flags &= ~NODE_DATA_HEAP;
+		else
+			np->flags |= NODE_DATA_HEAP;
 	}
-	/* keep searching */
-	return -1;
+	/* return found entry */
+	*retval = &np->entry;
+	return idx;
 }
 
-int hsearch_r(struct env_entry item, enum env_action action,
-	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+/*
+ * Search, and with ENV_ENTER create or update, an entry. When "arena" is
+ * given, item.key and item.data point into it and are used as they are.
+ */
+static int _hsearch(struct env_entry item, enum env_action action,
+		    struct env_entry **retval, struct hsearch_data *htab,
+		    int flag, struct env_arena *arena)
 {
-	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
+	struct env_entry_node *np;
+	unsigned int hval = hash_key(item.key);
+	unsigned int *slot;
 	unsigned int idx;
-	unsigned int first_deleted = 0;
-	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
+	if (!htab->index) {
+		__set_errno(action == ENV_ENTER ? ENOMEM : ESRCH);
+		*retval = NULL;
+		return 0;
 	}
 
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
-
-	/* The first index tried. */
-	idx = hval;
+	rehash_step(htab, ENV_REHASH_STEP);
 
-	if (htab->table[idx].used) {
-		/*
-		 * Further action might be required according to the
-		 * action value.
-		 */
-		unsigned hval2;
+	slot = hfind(htab, item.key, hval);
+	if (slot)
+		return _overwrite_entry(item, action, retval, htab, flag,
+					*slot, arena);
 
-		if (htab->table[idx].used == USED_DELETED
-		    && !first_deleted)
-			first_deleted = idx;
-
-		ret = _compare_and_overwrite_entry(item, action, retval, htab,
-			flag, hval, idx);
-		if (ret != -1)
-			return ret;
-
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
-
-		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
-
-			/*
-			 * If we visited all entries leave the loop
-			 * unsuccessfully.
-			 */
-			if (idx == hval)
-				break;
-
-			if (htab->table[idx].used == USED_DELETED
-			    && !first_deleted)
-				first_deleted = idx;
-
-			/* If entry is found use it. */
-			ret = _compare_and_overwrite_entry(item, action, retval,
-				htab, flag, hval, idx);
-			if (ret != -1)
-				return ret;
-		}
-		while (htab->table[idx].used != USED_FREE);
-	}
-
-	/* An empty bucket has been found. */
+	/* Not found */
 	if (action == ENV_ENTER) {
-		/*
-		 * If table is full and another entry should be
-		 * entered return with error.
-		 */
-		if (htab->filled == htab->size) {
-			__set_errno(ENOMEM);
-			*retval = NULL;
-			return 0;
-		}
-
 		/*
 		 * Create new entry;
-		 * create copies of item.key and item.data
+		 * create copies of item.key and item.data unless they are in
+		 * the arena
 		 */
-		if (first_deleted)
-			idx = first_deleted;
-
-		htab->table[idx].used = hval;
-		htab->table[idx].entry.key = strdup(item.key);
-		htab->table[idx].entry.data = strdup(item.data);
-		if (!htab->table[idx].entry.key ||
-		    !htab->table[idx].entry.data) {
+		if (index_reserve(htab) || !(idx = node_alloc(htab))) {
 			__set_errno(ENOMEM);
 			*retval = NULL;
 			return 0;
 		}
+		np = hnode(htab, idx);
+
+		if (arena) {
+			np->entry.key = item.key;
+			np->entry.data = item.data;
+			np->arena = arena;
+			++arena->refs;
+		} else {
+			np->entry.key = strdup(item.key);
+			np->entry.data = strdup(item.data);
+			np->flags = NODE_KEY_HEAP | NODE_DATA_HEAP;
+			if (!np->entry.key || !np->entry.data) {
+				node_release(htab, idx);
+				__set_errno(ENOMEM);
+				*retval = NULL;
+				return 0;
+			}
+		}
+		np->used = 1;
+		np->hval = hval;
+		index_insert(htab, idx);
 
+		sorted_add(htab, np);
 		++htab->filled;
 
 		/* This is a new entry, so look up a possible callback */
-		env_callback_init(&htab->table[idx].entry);
+		env_callback_init(&np->entry);
 		/* Also look for flags */
-		env_flags_init(&htab->table[idx].entry);
+		env_flags_init(&np->entry);
 
 		/* check for permission */
 		if (htab->change_ok != NULL && htab->change_ok(
-		    &htab->table[idx].entry, item.data, env_op_create, flag)) {
+		    &np->entry, item.data, env_op_create, flag)) {
 			debug("change_ok() rejected setting variable "
 				"%s, skipping it!\n", item.key);
-			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
+			_hdelete(item.key, htab, &np->entry, idx);
 			__set_errno(EPERM);
 			*retval = NULL;
 			return 0;
 		}
 
 		/* If there is a callback, call it */
-		if (htab->table[idx].entry.callback &&
-		    htab->table[idx].entry.callback(item.key, item.data,
+		if (np->entry.callback &&
+		    np->entry.callback(item.key, item.data,
 		    env_op_create, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
-			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
+			_hdelete(item.key, htab, &np->entry, idx);
 			__set_errno(EINVAL);
 			*retval = NULL;
 			return 0;
 		}
 
 		/* return new entry */
-		*retval = &htab->table[idx].entry;
+		*retval = &np->entry;
 		return 1;
 	}
 
@@ -423,6 +677,12 @@ int hsearch_r(struct env_entry item, enum env_action action,
 	return 0;
 }
 
+int hsearch_r(struct env_entry item, enum env_action action,
+	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+{
+	return _hsearch(item, action, retval, htab, flag, NULL);
+}
+
 
 /*
  * hdelete()
@@ -437,13 +697,16 @@ int hsearch_r(struct env_entry item, enum env_action action,
 static void _hdelete(const char *key, struct hsearch_data *htab,
 		     struct env_entry *ep, int idx)
 {
+	struct env_entry_node *np = hnode(htab, idx);
+	unsigned int *slot;
+
 	/* free used entry */
 	debug("hdelete: DELETING key \"%s\"\n", key);
-	free((void *)ep->key);
-	free(ep->data);
-	ep->callback = NULL;
-	ep->flags = 0;
-	htab->table[idx].used = USED_DELETED;
+	slot = hfind(htab, ep->key, np->hval);
+	if (slot)
+		*slot = INDEX_DELETED;
+	sorted_del(htab, np);
+	node_release(htab, idx);
 
 	--htab->filled;
 }
@@ -473,8 +736,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
-	if (htab->table[idx].entry.callback &&
-	    htab->table[idx].entry.callback(key, NULL, env_op_delete, flag)) {
+	if (ep->callback && ep->callback(key, NULL, env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
 			"%s, skipping it!\n", key);
 		__set_errno(EINVAL);
@@ -531,10 +793,10 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 
 static int cmpkey(const void *p1, const void *p2)
 {
-	struct env_entry *e1 = *(struct env_entry **)p1;
-	struct env_entry *e2 = *(struct env_entry **)p2;
+	struct env_entry_node *n1 = *(struct env_entry_node **)p1;
+	struct env_entry_node *n2 = *(struct env_entry_node **)p2;
 
-	return (strcmp(e1->key, e2->key));
+	return (strcmp(n1->entry.key, n2->entry.key));
 }
 
 static int match_string(int flag, const char *str, const char *pat, void *priv)
@@ -595,14 +857,27 @@ static int match_entry(struct env_entry *ep, int flag, int argc,
 	return 0;
 }
 
+/* Check whether an entry is to be exported */
+static int export_entry(struct env_entry *ep, int flag, int argc,
+			char *const argv[])
+{
+	if ((argc > 0) && (match_entry(ep, flag, argc, argv) == 0))
+		return 0;
+
+	if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+		return 0;
+
+	return 1;
+}
+
 ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char * const argv[])
 {
-	struct env_entry *list[htab->size];
+	struct env_entry_node **list;
 	char *res, *p;
 	size_t totlen;
-	int i, n;
+	unsigned int i, n;
 
 	/* Test for correct arguments.  */
 	if ((resp == NULL) || (htab == NULL)) {
@@ -612,56 +887,49 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 	debug("EXPORT  table = %p, htab.size = %d, htab.filled = %d, size = %lu\n",
 	      htab, htab->size, htab->filled, (ulong)size);
+	list = htab->sorted;
 	/*
-	 * Pass 1:
-	 * search used entries,
-	 * save addresses and compute total length
+	 * The list of entries sorted by keys is kept up to date by
+	 * hsearch_r() and hdelete_r(), except after an import
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
-
-		if (htab->table[i].used > 0) {
-			struct env_entry *ep = &htab->table[i].entry;
-			int found = match_entry(ep, flag, argc, argv);
-
-			if ((argc > 0) && (found == 0))
-				continue;
+	n = htab->filled;
+	if (!htab->sorted_valid) {
+		for (i = 1, n = 0; i <= htab->size; ++i) {
+			if (hnode(htab, i)->used)
+				list[n++] = hnode(htab, i);
+		}
+		qsort(list, n, sizeof(*list), cmpkey);
+		htab->sorted_valid = 1;
+	}
 
-			if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
-				continue;
+	/*
+	 * Pass 1:
+	 * compute total length of the entries to export
+	 */
+	for (i = 0, totlen = 0; i < n; ++i) {
+		struct env_entry *ep = &list[i]->entry;
 
-			list[n++] = ep;
+		if (!export_entry(ep, flag, argc, argv))
+			continue;
 
-			totlen += strlen(ep->key);
+		totlen += strlen(ep->key);
 
-			if (sep == '\0') {
-				totlen += strlen(ep->data);
-			} else {	/* check if escapes are needed */
-				char *s = ep->data;
+		if (sep == '\0') {
+			totlen += strlen(ep->data);
+		} else {	/* check if escapes are needed */
+			char *s = ep->data;
 
-				while (*s) {
+			while (*s) {
+				++totlen;
+				/* add room for needed escape chars */
+				if ((*s == sep) || (*s == '\\'))
 					++totlen;
-					/* add room for needed escape chars */
-					if ((*s == sep) || (*s == '\\'))
-						++totlen;
-					++s;
-				}
+				++s;
 			}
-			totlen += 2;	/* for '=' and 'sep' char */
 		}
+		totlen += 2;	/* for '=' and 'sep' char */
 	}
 
-#ifdef DEBUG
-	/* Pass 1a: print unsorted list */
-	printf("Unsorted: n=%d\n", n);
-	for (i = 0; i < n; ++i) {
-		printf("\t%3d: %p ==> %-10s => %s\n",
-		       i, list[i], list[i]->key, list[i]->data);
-	}
-#endif
-
-	/* Sort list by keys */
-	qsort(list, n, sizeof(struct env_entry *), cmpkey);
-
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
 		if (size < totlen + 1) {	/* provided buffer too small */
@@ -692,14 +960,18 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 	 * export sorted list of result data
 	 */
 	for (i = 0, p = res; i < n; ++i) {
+		struct env_entry *ep = &list[i]->entry;
 		const char *s;
 
-		s = list[i]->key;
+		if (!export_entry(ep, flag, argc, argv))
+			continue;
+
+		s = ep->key;
 		while (*s)
 			*p++ = *s++;
 		*p++ = '=';
 
-		s = list[i]->data;
+		s = ep->data;
 
 		while (*s) {
 			if ((*s == sep) || (*s == '\\'))
@@ -747,6 +1019,17 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
 	return res;
 }
 
+/* Length of a NUL separated environment, up to the empty string ending it */
+static size_t himport_len(const char *env, size_t size)
+{
+	const char *p = env, *end = env + size;
+
+	while (p < end && *p)
+		p += strnlen(p, end - p) + 1;
+
+	return p < end ? p - env : size;
+}
+
 /*
  * Import linearized data into hash table.
  *
@@ -791,6 +1074,8 @@ int himport_r(struct hsearch_data *htab,
 {
 	char *data, *sp, *dp, *name, *value;
 	char *localvars[nvars];
+	struct env_arena *arena;
+	size_t len = size;
 	int i;
 
 	/* Test for correct arguments.  */
@@ -799,14 +1084,25 @@ int himport_r(struct hsearch_data *htab,
 		return 0;
 	}
 
+	/*
+	 * The imported entries keep pointing into our copy, so only copy
+	 * the part of a NUL separated environment which is in use
+	 */
+	if (sep == '\0')
+		len = himport_len(env, size);
+
 	/* we allocate new space to make sure we can write to the array */
-	if ((data = malloc(size + 1)) == NULL) {
-		debug("himport_r: can't malloc %lu bytes\n", (ulong)size + 1);
+	arena = malloc(sizeof(*arena) + len + 1);
+	if (arena == NULL) {
+		debug("himport_r: can't malloc %lu bytes\n", (ulong)len + 1);
 		__set_errno(ENOMEM);
 		return 0;
 	}
-	memcpy(data, env, size);
-	data[size] = '\0';
+	/* Keep the buffer until the parser is done with it */
+	arena->refs = 1;
+	data = arena->buf;
+	memcpy(data, env, len);
+	data[len] = '\0';
 	dp = data;
 
 	/* make a local copy of the list of variables */
@@ -814,11 +1110,11 @@ int himport_r(struct hsearch_data *htab,
 		memcpy(localvars, vars, sizeof(vars[0]) * nvars);
 
 	if ((flag & H_NOCLEAR) == 0 && !nvars) {
-		/* Destroy old hash table if one exists */
-		debug("Destroy Hash Table: %p table = %p\n", htab,
-		       htab->table);
-		if (htab->table)
-			hdestroy_r(htab);
+		/* Empty the old hash table if one exists, but keep its memory */
+		debug("Clear Hash Table: %p index = %p\n", htab,
+		       htab->index);
+		if (htab->index)
+			hclear(htab);
 	}
 
 	/*
@@ -839,7 +1135,7 @@ int himport_r(struct hsearch_data *htab,
 	 * be overwritten in the board config file if needed.
 	 */
 
-	if (!htab->table) {
+	if (!htab->index) {
 		int nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
 
 		if (nent > CONFIG_ENV_MAX_ENTRIES)
@@ -848,15 +1144,19 @@ int himport_r(struct hsearch_data *htab,
 		debug("Create Hash Table: N=%d\n", nent);
 
 		if (hcreate_r(nent, htab) == 0) {
-			free(data);
+			free(arena);
 			return 0;
 		}
 	}
 
+	size = len;
 	if (!size) {
-		free(data);
+		free(arena);
 		return 1;		/* everything OK */
 	}
+
+	/* Sort the entries once at the next export rather than one by one */
+	htab->sorted_valid = 0;
 	if(crlf_is_lf) {
 		/* Remove Carriage Returns in front of Line Feeds */
 		unsigned ignored_crs = 0;
@@ -920,7 +1220,8 @@ int himport_r(struct hsearch_data *htab,
 		if (*name == 0) {
 			debug("INSERT: unable to use an empty key\n");
 			__set_errno(EINVAL);
-			free(data);
+			if (!--arena->refs)
+				free(arena);
 			return 0;
 		}
 
@@ -932,7 +1233,7 @@ int himport_r(struct hsearch_data *htab,
 		e.key = name;
 		e.data = value;
 
-		hsearch_r(e, ENV_ENTER, &rv, htab, flag);
+		_hsearch(e, ENV_ENTER, &rv, htab, flag, arena);
 		if (rv == NULL)
 			printf("himport_r: can't insert \"%s=%s\" into hash table\n",
 				name, value);
@@ -942,8 +1243,10 @@ int himport_r(struct hsearch_data *htab,
 			rv, name, value);
 	} while ((dp < data + size) && *dp);	/* size check needed for text */
 						/* without '\0' termination */
-	debug("INSERT: free(data = %p)\n", data);
-	free(data);
+	/* The arena stays as long as the entries which point into it */
+	debug("INSERT: %u entries in arena %p\n", arena->refs - 1, arena);
+	if (!--arena->refs)
+		free(arena);
 
 	if (flag & H_NOCLEAR)
 		goto end;
@@ -981,12 +1284,12 @@ end:
  */
 int hwalk_r(struct hsearch_data *htab, int (*callback)(struct env_entry *entry))
 {
-	int i;
+	unsigned int i;
 	int retval;
 
 	for (i = 1; i <= htab->size; ++i) {
-		if (htab->table[i].used > 0) {
-			retval = callback(&htab->table[i].entry);
+		if (hnode(htab, i)->used) {
+			retval = callback(&hnode(htab, i)->entry);
 			if (retval)
 				return retval;
 		}
@@ -9,242 +9,323 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <linux/libfdt.h>
 #include <of_live.h>
 #include <malloc.h>
 #include <dm/of_access.h>
 #include <linux/err.h>
 
-static void *unflatten_dt_alloc(void **mem, unsigned long size,
-				unsigned long align)
-{
-	void *res;
+/* Links are held as an array index plus one while the arrays can move */
+#define OF_LIVE_LINK(idx)	((void *)(ulong)((idx) + 1))
 
-	*mem = PTR_ALIGN(*mem, align);
-	res = *mem;
-	*mem += size;
+/**
+ * struct of_live_state - State while building a live tree
+ *
+ * The live tree is built in a single pass over the flat tree. Nodes and
+ * properties are each packed into one array, which grows as needed and is
+ * trimmed to size at the end. Property names and values, and node names,
+ * point into the flat tree, which must therefore stay where it is. Only
+ * the "name" property of nodes with a unit address needs a copy, since the
+ * name without the unit address is not nul-terminated in the flat tree.
+ *
+ * While the arrays can still move, the links between nodes and properties
+ * are held as array indices (see OF_LIVE_LINK()) and the copied names as
+ * offsets into @names. of_live_link() turns them into pointers at the end.
+ *
+ * @blob: Flat tree being converted
+ * @nodes: Nodes, in the order they appear in the flat tree
+ * @node_count: Number of nodes in @nodes
+ * @node_alloc: Number of nodes allocated in @nodes
+ * @props: Properties, those of each node being kept together
+ * @prop_count: Number of properties in @props
+ * @prop_alloc: Number of properties allocated in @props
+ * @names: Nul-terminated node names without their unit address
+ * @names_len: Number of bytes used in @names
+ * @names_alloc: Number of bytes allocated in @names
+ * @cur: Index of the node whose properties are being added, or -1
+ * @first_prop: Index of the first property of node @cur
+ * @has_name: true if node @cur has a "name" property
+ */
+struct of_live_state {
+	const void *blob;
+	struct device_node *nodes;
+	int node_count;
+	int node_alloc;
+	struct property *props;
+	int prop_count;
+	int prop_alloc;
+	char *names;
+	int names_len;
+	int names_alloc;
+	int cur;
+	int first_prop;
+	bool has_name;
+};
+
+static char of_live_report[48];
+
+static void *of_live_ptr(void *base, size_t size, const void *link)
+{
+	ulong idx = (ulong)link;
 
-	return res;
+	return idx ? base + (idx - 1) * size : NULL;
 }
 
 /**
- * unflatten_dt_node() - Alloc and populate a device_node from the flat tree
- * @blob: The parent device tree blob
- * @mem: Memory chunk to use for allocating device nodes and properties
- * @poffset: pointer to node in flat tree
- * @dad: Parent struct device_node
- * @nodepp: The device_node tree created by the call
- * @fpsize: Size of the node path up at t05he current depth.
- * @dryrun: If true, do not allocate device nodes but still calculate needed
- * memory size
+ * of_live_grow() - Make sure an array has space for some more entries
+ *
+ * @arrayp: Pointer to the array, updated if it moves
+ * @allocp: Pointer to the number of entries allocated, updated on growth
+ * @needed: Number of entries that are needed
+ * @size: Size of each entry in bytes
+ * @return 0 if OK, -ENOMEM if out of memory
  */
-static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
-			       struct device_node *dad,
-			       struct device_node **nodepp,
-			       unsigned long fpsize, bool dryrun)
+static int of_live_grow(void *arrayp, int *allocp, int needed, size_t size)
 {
-	const __be32 *p;
-	struct device_node *np;
-	struct property *pp, **prev_pp = NULL;
-	const char *pathp;
-	int l;
-	unsigned int allocl;
-	static int depth;
-	int old_depth;
-	int offset;
-	int has_name = 0;
-	int new_format = 0;
-
-	pathp = fdt_get_name(blob, *poffset, &l);
-	if (!pathp)
-		return mem;
-
-	allocl = ++l;
+	void **ptr = arrayp;
+	void *array;
+	int alloc;
+
+	if (needed <= *allocp)
+		return 0;
+	alloc = max(needed, *allocp * 2);
+	array = realloc(*ptr, alloc * size);
+	if (!array)
+		return -ENOMEM;
+	*ptr = array;
+	*allocp = alloc;
+
+	return 0;
+}
+
+static void *of_live_trim(void *array, size_t size)
+{
+	void *ptr;
+
+	if (!array || !size)
+		return array;
+	ptr = realloc(array, size);
+
+	return ptr ? ptr : array;
+}
+
+/* Finish adding properties to the current node */
+static int of_live_end_props(struct of_live_state *st)
+{
+	struct device_node *np = &st->nodes[st->cur];
+	struct property *pp;
+	const char *unit, *at;
+	int ret, len, i;
 
 	/*
-	 * version 0x10 has a more compact unit name here instead of the full
-	 * path. we accumulate the full path size using "fpsize", we'll rebuild
-	 * it later. We detect this because the first character of the name is
-	 * not '/'.
+	 * With version 0x10 we may not have the name property, so create it
+	 * from the node name, without the unit address
 	 */
-	if ((*pathp) != '/') {
-		new_format = 1;
-		if (fpsize == 0) {
-			/*
-			 * root node: special case. fpsize accounts for path
-			 * plus terminating zero. root node only has '/', so
-			 * fpsize should be 2, but we want to avoid the first
-			 * level nodes to have two '/' so we use fpsize 1 here
-			 */
-			fpsize = 1;
-			allocl = 2;
-			l = 1;
-			pathp = "";
+	if (!st->has_name) {
+		ret = of_live_grow(&st->props, &st->prop_alloc,
+				   st->prop_count + 1, sizeof(*st->props));
+		if (ret)
+			return ret;
+		pp = &st->props[st->prop_count++];
+		unit = np->full_name;
+		at = strchr(unit, '@');
+		if (at) {
+			len = at - unit;
+			ret = of_live_grow(&st->names, &st->names_alloc,
+					   st->names_len + len + 1, 1);
+			if (ret)
+				return ret;
+			memcpy(st->names + st->names_len, unit, len);
+			st->names[st->names_len + len] = '\0';
+
+			/* A NULL name marks an offset into the names */
+			pp->name = NULL;
+			pp->value = (void *)(ulong)st->names_len;
+			st->names_len += len + 1;
 		} else {
-			/*
-			 * account for '/' and path size minus terminal 0
-			 * already in 'l'
-			 */
-			fpsize += l;
-			allocl = fpsize;
+			len = strlen(unit);
+			pp->name = "name";
+			pp->value = (void *)unit;
 		}
+		pp->length = len + 1;
 	}
 
-	np = unflatten_dt_alloc(&mem, sizeof(struct device_node) + allocl,
-				__alignof__(struct device_node));
-	if (!dryrun) {
-		char *fn;
-
-		fn = (char *)np + sizeof(*np);
-		np->full_name = fn;
-		if (new_format) {
-			/* rebuild full path for new format */
-			if (dad && dad->parent) {
-				strcpy(fn, dad->full_name);
-#ifdef DEBUG
-				if ((strlen(fn) + l + 1) != allocl) {
-					debug("%s: p: %d, l: %d, a: %d\n",
-					      pathp, (int)strlen(fn), l,
-					      allocl);
-				}
-#endif
-				fn += strlen(fn);
-			}
-			*(fn++) = '/';
-		}
-		memcpy(fn, pathp, l);
+	if (st->prop_count > st->first_prop)
+		np->properties = OF_LIVE_LINK(st->first_prop);
+	for (i = st->first_prop; i < st->prop_count; i++) {
+		pp = &st->props[i];
+		pp->next = i + 1 < st->prop_count ? OF_LIVE_LINK(i + 1) : NULL;
+	}
+	st->cur = -1;
 
-		prev_pp = &np->properties;
-		if (dad != NULL) {
-			np->parent = dad;
-			np->sibling = dad->child;
-			dad->child = np;
-		}
+	return 0;
+}
+
+static int of_live_add_node(struct of_live_state *st, int offset, int parent,
+			    int *lastp)
+{
+	struct device_node *np;
+	const char *name;
+	int ret, idx;
+
+	name = fdt_get_name(st->blob, offset, NULL);
+	if (!name)
+		return -EINVAL;
+	ret = of_live_grow(&st->nodes, &st->node_alloc, st->node_count + 1,
+			   sizeof(*st->nodes));
+	if (ret)
+		return ret;
+	idx = st->node_count++;
+	np = &st->nodes[idx];
+	memset(np, '\0', sizeof(*np));
+	np->full_name = name;
+	if (parent >= 0) {
+		np->parent = OF_LIVE_LINK(parent);
+		if (*lastp >= 0)
+			st->nodes[*lastp].sibling = OF_LIVE_LINK(idx);
+		else
+			st->nodes[parent].child = OF_LIVE_LINK(idx);
+		*lastp = idx;
 	}
-	/* process properties */
-	for (offset = fdt_first_property_offset(blob, *poffset);
-	     (offset >= 0);
-	     (offset = fdt_next_property_offset(blob, offset))) {
-		const char *pname;
-		int sz;
-
-		p = fdt_getprop_by_offset(blob, offset, &pname, &sz);
-		if (!p) {
-			offset = -FDT_ERR_INTERNAL;
-			break;
-		}
+	st->cur = idx;
+	st->first_prop = st->prop_count;
+	st->has_name = false;
+
+	return idx;
+}
+
+static int of_live_add_prop(struct of_live_state *st, int offset)
+{
+	struct device_node *np = &st->nodes[st->cur];
+	struct property *pp;
+	const char *pname;
+	const void *val;
+	int ret, len;
+
+	val = fdt_getprop_by_offset(st->blob, offset, &pname, &len);
+	if (!val || !pname)
+		return -EINVAL;
+	ret = of_live_grow(&st->props, &st->prop_alloc, st->prop_count + 1,
+			   sizeof(*st->props));
+	if (ret)
+		return ret;
+	pp = &st->props[st->prop_count++];
+	pp->name = (char *)pname;
+	pp->length = len;
+	pp->value = (void *)val;
+
+	/*
+	 * We accept flattened tree phandles either in ePAPR-style "phandle"
+	 * properties, or the legacy "linux,phandle" properties. If both
+	 * appear and have different values, things will get weird. Don't do
+	 * that. The "ibm,phandle" property used in pSeries dynamic device
+	 * tree stuff always wins.
+	 */
+	if (!strcmp(pname, "phandle") || !strcmp(pname, "linux,phandle")) {
+		if (!np->phandle)
+			np->phandle = be32_to_cpup(val);
+	} else if (!strcmp(pname, "ibm,phandle")) {
+		np->phandle = be32_to_cpup(val);
+	} else if (!strcmp(pname, "name")) {
+		st->has_name = true;
+	}
+
+	return 0;
+}
+
+/**
+ * of_live_scan() - Add all the nodes and properties in the flat tree
+ *
+ * This walks the tags of the flat tree once, in order.
+ *
+ * @st: Build state
+ * @return 0 if OK, -ve on error
+ */
+static int of_live_scan(struct of_live_state *st)
+{
+	int parent[FDT_MAX_DEPTH], last[FDT_MAX_DEPTH];
+	int offset, next, depth = -1;
+	int ret;
 
-		if (pname == NULL) {
-			debug("Can't find property name in list !\n");
+	for (offset = 0;; offset = next) {
+		switch (fdt_next_tag(st->blob, offset, &next)) {
+		case FDT_BEGIN_NODE:
+			if (st->cur >= 0) {
+				ret = of_live_end_props(st);
+				if (ret)
+					return ret;
+			}
+			if (++depth == FDT_MAX_DEPTH)
+				return -E2BIG;
+			ret = of_live_add_node(st, offset,
+					       depth ? parent[depth - 1] : -1,
+					       depth ? &last[depth - 1] : NULL);
+			if (ret < 0)
+				return ret;
+			parent[depth] = ret;
+			last[depth] = -1;
 			break;
-		}
-		if (strcmp(pname, "name") == 0)
-			has_name = 1;
-		pp = unflatten_dt_alloc(&mem, sizeof(struct property),
-					__alignof__(struct property));
-		if (!dryrun) {
-			/*
-			 * We accept flattened tree phandles either in
-			 * ePAPR-style "phandle" properties, or the
-			 * legacy "linux,phandle" properties.  If both
-			 * appear and have different values, things
-			 * will get weird.  Don't do that. */
-			if ((strcmp(pname, "phandle") == 0) ||
-			    (strcmp(pname, "linux,phandle") == 0)) {
-				if (np->phandle == 0)
-					np->phandle = be32_to_cpup(p);
+		case FDT_PROP:
+			if (st->cur < 0)
+				return -EINVAL;
+			ret = of_live_add_prop(st, offset);
+			if (ret)
+				return ret;
+			break;
+		case FDT_END_NODE:
+			if (depth < 0)
+				return -EINVAL;
+			if (st->cur >= 0) {
+				ret = of_live_end_props(st);
+				if (ret)
+					return ret;
 			}
-			/*
-			 * And we process the "ibm,phandle" property
-			 * used in pSeries dynamic device tree
-			 * stuff */
-			if (strcmp(pname, "ibm,phandle") == 0)
-				np->phandle = be32_to_cpup(p);
-			pp->name = (char *)pname;
-			pp->length = sz;
-			pp->value = (__be32 *)p;
-			*prev_pp = pp;
-			prev_pp = &pp->next;
+			if (--depth < 0)
+				return 0;
+			break;
+		case FDT_NOP:
+			break;
+		default:
+			debug("unflatten: error %d processing FDT\n", next);
+			return -EINVAL;
 		}
 	}
-	/*
-	 * with version 0x10 we may not have the name property, recreate
-	 * it here from the unit name if absent
-	 */
-	if (!has_name) {
-		const char *p1 = pathp, *ps = pathp, *pa = NULL;
-		int sz;
-
-		while (*p1) {
-			if ((*p1) == '@')
-				pa = p1;
-			if ((*p1) == '/')
-				ps = p1 + 1;
-			p1++;
-		}
-		if (pa < ps)
-			pa = p1;
-		sz = (pa - ps) + 1;
-		pp = unflatten_dt_alloc(&mem, sizeof(struct property) + sz,
-					__alignof__(struct property));
-		if (!dryrun) {
+}
+
+/**
+ * of_live_link() - Turn the links in the new tree into pointers
+ *
+ * @st: Build state, whose arrays are now complete
+ */
+static void of_live_link(struct of_live_state *st)
+{
+	struct device_node *np;
+	struct property *pp;
+	int i;
+
+	for (i = 0; i < st->prop_count; i++) {
+		pp = &st->props[i];
+		pp->next = of_live_ptr(st->props, sizeof(*pp), pp->next);
+		if (!pp->name) {
 			pp->name = "name";
-			pp->length = sz;
-			pp->value = pp + 1;
-			*prev_pp = pp;
-			prev_pp = &pp->next;
-			memcpy(pp->value, ps, sz - 1);
-			((char *)pp->value)[sz - 1] = 0;
-			debug("fixed up name for %s -> %s\n", pathp,
-			      (char *)pp->value);
+			pp->value = st->names + (ulong)pp->value;
 		}
 	}
-	if (!dryrun) {
-		*prev_pp = NULL;
+	for (i = 0; i < st->node_count; i++) {
+		np = &st->nodes[i];
+		np->properties = of_live_ptr(st->props, sizeof(*pp),
+					     np->properties);
+		np->parent = of_live_ptr(st->nodes, sizeof(*np), np->parent);
+		np->child = of_live_ptr(st->nodes, sizeof(*np), np->child);
+		np->sibling = of_live_ptr(st->nodes, sizeof(*np), np->sibling);
 		np->name = of_get_property(np, "name", NULL);
 		np->type = of_get_property(np, "device_type", NULL);
-
 		if (!np->name)
 			np->name = "<NULL>";
 		if (!np->type)
-			np->type = "<NULL>";	}
-
-	old_depth = depth;
-	*poffset = fdt_next_node(blob, *poffset, &depth);
-	if (depth < 0)
-		depth = 0;
-	while (*poffset > 0 && depth > old_depth) {
-		mem = unflatten_dt_node(blob, mem, poffset, np, NULL,
-					fpsize, dryrun);
-		if (!mem)
-			return NULL;
-	}
-
-	if (*poffset < 0 && *poffset != -FDT_ERR_NOTFOUND) {
-		debug("unflatten: error %d processing FDT\n", *poffset);
-		return NULL;
-	}
-
-	/*
-	 * Reverse the child list. Some drivers assumes node order matches .dts
-	 * node order
-	 */
-	if (!dryrun && np->child) {
-		struct device_node *child = np->child;
-		np->child = NULL;
-		while (child) {
-			struct device_node *next = child->sibling;
-
-			child->sibling = np->child;
-			np->child = child;
-			child = next;
-		}
+			np->type = "<NULL>";
 	}
-
-	if (nodepp)
-		*nodepp = np;
-
-	return mem;
 }
 
 /**
@@ -261,9 +342,9 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 static int unflatten_device_tree(const void *blob,
 				 struct device_node **mynodes)
 {
-	unsigned long size;
-	int start;
-	void *mem;
+	struct of_live_state st;
+	int ret, struct_size;
+	ulong size;
 
 	debug(" -> unflatten_device_tree()\n");
 
@@ -282,34 +363,44 @@ static int unflatten_device_tree(const void *blob,
 		return -EINVAL;
 	}
 
-	/* First pass, scan for size */
-	start = 0;
-	size = (unsigned long)unflatten_dt_node(blob, NULL, &start, NULL, NULL,
-						0, true);
-	if (!size)
-		return -EFAULT;
-	size = ALIGN(size, 4);
-
-	debug("  size is %lx, allocating...\n", size);
-
-	/* Allocate memory for the expanded device tree */
-	mem = malloc(size + 4);
-	memset(mem, '\0', size);
-
-	*(__be32 *)(mem + size) = cpu_to_be32(0xdeadbeef);
-
-	debug("  unflattening %p...\n", mem);
-
-	/* Second pass, do actual unflattening */
-	start = 0;
-	unflatten_dt_node(blob, mem, &start, NULL, mynodes, 0, false);
-	if (be32_to_cpup(mem + size) != 0xdeadbeef) {
-		debug("End of tree marker overwritten: %08x\n",
-		      be32_to_cpup(mem + size));
-		return -ENOSPC;
+	/*
+	 * Start with a guess of the size from the size of the structure
+	 * block, to avoid growing the arrays in the common case: nodes are
+	 * typically a little over 100 bytes and properties about 20
+	 */
+	memset(&st, '\0', sizeof(st));
+	st.blob = blob;
+	st.cur = -1;
+	struct_size = fdt_size_dt_struct(blob);
+	ret = of_live_grow(&st.nodes, &st.node_alloc, struct_size / 128 + 1,
+			   sizeof(*st.nodes));
+	if (!ret)
+		ret = of_live_grow(&st.props, &st.prop_alloc,
+				   struct_size / 24 + 1, sizeof(*st.props));
+	if (!ret)
+		ret = of_live_scan(&st);
+	if (ret) {
+		debug("unflatten: error %d\n", ret);
+		free(st.nodes);
+		free(st.props);
+		free(st.names);
+		return ret;
 	}
 
-	debug(" <- unflatten_device_tree()\n");
+	/* Give back the unused space, now that the sizes are known */
+	st.nodes = of_live_trim(st.nodes, st.node_count * sizeof(*st.nodes));
+	st.props = of_live_trim(st.props, st.prop_count * sizeof(*st.props));
+	st.names = of_live_trim(st.names, st.names_len);
+	of_live_link(&st);
+	*mynodes = st.nodes;
+
+	size = st.node_count * sizeof(*st.nodes) +
+		st.prop_count * sizeof(*st.props) + st.names_len;
+	snprintf(of_live_report, sizeof(of_live_report),
+		 "of_live: %d nodes, %d props, %lu bytes", st.node_count,
+		 st.prop_count, size);
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, of_live_report);
+	debug(" <- unflatten_device_tree(): %s\n", of_live_report);
 
 	return 0;
 }
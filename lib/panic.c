@@ -10,6 +10,8 @@
  */
 
 #include <common.h>
+#include <blk.h>
+#include <serial.h>
 #if !defined(CONFIG_PANIC_HANG)
 #include <command.h>
 #endif
@@ -19,6 +21,8 @@ static void panic_finish(void) __attribute__ ((noreturn));
 static void panic_finish(void)
 {
 	putc('\n');
+	blkcache_flush_all();
+	serial_flush();
 #if defined(CONFIG_PANIC_HANG)
 	hang();
 #else
@@ -19,33 +19,19 @@ int hash_calculate(const char *name,
 		    const struct image_region region[],
 		    int region_count, uint8_t *checksum)
 {
-	struct hash_algo *algo;
-	int ret = 0;
-	void *ctx;
-	uint32_t i;
-	i = 0;
+	struct hash_stream hs;
+	int ret;
+	int i;
 
-	ret = hash_progressive_lookup_algo(name, &algo);
+	ret = hash_stream_start(&hs, name);
 	if (ret)
 		return ret;
 
-	ret = algo->hash_init(algo, &ctx);
-	if (ret)
-		return ret;
-
-	for (i = 0; i < region_count - 1; i++) {
-		ret = algo->hash_update(algo, ctx, region[i].data,
-					region[i].size, 0);
+	for (i = 0; i < region_count; i++) {
+		ret = hash_stream_update(&hs, region[i].data, region[i].size);
 		if (ret)
 			return ret;
 	}
 
-	ret = algo->hash_update(algo, ctx, region[i].data, region[i].size, 1);
-	if (ret)
-		return ret;
-	ret = algo->hash_finish(algo, ctx, checksum, algo->digest_size);
-	if (ret)
-		return ret;
-
-	return 0;
+	return hash_stream_finish(&hs, checksum, hs.algo->digest_size);
 }
@@ -425,12 +425,17 @@ int rsa_verify(struct image_sign_info *info,
 		return -ENOENT;
 	}
 
-	/* Calculate checksum with checksum-algorithm */
-	ret = info->checksum->calculate(info->checksum->name,
-					region, region_count, hash);
-	if (ret < 0) {
-		debug("%s: Error in checksum calculation\n", __func__);
-		return -EINVAL;
+	/* Calculate checksum with checksum-algorithm, unless already done */
+	if (info->digest) {
+		memcpy(hash, info->digest, info->checksum->checksum_len);
+	} else {
+		ret = info->checksum->calculate(info->checksum->name,
+						region, region_count, hash);
+		if (ret < 0) {
+			debug("%s: Error in checksum calculation\n",
+			      __func__);
+			return -EINVAL;
+		}
 	}
 
 	/* See if we must use a particular key */
@@ -65,7 +65,7 @@ void sha1_starts (sha1_context * ctx)
 	ctx->state[4] = 0xC3D2E1F0;
 }
 
-static void sha1_process(sha1_context *ctx, const unsigned char data[64])
+static void sha1_process_one(sha1_context *ctx, const unsigned char data[64])
 {
 	unsigned long temp, W[16], A, B, C, D, E;
 
@@ -219,6 +219,48 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	ctx->state[4] += E;
 }
 
+#if defined(CONFIG_SHA_ARMV8_CE) || defined(CONFIG_SHA_ARMV7)
+static void sha1_transform(sha1_context *ctx, const unsigned char *data,
+			   unsigned int blocks)
+{
+	uint32_t state[5];
+	int i;
+
+	/* state[] is unsigned long, the block functions want 32-bit words */
+	for (i = 0; i < 5; i++)
+		state[i] = ctx->state[i];
+#ifdef CONFIG_SHA_ARMV8_CE
+	sha1_ce_transform(state, data, blocks);
+#else
+	sha1_armv7_transform(state, data, blocks);
+#endif
+	for (i = 0; i < 5; i++)
+		ctx->state[i] = state[i];
+}
+#endif
+
+static void sha1_process(sha1_context *ctx, const unsigned char *data,
+			 unsigned int blocks)
+{
+	if (!blocks)
+		return;
+
+#ifdef CONFIG_SHA_ARMV8_CE
+	if (sha1_ce_available()) {
+		sha1_transform(ctx, data, blocks);
+		return;
+	}
+#elif defined(CONFIG_SHA_ARMV7)
+	sha1_transform(ctx, data, blocks);
+	return;
+#endif
+
+	while (blocks--) {
+		sha1_process_one(ctx, data);
+		data += 64;
+	}
+}
+
 /*
  * SHA-1 process buffer
  */
@@ -242,17 +284,15 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_process(ctx, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
-	}
+	sha1_process(ctx, input, ilen / 64);
+	input += ilen & ~0x3F;
+	ilen &= 0x3F;
 
 	if (ilen > 0) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, ilen);
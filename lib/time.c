@@ -7,6 +7,7 @@
 #include <common.h>
 #include <dm.h>
 #include <errno.h>
+#include <serial.h>
 #include <time.h>
 #include <timer.h>
 #include <watchdog.h>
@@ -154,6 +155,11 @@ unsigned long __weak notrace timer_get_us(void)
 	return tick_to_time(get_ticks() * 1000);
 }
 
+unsigned long __weak get_cpu_cycles(void)
+{
+	return 0;
+}
+
 uint64_t usec_to_tick(unsigned long usec)
 {
 	uint64_t tick = usec;
@@ -180,6 +186,7 @@ void udelay(unsigned long usec)
 
 	do {
 		WATCHDOG_RESET();
+		serial_drain();
 		kv = usec > CONFIG_WD_PERIOD ? CONFIG_WD_PERIOD : usec;
 		__udelay (kv);
 		usec -= kv;
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running work items on secondary CPUs
+ *
+ * This is the generic part. The CPU backend provides the arch_work_...()
+ * hooks: host threads on sandbox, PSCI on ARMv8. When the backend
+ * has no free CPU an item runs on the calling CPU, so callers can use the
+ * same code whether or not secondaries are available.
+ */
+
+#include <common.h>
+#include <workqueue.h>
+
+/* Full memory barrier between CPUs */
+#define work_mb()	__sync_synchronize()
+
+int work_cpus(void)
+{
+	return arch_work_cpus();
+}
+
+void work_run(struct work *work)
+{
+	work->ret = work->func(work->arg);
+	/* Make the results visible before the item is seen as done */
+	work_mb();
+	work->done = 1;
+}
+
+void work_queue(struct work *work, int (*func)(void *arg), void *arg)
+{
+	work->func = func;
+	work->arg = arg;
+	work->ret = 0;
+	work->done = 0;
+	work_mb();
+
+	if (arch_work_submit(work))
+		work_run(work);
+}
+
+int work_wait(struct work *work)
+{
+	if (!work->done)
+		arch_work_wait(work);
+
+	return work->ret;
+}
+
+int work_wait_all(struct work *work, int count)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		work_wait(&work[i]);
+		if (!ret)
+			ret = work[i].ret;
+	}
+
+	return ret;
+}
+
+void work_stop(void)
+{
+	arch_work_stop();
+}
@@ -2,6 +2,10 @@
  * Copyright (C) 1995-2005 Mark Adler
  * For conditions of distribution and use, see copyright notice in zlib.h
  */
+/* U-Boot: inflate() may run on a CPU which must not touch the watchdog */
+#define INFLATE_WATCHDOG_RESET(state) \
+    do { if (!(state)->no_watchdog) WATCHDOG_RESET(); } while (0)
+
 local void fixedtables OF((struct inflate_state FAR *state));
 local int updatewindow OF((z_streamp strm, unsigned out));
 
@@ -25,7 +29,7 @@ int ZEXPORT inflateReset(z_streamp strm)
     state->hold = 0;
     state->bits = 0;
     state->lencode = state->distcode = state->next = state->codes;
-    WATCHDOG_RESET();
+    INFLATE_WATCHDOG_RESET(state);
     Tracev((stderr, "inflate: reset\n"));
     return Z_OK;
 }
@@ -67,9 +71,18 @@ int ZEXPORT inflateInit2_(z_streamp strm, int windowBits, const char *version,
     }
     state->wbits = (unsigned)windowBits;
     state->window = Z_NULL;
+    state->no_watchdog = 0;
     return inflateReset(strm);
 }
 
+/* U-Boot: stop inflate() resetting the watchdog, e.g. on a secondary CPU */
+int ZEXPORT inflateNoWatchdog(z_streamp strm)
+{
+    if (strm == Z_NULL || strm->state == Z_NULL) return Z_STREAM_ERROR;
+    ((struct inflate_state FAR *)strm->state)->no_watchdog = 1;
+    return Z_OK;
+}
+
 int ZEXPORT inflateInit_(z_streamp strm, const char *version, int stream_size)
 {
     return inflateInit2_(strm, DEF_WBITS, version, stream_size);
@@ -543,7 +556,7 @@ int ZEXPORT inflate(z_streamp strm, int flush)
             strm->adler = state->check = adler32(0L, Z_NULL, 0);
             state->mode = TYPE;
         case TYPE:
-	    WATCHDOG_RESET();
+	    INFLATE_WATCHDOG_RESET(state);
             if (flush == Z_BLOCK) goto inf_leave;
         case TYPEDO:
             if (state->last) {
@@ -721,7 +734,7 @@ int ZEXPORT inflate(z_streamp strm, int flush)
             Tracev((stderr, "inflate:       codes ok\n"));
             state->mode = LEN;
         case LEN:
-	    WATCHDOG_RESET();
+	    INFLATE_WATCHDOG_RESET(state);
             if (have >= 6 && left >= 258) {
                 RESTORE();
                 inflate_fast(strm, out);
@@ -933,7 +946,7 @@ int ZEXPORT inflateEnd(z_streamp strm)
         return Z_STREAM_ERROR;
     state = (struct inflate_state FAR *)strm->state;
     if (state->window != Z_NULL) {
-	WATCHDOG_RESET();
+	INFLATE_WATCHDOG_RESET(state);
 	ZFREE(strm, state->window);
     }
     ZFREE(strm, strm->state);
@@ -32,6 +32,8 @@ DECLARE_GLOBAL_DATA_PTR;
 #endif
 /* Number of "loading" hashes per line (for checking the image size) */
 #define HASHES_PER_LINE	65
+/* Largest window (RFC 7440) we can track out-of-order blocks for */
+#define TFTP_WINDOWSIZE_MAX	256
 
 /*
  *	TFTP operations.
@@ -77,8 +79,16 @@ static int	tftp_our_port;
 static int	timeout_count;
 /* packet sequence number */
 static ulong	tftp_cur_block;
-/* last packet sequence number received */
+/* last packet sequence number received, or last in-order block when reading */
 static ulong	tftp_prev_block;
+/* last block we acknowledged (absolute, i.e. not wrapped) */
+static ulong	tftp_last_ack;
+/* absolute number of the final (short) block, 0 if not seen yet */
+static ulong	tftp_final_block;
+/* 1 if we have already asked the sender to resend from tftp_prev_block */
+static int	tftp_gap_acked;
+/* blocks received ahead of tftp_prev_block, indexed modulo the max window */
+static uchar	tftp_window_map[TFTP_WINDOWSIZE_MAX / 8];
 /* count of sequence number wraparounds */
 static ulong	tftp_block_wrap;
 /* memory offset due to wrapping */
@@ -141,9 +151,28 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
-static inline int store_block(int block, uchar *src, unsigned int len)
+/* Number of blocks the server may send before waiting for an ACK */
+static unsigned short tftp_windowsize = 1;
+static unsigned short tftp_windowsize_option = CONFIG_TFTP_WINDOWSIZE;
+
+#ifdef CONFIG_CMD_TFTPSRV
+/* Options requested in an incoming WRQ, to be confirmed by OACK */
+#define TFTP_OPT_BLKSIZE	BIT(0)
+#define TFTP_OPT_WINDOWSIZE	BIT(1)
+static int	tftp_srv_options;
+#endif
+
+/**
+ * store_block() - copy a received data block to its place in memory
+ *
+ * @block:	Block index, counting from 0 and ignoring sequence wraparound
+ * @src:	Block data
+ * @len:	Number of bytes in the block
+ * @return 0 if OK, non-zero on error
+ */
+static inline int store_block(ulong block, uchar *src, unsigned int len)
 {
-	ulong offset = block * tftp_block_size + tftp_block_wrap_offset;
+	ulong offset = block * tftp_block_size;
 	ulong newsize = offset + len;
 	ulong store_addr = tftp_load_addr + offset;
 #ifdef CONFIG_SYS_DIRECT_FLASH_TFTP
@@ -200,6 +229,10 @@ static void new_transfer(void)
 	tftp_prev_block = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
+	tftp_last_ack = 0;
+	tftp_final_block = 0;
+	tftp_gap_acked = 0;
+	memset(tftp_window_map, '\0', sizeof(tftp_window_map));
 #ifdef CONFIG_CMD_TFTPPUT
 	tftp_put_final_block_sent = 0;
 #endif
@@ -352,12 +385,32 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		/* and for several blocks per ACK when reading */
+		if (tftp_state == STATE_SEND_RRQ && tftp_windowsize_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_windowsize_option, 0);
 		len = pkt - xp;
 		break;
 
-	case STATE_OACK:
-
 	case STATE_RECV_WRQ:
+#ifdef CONFIG_CMD_TFTPSRV
+		if (tftp_srv_options) {
+			xp = pkt;
+			s = (ushort *)pkt;
+			*s++ = htons(TFTP_OACK);
+			pkt = (uchar *)s;
+			if (tftp_srv_options & TFTP_OPT_BLKSIZE)
+				pkt += sprintf((char *)pkt, "blksize%c%d%c",
+						0, tftp_block_size, 0);
+			if (tftp_srv_options & TFTP_OPT_WINDOWSIZE)
+				pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+						0, tftp_windowsize, 0);
+			len = pkt - xp;
+			break;
+		}
+#endif
+		/* fall through */
+	case STATE_OACK:
 	case STATE_DATA:
 		xp = pkt;
 		s = (ushort *)pkt;
@@ -405,6 +458,140 @@ static void tftp_send(void)
 			    tftp_remote_port, tftp_our_port, len);
 }
 
+static int window_test_and_set(ulong block)
+{
+	uint bit = block % TFTP_WINDOWSIZE_MAX;
+	uchar mask = 1 << (bit & 7);
+	uchar *p = &tftp_window_map[bit >> 3];
+	int old = (*p & mask) != 0;
+
+	*p |= mask;
+
+	return old;
+}
+
+static int window_test_and_clear(ulong block)
+{
+	uint bit = block % TFTP_WINDOWSIZE_MAX;
+	uchar mask = 1 << (bit & 7);
+	uchar *p = &tftp_window_map[bit >> 3];
+	int old = (*p & mask) != 0;
+
+	*p &= ~mask;
+
+	return old;
+}
+
+/* Acknowledge everything up to the last block received in order */
+static void tftp_send_ack(void)
+{
+	tftp_cur_block = (ushort)tftp_prev_block;
+	tftp_last_ack = tftp_prev_block;
+	tftp_send();
+}
+
+/**
+ * tftp_window_recv() - accept a data block into the receive window
+ *
+ * Blocks inside the window are stored as soon as they arrive, whatever
+ * their order, and remembered in tftp_window_map until the blocks before
+ * them turn up. An ACK is only sent when the window is complete, when the
+ * final block is in, or once per gap so that the sender restarts from the
+ * first missing block (RFC 7440 section 4). With a window size of 1 this
+ * is the plain lock-step protocol of RFC 1350.
+ *
+ * @block:	Block number from the packet
+ * @src:	Block data
+ * @len:	Number of bytes in the block
+ * @return 0 if OK, -1 if the block could not be stored
+ */
+static int tftp_window_recv(ushort block, uchar *src, unsigned int len)
+{
+	ulong delta = (ushort)(block - (ushort)tftp_prev_block);
+	ulong abs_block;
+
+	/*
+	 * Same block again, or one from a window already acknowledged; ignore
+	 * it. If our ACK got lost the timeout will send it again.
+	 */
+	if (!delta || delta > tftp_windowsize)
+		return 0;
+
+	abs_block = tftp_prev_block + delta;
+	if (window_test_and_set(abs_block))
+		return 0;
+
+	if (store_block(abs_block - 1, src, len))
+		return -1;
+	if (len < tftp_block_size)
+		tftp_final_block = abs_block;
+
+	/* Slide the window over everything that is now in order */
+	while (window_test_and_clear(tftp_prev_block + 1)) {
+		tftp_prev_block++;
+		tftp_cur_block = (ushort)tftp_prev_block;
+		tftp_gap_acked = 0;
+		update_block_number();
+	}
+
+	if (tftp_final_block && tftp_prev_block == tftp_final_block) {
+		tftp_send_ack();
+		tftp_complete();
+	} else if (tftp_prev_block - tftp_last_ack >= tftp_windowsize) {
+		tftp_send_ack();
+	} else if (delta != 1 && !tftp_gap_acked) {
+		tftp_gap_acked = 1;
+		tftp_send_ack();
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_CMD_TFTPSRV
+/**
+ * tftp_parse_wrq_options() - pick up the options of an incoming write request
+ *
+ * Only blksize and windowsize are honoured; anything else is left out of
+ * the OACK, as RFC 2347 allows.
+ *
+ * @pkt:	Request, starting with the file name
+ * @len:	Length of the request
+ */
+static void tftp_parse_wrq_options(uchar *pkt, unsigned len)
+{
+	char *opt = (char *)pkt;
+	char *end = (char *)pkt + len;
+	int i;
+
+	tftp_srv_options = 0;
+
+	/* Skip the file name and mode */
+	for (i = 0; i < 2 && opt < end; i++)
+		opt += strnlen(opt, end - opt) + 1;
+
+	while (opt < end) {
+		char *val = opt + strnlen(opt, end - opt) + 1;
+		ulong n;
+
+		if (val >= end)
+			break;
+		n = simple_strtoul(val, NULL, 10);
+		if (!strcasecmp(opt, "blksize") && n >= 8) {
+			tftp_block_size = min_t(ulong, n,
+						tftp_block_size_option);
+			tftp_srv_options |= TFTP_OPT_BLKSIZE;
+		} else if (!strcasecmp(opt, "windowsize") && n) {
+			tftp_windowsize = min_t(ulong, n,
+						tftp_windowsize_option);
+			tftp_srv_options |= TFTP_OPT_WINDOWSIZE;
+		}
+		opt = val + strnlen(val, end - val) + 1;
+	}
+	debug("WRQ options: blksize %d, windowsize %d\n", tftp_block_size,
+	      tftp_windowsize);
+}
+#endif
+
 #ifdef CONFIG_CMD_TFTPPUT
 static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 			 struct in_addr sip, unsigned src, uchar *pkt,
@@ -422,6 +609,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 {
 	__be16 proto;
 	__be16 *s;
+	ushort block;
 	int i;
 
 	if (dest != tftp_our_port) {
@@ -474,7 +662,8 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		tftp_remote_port = src;
 		tftp_our_port = 1024 + (get_timer(0) % 3072);
 		new_transfer();
-		tftp_send(); /* Send ACK(0) */
+		tftp_parse_wrq_options(pkt, len);
+		tftp_send(); /* Send ACK(0) or OACK */
 		break;
 #endif
 
@@ -496,6 +685,18 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (i + 11 < len &&
+			    strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_windowsize = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				if (!tftp_windowsize ||
+				    tftp_windowsize > tftp_windowsize_option)
+					tftp_windowsize =
+						tftp_windowsize_option;
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_windowsize);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -518,9 +719,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (len < 2)
 			return;
 		len -= 2;
-		tftp_cur_block = ntohs(*(__be16 *)pkt);
-
-		update_block_number();
+		block = ntohs(*(__be16 *)pkt);
 
 		if (tftp_state == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
@@ -532,39 +731,30 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			tftp_remote_port = src;
 			new_transfer();
 
-			if (tftp_cur_block != 1) {	/* Assertion */
+			/* Block 1 may be lost, but not the whole window */
+			if (!block || block > tftp_windowsize) { /* Assertion */
 				puts("\nTFTP error: ");
-				printf("First block is not block 1 (%ld)\n",
-				       tftp_cur_block);
+				printf("First block is not block 1 (%d)\n",
+				       block);
 				puts("Starting again\n\n");
 				net_start_again();
 				break;
 			}
 		}
 
-		if (tftp_cur_block == tftp_prev_block) {
-			/* Same block again; ignore it. */
-			break;
-		}
-
-		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
-		if (store_block(tftp_cur_block - 1, pkt + 2, len)) {
+		/*
+		 * Store the block and, at the end of the window or on a gap,
+		 * acknowledge what we have, which will prompt the remote for
+		 * the next blocks.
+		 */
+		if (tftp_window_recv(block, pkt + 2, len)) {
 			eth_halt();
 			net_set_state(NETLOOP_FAIL);
 			break;
 		}
-
-		/*
-		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
-		 */
-		tftp_send();
-
-		if (len < tftp_block_size)
-			tftp_complete();
 		break;
 
 	case TFTP_ERROR:
@@ -600,8 +790,13 @@ static void tftp_timeout_handler(void)
 	} else {
 		puts("T ");
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
-		if (tftp_state != STATE_RECV_WRQ)
+		if (tftp_state == STATE_DATA && !tftp_put_active) {
+			/* Resume the window at the first missing block */
+			tftp_gap_acked = 0;
+			tftp_send_ack();
+		} else if (tftp_state != STATE_RECV_WRQ) {
 			tftp_send();
+		}
 	}
 }
 
@@ -624,6 +819,30 @@ static int tftp_init_load_addr(void)
 	return 0;
 }
 
+#if CONFIG_NET_TFTP_VARS
+/* Let the user choose the TFTP block and window sizes */
+static void tftp_get_size_vars(void)
+{
+	char *ep;
+
+	ep = env_get("tftpblocksize");
+	if (ep != NULL)
+		tftp_block_size_option = simple_strtol(ep, NULL, 10);
+
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL)
+		tftp_windowsize_option = simple_strtol(ep, NULL, 10);
+
+	if (tftp_windowsize_option > TFTP_WINDOWSIZE_MAX) {
+		printf("TFTP window size (%d) too large, set max = %d\n",
+		       tftp_windowsize_option, TFTP_WINDOWSIZE_MAX);
+		tftp_windowsize_option = TFTP_WINDOWSIZE_MAX;
+	}
+	if (tftp_windowsize_option < 1)
+		tftp_windowsize_option = 1;
+}
+#endif
+
 void tftp_start(enum proto_t protocol)
 {
 #if CONFIG_NET_TFTP_VARS
@@ -634,9 +853,7 @@ void tftp_start(enum proto_t protocol)
 	 * TFTP protocol has a minimal timeout of 1 second.
 	 */
 
-	ep = env_get("tftpblocksize");
-	if (ep != NULL)
-		tftp_block_size_option = simple_strtol(ep, NULL, 10);
+	tftp_get_size_vars();
 
 	ep = env_get("tftptimeout");
 	if (ep != NULL)
@@ -659,8 +876,8 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_windowsize_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (!net_parse_bootfile(&tftp_remote_ip, tftp_filename, MAX_LEN)) {
@@ -759,8 +976,9 @@ void tftp_start(enum proto_t protocol)
 
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_windowsize to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_windowsize = 1;
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
 	tftp_tsize_num_hash = 0;
@@ -774,6 +992,12 @@ void tftp_start_server(void)
 {
 	tftp_filename[0] = 0;
 
+#if CONFIG_NET_TFTP_VARS
+	tftp_get_size_vars();
+#endif
+	debug("TFTP blocksize = %i, windowsize = %i\n",
+	      tftp_block_size_option, tftp_windowsize_option);
+
 	if (tftp_init_load_addr()) {
 		eth_halt();
 		net_set_state(NETLOOP_FAIL);
@@ -791,8 +1015,9 @@ void tftp_start_server(void)
 	timeout_ms = TIMEOUT;
 	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_windowsize to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_windowsize = 1;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
@@ -801,6 +1026,7 @@ void tftp_start_server(void)
 	tftp_tsize_num_hash = 0;
 #endif
 
+	tftp_srv_options = 0;
 	tftp_state = STATE_RECV_WRQ;
 	net_set_udp_handler(tftp_handler);
 
@@ -7,6 +7,7 @@
 #include <bootm.h>
 #include <command.h>
 #include <gzip.h>
+#include <hexdump.h>
 #include <lz4.h>
 #include <malloc.h>
 #include <mapmem.h>
@@ -155,6 +156,33 @@ static int uncompress_using_gzip(struct unit_test_state *uts,
 	return ret;
 }
 
+/* Feed gzip data to the streaming decompressor a few bytes at a time */
+static int uncompress_using_gzip_stream(struct unit_test_state *uts,
+					void *in, unsigned long in_size,
+					void *out, unsigned long out_max,
+					unsigned long *out_size)
+{
+	struct gunzip_stream *gs;
+	unsigned long pos, len;
+	int ret = 0;
+
+	gs = gunzip_stream_start(out, out_max);
+	if (!gs)
+		return -ENOMEM;
+
+	/* The first piece must hold the header */
+	for (pos = 0; !ret && pos < in_size; pos += len) {
+		len = min(in_size - pos, pos ? 13UL : 32UL);
+		ret = gunzip_stream_feed(gs, in + pos, len);
+	}
+	if (ret) {
+		gunzip_stream_finish(gs, NULL);
+		return ret;
+	}
+
+	return gunzip_stream_finish(gs, out_size);
+}
+
 static int compress_using_bzip2(struct unit_test_state *uts,
 				void *in, unsigned long in_size,
 				void *out, unsigned long out_max,
@@ -412,6 +440,60 @@ static int compression_test_gzip(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_gzip, 0);
 
+static int compression_test_gzip_stream(struct unit_test_state *uts)
+{
+	return run_test(uts, "gzip_stream", compress_using_gzip,
+			uncompress_using_gzip_stream);
+}
+COMPRESSION_TEST(compression_test_gzip_stream, 0);
+
+/* More chunks than sandbox has CPUs, so they go in several batches */
+#define GZIP_CHUNKS		11
+
+/* Compress plain[] in pieces and decompress them all with gunzip_chunks() */
+static int compression_test_gzip_chunks(struct unit_test_state *uts)
+{
+	unsigned long plain_size = strlen(plain);
+	unsigned long piece = DIV_ROUND_UP(plain_size, GZIP_CHUNKS);
+	unsigned char in[TEST_BUFFER_SIZE * 2];
+	char out[TEST_BUFFER_SIZE];
+	u32 sizes[GZIP_CHUNKS];
+	unsigned long pos, len;
+	unsigned long size;
+	unsigned char *trailer;
+	int i;
+
+	for (i = 0, pos = 0, len = 0; i < GZIP_CHUNKS; i++, pos += piece) {
+		size = sizeof(in) - len;
+		ut_assertok(gzip(in + len, &size, (unsigned char *)plain + pos,
+				 min(piece, plain_size - pos)));
+		sizes[i] = size;
+		len += size;
+	}
+
+	memset(out, 'A', sizeof(out));
+	ut_assertok(gunzip_chunks(out, sizeof(out), in, sizes, GZIP_CHUNKS,
+				  &len));
+	ut_asserteq(plain_size, len);
+	ut_asserteq_mem(plain, out, plain_size);
+	ut_asserteq('A', out[plain_size]);
+
+	/* Exactly the right size, then too small */
+	ut_assertok(gunzip_chunks(out, plain_size, in, sizes, GZIP_CHUNKS,
+				  &len));
+	ut_asserteq(-ENOSPC, gunzip_chunks(out, plain_size - 1, in, sizes,
+					   GZIP_CHUNKS, &len));
+
+	/* A chunk which does not match its trailer is rejected */
+	trailer = in + sizes[0] + sizes[1] - 4;
+	trailer[0]++;
+	ut_asserteq(-EIO, gunzip_chunks(out, sizeof(out), in, sizes,
+					GZIP_CHUNKS, &len));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_gzip_chunks, 0);
+
 static int compression_test_bzip2(struct unit_test_state *uts)
 {
 	return run_test(uts, "bzip2", compress_using_bzip2,
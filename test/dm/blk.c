@@ -5,6 +5,8 @@
 
 #include <common.h>
 #include <dm.h>
+#include <os.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
 #include <dm/test.h>
@@ -162,3 +164,136 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Get (and reset) the cache counters of host device 0 */
+static int blkcache_host0_stats(struct unit_test_state *uts,
+				struct block_cache_dev_stats *stats)
+{
+	int i;
+
+	for (i = 0; !blkcache_dev_stats(i, stats); i++) {
+		if (stats->iftype == IF_TYPE_HOST && !stats->devnum)
+			return 0;
+	}
+	ut_assert(false);
+
+	return 0;
+}
+
+/* Run the block cache tests on host device 0, backed by @fname */
+static int blkcache_check(struct unit_test_state *uts, const char *fname)
+{
+	struct block_cache_dev_stats stats;
+	struct blk_desc *desc;
+	char buf[512 * 8], cmp[512];
+	char *big;
+	int fd, i;
+
+	/* 256 blocks, each filled with its block number */
+	fd = os_open(fname, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	for (i = 0; i < 256; i++) {
+		memset(buf, i, 512);
+		ut_asserteq(512, os_write(fd, buf, 512));
+	}
+	os_close(fd);
+
+	blkcache_configure(8, 32);
+	ut_assertok(host_dev_bind(0, (char *)fname));
+	desc = blk_get_devnum_by_type(IF_TYPE_HOST, 0);
+	ut_assertnonnull(desc);
+
+	/* Drop the counts from the partition scan */
+	ut_assertok(blkcache_host0_stats(uts, &stats));
+
+	/* A repeated read comes from the cache */
+	ut_asserteq(1, blk_dread(desc, 40, 1, buf));
+	ut_asserteq(40, buf[0]);
+	ut_asserteq(1, blk_dread(desc, 40, 1, buf));
+	ut_assertok(blkcache_host0_stats(uts, &stats));
+	ut_asserteq(1, stats.hits);
+	ut_asserteq(1, stats.misses);
+
+	/* Reading a file block by block mostly hits read-ahead data */
+	for (i = 64; i < 128; i++) {
+		ut_asserteq(1, blk_dread(desc, i, 1, buf));
+		ut_asserteq(i, buf[0]);
+		ut_asserteq(i, buf[511]);
+	}
+	ut_assertok(blkcache_host0_stats(uts, &stats));
+	ut_assert(stats.misses <= 5);
+	ut_assert(stats.readahead > 0);
+
+	/* Writes stay in the cache until flushed in write-back mode */
+	blkcache_set_writeback(true);
+	memset(buf, 0xaa, 512 * 2);
+	ut_asserteq(2, blk_dwrite(desc, 200, 2, buf));
+	fd = os_open(fname, OS_O_RDONLY);
+	ut_assert(fd >= 0);
+	os_lseek(fd, 201 * 512, OS_SEEK_SET);
+	ut_asserteq(512, os_read(fd, cmp, 512));
+	os_close(fd);
+	ut_asserteq(201, (u8)cmp[0]);
+
+	/* A read overlapping dirty blocks sees the new data */
+	ut_asserteq(4, blk_dread(desc, 198, 4, buf));
+	ut_asserteq(198, (u8)buf[0]);
+	ut_asserteq(0xaa, (u8)buf[512 * 2]);
+	ut_asserteq(0xaa, (u8)buf[512 * 3 + 511]);
+
+	/* So does one which is too large to go through the cache */
+	big = malloc(512 * 96);
+	ut_assertnonnull(big);
+	i = blk_dread(desc, 160, 96, big);
+	if (i == 96)
+		i = (u8)big[512 * 40] << 8 | (u8)big[512 * 42];
+	free(big);
+	ut_asserteq(0xaa << 8 | 202, i);
+
+	ut_assertok(blkcache_flush(IF_TYPE_HOST, 0));
+	fd = os_open(fname, OS_O_RDONLY);
+	ut_assert(fd >= 0);
+	os_lseek(fd, 201 * 512, OS_SEEK_SET);
+	ut_asserteq(512, os_read(fd, cmp, 512));
+	os_close(fd);
+	ut_asserteq(0xaa, (u8)cmp[0]);
+	ut_assertok(blkcache_host0_stats(uts, &stats));
+	ut_asserteq(2, stats.writebacks);
+
+	/* Reset, panic and bootm write back all devices */
+	memset(buf, 0x55, 512);
+	ut_asserteq(1, blk_dwrite(desc, 220, 1, buf));
+	blkcache_flush_all();
+	fd = os_open(fname, OS_O_RDONLY);
+	ut_assert(fd >= 0);
+	os_lseek(fd, 220 * 512, OS_SEEK_SET);
+	ut_asserteq(512, os_read(fd, cmp, 512));
+	os_close(fd);
+	ut_asserteq(0x55, (u8)cmp[0]);
+	ut_assertok(blkcache_host0_stats(uts, &stats));
+	ut_asserteq(1, stats.writebacks);
+
+	return 0;
+}
+
+/* Test the block cache, including read-ahead and write-back */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	const char *fname = "blkcache-test.img";
+	struct block_cache_stats saved;
+	int ret;
+
+	blkcache_stats(&saved);
+	ret = blkcache_check(uts, fname);
+
+	/* Put the cache back as it was, even if the test failed */
+	blkcache_set_writeback(saved.writeback);
+	blkcache_configure(saved.max_blocks_per_entry, saved.max_entries);
+	host_dev_bind(0, NULL);
+	os_unlink(fname);
+
+	return ret;
+}
+DM_TEST(dm_test_blk_cache, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
@@ -1034,6 +1034,148 @@ static int dm_test_uclass_names(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_uclass_names, DM_TESTF_SCAN_PDATA);
 
+#define INDEX_TEST_DEVS		200	/* devices bound by the index test */
+#define INDEX_TEST_LOOPS	10000	/* lookups timed for each device */
+
+/* Find a device by sequence number, walking the uclass's list */
+static struct udevice *find_seq_linear(struct uclass *uc, int seq)
+{
+	struct udevice *dev;
+
+	uclass_foreach_dev(dev, uc) {
+		if (dev->seq == seq)
+			return dev;
+	}
+
+	return NULL;
+}
+
+/* Find a device by node, walking the uclass's list */
+static struct udevice *find_node_linear(struct uclass *uc, ofnode node)
+{
+	struct udevice *dev;
+
+	uclass_foreach_dev(dev, uc) {
+		if (ofnode_equal(dev_ofnode(dev), node))
+			return dev;
+	}
+
+	return NULL;
+}
+
+/* Time a number of lookups by position, sequence number and node */
+static void index_test_time(int pos, int seq, ofnode node, ulong times[3])
+{
+	struct udevice *found;
+	ulong start;
+	int i;
+
+	start = timer_get_us();
+	for (i = 0; i < INDEX_TEST_LOOPS; i++)
+		uclass_find_device(UCLASS_TEST, pos, &found);
+	times[0] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < INDEX_TEST_LOOPS; i++)
+		uclass_find_device_by_seq(UCLASS_TEST, seq, false, &found);
+	times[1] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < INDEX_TEST_LOOPS; i++)
+		uclass_find_device_by_ofnode(UCLASS_TEST, node, &found);
+	times[2] = timer_get_us() - start;
+}
+
+/* Test that device lookups match the uclass's list as devices come and go */
+static int dm_test_uclass_index(struct unit_test_state *uts)
+{
+	static const char *const names[] = { "index", "seq", "node" };
+	struct dm_test_state *dms = uts->priv;
+	ofnode node, first_node, last_node;
+	ulong first_us[3], last_us[3];
+	struct udevice *dev, *found;
+	int i, count, max_seq;
+	struct uclass *uc;
+
+	/* Skip the behaviour in test_post_probe() */
+	dms->skip_post_probe = 1;
+
+	ut_assertok(uclass_get(UCLASS_TEST, &uc));
+	ut_asserteq_ptr(uc, uclass_find(UCLASS_TEST));
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	ut_assertnonnull(uc->index);
+#endif
+
+	/*
+	 * Give every other device a node, wrapping around so that some nodes
+	 * have more than one device. The nodes belong to other drivers, so
+	 * only probe the devices without one. Remove and unbind a mixture of
+	 * devices so that the index has to follow the list.
+	 */
+	node = ofnode_first_subnode(ofnode_path("/"));
+	for (i = 0; i < INDEX_TEST_DEVS; i++) {
+		ut_assertok(device_bind_ofnode(dms->root,
+					       DM_GET_DRIVER(test_manual_drv),
+					       "index_test", NULL,
+					       i & 1 ? ofnode_null() : node,
+					       &dev));
+		if (i & 1) {
+			ut_assertok(device_probe(dev));
+			if (i % 5 == 1)
+				ut_assertok(device_remove(dev,
+							  DM_REMOVE_NORMAL));
+		} else {
+			node = ofnode_next_subnode(node);
+			if (!ofnode_valid(node))
+				node = ofnode_first_subnode(ofnode_path("/"));
+		}
+		if (i % 7 == 2 || i % 11 == 3) {
+			ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+			ut_assertok(device_unbind(dev));
+		}
+	}
+
+	count = 0;
+	max_seq = -1;
+	first_node = ofnode_null();
+	last_node = ofnode_null();
+	uclass_foreach_dev(dev, uc) {
+		ut_assertok(uclass_find_device(UCLASS_TEST, count++, &found));
+		ut_asserteq_ptr(dev, found);
+		max_seq = max(max_seq, dev->seq);
+		node = dev_ofnode(dev);
+		if (!ofnode_valid(node))
+			continue;
+		ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST, node,
+							 &found));
+		ut_asserteq_ptr(find_node_linear(uc, node), found);
+		if (!ofnode_valid(first_node))
+			first_node = node;
+		last_node = node;
+	}
+	ut_asserteq(-ENODEV, uclass_find_device(UCLASS_TEST, count, &found));
+	ut_asserteq(-ENODEV, uclass_find_device(UCLASS_TEST, -1, &found));
+
+	for (i = 0; i <= max_seq + 10; i++) {
+		dev = find_seq_linear(uc, i);
+		ut_asserteq(dev ? 0 : -ENODEV,
+			    uclass_find_device_by_seq(UCLASS_TEST, i, false,
+						      &found));
+		ut_asserteq_ptr(dev, found);
+	}
+
+	/* Looking up the last device should not take longer than the first */
+	index_test_time(0, 0, first_node, first_us);
+	index_test_time(count - 1, max_seq, last_node, last_us);
+	printf("lookup  first us  last us  (%d devices, %d lookups)\n", count,
+	       INDEX_TEST_LOOPS);
+	for (i = 0; i < ARRAY_SIZE(names); i++)
+		printf("%-6s%10lu%9lu\n", names[i], first_us[i], last_us[i]);
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_index, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 static int dm_test_inactive_child(struct unit_test_state *uts)
 {
 	struct dm_test_state *dms = uts->priv;
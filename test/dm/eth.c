@@ -11,6 +11,7 @@
 #include <env.h>
 #include <fdtdec.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <net.h>
 #include <dm/test.h>
 #include <dm/device-internal.h>
@@ -429,3 +430,257 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_eth_async_ping_reply, DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_CMD_TFTPBOOT
+#define TFTP_TEST_PORT		5000
+#define TFTP_TEST_SIZE		(1024 * 1024 + 123)
+#define TFTP_TEST_ADDR		0x1000000
+#define TFTP_TEST_BLKSIZE	1468
+/* 715 blocks, the last one short */
+#define TFTP_TEST_BLOCKS	(TFTP_TEST_SIZE / TFTP_TEST_BLKSIZE + 1)
+
+/* TFTP opcodes, see RFC 1350 and RFC 2347 */
+#define TFTP_RRQ	1
+#define TFTP_DATA	3
+#define TFTP_ACK	4
+#define TFTP_OACK	6
+
+/**
+ * struct sb_tftp_server - state of the fake TFTP server behind eth0
+ *
+ * @blksize: Block size agreed with the client
+ * @windowsize: Window size agreed with the client
+ * @nblocks: Number of blocks in the file (the last one is short)
+ * @drop_block: Block to drop the first time it is sent, 0 for none
+ * @client_port: UDP port the client sends from
+ * @data_sent: Number of DATA packets sent
+ * @acks: Number of ACKs received
+ */
+struct sb_tftp_server {
+	int blksize;
+	int windowsize;
+	int nblocks;
+	int drop_block;
+	int client_port;
+	int data_sent;
+	int acks;
+};
+
+static u8 sb_tftp_byte(int offset)
+{
+	return offset * 7 + (offset >> 9);
+}
+
+/* Queue a UDP packet from the fake host in reply to @req */
+static int sb_tftp_reply(struct udevice *dev, void *req, const void *payload,
+			 int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = req;
+	struct ip_udp_hdr *ip = req + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return -ENOSPC;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	memset(ipr, '\0', IP_UDP_HDR_SIZE);
+	ipr->ip_hl_v = 0x45;
+	ipr->ip_len = htons(IP_UDP_HDR_SIZE + len);
+	ipr->ip_off = htons(IP_FLAGS_DFRAG);
+	ipr->ip_ttl = 255;
+	ipr->ip_p = IPPROTO_UDP;
+	net_copy_ip((void *)&ipr->ip_src, &ip->ip_dst);
+	net_copy_ip((void *)&ipr->ip_dst, &ip->ip_src);
+	ipr->ip_sum = compute_ip_checksum(ipr, IP_HDR_SIZE);
+	ipr->udp_src = htons(TFTP_TEST_PORT);
+	ipr->udp_dst = ip->udp_src;
+	ipr->udp_len = htons(UDP_HDR_SIZE + len);
+	memcpy((void *)ipr + IP_UDP_HDR_SIZE, payload, len);
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len;
+	++priv->recv_packets;
+
+	return 0;
+}
+
+/* Send the window of blocks that follows block @acked */
+static void sb_tftp_send_window(struct udevice *dev, void *req,
+				struct sb_tftp_server *srv, int acked)
+{
+	uchar buf[2 * sizeof(__be16) + 1468];
+	__be16 *s = (__be16 *)buf;
+	int block, i;
+
+	for (block = acked + 1;
+	     block <= acked + srv->windowsize && block <= srv->nblocks;
+	     block++) {
+		int offset = (block - 1) * srv->blksize;
+		int len = min(srv->blksize, TFTP_TEST_SIZE - offset);
+
+		if (block == srv->drop_block) {
+			srv->drop_block = 0;
+			continue;
+		}
+		s[0] = htons(TFTP_DATA);
+		s[1] = htons(block);
+		for (i = 0; i < len; i++)
+			buf[4 + i] = sb_tftp_byte(offset + i);
+		if (sb_tftp_reply(dev, req, buf, 4 + len))
+			break;
+		srv->data_sent++;
+	}
+}
+
+static int sb_tftp_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_tftp_server *srv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	__be16 *s = packet + ETHER_HDR_SIZE + IP_UDP_HDR_SIZE;
+	char *opt, *end;
+	uchar oack[64];
+	int oack_len;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	switch (ntohs(s[0])) {
+	case TFTP_RRQ:
+		srv->client_port = ntohs(ip->udp_src);
+		srv->blksize = 512;
+		srv->windowsize = 1;
+
+		/* Skip the file name and mode, then pick up the options */
+		opt = (char *)(s + 1);
+		end = (char *)packet + len;
+		opt += strlen(opt) + 1;
+		opt += strlen(opt) + 1;
+		while (opt < end) {
+			char *val = opt + strlen(opt) + 1;
+
+			if (!strcmp(opt, "blksize"))
+				srv->blksize = simple_strtoul(val, NULL, 10);
+			else if (!strcmp(opt, "windowsize"))
+				srv->windowsize = simple_strtoul(val, NULL, 10);
+			opt = val + strlen(val) + 1;
+		}
+		srv->nblocks = TFTP_TEST_SIZE / srv->blksize + 1;
+
+		s = (__be16 *)oack;
+		*s++ = htons(TFTP_OACK);
+		oack_len = 2 + sprintf((char *)s, "blksize%c%d%cwindowsize%c%d",
+				       0, srv->blksize, 0, 0, srv->windowsize);
+		return sb_tftp_reply(dev, packet, oack, oack_len + 1);
+	case TFTP_ACK:
+		srv->acks++;
+		sb_tftp_send_window(dev, packet, srv, ntohs(s[1]));
+		break;
+	}
+
+	return 0;
+}
+
+static int sb_tftp_get(struct unit_test_state *uts, int windowsize,
+		       int drop_block)
+{
+	struct sb_tftp_server srv = {
+		.drop_block = drop_block,
+	};
+	ulong start, msecs;
+	u8 *buf;
+	int i;
+
+	sandbox_eth_set_priv(0, &srv);
+	env_set_ulong("tftpwindowsize", windowsize);
+
+	buf = map_sysmem(TFTP_TEST_ADDR, TFTP_TEST_SIZE);
+	memset(buf, '\0', TFTP_TEST_SIZE);
+	start = get_timer(0);
+	ut_assertok(run_command("tftpboot 1000000 sb-tftp.bin", 0));
+	msecs = max(get_timer(start), 1UL);
+	ut_asserteq(TFTP_TEST_SIZE, env_get_hex("filesize", 0));
+	for (i = 0; i < TFTP_TEST_SIZE; i++)
+		ut_asserteq(sb_tftp_byte(i), buf[i]);
+	unmap_sysmem(buf);
+
+	/* Only one ACK per window, plus one for a lost block */
+	ut_asserteq(TFTP_TEST_BLKSIZE, srv.blksize);
+	ut_asserteq(TFTP_TEST_BLOCKS, srv.nblocks);
+	ut_asserteq(windowsize, srv.windowsize);
+	ut_assert(srv.acks <= DIV_ROUND_UP(srv.nblocks, windowsize) + 2 +
+		  (drop_block ? 1 : 0));
+	printf("TFTP windowsize %d: %d blocks, %d ACKs, %lu.%03lu MB/s\n",
+	       windowsize, srv.nblocks, srv.acks,
+	       TFTP_TEST_SIZE / 1000 / msecs,
+	       TFTP_TEST_SIZE / msecs % 1000);
+
+	return 0;
+}
+
+/* Test the TFTP client with several window sizes, also over lost blocks */
+static int dm_test_eth_tftp_window(struct unit_test_state *uts)
+{
+	int retval;
+
+	sandbox_eth_set_tx_handler(0, sb_tftp_handler);
+	env_set("ethact", "eth@10002000");
+	net_server_ip = string_to_ip("1.2.3.5");
+
+	env_set_ulong("tftpblocksize", TFTP_TEST_BLKSIZE);
+
+	/*
+	 * The sandbox driver can only queue PKTBUFSRX packets, and after a
+	 * gap a whole window may still be waiting when the next one is sent,
+	 * so windows are at most PKTBUFSRX / 2 blocks. A lost block is only
+	 * seen without a timeout when a later block of its window arrives,
+	 * so the tests never drop the last block of a window.
+	 *
+	 * 715 blocks leave a last window of 3 blocks with windowsize 8 and
+	 * of 11 with windowsize 32, while 13 gives a full last window.
+	 */
+	ut_assert(PKTBUFSRX >= 2 * 32);
+	retval = sb_tftp_get(uts, 1, 0);
+	if (!retval)
+		retval = sb_tftp_get(uts, 2, 99);
+	if (!retval)
+		retval = sb_tftp_get(uts, 8, 0);
+	if (!retval)
+		retval = sb_tftp_get(uts, 13, 0);
+	if (!retval)
+		retval = sb_tftp_get(uts, 32, 0);
+
+	/* Blocks 97-104: drop one from the middle of the window */
+	if (!retval)
+		retval = sb_tftp_get(uts, 8, 100);
+
+	/* Blocks 705-715: drop one from the middle of the short last window */
+	if (!retval)
+		retval = sb_tftp_get(uts, 32, TFTP_TEST_BLOCKS - 5);
+
+	/* Blocks 713-715: drop the first block of the short last window */
+	if (!retval)
+		retval = sb_tftp_get(uts, 8, TFTP_TEST_BLOCKS - 2);
+
+	/* Restore the env */
+	env_set("tftpblocksize", NULL);
+	env_set("tftpwindowsize", NULL);
+	net_server_ip.s_addr = 0;
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	return retval;
+}
+DM_TEST(dm_test_eth_tftp_window, DM_TESTF_SCAN_FDT);
+#endif
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the slab allocator in front of malloc()
+ */
+
+#include <common.h>
+#include <div64.h>
+#include <dm.h>
+#include <malloc.h>
+#include <malloc_slab.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define BENCH_TRACE_MAX	20000	/* malloc() and free() calls to record */
+#define BENCH_LOOPS	20	/* times to replay the trace */
+
+/* Test that small objects come from the slab area and large ones do not */
+static int dm_test_malloc_slab(struct unit_test_state *uts)
+{
+	const struct malloc_slab_class *sc;
+	uint allocs, frees;
+	char *ptr, *big, *aligned;
+	int i;
+
+	sc = malloc_slab_get_class(2);
+	ut_assertnonnull(sc);
+	ut_asserteq(48, sc->size);
+	allocs = sc->allocs;
+	frees = sc->frees;
+
+	ptr = malloc(40);
+	ut_assertnonnull(ptr);
+	ut_asserteq(48, malloc_slab_usable_size(ptr));
+	ut_asserteq(48, malloc_usable_size(ptr));
+	ut_asserteq(allocs + 1, sc->allocs);
+	strcpy(ptr, "slab");
+
+	/* Growing within the class keeps the object where it is */
+	ut_asserteq_ptr(ptr, realloc(ptr, 48));
+
+	/* Growing beyond it moves the object and keeps the contents */
+	ptr = realloc(ptr, 100);
+	ut_assertnonnull(ptr);
+	ut_asserteq(112, malloc_slab_usable_size(ptr));
+	ut_asserteq_str("slab", ptr);
+	ut_asserteq(frees + 1, sc->frees);
+	free(ptr);
+
+	ptr = calloc(1, 200);
+	ut_assertnonnull(ptr);
+	ut_asserteq(256, malloc_slab_usable_size(ptr));
+	for (i = 0; i < 200; i++)
+		ut_asserteq(0, ptr[i]);
+	free(ptr);
+
+	big = malloc(MALLOC_SLAB_MAX + 1);
+	ut_assertnonnull(big);
+	ut_asserteq(0, malloc_slab_usable_size(big));
+	free(big);
+
+	aligned = memalign(64, 16);
+	ut_assertnonnull(aligned);
+	ut_asserteq(0, (ulong)aligned & 63);
+	ut_asserteq(0, malloc_slab_usable_size(aligned));
+	free(aligned);
+
+	/* While disabled, requests go to the main allocator */
+	ut_asserteq(true, malloc_slab_set_enabled(false));
+	ptr = malloc(16);
+	ut_assertnonnull(ptr);
+	ut_asserteq(0, malloc_slab_usable_size(ptr));
+	free(ptr);
+	ut_asserteq(false, malloc_slab_set_enabled(true));
+
+	return 0;
+}
+DM_TEST(dm_test_malloc_slab, 0);
+
+/* Replay a trace once, then free anything it left allocated */
+static ulong bench_replay(struct malloc_slab_trace *trace, int count,
+			  int *match, void **slot)
+{
+	ulong start, us;
+	int i;
+
+	start = timer_get_us();
+	for (i = 0; i < count; i++) {
+		if (trace[i].size != MALLOC_SLAB_TRACE_FREE)
+			slot[i] = malloc(trace[i].size);
+		else if (match[i] >= 0)
+			free(slot[match[i]]);
+	}
+	us = timer_get_us() - start;
+
+	for (i = 0; i < count; i++) {
+		if (trace[i].size != MALLOC_SLAB_TRACE_FREE && match[i] < 0)
+			free(slot[i]);
+	}
+
+	return us;
+}
+
+static void bench_report(const char *name, u64 total, uint count)
+{
+	total *= 100;
+	do_div(total, count);
+	printf("%-10s%9llu.%02llu\n", name, total / 100, total % 100);
+}
+
+/*
+ * Benchmark the slab allocator against dlmalloc
+ *
+ * The malloc() and free() calls made while binding the devices are recorded
+ * and then replayed, with and without the slab allocator. The test starts
+ * with just the root device, and the scan is the one the test framework does
+ * for DM_TESTF_SCAN_PDATA and DM_TESTF_SCAN_FDT, so driver model is not set
+ * up again under the framework's feet.
+ */
+static int dm_test_malloc_slab_bench(struct unit_test_state *uts)
+{
+	struct malloc_slab_trace *trace;
+	int count, allocs, loop, i, j, ret;
+	u64 total;
+	void **slot;
+	int *match;
+
+	trace = malloc(BENCH_TRACE_MAX * sizeof(*trace));
+	match = malloc(BENCH_TRACE_MAX * sizeof(*match));
+	slot = malloc(BENCH_TRACE_MAX * sizeof(*slot));
+	ut_assertnonnull(trace);
+	ut_assertnonnull(match);
+	ut_assertnonnull(slot);
+
+	ut_assertok(malloc_slab_trace_start(trace, BENCH_TRACE_MAX));
+	ret = dm_scan_platdata(false);
+	if (!ret)
+		ret = dm_extended_scan_fdt(gd->fdt_blob, false);
+	count = malloc_slab_trace_stop();
+	ut_assertok(ret);
+	ut_assert(count > 0);
+
+	/*
+	 * Pair each free() with the malloc() that returned its pointer. Frees
+	 * of memory allocated before the trace started are dropped. A
+	 * non-negative match[] on an allocation means that it is freed.
+	 */
+	allocs = 0;
+	for (i = 0; i < count; i++) {
+		match[i] = -1;
+		if (trace[i].size != MALLOC_SLAB_TRACE_FREE) {
+			allocs++;
+			continue;
+		}
+		for (j = i - 1; j >= 0; j--) {
+			if (trace[j].ptr == trace[i].ptr &&
+			    trace[j].size != MALLOC_SLAB_TRACE_FREE &&
+			    match[j] < 0) {
+				match[i] = j;
+				match[j] = i;
+				break;
+			}
+		}
+	}
+	printf("Replaying %d mallocs and %d frees from the device scan\n",
+	       allocs, count - allocs);
+
+	printf("allocator   us/run\n");
+	ut_asserteq(true, malloc_slab_set_enabled(false));
+	total = 0;
+	for (loop = 0; loop < BENCH_LOOPS; loop++)
+		total += bench_replay(trace, count, match, slot);
+	bench_report("dlmalloc", total, BENCH_LOOPS);
+
+	ut_asserteq(false, malloc_slab_set_enabled(true));
+	total = 0;
+	for (loop = 0; loop < BENCH_LOOPS; loop++)
+		total += bench_replay(trace, count, match, slot);
+	bench_report("slab", total, BENCH_LOOPS);
+	malloc_slab_info();
+
+	free(slot);
+	free(match);
+	free(trace);
+
+	return 0;
+}
+DM_TEST(dm_test_malloc_slab_bench, DM_TESTF_LIVE_TREE);
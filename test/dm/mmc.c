@@ -41,3 +41,54 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(MMC_QUEUE)
+static int dm_test_mmc_queue(struct unit_test_state *uts)
+{
+	char buf0[1024], buf1[1024];
+	struct blk_desc *dev_desc;
+	struct mmc_queue q;
+	struct udevice *dev;
+	lbaint_t blocks;
+	void *buf;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+
+	/* Five blocks in chunks of two: multi, multi, then a single block */
+	memset(buf0, 'x', sizeof(buf0));
+	memset(buf1, 'x', sizeof(buf1));
+	ut_assertok(mmc_queue_start(&q, dev_desc, 0, 5, buf0, buf1, 2));
+
+	ut_assertok(mmc_queue_next(&q, &buf, &blocks));
+	ut_asserteq_ptr(buf0, buf);
+	ut_asserteq(2, blocks);
+	ut_assertok(strcmp(buf, "this is a test"));
+	strcpy(buf, "consumed");
+
+	ut_assertok(mmc_queue_next(&q, &buf, &blocks));
+	ut_asserteq_ptr(buf1, buf);
+	ut_asserteq(2, blocks);
+	ut_assertok(strcmp(buf, "this is a test"));
+
+	/* The single-block read returns zeroes, over the consumed buffer */
+	ut_assertok(mmc_queue_next(&q, &buf, &blocks));
+	ut_asserteq_ptr(buf0, buf);
+	ut_asserteq(1, blocks);
+	ut_asserteq(0, buf0[0]);
+	ut_asserteq(0, buf0[511]);
+	ut_asserteq('x', buf0[512]);
+
+	ut_assertok(mmc_queue_next(&q, &buf, &blocks));
+	ut_asserteq(0, blocks);
+	ut_assertnull(buf);
+	mmc_queue_stop(&q);
+
+	/* Reading past the end of the device is refused */
+	ut_asserteq(-ERANGE, mmc_queue_start(&q, dev_desc, dev_desc->lba, 1,
+					     buf0, buf1, 2));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_queue, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
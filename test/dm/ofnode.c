@@ -2,10 +2,14 @@
 
 #include <common.h>
 #include <dm.h>
+#include <fdtdec.h>
+#include <dm/of_access.h>
 #include <dm/of_extra.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static int dm_test_ofnode_compatible(struct unit_test_state *uts)
 {
 	ofnode root_node = ofnode_path("/");
@@ -58,3 +62,97 @@ static int dm_test_ofnode_fmap(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_ofnode_fmap, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Check that lookups using the index match those in the flat tree */
+static int dm_test_ofnode_index(struct unit_test_state *uts)
+{
+	const char compat[] = "denx,u-boot-fdt-test";
+	const void *blob = gd->fdt_blob;
+	int node, depth, prop, len, ilen, found, count;
+	const char *name;
+	const void *val;
+	u32 phandle;
+
+	if (!CONFIG_IS_ENABLED(OF_INDEX) || of_live_active())
+		return 0;
+	ut_assertok(fdtdec_index_init(blob));
+
+	for (node = 0, depth = 0; node >= 0 && depth >= 0;
+	     node = fdt_next_node(blob, node, &depth)) {
+		ut_asserteq(fdt_parent_offset(blob, node),
+			    fdtdec_parent_offset(blob, node));
+		fdt_for_each_property_offset(prop, blob, node) {
+			val = fdt_getprop_by_offset(blob, prop, &name, &len);
+			ut_asserteq_ptr(val, fdtdec_getprop(blob, node, name,
+							    &ilen));
+			ut_asserteq(len, ilen);
+		}
+		ut_assertnull(fdtdec_getprop(blob, node, "no-such-prop",
+					     &ilen));
+		ut_asserteq(-FDT_ERR_NOTFOUND, ilen);
+
+		phandle = fdt_get_phandle(blob, node);
+		if (phandle)
+			ut_asserteq(node,
+				    fdtdec_node_by_phandle(blob, phandle));
+	}
+
+	for (node = -1, count = 0; ; node = found, count++) {
+		found = fdt_node_offset_by_compatible(blob, node, compat);
+		ut_asserteq(found, fdtdec_node_by_compatible(blob, node,
+							     compat));
+		if (found < 0)
+			break;
+	}
+	ut_assert(count > 1);
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_node_by_compatible(blob, -1, "denx,no-such-dev"));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_index, DM_TESTF_SCAN_FDT);
+
+/* Check that the live tree matches the flat tree it was built over */
+static int dm_test_ofnode_livetree_inplace(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	const void *end = blob + fdt_totalsize(blob);
+	struct device_node *np;
+	struct property *pp;
+	const char *name;
+	const void *val;
+	int node, depth, prop, len;
+
+	if (!of_live_active())
+		return 0;
+
+	/* Both trees list their nodes in the same order */
+	np = of_find_all_nodes(NULL);
+	for (node = 0, depth = 0; node >= 0 && depth >= 0;
+	     node = fdt_next_node(blob, node, &depth)) {
+		ut_assertnonnull(np);
+		ut_asserteq_ptr(fdt_get_name(blob, node, NULL), np->full_name);
+		ut_asserteq(fdt_get_phandle(blob, node), np->phandle);
+		ut_assertnonnull(of_get_property(np, "name", NULL));
+
+		/*
+		 * Names and values point into the flat tree, unless a test
+		 * has changed the value since
+		 */
+		fdt_for_each_property_offset(prop, blob, node) {
+			val = fdt_getprop_by_offset(blob, prop, &name, &len);
+			pp = of_find_property(np, name, NULL);
+			ut_assertnonnull(pp);
+			ut_asserteq_ptr(name, pp->name);
+			if (pp->value >= blob && pp->value < end) {
+				ut_asserteq_ptr(val, pp->value);
+				ut_asserteq(len, pp->length);
+			}
+		}
+		np = of_find_all_nodes(np);
+	}
+	ut_assertnull(np);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_livetree_inplace, DM_TESTF_SCAN_FDT);
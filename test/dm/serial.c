@@ -6,9 +6,12 @@
 #include <common.h>
 #include <serial.h>
 #include <dm.h>
+#include <asm/test.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static int dm_test_serial(struct unit_test_state *uts)
 {
 	struct serial_device_info info_serial = {0};
@@ -67,3 +70,63 @@ static int dm_test_serial(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_serial, DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+static int dm_test_serial_tx_buffer(struct unit_test_state *uts)
+{
+	struct serial_dev_priv *upriv;
+	struct udevice *dev;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_SERIAL, "serial", &dev));
+	upriv = dev_get_uclass_priv(dev);
+	ut_assertnonnull(upriv->txbuf.start);
+
+	/* The sandbox uart never fills, so output does not stay buffered */
+	serial_puts("buffered\n");
+	serial_flush();
+	ut_assert(membuff_isempty(&upriv->txbuf));
+
+	return 0;
+}
+DM_TEST(dm_test_serial_tx_buffer, DM_TESTF_SCAN_FDT);
+
+/* Test that buffered output is written before the uart settings change */
+static int dm_test_serial_flush(struct unit_test_state *uts)
+{
+	struct udevice *old = gd->cur_serial_dev;
+	struct serial_dev_priv *upriv;
+	int written, at_change;
+	struct udevice *dev;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_SERIAL, "serial", &dev));
+	upriv = dev_get_uclass_priv(dev);
+	gd->cur_serial_dev = dev;
+
+	/* While the uart is busy, output stays in the buffer */
+	written = sandbox_serial_get_written(dev, &at_change);
+	sandbox_serial_set_busy(dev, 10);
+	serial_puts("abc");
+	ut_assert(!membuff_isempty(&upriv->txbuf));
+	ut_asserteq(written, sandbox_serial_get_written(dev, &at_change));
+
+	/* It is written out before the line settings change */
+	ut_assertok(serial_setconfig(dev, SERIAL_DEFAULT_CONFIG));
+	ut_assert(membuff_isempty(&upriv->txbuf));
+	ut_asserteq(written + 3, sandbox_serial_get_written(dev, &at_change));
+	ut_asserteq(written + 3, at_change);
+
+	/* ...and before the baud rate changes */
+	sandbox_serial_set_busy(dev, 10);
+	serial_puts("de");
+	ut_assert(!membuff_isempty(&upriv->txbuf));
+	serial_setbrg();
+	ut_assert(membuff_isempty(&upriv->txbuf));
+	ut_asserteq(written + 5, sandbox_serial_get_written(dev, &at_change));
+	ut_asserteq(written + 5, at_change);
+
+	gd->cur_serial_dev = old;
+
+	return 0;
+}
+DM_TEST(dm_test_serial_flush, DM_TESTF_SCAN_FDT);
+#endif
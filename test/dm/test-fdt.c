@@ -814,3 +814,84 @@ static int dm_test_read_int(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_read_int, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Find the first driver with a compatible string, as lists_bind_fdt() did */
+static struct driver *find_compat_linear(const char *compat,
+					 const struct udevice_id **idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	struct driver *entry;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			if (!strcmp(id->compatible, compat)) {
+				*idp = id;
+				return entry;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Test that looking up a compatible string finds the same driver */
+static int dm_test_fdt_compat_lookup(struct unit_test_state *uts)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id, *expect_id, *found_id;
+	struct driver *entry, *expect, *found;
+	int count = 0;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			expect = find_compat_linear(id->compatible, &expect_id);
+			ut_assertok(lists_driver_lookup_compat(id->compatible,
+							       &found,
+							       &found_id));
+			ut_asserteq_ptr(expect, found);
+			ut_asserteq_ptr(expect_id, found_id);
+			count++;
+		}
+	}
+	ut_assert(count > 0);
+
+	ut_asserteq(-ENOENT, lists_driver_lookup_compat("denx,no-such-driver",
+							&found, &found_id));
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_compat_lookup, 0);
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+/* Test building the table into a given buffer, as before relocation */
+static int dm_test_fdt_compat_build(struct unit_test_state *uts)
+{
+	struct lists_compat_table *old = gd->dm_compat;
+	const struct udevice_id *found_id;
+	ulong size = lists_compat_size();
+	struct driver *found;
+	void *buf;
+
+	ut_assert(size > 0);
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	ut_asserteq(-ENOSPC, lists_compat_build(buf, size - 1));
+	ut_assertok(lists_compat_build(buf, size));
+
+	/* Look up with the new table, then put back the old one */
+	gd->dm_compat = buf;
+	ut_assertok(lists_driver_lookup_compat("denx,u-boot-fdt-test", &found,
+					       &found_id));
+	ut_asserteq_str("denx,u-boot-fdt-test", found_id->compatible);
+	ut_asserteq(-ENOENT, lists_driver_lookup_compat("denx,no-such-driver",
+							&found, &found_id));
+	gd->dm_compat = old;
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_compat_build, 0);
+#endif
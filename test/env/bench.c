@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Benchmark for the environment hash table
+ *
+ * An environment of a few hundred variables, as written by boot scripts, is
+ * imported, looked up and exported repeatedly, and the time per operation
+ * is reported.
+ */
+
+#include <common.h>
+#include <div64.h>
+#include <malloc.h>
+#include <search.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+#define BENCH_VARS	400	/* variables in the environment */
+#define BENCH_LOOPS	20	/* imports, lookup rounds and exports */
+
+static void bench_report(const char *name, u64 total, uint count)
+{
+	total *= 100;
+	do_div(total, count);
+	printf("%-8s%8u%9llu.%02llu\n", name, count, total / 100, total % 100);
+}
+
+/* Build a NUL separated environment, as stored on a device */
+static char *bench_env(size_t *sizep)
+{
+	char *env, *p;
+	int i;
+
+	env = malloc(BENCH_VARS * 64 + 1);
+	if (!env)
+		return NULL;
+
+	for (i = 0, p = env; i < BENCH_VARS; i++) {
+		p += sprintf(p, "%s_%03d=setenv bootargs ${bootargs} opt%d=%d",
+			     i & 1 ? "boot" : "script", (i * 37) % BENCH_VARS,
+			     i, i * 1000) + 1;
+	}
+	*p++ = '\0';
+	*sizep = p - env;
+
+	return env;
+}
+
+static int env_test_bench(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_entry item, *ritem;
+	char *env, *res = NULL;
+	char key[20];
+	size_t size;
+	ulong start;
+	u64 total;
+	int i, loop;
+
+	env = bench_env(&size);
+	ut_assertnonnull(env);
+	memset(&htab, 0, sizeof(htab));
+
+	printf("op         count    us/op\n");
+	total = 0;
+	for (loop = 0; loop < BENCH_LOOPS; loop++) {
+		start = timer_get_us();
+		ut_asserteq(1, himport_r(&htab, env, size, '\0', 0, 0, 0,
+					 NULL));
+		total += timer_get_us() - start;
+	}
+	ut_asserteq(BENCH_VARS, htab.filled);
+	bench_report("import", total, BENCH_LOOPS);
+
+	total = 0;
+	item.data = NULL;
+	for (loop = 0; loop < BENCH_LOOPS; loop++) {
+		for (i = 0; i < BENCH_VARS; i++) {
+			sprintf(key, "%s_%03d", i & 1 ? "boot" : "script",
+				(i * 37) % BENCH_VARS);
+			item.key = key;
+			start = timer_get_us();
+			hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+			total += timer_get_us() - start;
+			ut_assertnonnull(ritem);
+		}
+	}
+	bench_report("lookup", total, BENCH_LOOPS * BENCH_VARS);
+
+	total = 0;
+	for (loop = 0; loop < BENCH_LOOPS; loop++) {
+		start = timer_get_us();
+		ut_assert(hexport_r(&htab, '\0', 0, &res, 0, 0, NULL) > 0);
+		total += timer_get_us() - start;
+		free(res);
+		res = NULL;
+	}
+	bench_report("export", total, BENCH_LOOPS);
+
+	hdestroy_r(&htab);
+	free(env);
+
+	return 0;
+}
+
+ENV_TEST(env_test_bench, 0);
@@ -13,6 +13,9 @@
 
 #define SIZE 32
 #define ITERATIONS 10000
+#define GROW_SIZE 500
+#define SHRINK_SIZE 700
+#define SHRINK_KEEP 7
 
 static int htab_fill(struct unit_test_state *uts,
 		     struct hsearch_data *htab, size_t size)
@@ -123,3 +126,187 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+static int htab_export_check(struct unit_test_state *uts,
+			     struct hsearch_data *htab)
+{
+	char *res = NULL, *p, *eq, *eol;
+	const char *prev = NULL;
+	int n;
+
+	ut_assert(hexport_r(htab, '\n', 0, &res, 0, 0, NULL) > 0);
+
+	/* One line per entry, in ascending order of keys */
+	for (n = 0, p = res; *p; n++, p = eol + 1) {
+		eol = strchr(p, '\n');
+		eq = strchr(p, '=');
+		ut_assertnonnull(eol);
+		ut_assertnonnull(eq);
+		*eq = '\0';
+		if (prev)
+			ut_assert(strcmp(prev, p) < 0);
+		prev = p;
+	}
+	ut_asserteq(htab->filled, n);
+	free(res);
+
+	return 0;
+}
+
+/*
+ * Grow the hash table well beyond its initial size, delete some entries, and
+ * check the export order and that an import of the export reproduces it
+ */
+static int env_test_htab_export(struct unit_test_state *uts)
+{
+	struct hsearch_data htab, copy;
+	struct env_entry item;
+	struct env_entry *ritem;
+	char *res = NULL, *res2 = NULL;
+	ssize_t len, len2;
+	char key[20];
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	/* Insert in an order unrelated to the order of the keys */
+	for (i = 0; i < GROW_SIZE; i++) {
+		sprintf(key, "k%d", (i * 7919) % GROW_SIZE);
+		item.callback = NULL;
+		item.data = key;
+		item.flags = 0;
+		item.key = key;
+		ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	}
+	ut_assertok(htab_export_check(uts, &htab));
+
+	/* Deleting and adding keeps the export order */
+	for (i = 0; i < GROW_SIZE; i += 3) {
+		sprintf(key, "k%d", i);
+		ut_asserteq(1, hdelete_r(key, &htab, 0));
+	}
+	ut_asserteq(GROW_SIZE - (GROW_SIZE + 2) / 3, htab.filled);
+	item.key = "a";
+	item.data = "first";
+	ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_assertok(htab_export_check(uts, &htab));
+
+	for (i = 0; i < GROW_SIZE; i++) {
+		sprintf(key, "k%d", i);
+		item.key = key;
+		hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+		if (i % 3) {
+			ut_assertnonnull(ritem);
+			ut_asserteq_str(key, ritem->data);
+		} else {
+			ut_assertnull(ritem);
+		}
+	}
+
+	len = hexport_r(&htab, '\0', 0, &res, 0, 0, NULL);
+	ut_assert(len > 0);
+	memset(&copy, 0, sizeof(copy));
+	ut_asserteq(1, himport_r(&copy, res, len, '\0', 0, 0, 0, NULL));
+	ut_asserteq(htab.filled, copy.filled);
+	len2 = hexport_r(&copy, '\0', 0, &res2, 0, 0, NULL);
+	ut_asserteq(len, len2);
+	ut_assertok(memcmp(res, res2, len));
+
+	free(res);
+	free(res2);
+	hdestroy_r(&copy);
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_export, 0);
+
+/*
+ * Delete an imported entry within the same import, which drops the last
+ * entry using the import buffer while the rest of it is still being parsed
+ */
+static int env_test_htab_import_delete(struct unit_test_state *uts)
+{
+	const char env[] = "a=1\na=\nb=2\nc=3\nc=\n";
+	struct hsearch_data htab;
+	struct env_entry item;
+	struct env_entry *ritem;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, himport_r(&htab, env, sizeof(env) - 1, '\n', 0, 0,
+				 0, NULL));
+	ut_asserteq(1, htab.filled);
+
+	item.callback = NULL;
+	item.flags = 0;
+	item.data = NULL;
+	item.key = "a";
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnull(ritem);
+	item.key = "c";
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnull(ritem);
+	item.key = "b";
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnonnull(ritem);
+	ut_asserteq_str("2", ritem->data);
+
+	/* The last entry goes, leaving no users of the buffer */
+	ut_asserteq(1, hdelete_r("b", &htab, 0));
+	ut_asserteq(0, htab.filled);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_import_delete, 0);
+
+/*
+ * Delete most entries of a large table, so that the next rehash moves them
+ * to an index of only 16 slots, then keep adding entries while it runs
+ */
+static int env_test_htab_shrink(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_entry item;
+	struct env_entry *ritem;
+	char key[20];
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, SHRINK_SIZE));
+	for (i = SHRINK_KEEP; i < SHRINK_SIZE; i++) {
+		sprintf(key, "%d", i);
+		ut_asserteq(1, hdelete_r(key, &htab, 0));
+	}
+	ut_asserteq(SHRINK_KEEP, htab.filled);
+
+	/* Create and delete entries until the index is replaced */
+	item.callback = NULL;
+	item.flags = 0;
+	for (i = 0; i < ITERATIONS && htab.index_size >= SHRINK_SIZE; i++) {
+		sprintf(key, "cd-%d", i);
+		item.data = key;
+		item.key = key;
+		ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+		ut_asserteq(1, hdelete_r(key, &htab, 0));
+	}
+	ut_assert(htab.index_size < SHRINK_SIZE);
+
+	for (i = 0; i < SIZE; i++) {
+		sprintf(key, "new-%d", i);
+		item.data = key;
+		item.key = key;
+		ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	}
+	ut_assertok(htab_check_fill(uts, &htab, SHRINK_KEEP));
+	ut_asserteq(SHRINK_KEEP + SIZE, htab.filled);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_shrink, 0);
@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the journal of environment changes
+ */
+
+#include <common.h>
+#include <env.h>
+#include <env_internal.h>
+#include <malloc.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+#define JNL_UNIT	512
+#define JNL_SIZE	(8 * JNL_UNIT)
+#define JNL_BASE_CRC	0x12345678
+
+/*
+ * Journal area in RAM. Only the first @write_limit bytes of each write reach
+ * it, to simulate a write cut short by a power failure.
+ */
+struct jnl_ram {
+	u8 area[JNL_SIZE];
+	ulong write_limit;
+};
+
+static int jnl_ram_read(struct env_journal *jnl, ulong offset, ulong len,
+			void *buf)
+{
+	struct jnl_ram *ram = jnl->priv;
+
+	memcpy(buf, ram->area + offset, len);
+
+	return 0;
+}
+
+static int jnl_ram_write(struct env_journal *jnl, ulong offset, ulong len,
+			 const void *buf)
+{
+	struct jnl_ram *ram = jnl->priv;
+
+	memcpy(ram->area + offset, buf, min(len, ram->write_limit));
+
+	return 0;
+}
+
+static int jnl_ram_erase(struct env_journal *jnl, ulong len)
+{
+	struct jnl_ram *ram = jnl->priv;
+
+	memset(ram->area, 0xff, len);
+
+	return 0;
+}
+
+static const struct env_journal_ops jnl_ram_ops = {
+	.read	= jnl_ram_read,
+	.write	= jnl_ram_write,
+	.erase	= jnl_ram_erase,
+};
+
+/* Test the changes written between two environments */
+static int env_test_journal_diff(struct unit_test_state *uts)
+{
+	char out[64];
+
+	/* Changed, deleted and added, at the start, middle and end */
+	ut_asserteq(11, env_journal_diff("a=1\0b=2\0c=3\0", "a=9\0c=3\0d=4\0",
+					 out, sizeof(out)));
+	ut_assertok(memcmp("a=9\0b\0d=4\0", out, 11));
+
+	/* A name which is a prefix of another one is a different variable */
+	ut_asserteq(5, env_journal_diff("ab=1\0", "a=1\0ab=1\0", out,
+					sizeof(out)));
+	ut_assertok(memcmp("a=1\0", out, 5));
+	ut_asserteq(3, env_journal_diff("a=1\0ab=1\0", "ab=1\0", out,
+					sizeof(out)));
+	ut_assertok(memcmp("a\0", out, 3));
+
+	/* Deleting or emptying everything */
+	ut_asserteq(5, env_journal_diff("a=1\0b=2\0", "", out, sizeof(out)));
+	ut_assertok(memcmp("a\0b\0", out, 5));
+	ut_asserteq(1, env_journal_diff("", "", out, sizeof(out)));
+	ut_asserteq(1, env_journal_diff("a=1\0", "a=1\0", out, sizeof(out)));
+
+	/* Too small a buffer */
+	ut_asserteq(-ENOSPC, env_journal_diff("", "a=123456\0", out, 8));
+
+	return 0;
+}
+ENV_TEST(env_test_journal_diff, 0);
+
+/* Put back the variables the journal test uses as they were in the base */
+static int jnl_set_base(struct unit_test_state *uts)
+{
+	ut_assertok(env_set("jnltest_a", "1"));
+	ut_assertok(env_set("jnltest_b", "2"));
+	/* These may not exist, which makes env_set() fail */
+	env_set("jnltest_c", NULL);
+	env_set("jnltest_d", NULL);
+
+	return 0;
+}
+
+static int jnl_check(struct unit_test_state *uts)
+{
+	struct jnl_ram *ram;
+	struct env_journal jnl;
+	env_t *base;
+
+	ram = malloc(sizeof(*ram));
+	base = calloc(1, sizeof(*base));
+	ut_assertnonnull(ram);
+	ut_assertnonnull(base);
+	memset(ram->area, 0xff, sizeof(ram->area));
+	ram->write_limit = JNL_SIZE;
+	memset(&jnl, '\0', sizeof(jnl));
+	jnl.ops = &jnl_ram_ops;
+	jnl.priv = ram;
+	jnl.size = JNL_SIZE;
+	jnl.unit = JNL_UNIT;
+
+	ut_assertok(jnl_set_base(uts));
+	base->crc = JNL_BASE_CRC;
+	ut_assertok(env_journal_reset(&jnl, base));
+
+	/* A record with a change, a delete and an addition */
+	ut_assertok(env_set("jnltest_a", "3"));
+	ut_assertok(env_set("jnltest_b", NULL));
+	ut_assertok(env_set("jnltest_c", "4"));
+	ut_assertok(env_journal_append(&jnl));
+	ut_asserteq(JNL_UNIT, jnl.end);
+
+	/* Replaying it on top of the base gives the saved environment */
+	ut_assertok(jnl_set_base(uts));
+	ut_assertok(env_journal_replay(&jnl, JNL_BASE_CRC));
+	ut_asserteq(1, jnl.seq);
+	ut_asserteq_str("3", env_get("jnltest_a"));
+	ut_assertnull(env_get("jnltest_b"));
+	ut_asserteq_str("4", env_get("jnltest_c"));
+
+	/* Records for another base are ignored */
+	ut_assertok(jnl_set_base(uts));
+	ut_assertok(env_journal_replay(&jnl, JNL_BASE_CRC + 1));
+	ut_asserteq(0, jnl.seq);
+	ut_asserteq(0, jnl.end);
+	ut_asserteq_str("1", env_get("jnltest_a"));
+	ut_assertnull(env_get("jnltest_c"));
+
+	/* A record cut short is ignored, as is anything after it */
+	ut_assertok(env_journal_replay(&jnl, JNL_BASE_CRC));
+	ut_assertok(env_set("jnltest_d", "5"));
+	ram->write_limit = 16;
+	ut_assertok(env_journal_append(&jnl));
+	ram->write_limit = JNL_SIZE;
+
+	ut_assertok(jnl_set_base(uts));
+	ut_assertok(env_journal_replay(&jnl, JNL_BASE_CRC));
+	ut_asserteq(1, jnl.seq);
+	ut_asserteq_str("3", env_get("jnltest_a"));
+	ut_assertnull(env_get("jnltest_d"));
+
+	/* The torn record must be erased before anything else is written */
+	ut_asserteq(-ENOSPC, env_journal_append(&jnl));
+
+	free(jnl.snap);
+	free(base);
+	free(ram);
+
+	return 0;
+}
+
+/* Test saving records and replaying them */
+static int env_test_journal_replay(struct unit_test_state *uts)
+{
+	int ret;
+
+	ret = jnl_check(uts);
+
+	/* The journal only ever touches the test variables */
+	env_set("jnltest_a", NULL);
+	env_set("jnltest_b", NULL);
+	env_set("jnltest_c", NULL);
+	env_set("jnltest_d", NULL);
+
+	return ret;
+}
+ENV_TEST(env_test_journal_replay, 0);
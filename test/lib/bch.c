@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests and benchmark for the software BCH decoder
+ *
+ * Random pages are encoded with encode_bch(), up to t bit errors are
+ * injected into the data and ECC, and decode_bch() must locate all of them.
+ */
+
+#include <common.h>
+#include <div64.h>
+#include <malloc.h>
+#include <linux/bch.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+struct bch_test_code {
+	int m;
+	int t;
+	int len;	/* data bytes per codeword */
+};
+
+static const struct bch_test_code bch_test_codes[] = {
+	{ 13, 4, 512 },		/* OMAP BCH4 */
+	{ 13, 8, 512 },		/* OMAP BCH8 */
+	{ 13, 16, 512 },	/* OMAP BCH16 */
+	{ 14, 24, 1024 },
+};
+
+/* Decodes per code and error count in the benchmark */
+#define BCH_BENCH_LOOPS		200
+
+static u32 bch_test_rand(u32 *seed)
+{
+	/* xorshift32, so that the test does not depend on LIB_RAND */
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+
+	return *seed;
+}
+
+/* Flip @nerr distinct bits among the first @nbits of data followed by ecc */
+static void bch_test_inject(u8 *data, u8 *ecc, int len, int nbits, int nerr,
+			    u32 *seed)
+{
+	unsigned int pos[64];
+	int i, j;
+
+	for (i = 0; i < nerr; i++) {
+		do {
+			pos[i] = bch_test_rand(seed) % nbits;
+			for (j = 0; j < i && pos[j] != pos[i]; j++)
+				;
+		} while (j < i);
+
+		if (pos[i] < 8 * len)
+			data[pos[i] / 8] ^= 1 << (pos[i] % 8);
+		else
+			ecc[pos[i] / 8 - len] ^= 1 << (pos[i] % 8);
+	}
+}
+
+/* Apply the corrections reported by decode_bch() */
+static void bch_test_correct(u8 *data, u8 *ecc, int len, unsigned int *errloc,
+			     int nerr)
+{
+	int i;
+
+	for (i = 0; i < nerr; i++) {
+		if (errloc[i] < 8 * len)
+			data[errloc[i] / 8] ^= 1 << (errloc[i] % 8);
+		else
+			ecc[errloc[i] / 8 - len] ^= 1 << (errloc[i] % 8);
+	}
+}
+
+struct bch_test_buf {
+	u8 *data;
+	u8 *orig;
+	u8 ecc[64];
+	u8 orig_ecc[64];
+	unsigned int errloc[64];
+};
+
+static int bch_test_alloc(struct bch_test_buf *buf, int len)
+{
+	buf->data = malloc(len);
+	buf->orig = malloc(len);
+	if (!buf->data || !buf->orig) {
+		free(buf->data);
+		free(buf->orig);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void bch_test_free(struct bch_test_buf *buf)
+{
+	free(buf->data);
+	free(buf->orig);
+}
+
+/* Encode a random page, then corrupt a copy of it with @nerr bit flips */
+static void bch_test_page(struct bch_control *bch,
+			  const struct bch_test_code *code,
+			  struct bch_test_buf *buf, int nerr, u32 *seed)
+{
+	int i;
+
+	for (i = 0; i < code->len; i++)
+		buf->orig[i] = bch_test_rand(seed);
+	memset(buf->orig_ecc, '\0', sizeof(buf->orig_ecc));
+	encode_bch(bch, buf->orig, code->len, buf->orig_ecc);
+
+	memcpy(buf->data, buf->orig, code->len);
+	memcpy(buf->ecc, buf->orig_ecc, bch->ecc_bytes);
+	/* Only use whole ecc bytes, the last one may be partly padding */
+	bch_test_inject(buf->data, buf->ecc, code->len,
+			8 * code->len + (bch->ecc_bits & ~7), nerr, seed);
+}
+
+/* Check that every number of errors up to t is found and corrected */
+static int lib_test_bch_decode(struct unit_test_state *uts)
+{
+	struct bch_test_buf buf;
+	u32 seed = 0x1234567;
+	int i, nerr, pass;
+
+	for (i = 0; i < ARRAY_SIZE(bch_test_codes); i++) {
+		const struct bch_test_code *code = &bch_test_codes[i];
+		struct bch_control *bch;
+
+		bch = init_bch(code->m, code->t, 0);
+		ut_assertnonnull(bch);
+		ut_assertok(bch_test_alloc(&buf, code->len));
+
+		for (nerr = 0; nerr <= code->t; nerr++) {
+			for (pass = 0; pass < 8; pass++) {
+				bch_test_page(bch, code, &buf, nerr, &seed);
+				ut_asserteq(nerr, decode_bch(bch, buf.data,
+							     code->len, buf.ecc,
+							     NULL, NULL,
+							     buf.errloc));
+				bch_test_correct(buf.data, buf.ecc, code->len,
+						 buf.errloc, nerr);
+				ut_assert(!memcmp(buf.orig, buf.data,
+						  code->len));
+				ut_assert(!memcmp(buf.orig_ecc, buf.ecc,
+						  bch->ecc_bits / 8));
+			}
+		}
+
+		bch_test_free(&buf);
+		free_bch(bch);
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_bch_decode, 0);
+
+/* Report decode time for clean pages and pages with t/2 and t errors */
+static int lib_test_bch_bench(struct unit_test_state *uts)
+{
+	struct bch_test_buf buf;
+	u32 seed = 0x89abcdef;
+	int i, j, loop;
+
+	printf("   m   t   len  errors   us/decode\n");
+	for (i = 0; i < ARRAY_SIZE(bch_test_codes); i++) {
+		const struct bch_test_code *code = &bch_test_codes[i];
+		const int errs[] = { 0, code->t / 2, code->t };
+		struct bch_control *bch;
+
+		bch = init_bch(code->m, code->t, 0);
+		ut_assertnonnull(bch);
+		ut_assertok(bch_test_alloc(&buf, code->len));
+
+		for (j = 0; j < ARRAY_SIZE(errs); j++) {
+			u64 total = 0;
+			ulong start;
+
+			for (loop = 0; loop < BCH_BENCH_LOOPS; loop++) {
+				bch_test_page(bch, code, &buf, errs[j], &seed);
+				start = timer_get_us();
+				ut_asserteq(errs[j],
+					    decode_bch(bch, buf.data, code->len,
+						       buf.ecc, NULL, NULL,
+						       buf.errloc));
+				total += timer_get_us() - start;
+			}
+			do_div(total, BCH_BENCH_LOOPS / 100);
+			printf("%4d%4d%6d%8d%9llu.%02llu\n", code->m, code->t,
+			       code->len, errs[j], total / 100, total % 100);
+		}
+
+		bch_test_free(&buf);
+		free_bch(bch);
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_bch_bench, 0);
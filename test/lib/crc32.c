@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for the CRC32 and CRC32C backends
+ *
+ * Every backend which is available must agree with the byte-at-a-time
+ * table, for any alignment and length.
+ */
+
+#include <common.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+#define BUFLEN	1024
+
+static const u8 check_str[] = "123456789";
+
+/* Check the standard check values of each backend */
+static int lib_test_crc32_check(struct unit_test_state *uts)
+{
+	enum crc32_backend old = crc32_get_backend();
+	enum crc32_backend backend;
+
+	for (backend = 0; backend < CRC32_BACKEND_COUNT; backend++) {
+		if (crc32_set_backend(backend))
+			continue;
+		ut_asserteq(crc32_get_backend(), backend);
+		ut_asserteq(0xcbf43926, crc32(0, check_str, 9));
+		ut_asserteq(0x2dfd2d88, crc32_no_comp(0, check_str, 9));
+#ifdef CONFIG_CRC32C
+		ut_asserteq(0xe3069283,
+			    crc32c_no_comp(~0U, check_str, 9) ^ ~0U);
+#endif
+	}
+	ut_assertok(crc32_set_backend(old));
+
+	return 0;
+}
+
+LIB_TEST(lib_test_crc32_check, 0);
+
+/* Check all backends against the byte table for many alignments and sizes */
+static int lib_test_crc32_backends(struct unit_test_state *uts)
+{
+	enum crc32_backend old = crc32_get_backend();
+	enum crc32_backend backend;
+	u32 ref, ref_c = 0;
+	u8 buf[BUFLEN];
+	int i, offset, len;
+
+	for (i = 0; i < BUFLEN; i++)
+		buf[i] = (i * 131 + 17) ^ (i >> 3);
+
+	ut_assert(crc32_backend_available(CRC32_BACKEND_BYTE));
+	ut_asserteq(-ENOSYS, crc32_set_backend(CRC32_BACKEND_COUNT));
+
+	for (offset = 0; offset < 16; offset++) {
+		for (len = 0; len < BUFLEN - 16; len += len < 64 ? 1 : 61) {
+			ut_assertok(crc32_set_backend(CRC32_BACKEND_BYTE));
+			ref = crc32(0x12345678, buf + offset, len);
+#ifdef CONFIG_CRC32C
+			ref_c = crc32c_no_comp(0x12345678, buf + offset, len);
+#endif
+			for (backend = 0; backend < CRC32_BACKEND_COUNT;
+			     backend++) {
+				if (crc32_set_backend(backend))
+					continue;
+				ut_asserteq(ref, crc32(0x12345678, buf + offset,
+						       len));
+#ifdef CONFIG_CRC32C
+				ut_asserteq(ref_c,
+					    crc32c_no_comp(0x12345678,
+							   buf + offset, len));
+#endif
+			}
+		}
+	}
+	ut_assertok(crc32_set_backend(old));
+
+	return 0;
+}
+
+LIB_TEST(lib_test_crc32_backends, 0);
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for checking FIT image hashes while the image is loaded
+ *
+ * The digests gathered by fit_image_stream_update() must give the same
+ * answer as fit_image_verify_with_data() over the whole image, however the
+ * data is split.
+ */
+
+#include <common.h>
+#include <image.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define FIT_SIZE	1024
+#define DATA_LEN	1000
+
+static void fit_stream_fill(u8 *data)
+{
+	int i;
+
+	for (i = 0; i < DATA_LEN; i++)
+		data[i] = (i * 73 + 5) ^ (i >> 4);
+}
+
+/* Add a hash node to @image giving the @algo digest of @data */
+static int fit_stream_add_hash(struct unit_test_state *uts, void *fit,
+			       int image, const char *name, const char *algo,
+			       const u8 *data)
+{
+	u8 value[FIT_MAX_HASH_LEN];
+	int value_len;
+	int node;
+
+	node = fdt_add_subnode(fit, image, name);
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(fit, node, FIT_ALGO_PROP, algo));
+	ut_assertok(calculate_hash(data, DATA_LEN, algo, value, &value_len));
+	ut_assertok(fdt_setprop(fit, node, FIT_VALUE_PROP, value, value_len));
+
+	return 0;
+}
+
+/* Create a FIT holding a single image node, with no hashes yet */
+static int fit_stream_create(struct unit_test_state *uts, void *fit,
+			     int *imagep)
+{
+	int images;
+
+	ut_assertok(fdt_create_empty_tree(fit, FIT_SIZE));
+	images = fdt_add_subnode(fit, 0, FIT_IMAGES_PATH + 1);
+	ut_assert(images >= 0);
+	*imagep = fdt_add_subnode(fit, images, "firmware-1");
+	ut_assert(*imagep >= 0);
+
+	return 0;
+}
+
+/* Feed @data to a stream in pieces of @step bytes and check the result */
+static int fit_stream_check(struct unit_test_state *uts, const void *fit,
+			    int image, const u8 *data, int step, int expect)
+{
+	struct fit_image_stream fs;
+	int pos;
+
+	ut_assertok(fit_image_stream_start(&fs, fit, image));
+	for (pos = 0; pos < DATA_LEN; pos += step)
+		ut_assertok(fit_image_stream_update(&fs, data + pos,
+						    min(step, DATA_LEN - pos)));
+	ut_asserteq(expect, fit_image_stream_verify(&fs, data, DATA_LEN));
+
+	return 0;
+}
+
+/* Check that streamed hashes accept good data however it is split */
+static int lib_test_fit_stream_verify(struct unit_test_state *uts)
+{
+	u8 data[DATA_LEN];
+	u8 fit[FIT_SIZE];
+	int image;
+	int step;
+
+	fit_stream_fill(data);
+	ut_assertok(fit_stream_create(uts, fit, &image));
+	ut_assertok(fit_stream_add_hash(uts, fit, image, "hash-1", "sha256",
+					data));
+	ut_assertok(fit_stream_add_hash(uts, fit, image, "hash-2", "sha1",
+					data));
+	ut_assertok(fit_stream_add_hash(uts, fit, image, "hash-3", "crc32",
+					data));
+
+	for (step = 1; step <= DATA_LEN; step += step < 8 ? 1 : 157)
+		ut_assertok(fit_stream_check(uts, fit, image, data, step, 1));
+
+	/* The streamed digests agree with the one-shot check */
+	ut_asserteq(1, fit_image_verify_with_data(fit, image, data, DATA_LEN));
+
+	return 0;
+}
+
+LIB_TEST(lib_test_fit_stream_verify, 0);
+
+/* Check that a change to the data or to a stored hash is caught */
+static int lib_test_fit_stream_mismatch(struct unit_test_state *uts)
+{
+	struct fit_image_stream fs;
+	u8 data[DATA_LEN];
+	u8 fit[FIT_SIZE];
+	int image;
+
+	fit_stream_fill(data);
+	ut_assertok(fit_stream_create(uts, fit, &image));
+	ut_assertok(fit_stream_add_hash(uts, fit, image, "hash-1", "sha256",
+					data));
+	ut_assertok(fit_stream_add_hash(uts, fit, image, "hash-2", "crc32",
+					data));
+
+	/* One byte changed in the middle of the image */
+	data[DATA_LEN / 2] ^= 0x40;
+	ut_assertok(fit_stream_check(uts, fit, image, data, 64, 0));
+	data[DATA_LEN / 2] ^= 0x40;
+	ut_assertok(fit_stream_check(uts, fit, image, data, 64, 1));
+
+	/* Data cut short */
+	ut_assertok(fit_image_stream_start(&fs, fit, image));
+	ut_assertok(fit_image_stream_update(&fs, data, DATA_LEN - 1));
+	ut_asserteq(0, fit_image_stream_verify(&fs, data, DATA_LEN - 1));
+
+	/* A hash node which does not match the data */
+	ut_assertok(fit_stream_add_hash(uts, fit, image, "hash-3", "sha1",
+					data + 1));
+	ut_assertok(fit_stream_check(uts, fit, image, data, 64, 0));
+
+	return 0;
+}
+
+LIB_TEST(lib_test_fit_stream_mismatch, 0);
+
+/* Check the images which must be loaded in one piece instead */
+static int lib_test_fit_stream_refuse(struct unit_test_state *uts)
+{
+	struct fit_image_stream fs;
+	u8 data[DATA_LEN];
+	u8 fit[FIT_SIZE];
+	char name[20];
+	int image;
+	int i;
+
+	fit_stream_fill(data);
+
+	/* md5 cannot be calculated progressively */
+	ut_assertok(fit_stream_create(uts, fit, &image));
+	ut_assertok(fit_stream_add_hash(uts, fit, image, "hash-1", "md5",
+					data));
+	ut_asserteq(-EPROTONOSUPPORT, fit_image_stream_start(&fs, fit, image));
+	ut_asserteq(0, fs.count);
+
+	/* Too many hash nodes */
+	ut_assertok(fit_stream_create(uts, fit, &image));
+	for (i = 0; i <= FIT_STREAM_MAX_HASHES; i++) {
+		snprintf(name, sizeof(name), "hash-%d", i + 1);
+		ut_assertok(fit_stream_add_hash(uts, fit, image, name, "crc32",
+						data));
+	}
+	ut_asserteq(-EPROTONOSUPPORT, fit_image_stream_start(&fs, fit, image));
+
+	/* Signatures are checked over the whole image */
+	if (IS_ENABLED(CONFIG_FIT_SIGNATURE)) {
+		ut_assertok(fit_stream_create(uts, fit, &image));
+		ut_assertok(fit_stream_add_hash(uts, fit, image, "hash-1",
+						"sha256", data));
+		ut_assert(fdt_add_subnode(fit, image, "signature-1") >= 0);
+		ut_asserteq(-EPROTONOSUPPORT,
+			    fit_image_stream_start(&fs, fit, image));
+	}
+
+	/* A stream can be dropped without verifying it */
+	ut_assertok(fit_stream_create(uts, fit, &image));
+	ut_assertok(fit_stream_add_hash(uts, fit, image, "hash-1", "sha256",
+					data));
+	ut_assertok(fit_image_stream_start(&fs, fit, image));
+	ut_assertok(fit_image_stream_update(&fs, data, DATA_LEN));
+	fit_image_stream_abort(&fs);
+	ut_asserteq(0, fs.count);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_fit_stream_refuse, 0);
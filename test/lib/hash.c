@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for the streaming hash API
+ *
+ * A digest must not depend on how the data is split between updates, and
+ * must match both hash_block() and the FIPS 180 test vectors.
+ */
+
+#include <common.h>
+#include <hash.h>
+#include <image.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+
+#define BUFLEN	1000
+
+static const u8 sha1_abc[SHA1_SUM_LEN] = {
+	0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+	0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d,
+};
+
+static const u8 sha256_abc[SHA256_SUM_LEN] = {
+	0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+	0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+	0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+	0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+};
+
+static int hash_stream_vector(struct unit_test_state *uts, const char *name,
+			      const u8 *expect, int len)
+{
+	u8 out[HASH_MAX_DIGEST_SIZE];
+	struct hash_stream hs;
+
+	ut_assertok(hash_stream_start(&hs, name));
+	ut_assertok(hash_stream_update(&hs, "a", 1));
+	ut_assertok(hash_stream_update(&hs, "", 0));
+	ut_assertok(hash_stream_update(&hs, "bc", 2));
+	ut_assertok(hash_stream_finish(&hs, out, sizeof(out)));
+	ut_assertok(memcmp(expect, out, len));
+
+	/* A finished stream cannot be used again */
+	ut_asserteq(-EINVAL, hash_stream_update(&hs, "a", 1));
+	ut_asserteq(-EINVAL, hash_stream_finish(&hs, out, sizeof(out)));
+
+	return 0;
+}
+
+/* Check the "abc" test vectors and error handling */
+static int lib_test_hash_stream_vectors(struct unit_test_state *uts)
+{
+	u8 out[HASH_MAX_DIGEST_SIZE];
+	struct hash_stream hs;
+
+	ut_assertok(hash_stream_vector(uts, "sha1", sha1_abc, SHA1_SUM_LEN));
+	ut_assertok(hash_stream_vector(uts, "sha256", sha256_abc,
+				       SHA256_SUM_LEN));
+
+	ut_asserteq(-EPROTONOSUPPORT, hash_stream_start(&hs, "nosuchhash"));
+
+	ut_assertok(hash_stream_start(&hs, "sha256"));
+	ut_asserteq(-ENOSPC, hash_stream_finish(&hs, out, SHA1_SUM_LEN));
+
+	/* Aborting twice is harmless */
+	ut_assertok(hash_stream_start(&hs, "sha1"));
+	hash_stream_abort(&hs);
+	hash_stream_abort(&hs);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_hash_stream_vectors, 0);
+
+/* Check that any split of the input gives the one-shot digest */
+static int lib_test_hash_stream_split(struct unit_test_state *uts)
+{
+	static const char *const names[] = { "sha1", "sha256" };
+	u8 expect[HASH_MAX_DIGEST_SIZE], out[HASH_MAX_DIGEST_SIZE];
+	struct hash_stream hs;
+	u8 buf[BUFLEN];
+	int i, step, pos, size;
+
+	for (i = 0; i < BUFLEN; i++)
+		buf[i] = (i * 73 + 5) ^ (i >> 4);
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		size = sizeof(expect);
+		ut_assertok(hash_block(names[i], buf, BUFLEN, expect, &size));
+
+		/* Steps either side of the 64-byte block size */
+		for (step = 1; step <= 200; step += step < 8 ? 1 : 57) {
+			ut_assertok(hash_stream_start(&hs, names[i]));
+			for (pos = 0; pos < BUFLEN; pos += step)
+				ut_assertok(hash_stream_update(&hs, buf + pos,
+						min(step, BUFLEN - pos)));
+			ut_assertok(hash_stream_finish(&hs, out, sizeof(out)));
+			ut_assertok(memcmp(expect, out, size));
+		}
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_hash_stream_split, 0);
+
+/* Check hashes queued together, over several regions, against hash_block() */
+static int lib_test_hash_calculate_queue(struct unit_test_state *uts)
+{
+	static const char *const names[] = { "sha1", "sha256", "sha1" };
+	u8 expect[HASH_MAX_DIGEST_SIZE];
+	u8 out[ARRAY_SIZE(names)][HASH_MAX_DIGEST_SIZE];
+	struct hash_calculation hc[ARRAY_SIZE(names)];
+	struct image_region region[3];
+	u8 buf[BUFLEN];
+	int i, size;
+
+	for (i = 0; i < BUFLEN; i++)
+		buf[i] = (i * 73 + 5) ^ (i >> 4);
+	region[0].data = buf;
+	region[0].size = 100;
+	region[1].data = buf + 100;
+	region[1].size = 0;
+	region[2].data = buf + 100;
+	region[2].size = BUFLEN - 100;
+
+	for (i = 0; i < ARRAY_SIZE(names); i++)
+		ut_assertok(hash_calculate_queue(&hc[i], names[i], region,
+						 ARRAY_SIZE(region)));
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		ut_assertok(hash_calculate_wait(&hc[i], out[i]));
+		size = sizeof(expect);
+		ut_assertok(hash_block(names[i], buf, BUFLEN, expect, &size));
+		ut_assertok(memcmp(expect, out[i], size));
+	}
+
+	ut_asserteq(-EPROTONOSUPPORT,
+		    hash_calculate_queue(&hc[0], "nosuchhash", region, 1));
+
+	return 0;
+}
+
+LIB_TEST(lib_test_hash_calculate_queue, 0);
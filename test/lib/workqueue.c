@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for the work queue
+ *
+ * On sandbox the work runs on host threads, so these also check that results
+ * are visible to the caller once work_wait() returns.
+ */
+
+#include <common.h>
+#include <workqueue.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define NUM_ITEMS	100
+#define DATA_LEN	4096
+
+struct sum_work {
+	const u8 *data;
+	int len;
+	u32 sum;
+};
+
+static int sum_work(void *arg)
+{
+	struct sum_work *sw = arg;
+	int i;
+
+	sw->sum = 0;
+	for (i = 0; i < sw->len; i++)
+		sw->sum = sw->sum * 31 + sw->data[i];
+
+	/* Fail odd lengths so that the return value can be checked */
+	return sw->len & 1 ? -EINVAL : 0;
+}
+
+/* Queue more items than there are CPUs or queue slots */
+static int lib_test_work_barrier(struct unit_test_state *uts)
+{
+	struct sum_work sw[NUM_ITEMS];
+	struct work work[NUM_ITEMS];
+	struct sum_work expect;
+	u8 data[DATA_LEN];
+	int i;
+
+	for (i = 0; i < DATA_LEN; i++)
+		data[i] = i ^ (i >> 5);
+
+	if (IS_ENABLED(CONFIG_SANDBOX))
+		ut_asserteq(CONFIG_SANDBOX_WORK_CPUS, work_cpus());
+
+	for (i = 0; i < NUM_ITEMS; i++) {
+		sw[i].data = data + i;
+		sw[i].len = (DATA_LEN - NUM_ITEMS) & ~1;
+		work_queue(&work[i], sum_work, &sw[i]);
+	}
+	ut_assertok(work_wait_all(work, NUM_ITEMS));
+
+	for (i = 0; i < NUM_ITEMS; i++) {
+		ut_assert(work[i].done);
+		expect = sw[i];
+		ut_assertok(sum_work(&expect));
+		ut_asserteq(expect.sum, sw[i].sum);
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_work_barrier, 0);
+
+/* Check that errors are returned, and that all items finish regardless */
+static int lib_test_work_errors(struct unit_test_state *uts)
+{
+	struct sum_work sw[8];
+	struct work work[8];
+	u8 data[64] = { 1 };
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sw); i++) {
+		sw[i].data = data;
+		sw[i].len = i == 5 ? 7 : 8 * i;
+		work_queue(&work[i], sum_work, &sw[i]);
+	}
+	ut_asserteq(-EINVAL, work_wait_all(work, ARRAY_SIZE(work)));
+	for (i = 0; i < ARRAY_SIZE(work); i++)
+		ut_assert(work[i].done);
+	ut_asserteq(-EINVAL, work_wait(&work[5]));
+	ut_assertok(work_wait(&work[6]));
+
+	return 0;
+}
+
+LIB_TEST(lib_test_work_errors, 0);
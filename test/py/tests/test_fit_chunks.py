@@ -0,0 +1,74 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Test a FIT kernel made by mkimage from separately compressed gzip chunks
+
+import gzip
+import os
+import struct
+import pytest
+import u_boot_utils as util
+
+script = '''
+host load hostfs 0 %(fit_addr)x %(fit)s
+bootm start %(fit_addr)x
+bootm loados
+host save hostfs 0 %(kernel_addr)x %(kernel_out)s %(kernel_size)x
+'''
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fit')
+@pytest.mark.buildconfigspec('gzip')
+def test_fit_chunks(u_boot_console):
+    """Test that each chunk given to mkimage is listed and decompressed."""
+
+    cons = u_boot_console
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    kernel = os.path.join(cons.config.build_dir, 'chunks-kernel.bin')
+    kernel_out = os.path.join(cons.config.build_dir, 'chunks-kernel-out.bin')
+    fit = os.path.join(cons.config.build_dir, 'chunks.itb')
+
+    data = b''.join(b'this kernel %d is unlikely to boot\n' % i
+                    for i in range(20000))
+    with open(kernel, 'wb') as fd:
+        fd.write(data)
+
+    # Three chunks, the last one shorter
+    chunk_size = 0x40000
+    chunks = []
+    sizes = []
+    for i, offset in enumerate(range(0, len(data), chunk_size)):
+        fname = '%s.%d.gz' % (kernel, i)
+        comp = gzip.compress(data[offset:offset + chunk_size])
+        with open(fname, 'wb') as fd:
+            fd.write(comp)
+        chunks.append(fname)
+        sizes.append(len(comp))
+    assert len(chunks) == 3
+
+    util.run_and_log(cons, [mkimage, '-f', 'auto', '-A', 'sandbox',
+                            '-O', 'linux', '-T', 'kernel', '-C', 'gzip',
+                            '-a', '40000', '-e', '0', '-d', ':'.join(chunks),
+                            fit])
+    with open(fit, 'rb') as fd:
+        itb = fd.read()
+    assert struct.pack('>3L', *sizes) in itb
+    assert b''.join(open(fname, 'rb').read() for fname in chunks) in itb
+
+    params = {
+        'fit_addr' : 0x1000,
+        'fit' : fit,
+        'kernel_addr' : 0x40000,
+        'kernel_out' : kernel_out,
+        'kernel_size' : len(data),
+    }
+    output = cons.run_command_list((script % params).splitlines())
+    assert 'Uncompressing Kernel Image in 3 chunks' in ''.join(output)
+    with open(kernel_out, 'rb') as fd:
+        assert fd.read() == data
+
+    # A missing chunk file is an error, not a shorter image
+    util.run_and_log_expect_exception(
+        cons, [mkimage, '-f', 'auto', '-A', 'sandbox', '-O', 'linux',
+               '-T', 'kernel', '-C', 'gzip', '-a', '40000', '-e', '0',
+               '-d', chunks[0] + ':' + kernel + '.missing.gz', fit],
+        1, "Can't open")
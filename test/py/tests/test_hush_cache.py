@@ -0,0 +1,91 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Test the cache of parsed hush scripts, and measure how long a boot script
+# loop takes with it.
+
+import pytest
+import re
+
+pytestmark = pytest.mark.buildconfigspec('hush_parser')
+
+# Slot selection as run by an A/B boot script for each slot it may boot
+slot_env = (
+    ('slot_select', 'if test "${slot}" = "${boot_slot}"; then '
+                    'setenv slot_tries ${tries_left}; '
+                    'elif test "${slot}" = a || test "${slot}" = b; then '
+                    'setenv slot_other ${slot}; '
+                    'else echo bad slot ${slot}; fi'),
+    ('boot_slot', 'a'),
+    ('tries_left', '3'),
+    ('slots', ' '.join(['a', 'b'] * 500)),
+    ('slot_loop', 'for slot in ${slots}; do run slot_select; done'),
+)
+
+def setenv_list(u_boot_console, env):
+    for name, value in env:
+        u_boot_console.run_command("setenv %s '%s'" % (name, value))
+
+def unsetenv_list(u_boot_console, env):
+    for name, value in env:
+        u_boot_console.run_command('setenv %s' % name)
+
+@pytest.mark.buildconfigspec('cmd_echo')
+def test_hush_cache_change(u_boot_console):
+    """Test that running a variable again follows changes to it."""
+
+    u_boot_console.run_command("setenv cache_test 'echo one'")
+    response = u_boot_console.run_command('run cache_test')
+    assert response.strip() == 'one'
+    u_boot_console.run_command("setenv cache_test 'echo two'")
+    response = u_boot_console.run_command(
+        'for i in 1 2 3; do run cache_test; done')
+    assert response.split() == ['two'] * 3
+    u_boot_console.run_command('setenv cache_test')
+
+@pytest.mark.buildconfigspec('cmd_echo')
+def test_hush_cache_self(u_boot_console):
+    """Test a script which changes the variable it is run from."""
+
+    u_boot_console.run_command(
+        "setenv cache_test 'setenv cache_test echo changed; echo first'")
+    response = u_boot_console.run_command('run cache_test')
+    assert response.strip() == 'first'
+    response = u_boot_console.run_command('run cache_test')
+    assert response.strip() == 'changed'
+    u_boot_console.run_command('setenv cache_test')
+
+@pytest.mark.buildconfigspec('cmd_echo')
+def test_hush_cache_for(u_boot_console):
+    """Test that a loop gives the same result each time it is run."""
+
+    u_boot_console.run_command(
+        "setenv cache_test 'for i in a b c; do echo ${i}; done'")
+    for i in range(3):
+        response = u_boot_console.run_command('run cache_test')
+        assert response.split() == ['a', 'b', 'c']
+    u_boot_console.run_command('setenv cache_test')
+
+@pytest.mark.buildconfigspec('cmd_time')
+def test_hush_cache_bench(u_boot_console):
+    """Measure how long a slot selection loop takes.
+
+    The loop runs the same script for each of 1000 slots. Build with and
+    without CONFIG_HUSH_CACHE to compare.
+    """
+
+    setenv_list(u_boot_console, slot_env)
+    times = []
+    for i in range(5):
+        response = u_boot_console.run_command('time run slot_loop')
+        assert 'bad slot' not in response
+        m = re.search(r'time: (\d+)\.(\d+) seconds', response)
+        assert m
+        times.append(int(m.group(1)) * 1000 + int(m.group(2)))
+    response = u_boot_console.run_command('echo ${slot_tries} ${slot_other}')
+    assert response.strip() == '3 b'
+    unsetenv_list(u_boot_console, slot_env)
+    u_boot_console.run_command('setenv slot_tries')
+    u_boot_console.run_command('setenv slot_other')
+
+    u_boot_console.log.info('slot loop: %s ms, best %d us per slot' %
+                            (times, min(times)))
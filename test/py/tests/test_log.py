@@ -9,6 +9,7 @@ and checks that the output is correct.
 """
 
 import pytest
+import u_boot_utils as util
 
 LOGL_FIRST, LOGL_WARNING, LOGL_INFO = (0, 4, 6)
 
@@ -130,3 +131,46 @@ def test_log_format(u_boot_console):
         run_with_format('FLfm', 'file.c:123-func() msg')
         run_with_format('lm', 'NOTICE. msg')
         run_with_format('m', 'msg')
+
+@pytest.mark.buildconfigspec('cmd_log')
+@pytest.mark.buildconfigspec('log_binary')
+def test_log_dump(u_boot_console):
+    """Test that 'log dump' shows records written to the binary log"""
+    cons = u_boot_console
+    with cons.log.section('dump'):
+        cons.run_command('log rec arch notice file.c 123 func binary-msg')
+        # Reuse the command buffer which held the file name
+        cons.run_command('echo overwrite-the-command-line')
+        output = cons.run_command('log dump')
+        assert 'U-Boot started' in output
+        lines = [line for line in output.splitlines() if 'binary-msg' in line]
+        assert lines
+        assert 'NOTICE.arch,' in lines[-1]
+        assert 'file.c:123- binary-msg' in lines[-1]
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_log')
+@pytest.mark.buildconfigspec('log_binary')
+def test_log_decode(u_boot_console):
+    """Test that tools/logdecode decodes a copy of the binary log"""
+    cons = u_boot_console
+    addr = int(cons.config.buildconfig['config_log_binary_addr'], 16)
+    size = int(cons.config.buildconfig['config_log_binary_size'], 16)
+    fname = cons.config.persistent_data_dir + '/log.bin'
+    logdecode = cons.config.build_dir + '/tools/logdecode'
+    elf = cons.config.build_dir + '/u-boot'
+    with cons.log.section('decode'):
+        cons.run_command('log rec arch notice file.c 123 func decode-msg')
+        cons.run_command('host save hostfs 0 %x %s %x' % (addr, fname, size))
+        output = util.run_and_log(cons, [logdecode, '-u', elf, fname])
+        assert 'U-Boot started' in output
+        assert '(no ELF file)' not in output
+        lines = [line for line in output.splitlines() if 'decode-msg' in line]
+        assert lines
+        assert 'NOTICE.' in lines[-1]
+        assert 'file.c:123- decode-msg' in lines[-1]
+
+        # Without the ELF file only the file name and line are known
+        output = util.run_and_log(cons, [logdecode, fname])
+        assert 'U-Boot started (no ELF file)' in output
+        assert 'file.c:123- fmt 0x' in output
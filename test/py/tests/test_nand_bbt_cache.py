@@ -0,0 +1,89 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Test the NAND bad block cache on the emulated sandbox device, which has
+# factory bad blocks 5 and 700 and 128KiB eraseblocks.
+
+import pytest
+
+pytestmark = [pytest.mark.boardspec('sandbox'),
+              pytest.mark.buildconfigspec('nand_bbt_cache'),
+              pytest.mark.buildconfigspec('cmd_nand')]
+
+factory_bad = ['000a0000', '05780000']
+
+def bad_blocks(u_boot_console):
+    response = u_boot_console.run_command('nand bad')
+    assert 'Device 0 bad blocks:' in response
+    return response.split('bad blocks:')[1].split()
+
+def test_nand_bbt_cache_bad(u_boot_console):
+    """Test that the factory bad blocks are reported."""
+
+    bad = bad_blocks(u_boot_console)
+    for block in factory_bad:
+        assert block in bad
+
+def test_nand_bbt_cache_erase(u_boot_console):
+    """Test that erasing skips a bad block and keeps it bad."""
+
+    response = u_boot_console.run_command('nand erase 0x80000 0x80000')
+    assert 'Skipping bad block at  0x000a0000' in response
+    assert 'OK' in response
+    assert '000a0000' in bad_blocks(u_boot_console)
+
+def test_nand_bbt_cache_rebuild(u_boot_console):
+    """Test that a block marked bad is kept when the cache is rebuilt."""
+
+    response = u_boot_console.run_command('nand markbad 0x7e00000')
+    assert 'successfully marked as bad' in response
+    before = bad_blocks(u_boot_console)
+    assert '07e00000' in before
+
+    response = u_boot_console.run_command('nand bbtcache rebuild')
+    assert 'failed' not in response
+    assert bad_blocks(u_boot_console) == before
+
+def test_nand_bbt_cache_drop(u_boot_console):
+    """Test that dropping the cache does not change the bad blocks."""
+
+    before = bad_blocks(u_boot_console)
+    response = u_boot_console.run_command('nand bbtcache drop')
+    assert 'failed' not in response
+    assert bad_blocks(u_boot_console) == before
+
+def test_nand_bbt_cache_reload(u_boot_console):
+    """Test that the cache is restored from flash without scanning, that
+    reads trust it, and that a block marked bad since the cache was stored is
+    found before it is erased."""
+
+    cons = u_boot_console
+    response = cons.run_command('nand bbtcache rebuild')
+    assert 'failed' not in response
+    before = bad_blocks(cons)
+
+    # Mark block 992 bad in its OOB only, so that the cache does not know
+    cons.run_command('mw.b 1000000 ff 840')
+    cons.run_command('mw.w 1000800 0')
+    response = cons.run_command('nand write.raw 1000000 7c00000 1')
+    assert 'OK' in response
+
+    # Restoring from flash reads no bad block marker
+    response = cons.run_command('nand bbtcache reload')
+    assert 'failed' not in response
+    response = cons.run_command('nand bbtcache info')
+    unchecked = 1024 - len(before)
+    assert ('restored from the cache, %d blocks not checked yet' %
+            unchecked) in response
+
+    # Reading blocks 991 to 993 reads no marker
+    response = cons.run_command('nand read 1000000 7be0000 60000')
+    assert 'OK' in response
+    response = cons.run_command('nand bbtcache info')
+    assert ('%d blocks not checked yet' % unchecked) in response
+
+    # Erasing them checks their markers and leaves block 992 alone
+    response = cons.run_command('nand erase 7be0000 60000')
+    assert 'MTD Erase failure' in response
+    response = cons.run_command('nand bbtcache info')
+    assert ('%d blocks not checked yet' % (unchecked - 3)) in response
+    assert '07c00000' in bad_blocks(cons)
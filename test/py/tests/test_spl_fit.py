@@ -0,0 +1,84 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Test loading a FIT with external data in sandbox SPL, which hashes the
+# image as it is read when SPL_FIT_STREAM is enabled
+
+import os
+import struct
+import zlib
+
+import pytest
+import u_boot_utils as util
+
+ITS = '''
+/dts-v1/;
+
+/ {
+	description = "SPL FIT load test";
+	#address-cells = <1>;
+
+	images {
+		firmware-1 {
+			description = "Test firmware";
+			data = /incbin/("%s");
+			type = "firmware";
+			arch = "sandbox";
+			os = "u-boot";
+			compression = "none";
+			hash-1 {
+				algo = "sha256";
+			};
+		};
+	};
+	configurations {
+		default = "conf-1";
+		conf-1 {
+			firmware = "firmware-1";
+		};
+	};
+};
+'''
+
+@pytest.mark.boardspec('sandbox_spl')
+@pytest.mark.buildconfigspec('spl_fit_stream')
+@pytest.mark.buildconfigspec('spl_fit_signature')
+@pytest.mark.requiredtool('dtc')
+def test_spl_fit_stream(u_boot_console):
+    """Test that SPL loads a FIT image and rejects one with a bad hash"""
+    cons = u_boot_console
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    data_fname = os.path.join(cons.config.build_dir, 'spl-fit-data.bin')
+    its = os.path.join(cons.config.build_dir, 'spl-fit.its')
+    fit = os.path.join(cons.config.build_dir, 'spl-fit.fit')
+
+    # Several chunks, not a multiple of the chunk size
+    data = bytes((i * 73 + 5 ^ i >> 4) & 0xff for i in range(300000))
+    with open(data_fname, 'wb') as fd:
+        fd.write(data)
+    with open(its, 'w') as fd:
+        fd.write(ITS % data_fname)
+    util.run_and_log(cons, [mkimage, '-E', '-f', its, fit])
+
+    try:
+        cons.restart_uboot_with_flags(['--load_fit', fit])
+        output = cons.get_spawn_output().replace('\r', '')
+        assert 'sha256+ OK' in output
+        assert ('FIT loaded: size %x crc32 %08x' %
+                (len(data), zlib.crc32(data))) in output
+
+        # External data starts after the FIT, aligned to four bytes
+        with open(fit, 'rb') as fd:
+            blob = bytearray(fd.read())
+        base = (struct.unpack('>I', blob[4:8])[0] + 3) & ~3
+        blob[base + len(data) // 2] ^= 0x40
+        with open(fit, 'wb') as fd:
+            fd.write(blob)
+
+        cons.restart_uboot_with_flags(['--load_fit', fit])
+        output = cons.get_spawn_output().replace('\r', '')
+        assert 'Bad hash value' in output
+        assert 'FIT load failed' in output
+        assert 'FIT loaded' not in output
+    finally:
+        # Restart afterward in order to drop the --load_fit flag
+        cons.restart_uboot()
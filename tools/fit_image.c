@@ -78,6 +78,106 @@ err_keydest:
 	return ret;
 }
 
+/* Separates the files of a gzip image given in chunks, see fit_chunks() */
+#define FIT_CHUNK_SEP	':'
+
+/**
+ * fit_chunks() - Check whether the main image is given as gzip chunks
+ *
+ * With -C gzip, -d may list several files separated by ':', each of which
+ * is compressed on its own. They are joined into one image whose
+ * compression-chunks property lists their sizes, so that U-Boot can
+ * decompress them on several CPUs.
+ */
+static bool fit_chunks(struct image_tool_params *params)
+{
+	return params->comp == IH_COMP_GZIP &&
+	       strchr(params->datafile, FIT_CHUNK_SEP);
+}
+
+static int fit_read_file(struct image_tool_params *params, const char *fname,
+			 void *buf, int size)
+{
+	int ret;
+	int fd;
+
+	fd = open(fname, O_RDONLY | O_BINARY);
+	if (fd < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n",
+			params->cmdname, fname, strerror(errno));
+		return -1;
+	}
+	ret = read(fd, buf, size);
+	close(fd);
+	if (ret != size) {
+		fprintf(stderr, "%s: Can't read %s: %s\n",
+			params->cmdname, fname, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * fdt_property_chunks() - Write the compression-chunks and data properties
+ *
+ * @params:	Parameters; the chunk files are in params->datafile
+ * @fdt:	FIT being written, or NULL to just add up the chunk sizes
+ * @return total size of the chunks, or -1 on error
+ */
+static int fdt_property_chunks(struct image_tool_params *params, void *fdt)
+{
+	fdt32_t *sizes = NULL, *new_sizes;
+	char *fnames, *fname, *next;
+	int count = 0, total = 0;
+	int size, ret, i;
+	char *ptr;
+
+	fnames = strdup(params->datafile);
+	if (!fnames)
+		return -1;
+	for (fname = fnames; fname; fname = next) {
+		next = strchr(fname, FIT_CHUNK_SEP);
+		if (next)
+			*next++ = '\0';
+		size = imagetool_get_filesize(params, fname);
+		if (size <= 0)
+			goto err;
+		new_sizes = realloc(sizes, (count + 1) * sizeof(*sizes));
+		if (!new_sizes)
+			goto err;
+		sizes = new_sizes;
+		sizes[count++] = cpu_to_fdt32(size);
+		total += size;
+	}
+	if (!fdt)
+		goto done;
+
+	ret = fdt_property(fdt, FIT_COMP_CHUNKS_PROP, sizes,
+			   count * sizeof(*sizes));
+	if (!ret)
+		ret = fdt_property_placeholder(fdt, FIT_DATA_PROP, total,
+					       (void **)&ptr);
+	if (ret)
+		goto err;
+	for (fname = fnames, i = 0; i < count; i++) {
+		size = fdt32_to_cpu(sizes[i]);
+		if (fit_read_file(params, fname, ptr, size))
+			goto err;
+		ptr += size;
+		fname += strlen(fname) + 1;
+	}
+done:
+	free(sizes);
+	free(fnames);
+
+	return total;
+err:
+	free(sizes);
+	free(fnames);
+	return -1;
+}
+
 /**
  * fit_calc_size() - Calculate the approximate size of the FIT we will generate
  */
@@ -86,7 +186,10 @@ static int fit_calc_size(struct image_tool_params *params)
 	struct content_info *cont;
 	int size, total_size;
 
-	size = imagetool_get_filesize(params, params->datafile);
+	if (fit_chunks(params))
+		size = fdt_property_chunks(params, NULL);
+	else
+		size = imagetool_get_filesize(params, params->datafile);
 	if (size < 0)
 		return -1;
 	total_size = size;
@@ -219,7 +322,11 @@ static int fit_write_images(struct image_tool_params *params, char *fdt)
 	 * Put data last since it is large. SPL may only load the first part
 	 * of the DT, so this way it can access all the above fields.
 	 */
-	ret = fdt_property_file(params, fdt, FIT_DATA_PROP, params->datafile);
+	if (fit_chunks(params))
+		ret = fdt_property_chunks(params, fdt) < 0 ? -1 : 0;
+	else
+		ret = fdt_property_file(params, fdt, FIT_DATA_PROP,
+					params->datafile);
 	if (ret)
 		return ret;
 	fdt_end_node(fdt);
@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Decode a binary log written by U-Boot's binary log driver
+ *
+ * The log holds the addresses of format strings. These are looked up in the
+ * ELF files of the images which wrote the log, using the log_binary_anchor
+ * symbol to find where each image was running.
+ */
+
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <log_binary.h>
+
+#define ANCHOR_NAME	"log_binary_anchor"
+
+/* Phases, as enum u_boot_phase */
+enum {
+	PHASE_TPL,
+	PHASE_SPL,
+	PHASE_BOARD_F,
+	PHASE_BOARD_R,
+
+	PHASE_COUNT,
+};
+
+static const char *const phase_name[PHASE_COUNT] = {
+	"TPL",
+	"SPL",
+	"U-Boot before relocation",
+	"U-Boot",
+};
+
+/* Log levels, as enum log_level_t */
+static const char *const level_name[] = {
+	"EMERG",
+	"ALERT",
+	"CRIT",
+	"ERR",
+	"WARNING",
+	"NOTICE",
+	"INFO",
+	"DEBUG",
+	"CONTENT",
+	"IO",
+};
+
+/**
+ * struct elf_file - an ELF file read into memory
+ *
+ * @fname: Name of the file
+ * @data: Contents of the file
+ * @size: Size of the file in bytes
+ * @is64: true for ELFCLASS64, false for ELFCLASS32
+ */
+struct elf_file {
+	const char *fname;
+	uint8_t *data;
+	size_t size;
+	bool is64;
+};
+
+/**
+ * struct elf_sect - the fields we need from a section header
+ */
+struct elf_sect {
+	uint32_t type;
+	uint64_t flags;
+	uint64_t addr;
+	uint64_t offset;
+	uint64_t size;
+	uint32_t link;
+	uint64_t entsize;
+};
+
+static void *read_file(const char *fname, size_t *sizep)
+{
+	struct stat st;
+	void *buf;
+	int fd;
+
+	fd = open(fname, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st)) {
+		fprintf(stderr, "Cannot open '%s': %s\n", fname,
+			strerror(errno));
+		return NULL;
+	}
+	buf = malloc(st.st_size);
+	if (!buf || read(fd, buf, st.st_size) != st.st_size) {
+		fprintf(stderr, "Cannot read '%s'\n", fname);
+		free(buf);
+		close(fd);
+		return NULL;
+	}
+	close(fd);
+	*sizep = st.st_size;
+
+	return buf;
+}
+
+static int elf_open(struct elf_file *elf, const char *fname)
+{
+	elf->fname = fname;
+	elf->data = read_file(fname, &elf->size);
+	if (!elf->data)
+		return -1;
+	if (elf->size < sizeof(Elf32_Ehdr) ||
+	    memcmp(elf->data, ELFMAG, SELFMAG)) {
+		fprintf(stderr, "'%s' is not an ELF file\n", fname);
+		return -1;
+	}
+	elf->is64 = elf->data[EI_CLASS] == ELFCLASS64;
+	if (elf->is64 && elf->size < sizeof(Elf64_Ehdr)) {
+		fprintf(stderr, "'%s' is too short\n", fname);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Get section header @idx, returning -1 if there is none */
+static int elf_get_sect(struct elf_file *elf, int idx, struct elf_sect *sect)
+{
+	uint64_t off;
+
+	if (elf->is64) {
+		Elf64_Ehdr *ehdr = (Elf64_Ehdr *)elf->data;
+		Elf64_Shdr *shdr;
+
+		off = ehdr->e_shoff + (uint64_t)idx * ehdr->e_shentsize;
+		if (idx >= ehdr->e_shnum || off + sizeof(*shdr) > elf->size)
+			return -1;
+		shdr = (Elf64_Shdr *)(elf->data + off);
+		sect->type = shdr->sh_type;
+		sect->flags = shdr->sh_flags;
+		sect->addr = shdr->sh_addr;
+		sect->offset = shdr->sh_offset;
+		sect->size = shdr->sh_size;
+		sect->link = shdr->sh_link;
+		sect->entsize = shdr->sh_entsize;
+	} else {
+		Elf32_Ehdr *ehdr = (Elf32_Ehdr *)elf->data;
+		Elf32_Shdr *shdr;
+
+		off = ehdr->e_shoff + (uint64_t)idx * ehdr->e_shentsize;
+		if (idx >= ehdr->e_shnum || off + sizeof(*shdr) > elf->size)
+			return -1;
+		shdr = (Elf32_Shdr *)(elf->data + off);
+		sect->type = shdr->sh_type;
+		sect->flags = shdr->sh_flags;
+		sect->addr = shdr->sh_addr;
+		sect->offset = shdr->sh_offset;
+		sect->size = shdr->sh_size;
+		sect->link = shdr->sh_link;
+		sect->entsize = shdr->sh_entsize;
+	}
+	if (sect->type != SHT_NOBITS &&
+	    (sect->offset > elf->size || sect->size > elf->size - sect->offset))
+		return -1;
+
+	return 0;
+}
+
+/* Find the string at link address @addr, or return NULL */
+static const char *elf_get_str(struct elf_file *elf, uint64_t addr)
+{
+	struct elf_sect sect;
+	const char *str;
+	int i;
+
+	for (i = 0; !elf_get_sect(elf, i, &sect); i++) {
+		if (!(sect.flags & SHF_ALLOC) || sect.type == SHT_NOBITS ||
+		    addr < sect.addr || addr >= sect.addr + sect.size)
+			continue;
+		str = (const char *)elf->data + sect.offset + addr - sect.addr;
+		if (!memchr(str, '\0', sect.addr + sect.size - addr))
+			return NULL;
+		return str;
+	}
+
+	return NULL;
+}
+
+/* Find the value of symbol @name, returning -1 if not found */
+static int elf_find_sym(struct elf_file *elf, const char *name,
+			uint64_t *valuep)
+{
+	struct elf_sect sect, strs;
+	const char *symname;
+	uint64_t off, value;
+	uint32_t name_off;
+	int i;
+
+	for (i = 0; !elf_get_sect(elf, i, &sect); i++) {
+		if (sect.type != SHT_SYMTAB || !sect.entsize ||
+		    elf_get_sect(elf, sect.link, &strs))
+			continue;
+		for (off = 0; off + sect.entsize <= sect.size;
+		     off += sect.entsize) {
+			uint8_t *sym = elf->data + sect.offset + off;
+
+			if (elf->is64) {
+				name_off = ((Elf64_Sym *)sym)->st_name;
+				value = ((Elf64_Sym *)sym)->st_value;
+			} else {
+				name_off = ((Elf32_Sym *)sym)->st_name;
+				value = ((Elf32_Sym *)sym)->st_value;
+			}
+			if (name_off >= strs.size)
+				continue;
+			symname = (const char *)elf->data + strs.offset +
+				name_off;
+			if (memchr(symname, '\0', strs.size - name_off) &&
+			    !strcmp(symname, name)) {
+				*valuep = value;
+				return 0;
+			}
+		}
+	}
+
+	return -1;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-u u-boot] [-s u-boot-spl] [-t u-boot-tpl] <log>\n"
+		"Decode a binary log, using the ELF files which wrote it\n"
+		"   -u <file>  ELF file for U-Boot\n"
+		"   -s <file>  ELF file for SPL\n"
+		"   -t <file>  ELF file for TPL\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct elf_file elf[PHASE_COUNT], *cur = NULL;
+	const struct logb_rec *rec;
+	const struct logb_hdr *hdr;
+	char file[LOGB_STR_MAX + 1];
+	const uint8_t *args;
+	const char *fmt;
+	char msg[1024];
+	uint64_t offset = 0, anchor;
+	size_t size;
+	uint32_t off;
+	int opt, len;
+
+	memset(elf, '\0', sizeof(elf));
+	while ((opt = getopt(argc, argv, "s:t:u:")) != -1) {
+		switch (opt) {
+		case 's':
+			if (elf_open(&elf[PHASE_SPL], optarg))
+				return 1;
+			break;
+		case 't':
+			if (elf_open(&elf[PHASE_TPL], optarg))
+				return 1;
+			break;
+		case 'u':
+			if (elf_open(&elf[PHASE_BOARD_F], optarg))
+				return 1;
+			elf[PHASE_BOARD_R] = elf[PHASE_BOARD_F];
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1)
+		usage(argv[0]);
+
+	hdr = read_file(argv[optind], &size);
+	if (!hdr)
+		return 1;
+	if (size > UINT32_MAX || logb_check_hdr(hdr, size)) {
+		fprintf(stderr, "'%s' does not hold a valid binary log\n",
+			argv[optind]);
+		return 1;
+	}
+
+	for (off = hdr->tail; (rec = logb_next_rec(hdr, &off));) {
+		if (rec->type == LOGBT_START) {
+			cur = rec->level < PHASE_COUNT && elf[rec->level].data ?
+				&elf[rec->level] : NULL;
+			if (cur && elf_find_sym(cur, ANCHOR_NAME, &anchor)) {
+				fprintf(stderr, "No symbol %s in '%s'\n",
+					ANCHOR_NAME, cur->fname);
+				cur = NULL;
+			}
+			/* Check that the version string is the same */
+			if (cur) {
+				const char *str = elf_get_str(cur, anchor);
+
+				if (!str || logb_hash(str) != rec->file) {
+					fprintf(stderr,
+						"'%s' did not write this log\n",
+						cur->fname);
+					cur = NULL;
+				}
+				offset = anchor - rec->fmt;
+			}
+			printf("%10llu --- %s started%s\n",
+			       (unsigned long long)rec->time,
+			       rec->level < PHASE_COUNT ?
+			       phase_name[rec->level] : "?",
+			       cur ? "" : " (no ELF file)");
+			continue;
+		}
+		if (rec->type != LOGBT_MSG)
+			continue;
+
+		printf("%10llu %s.%u,", (unsigned long long)rec->time,
+		       rec->level < sizeof(level_name) / sizeof(level_name[0]) ?
+		       level_name[rec->level] : "INVALID", rec->cat);
+		args = (const uint8_t *)(rec + 1);
+		len = logb_get_str(args, rec->size - sizeof(*rec), file);
+		if (len < 0) {
+			printf("%u- corrupt record\n", rec->line);
+			continue;
+		}
+		args += len;
+		fmt = cur ? elf_get_str(cur, rec->fmt + offset) : NULL;
+		if (!fmt) {
+			printf("%s:%u- fmt %#llx\n", file, rec->line,
+			       (unsigned long long)rec->fmt);
+			continue;
+		}
+		len = logb_format(msg, sizeof(msg), fmt, args,
+				  (const uint8_t *)rec + rec->size - args,
+				  hdr->long_size);
+		printf("%s:%u- %s%s", file, rec->line, msg,
+		       len && msg[len - 1] == '\n' ? "" : "\n");
+	}
+
+	return 0;
+}